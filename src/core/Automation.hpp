@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Automation lane: a curve for one (node, param) stored as sorted point arrays. Graph::process
+// evaluates each lane once per block and ramps the parameter to the curve's value at the block
+// end (Node::automate), so dense automation costs no commands and no block splitting; within a
+// block the curve is followed linearly.
+struct AutomationLane {
+  enum class Shape : uint8_t { Linear = 0, Exp, Bezier };
+
+  std::string nodeId;
+  std::string paramName; // optional: resolved to paramId per node type when loaded
+  uint16_t paramId = 0;
+  // Point i: absolute frame and value. shapes[i] (and for bezier the control values c1[i],
+  // c2[i]) shape the segment from point i - 1 to point i; shapes[0] is unused.
+  std::vector<uint64_t> times;
+  std::vector<float> values;
+  std::vector<Shape> shapes;
+  std::vector<float> c1, c2;
+
+  bool empty() const { return times.empty(); }
+  size_t size() const { return times.size(); }
+
+  void addPoint(uint64_t t, float v, Shape s = Shape::Linear, float ctrl1 = 0.0f, float ctrl2 = 0.0f) {
+    times.push_back(t); values.push_back(v); shapes.push_back(s); c1.push_back(ctrl1); c2.push_back(ctrl2);
+  }
+
+  // Stable sort by time; points at the same time keep their order (a jump)
+  void sort() {
+    std::vector<size_t> idx(times.size());
+    std::iota(idx.begin(), idx.end(), size_t{0});
+    std::stable_sort(idx.begin(), idx.end(), [&](size_t a, size_t b) { return times[a] < times[b]; });
+    AutomationLane s; s.nodeId = nodeId; s.paramName = paramName; s.paramId = paramId;
+    for (size_t i : idx) s.addPoint(times[i], values[i], shapes[i], c1[i], c2[i]);
+    *this = std::move(s);
+  }
+
+  // Move the lane by `frames`; a negative shift drops points before 0 and starts the curve at
+  // its value there
+  void shift(int64_t frames) {
+    if (times.empty() || frames == 0) return;
+    if (frames > 0) { for (auto& t : times) t += static_cast<uint64_t>(frames); return; }
+    const uint64_t adv = static_cast<uint64_t>(-frames);
+    size_t cursor = 0;
+    const float v0 = times.front() < adv ? valueAt(adv, cursor) : values.front();
+    AutomationLane s; s.nodeId = nodeId; s.paramName = paramName; s.paramId = paramId;
+    if (times.front() < adv) s.addPoint(0, v0);
+    for (size_t i = 0; i < times.size(); ++i) {
+      if (times[i] < adv) continue;
+      s.addPoint(times[i] - adv, values[i], shapes[i], c1[i], c2[i]);
+    }
+    *this = std::move(s);
+  }
+
+  // Value at t (held before the first and after the last point). cursor caches the segment
+  // between calls, so evaluation at rising t is O(1); earlier t falls back to a binary search.
+  float valueAt(uint64_t t, size_t& cursor) const {
+    const size_t n = times.size();
+    if (n == 0) return 0.0f;
+    if (t <= times.front()) { cursor = 0; return values.front(); }
+    if (t >= times.back()) { cursor = n - 1; return values.back(); }
+    if (cursor >= n || times[cursor] > t) cursor = static_cast<size_t>(std::upper_bound(times.begin(), times.end(), t) - times.begin()) - 1;
+    while (cursor + 1 < n && times[cursor + 1] <= t) ++cursor;
+    const size_t i = cursor + 1;
+    const float a = values[cursor], b = values[i];
+    const double u = static_cast<double>(t - times[cursor]) / static_cast<double>(times[i] - times[cursor]);
+    switch (shapes[i]) {
+      case Shape::Exp:
+        // Geometric between same-sign values (frequencies, times); linear across zero
+        if ((a > 0.0f && b > 0.0f) || (a < 0.0f && b < 0.0f)) return static_cast<float>(a * std::pow(static_cast<double>(b) / a, u));
+        break;
+      case Shape::Bezier: {
+        const double v = 1.0 - u;
+        return static_cast<float>(v * v * v * a + 3.0 * v * v * u * c1[i] + 3.0 * v * u * u * c2[i] + u * u * u * b);
+      }
+      default: break;
+    }
+    return static_cast<float>(a + (b - a) * u);
+  }
+
+  static bool parseShape(const std::string& s, Shape& out) {
+    if (s.empty() || s == "linear") { out = Shape::Linear; return true; }
+    if (s == "exp") { out = Shape::Exp; return true; }
+    if (s == "bezier") { out = Shape::Bezier; return true; }
+    return false;
+  }
+  static const char* shapeName(Shape s) {
+    switch (s) {
+      case Shape::Exp: return "exp";
+      case Shape::Bezier: return "bezier";
+      default: return "linear";
+    }
+  }
+};
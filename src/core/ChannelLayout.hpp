@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Named bus/channel layouts. Speaker order follows the common SMPTE/WAV order:
+//   mono: C | stereo: L R | ms: M S | quad: L R Ls Rs | 5.1: L R C LFE Ls Rs | 7.1: L R C LFE Ls Rs Lrs Rrs
+// Any other channel count is Discrete (no speaker semantics; channels map by index).
+enum class ChannelLayout : uint8_t { Mono, Stereo, MidSide, Quad, Surround51, Surround71, Discrete };
+
+inline uint32_t channelCountForLayout(ChannelLayout l, uint32_t discreteChannels = 2) {
+  switch (l) {
+    case ChannelLayout::Mono: return 1;
+    case ChannelLayout::Stereo: return 2;
+    case ChannelLayout::MidSide: return 2;
+    case ChannelLayout::Quad: return 4;
+    case ChannelLayout::Surround51: return 6;
+    case ChannelLayout::Surround71: return 8;
+    case ChannelLayout::Discrete: return discreteChannels > 0 ? discreteChannels : 1;
+  }
+  return 2;
+}
+
+inline ChannelLayout defaultLayoutForChannels(uint32_t channels) {
+  switch (channels) {
+    case 1: return ChannelLayout::Mono;
+    case 2: return ChannelLayout::Stereo;
+    case 4: return ChannelLayout::Quad;
+    case 6: return ChannelLayout::Surround51;
+    case 8: return ChannelLayout::Surround71;
+    default: return ChannelLayout::Discrete;
+  }
+}
+
+inline const char* channelLayoutName(ChannelLayout l) {
+  switch (l) {
+    case ChannelLayout::Mono: return "mono";
+    case ChannelLayout::Stereo: return "stereo";
+    case ChannelLayout::MidSide: return "ms";
+    case ChannelLayout::Quad: return "quad";
+    case ChannelLayout::Surround51: return "5.1";
+    case ChannelLayout::Surround71: return "7.1";
+    case ChannelLayout::Discrete: return "discrete";
+  }
+  return "discrete";
+}
+
+// Returns false for unknown names (out unchanged)
+inline bool parseChannelLayout(const std::string& s, ChannelLayout& out) {
+  if (s == "mono") { out = ChannelLayout::Mono; return true; }
+  if (s == "stereo") { out = ChannelLayout::Stereo; return true; }
+  if (s == "ms" || s == "midside" || s == "MidSide") { out = ChannelLayout::MidSide; return true; }
+  if (s == "quad") { out = ChannelLayout::Quad; return true; }
+  if (s == "5.1") { out = ChannelLayout::Surround51; return true; }
+  if (s == "7.1") { out = ChannelLayout::Surround71; return true; }
+  if (s == "discrete") { out = ChannelLayout::Discrete; return true; }
+  return false;
+}
+
+// Up/down-mix matrix between two layouts, precomputed once per route.
+// Downmix follows ITU-R BS.775 (centre and surrounds at -3 dB, LFE dropped); mono folds L/R
+// at -6 dB each so correlated stereo keeps its level. M/S is converted through stereo.
+struct ChannelMixMatrix {
+  uint32_t inChannels = 0;
+  uint32_t outChannels = 0;
+  bool identity = false;
+  std::vector<float> coeffs; // outChannels x inChannels, row-major
+
+  float at(uint32_t o, uint32_t i) const { return coeffs[static_cast<size_t>(o) * inChannels + i]; }
+
+  // dst (outChannels wide) += gain * M * src (inChannels wide)
+  void applyAdd(float* dst, const float* src, uint32_t frames, float gain) const {
+    if (identity) {
+      const size_t n = static_cast<size_t>(frames) * outChannels;
+      for (size_t k = 0; k < n; ++k) dst[k] += src[k] * gain;
+      return;
+    }
+    if (inChannels > 8 || outChannels > 8) {
+      for (uint32_t f = 0; f < frames; ++f)
+        for (uint32_t o = 0; o < outChannels; ++o)
+          for (uint32_t i = 0; i < inChannels; ++i) dst[static_cast<size_t>(f) * outChannels + o] += at(o, i) * gain * src[static_cast<size_t>(f) * inChannels + i];
+      return;
+    }
+    // Small fixed-width row loops; the inner loops vectorize for the common widths
+    float g[8 * 8];
+    const uint32_t ni = std::min<uint32_t>(inChannels, 8), no = std::min<uint32_t>(outChannels, 8);
+    for (uint32_t o = 0; o < no; ++o) for (uint32_t i = 0; i < ni; ++i) g[o * 8 + i] = at(o, i) * gain;
+    for (uint32_t f = 0; f < frames; ++f) {
+      const float* s = src + static_cast<size_t>(f) * inChannels;
+      float* d = dst + static_cast<size_t>(f) * outChannels;
+      for (uint32_t o = 0; o < no; ++o) {
+        float acc = 0.0f;
+        for (uint32_t i = 0; i < ni; ++i) acc += g[o * 8 + i] * s[i];
+        d[o] += acc;
+      }
+    }
+  }
+
+  // dst += scalar * gains[frame] * M * src; per-frame gain buffer for ramps and crossfades
+  void applyAddGains(float* dst, const float* src, uint32_t frames, const float* gains, float scalar) const {
+    if (identity) {
+      for (uint32_t f = 0; f < frames; ++f) {
+        const float g = gains[f] * scalar;
+        const float* s = src + static_cast<size_t>(f) * inChannels;
+        float* d = dst + static_cast<size_t>(f) * outChannels;
+        for (uint32_t c = 0; c < outChannels; ++c) d[c] += s[c] * g;
+      }
+      return;
+    }
+    for (uint32_t f = 0; f < frames; ++f) {
+      const float g = gains[f] * scalar;
+      const float* s = src + static_cast<size_t>(f) * inChannels;
+      float* d = dst + static_cast<size_t>(f) * outChannels;
+      for (uint32_t o = 0; o < outChannels; ++o) {
+        float acc = 0.0f;
+        for (uint32_t i = 0; i < inChannels; ++i) acc += at(o, i) * s[i];
+        d[o] += acc * g;
+      }
+    }
+  }
+};
+
+namespace channel_layout_detail {
+enum Role : uint8_t { L, R, C, LFE, Ls, Rs, Lrs, Rrs, kRoleCount };
+
+inline std::vector<Role> roles(ChannelLayout l) {
+  switch (l) {
+    case ChannelLayout::Mono: return {C};
+    case ChannelLayout::Stereo: return {L, R};
+    case ChannelLayout::Quad: return {L, R, Ls, Rs};
+    case ChannelLayout::Surround51: return {L, R, C, LFE, Ls, Rs};
+    case ChannelLayout::Surround71: return {L, R, C, LFE, Ls, Rs, Lrs, Rrs};
+    default: return {};
+  }
+}
+
+// Accumulate the contribution of input role r (scaled by w) into output coefficients
+inline void fold(Role r, float w, const std::vector<int>& outIndex, std::vector<float>& row) {
+  constexpr float kMinus3dB = 0.70710678f;
+  if (outIndex[r] >= 0) { row[static_cast<size_t>(outIndex[r])] += w; return; }
+  switch (r) {
+    case L: case R: fold(C, 0.5f * w, outIndex, row); break;          // only missing in mono
+    case C: fold(L, kMinus3dB * w, outIndex, row); fold(R, kMinus3dB * w, outIndex, row); break;
+    case LFE: break;
+    case Ls: fold(L, kMinus3dB * w, outIndex, row); break;
+    case Rs: fold(R, kMinus3dB * w, outIndex, row); break;
+    case Lrs: fold(Ls, w, outIndex, row); break;
+    case Rrs: fold(Rs, w, outIndex, row); break;
+    default: break;
+  }
+}
+
+inline std::vector<float> multiply(const std::vector<float>& a, uint32_t aRows, uint32_t aCols, const std::vector<float>& b, uint32_t bCols) {
+  std::vector<float> out(static_cast<size_t>(aRows) * bCols, 0.0f);
+  for (uint32_t r = 0; r < aRows; ++r)
+    for (uint32_t k = 0; k < aCols; ++k)
+      for (uint32_t c = 0; c < bCols; ++c) out[static_cast<size_t>(r) * bCols + c] += a[static_cast<size_t>(r) * aCols + k] * b[static_cast<size_t>(k) * bCols + c];
+  return out;
+}
+} // namespace channel_layout_detail
+
+inline ChannelMixMatrix makeChannelMixMatrix(ChannelLayout from, uint32_t fromChannels, ChannelLayout to, uint32_t toChannels) {
+  using namespace channel_layout_detail;
+  ChannelMixMatrix m;
+  m.inChannels = fromChannels; m.outChannels = toChannels;
+  m.coeffs.assign(static_cast<size_t>(toChannels) * fromChannels, 0.0f);
+  if (from == to && fromChannels == toChannels) {
+    for (uint32_t c = 0; c < toChannels; ++c) m.coeffs[static_cast<size_t>(c) * fromChannels + c] = 1.0f;
+    m.identity = true;
+    return m;
+  }
+  // M/S goes through stereo: L = M + S, R = M - S; M = (L + R)/2, S = (L - R)/2
+  if (from == ChannelLayout::MidSide || to == ChannelLayout::MidSide) {
+    const std::vector<float> msToLr{1.0f, 1.0f, 1.0f, -1.0f};
+    const std::vector<float> lrToMs{0.5f, 0.5f, 0.5f, -0.5f};
+    ChannelMixMatrix inner = makeChannelMixMatrix(from == ChannelLayout::MidSide ? ChannelLayout::Stereo : from, fromChannels,
+                                                  to == ChannelLayout::MidSide ? ChannelLayout::Stereo : to, toChannels);
+    std::vector<float> c = inner.coeffs;
+    if (from == ChannelLayout::MidSide) c = multiply(c, toChannels, 2, msToLr, 2);
+    if (to == ChannelLayout::MidSide) c = multiply(lrToMs, 2, 2, c, fromChannels);
+    m.coeffs = std::move(c);
+    return m;
+  }
+  const std::vector<Role> inRoles = roles(from), outRoles = roles(to);
+  if (inRoles.empty() || outRoles.empty()) {
+    // Discrete on either side: map by index, drop channels that do not exist on the output
+    for (uint32_t c = 0; c < std::min(fromChannels, toChannels); ++c) m.coeffs[static_cast<size_t>(c) * fromChannels + c] = 1.0f;
+    m.identity = (fromChannels == toChannels);
+    return m;
+  }
+  std::vector<int> outIndex(kRoleCount, -1);
+  for (size_t o = 0; o < outRoles.size(); ++o) outIndex[outRoles[o]] = static_cast<int>(o);
+  std::vector<float> col(toChannels, 0.0f);
+  for (uint32_t i = 0; i < fromChannels && i < inRoles.size(); ++i) {
+    std::fill(col.begin(), col.end(), 0.0f);
+    fold(inRoles[i], 1.0f, outIndex, col);
+    for (uint32_t o = 0; o < toChannels; ++o) m.coeffs[static_cast<size_t>(o) * fromChannels + i] = col[o];
+  }
+  return m;
+}
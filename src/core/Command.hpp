@@ -42,14 +42,17 @@ public:
   }
   constexpr size_t capacity() const { return Capacity - 1; }
 
-  // Drain into out vector all commands with sampleTime < cutoff
-  void drainUpTo(SampleTime cutoff, std::vector<Command>& out) {
+  // Drain into out vector all commands with sampleTime < cutoff, stopping once out holds maxOut
+  // commands. Returns false if due commands were left queued because of that limit.
+  bool drainUpTo(SampleTime cutoff, std::vector<Command>& out, size_t maxOut = static_cast<size_t>(-1)) {
     while (tail_.load(std::memory_order_relaxed) != head_) {
       const Command& c = buffer_[tail_];
       if (c.sampleTime >= cutoff) break;
+      if (out.size() >= maxOut) return false;
       out.push_back(c);
       tail_.store((tail_.load(std::memory_order_relaxed) + 1) % Capacity, std::memory_order_release);
     }
+    return true;
   }
 
 private:
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Node.hpp"
+#include "SidechainDetector.hpp"
 #include <algorithm>
 #include <cmath>
 
@@ -14,12 +15,12 @@ public:
   float makeupDb = 0.0f;
 
   const char* name() const override { return "compressor"; }
-  void prepare(double sampleRate, uint32_t /*maxBlock*/) override {
+  void prepare(double sampleRate, uint32_t maxBlock) override {
     sampleRate_ = sampleRate > 0.0 ? sampleRate : 48000.0;
-    updateCoefs();
-    env_ = 0.0f;
+    detector_.configure(detectorConfig());
+    detector_.prepare(sampleRate_, maxBlock);
   }
-  void reset() override { env_ = 0.0f; }
+  void reset() override { detector_.reset(); }
   void process(ProcessContext ctx, float* interleavedOut, uint32_t channels) override {
     // Generator-style not used; compressor is insert, so this is a no-op
     (void)ctx; (void)interleavedOut; (void)channels;
@@ -29,29 +30,40 @@ public:
     applySidechain(ctx, interleaved, interleaved, channels);
   }
 
+  // Silent main input and detector: the output is silence; the envelope releases toward zero
+  // exactly as applySidechain would step it
+  bool skipIfSilent(ProcessContext ctx) override {
+    detector_.releaseSilent(ctx.frames);
+    return true;
+  }
+
+  // Settings of the key analysis; consumers with equal settings and the same key may share a detector
+  virtual SidechainDetector::Config detectorConfig() const {
+    SidechainDetector::Config c;
+    c.attackMs = attackMs; c.releaseMs = releaseMs;
+    return c;
+  }
+
+  // Analyse the key with the node's own detector, then apply the gain
   virtual void applySidechain(ProcessContext ctx, float* mainInterleaved, const float* scInterleaved, uint32_t channels) {
+    if (channels == 0 || ctx.frames == 0) return;
+    detector_.analyse(scInterleaved, ctx.frames, channels);
+    applyDetected(ctx, mainInterleaved, detector_, 0, channels);
+  }
+
+  // Apply the gain from envelopes already analysed by `det` (its frames [offset, offset + frames))
+  virtual void applyDetected(ProcessContext ctx, float* mainInterleaved, const SidechainDetector& det, uint32_t offset, uint32_t channels) {
     const uint32_t frames = ctx.frames;
     const float thrLin = std::pow(10.0f, thresholdDb / 20.0f);
     const float makeupLin = std::pow(10.0f, makeupDb / 20.0f);
     if (channels == 0 || frames == 0) return;
+    const float* envs = det.envelope(0) + offset;
     for (uint32_t i = 0; i < frames; ++i) {
-      // detector: mono from sidechain by averaging
-      float sc = 0.0f;
-      if (channels == 1) {
-        sc = std::fabs(scInterleaved[i]);
-      } else {
-        const float L = scInterleaved[2 * static_cast<size_t>(i)];
-        const float R = scInterleaved[2 * static_cast<size_t>(i) + 1];
-        sc = 0.5f * (std::fabs(L) + std::fabs(R));
-      }
-      // envelope follower
-      const float target = sc;
-      const float coef = (target > env_) ? attackCoef_ : releaseCoef_;
-      env_ = target + coef * (env_ - target);
+      const float env = envs[i];
       // static curve
       float gain = 1.0f;
-      if (env_ > thrLin && ratio > 1.0f) {
-        const float envDb = 20.0f * std::log10(std::max(env_, 1e-8f));
+      if (env > thrLin && ratio > 1.0f) {
+        const float envDb = 20.0f * std::log10(std::max(env, 1e-8f));
         const float over = envDb - thresholdDb;
         const float grDb = -over * (1.0f - 1.0f / ratio);
         gain = std::pow(10.0f, grDb / 20.0f);
@@ -66,23 +78,22 @@ public:
     }
   }
 
+  bool hashState(StateHash& h) const override {
+    h.add(thresholdDb, ratio, attackMs, releaseMs, makeupDb);
+    detector_.hashState(h);
+    return true;
+  }
+  size_t memoryBytes() const override { return detector_.memoryBytes(); }
+
   void setParams(float thrDb, float rat, float attMs, float relMs, float mkDb) {
     thresholdDb = thrDb; ratio = std::max(1.0f, rat);
-    attackMs = std::max(0.1f, attMs); releaseMs = std::max(0.1f, relMs); makeupDb = mkDb; updateCoefs();
+    attackMs = std::max(0.1f, attMs); releaseMs = std::max(0.1f, relMs); makeupDb = mkDb;
+    detector_.configure(detectorConfig());
   }
 
 protected:
-  void updateCoefs() {
-    const float attT = std::max(0.0001f, attackMs / 1000.0f);
-    const float relT = std::max(0.0001f, releaseMs / 1000.0f);
-    attackCoef_ = std::exp(-1.0f / static_cast<float>(sampleRate_ * attT));
-    releaseCoef_ = std::exp(-1.0f / static_cast<float>(sampleRate_ * relT));
-  }
-
   double sampleRate_ = 48000.0;
-  float env_ = 0.0f;
-  float attackCoef_ = 0.0f;
-  float releaseCoef_ = 0.0f;
+  SidechainDetector detector_{};
 };
 
 
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "MemoryAccounting.hpp"
 #include "Node.hpp"
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 // Simple interleaved feedback delay as an insert effect
 class DelayNode final : public Node {
@@ -17,11 +20,21 @@ public:
     const size_t need = static_cast<size_t>(std::max<uint32_t>(1, delaySamples_)) * 2u;
     if (delay_.size() < need) delay_.assign(need, 0.0f);
     writeIndex_ = 0;
+    zeroRun_ = kClean;
   }
 
   void reset() override {
     std::fill(delay_.begin(), delay_.end(), 0.0f);
     writeIndex_ = 0;
+    zeroRun_ = kClean;
+  }
+
+  // Silent input into an all-zero line: the output is silence and the line stays zero (the write
+  // position of an all-zero line is irrelevant, so it is left where it is)
+  bool skipIfSilent(ProcessContext ctx) override {
+    if (zeroRun_ < delaySamples_) return false;
+    zeroRun_ = std::min<uint64_t>(zeroRun_ + ctx.frames, kClean);
+    return true;
   }
 
   void process(ProcessContext /*ctx*/, float* interleavedOut, uint32_t /*channels*/) override {
@@ -38,6 +51,7 @@ public:
     const float mixAmt = std::clamp(mix, 0.0f, 1.0f);
     const float dryAmt = 1.0f - mixAmt;
     for (uint32_t n = 0; n < frames; ++n) {
+      bool wrote = false;
       for (uint32_t ch = 0; ch < channels; ++ch) {
         const size_t delayLen = delay_.size() / channels;
         const size_t readIndex = (writeIndex_ + delayLen - delaySamples_) % delayLen;
@@ -47,11 +61,31 @@ public:
         const float input = sample;
         // wet/dry mix
         sample = input * dryAmt + delayed * mixAmt;
-        // write new value into delay line with feedback
-        line[writeIndex_] = input + delayed * fb;
+        // write new value into delay line with feedback; flush the feedback tail below -300 dBFS
+        // so the line reaches exact zero instead of recirculating denormals
+        float w = input + delayed * fb;
+        if (std::fabs(w) < 1e-15f) w = 0.0f;
+        line[writeIndex_] = w;
+        wrote = wrote || w != 0.0f;
       }
       writeIndex_ = (writeIndex_ + 1) % (delay_.size() / channels);
+      zeroRun_ = wrote ? 0 : std::min<uint64_t>(zeroRun_ + 1, kClean);
+    }
+  }
+
+  // The line is hashed from the write position on, so the same contents at another offset match
+  bool hashState(StateHash& h) const override {
+    h.add(delayMs, feedback, mix, delaySamples_);
+    if (zeroRun_ >= delaySamples_ || delay_.empty()) { h.add(true); return true; }
+    const size_t len = delaySamples_;
+    if (delay_.size() % len != 0 || writeIndex_ >= len) return false;
+    h.add(false, delay_.size());
+    for (size_t ch = 0; ch < delay_.size() / len; ++ch) {
+      const float* line = &delay_[len * ch];
+      h.floats(line + writeIndex_, len - writeIndex_);
+      h.floats(line, writeIndex_);
     }
+    return true;
   }
 
   // Parameters
@@ -70,13 +104,16 @@ private:
   uint32_t delaySamples_ = 1;
   std::vector<float> delay_{}; // interleaved per channel sections
   size_t writeIndex_ = 0;      // per channel shared index
+  static constexpr uint64_t kClean = UINT64_MAX / 2;
+  uint64_t zeroRun_ = kClean;  // frames since the last non-zero write; >= line length means all zero
 
   void ensureBuffer(uint32_t channels) {
     const size_t need = static_cast<size_t>(std::max<uint32_t>(1, delaySamples_)) * channels;
-    if (delay_.size() != need) delay_.assign(need, 0.0f);
+    if (delay_.size() != need) { delay_.assign(need, 0.0f); zeroRun_ = kClean; }
     if (writeIndex_ >= (delay_.size() / channels)) writeIndex_ = 0;
   }
   uint32_t latencySamples() const override { return delaySamples_; }
+  size_t memoryBytes() const override { return vectorBytes(delay_); }
 };
 
 
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "StateHash.hpp"
+
+// Linear gain ramp rendered per sample. State advances one sample at a time, so the result
+// does not depend on how a render is split into blocks.
+struct GainRamp {
+  float value = 1.0f;
+  float target = 1.0f;
+  float step = 0.0f;
+  uint32_t remaining = 0;
+
+  void setImmediate(float g) { value = target = g; step = 0.0f; remaining = 0; }
+  void rampTo(float g, double rampMs, double sampleRate) {
+    const double samples = std::floor(std::max(0.0, rampMs) * 0.001 * sampleRate + 0.5);
+    if (samples < 1.0) { setImmediate(g); return; }
+    target = g;
+    remaining = static_cast<uint32_t>(std::min(samples, 4294967295.0));
+    step = static_cast<float>((static_cast<double>(g) - static_cast<double>(value)) / samples);
+  }
+  bool steady() const { return remaining == 0; }
+  void hashState(StateHash& h) const { h.add(value, target, step, remaining); }
+  // Write frames gains to out and advance
+  void render(float* out, uint32_t frames) {
+    uint32_t i = 0;
+    for (; i < frames && remaining > 0; ++i) {
+      value += step;
+      if (--remaining == 0) value = target;
+      out[i] = value;
+    }
+    for (; i < frames; ++i) out[i] = value;
+  }
+};
+
+// In-place dst[i] *= gains[i]; written to auto-vectorise
+inline void multiplyGains(float* dst, const float* gains, uint32_t frames) {
+  for (uint32_t i = 0; i < frames; ++i) dst[i] *= gains[i];
+}
@@ -1,15 +1,22 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <memory>
 #include <functional>
 #include <string>
+#include <string_view>
 #include "Node.hpp"
 #include "MixerNode.hpp"
 #include "DelayNode.hpp"
 #include "MeterNode.hpp"
 #include "CompressorNode.hpp"
+#include "WiretapNode.hpp"
+#include "SidechainDetector.hpp"
+#include "PerfCounters.hpp"
+#include "MemoryAccounting.hpp"
 #include "GraphConfig.hpp"
+#include "KernelBatch.hpp"
 #include <unordered_map>
 #include <unordered_set>
 #include <chrono>
@@ -26,11 +33,18 @@ public:
     if (mixer_) {
       for (const auto& ch : mixer_->channels()) mixerInputIds_.insert(ch.id);
     }
+    topoDirty_ = true;
   }
   void setConnections(const std::vector<GraphSpec::Connection>& conns) {
     connections_ = conns;
     topoDirty_ = true;
   }
+  // Automation lanes (see AutomationLane); lanes for unknown node ids are ignored
+  void setAutomation(std::vector<AutomationLane> lanes) {
+    automation_ = std::move(lanes);
+    topoDirty_ = true;
+  }
+  const std::vector<AutomationLane>& automation() const { return automation_; }
   // Optional: provide per-node port descriptors parsed from JSON for validation/adaptation
   void setPortDescriptors(const std::vector<NodeSpec>& nodeSpecs) {
     inPortChannels_.clear(); outPortChannels_.clear(); idToIndex_.clear();
@@ -42,6 +56,12 @@ public:
       for (const auto& ip : ns.ports.inputs) inPortChannels_[idx][ip.index] = ip.channels;
       for (const auto& op : ns.ports.outputs) outPortChannels_[idx][op.index] = op.channels;
     }
+    topoDirty_ = true;
+  }
+
+  // Key every node's random stream from seed + (scope + node id); call after all nodes are added
+  void setRandomSeed(uint64_t seed, const std::string& scope = std::string()) {
+    for (auto& e : nodes_) e.node->setRandomKey(deriveRngKey(seed, scope + e.id));
   }
 
   // Iterate nodes with their ids (read-only access to Node&). Not realtime-safe to mutate graph.
@@ -53,6 +73,12 @@ public:
   size_t nodeCount() const { return nodes_.size(); }
   const std::string& nodeIdAt(size_t idx) const { return nodes_[idx].id; }
   Node* nodeAt(size_t idx) { return nodes_[idx].node.get(); }
+  // Node with the given id, or nullptr. Looks up the index built with the topology, so it does
+  // not allocate once the graph is prepared (realtime latches use it per event)
+  Node* findNode(std::string_view id) {
+    auto it = nodeIndexById_.find(id);
+    return it != nodeIndexById_.end() ? nodes_[it->second].node.get() : nullptr;
+  }
   void ensureTopology() { if (topoDirty_ || (topoOrder_.empty() && insertionOrder_.empty())) rebuildTopology(); }
   struct EdgeInfo { size_t fromIndex; float gain; uint32_t fromPort; uint32_t toPort; };
   void getUpstreamEdgeInfos(size_t nodeIndex, std::vector<EdgeInfo>& out) const {
@@ -83,7 +109,14 @@ public:
                       uint32_t frames, uint32_t graphCh,
                       uint32_t srcDeclared, uint32_t dstDeclared,
                       float gain) {
-    adaptAndAccumulate(src, dst, frames, graphCh, srcDeclared, dstDeclared, gain);
+    adaptAndAccumulate(src, dst.data(), frames, graphCh, srcDeclared, dstDeclared, gain);
+  }
+  // Raw-buffer form; overwrite writes the first contribution instead of adding to a cleared buffer
+  void accumulateEdge(const float* src, float* dst,
+                      uint32_t frames, uint32_t graphCh,
+                      uint32_t srcDeclared, uint32_t dstDeclared,
+                      float gain, bool overwrite) {
+    adaptAndAccumulate(src, dst, frames, graphCh, srcDeclared, dstDeclared, gain, overwrite);
   }
   bool hasMixer() const { return static_cast<bool>(mixer_); }
   float mixerMasterGain() const { return mixer_ ? mixer_->masterGain() : 1.0f; }
@@ -96,87 +129,215 @@ public:
 
   void prepare(double sampleRate, uint32_t maxBlock) {
     for (auto& e : nodes_) e.node->prepare(sampleRate, maxBlock);
+    sampleRate_ = sampleRate; maxBlock_ = maxBlock;
+    for (auto& d : detectors_) d->prepare(sampleRate, maxBlock);
     if (statsEnabled_) initStats();
     if (traceEnabled_ && traceEpoch_ == std::chrono::steady_clock::time_point{}) {
       traceEpoch_ = std::chrono::steady_clock::now();
     }
   }
 
+  // Realtime: give every node buffer and the sidechain scratch capacity for maxBlock_ frames up
+  // front, so blocks of any size up to the prepared maximum never allocate on the audio thread
+  void reserveBuffers(uint32_t channels) {
+    ensureNodeBuffers();
+    const size_t total = static_cast<size_t>(maxBlock_) * channels;
+    for (auto& b : outBuffers_) b.reserve(total);
+    scWork_.reserve(total);
+    zeros_.reserve(total);
+  }
+
   void reset() {
     for (auto& e : nodes_) e.node->reset();
+    for (auto& d : detectors_) d->reset();
+    for (auto& st : laneStates_) { st.cursor = 0; st.sent = false; }
+  }
+
+  // Lane batching (--simd-lanes): generators with a batch kernel render together through it,
+  // grouped with the other nodes of their kernel (see KernelBatch.hpp). Same output bits.
+  void setLaneBatching(bool on) { laneBatching_ = on; }
+
+  // First half of process(): topology, buffers, event routing and automation for the block.
+  // Lockstep renderers call beginBlock and collectBatchLanes on several graphs, render all their
+  // lanes (renderBatchLanes), then process() each graph with the same ctx.
+  void beginBlock(const ProcessContext& ctx) {
+    ensureNodeBuffers();
+    ++blockSerial_;
+    if (ctx.eventCount > 0) routeEvents(ctx);
+    if (!laneStates_.empty()) applyAutomation(ctx.blockStart, ctx.frames, ctx.sampleRate);
+    blockEvents_ = ctx.eventCount > 0; // nodeEvents_ is only routed (and current) then
+    blockCtx_ = ctx; blockCtx_.events = nullptr; blockCtx_.eventCount = 0;
+    blockBegun_ = true;
+  }
+
+  // Append this block's generators that have a batch kernel, with zeroed buffers; process()
+  // then takes their results instead of running them. None while per-node CPU, trace or perf
+  // counters attribute time to nodes.
+  void collectBatchLanes(std::vector<BatchLane>& lanes, uint32_t channels) {
+    if (!blockBegun_ || cpuStatsEnabled_ || traceEnabled_ || perfEnabled_) return;
+    const size_t total = static_cast<size_t>(blockCtx_.frames) * channels;
+    if (batched_.size() != nodes_.size()) { batched_.assign(nodes_.size(), 0u); batchResults_.assign(nodes_.size(), BatchResult{}); }
+    for (size_t ni = 0; ni < nodes_.size(); ++ni) {
+      if (kinds_[ni] != NodeKind::Generator) continue;
+      Node* node = nodes_[ni].node.get();
+      const BatchKernel* kernel = node->batchKernel();
+      if (!kernel) continue;
+      auto& out = outBuffers_[ni];
+      BufferMeta& meta = meta_[ni];
+      if (out.size() != total) { out.assign(total, 0.0f); meta.zero = true; }
+      if (!meta.zero) { std::fill(out.begin(), out.end(), 0.0f); meta.zero = true; }
+      BatchLane lane;
+      lane.node = node; lane.kernel = kernel; lane.ctx = blockCtx_;
+      if (blockEvents_ && !nodeEvents_[ni].empty()) {
+        lane.ctx.events = nodeEvents_[ni].data();
+        lane.ctx.eventCount = static_cast<uint32_t>(nodeEvents_[ni].size());
+      }
+      lane.out = out.data(); lane.idleSkip = idleSkip_; lane.result = &batchResults_[ni];
+      lanes.push_back(lane);
+      batched_[ni] = 1u;
+    }
   }
 
   void process(ProcessContext ctx, float* interleavedOut, uint32_t channels) {
     if (nodes_.empty()) return;
     const auto tBlockStart = cpuStatsEnabled_ ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
-    if (topoDirty_ || (topoOrder_.empty() && insertionOrder_.empty())) rebuildTopology();
+    if (!blockBegun_) {
+      beginBlock(ctx);
+      if (laneBatching_) {
+        batchLanes_.clear();
+        collectBatchLanes(batchLanes_, channels);
+        renderBatchLanes(batchLanes_.data(), batchLanes_.size(), channels);
+      }
+    }
+    blockBegun_ = false;
     const size_t total = static_cast<size_t>(ctx.frames) * channels;
-    if (outBuffers_.size() != nodes_.size()) outBuffers_.assign(nodes_.size(), std::vector<float>());
-    if (work_.size() != total) work_.assign(total, 0.0f);
+
+    // Hardware counters of the thread rendering this block (opened on its first block)
+    const PerfCounters* perf = perfEnabled_ ? &PerfCounters::forThisThread() : nullptr;
+    if (perf && !perf->available()) perf = nullptr;
+    if (perf && nodePerf_.size() != nodes_.size()) nodePerf_.resize(nodes_.size());
 
     // Process nodes by topo order; if empty, fall back to insertion order
     const std::vector<size_t>& order = topoOrder_.empty() ? insertionOrder_ : topoOrder_;
-    // Prepare buffers
-    for (size_t idx = 0; idx < nodes_.size(); ++idx) {
-      auto& buf = outBuffers_[idx];
-      if (buf.size() != total) buf.assign(total, 0.0f); else std::fill(buf.begin(), buf.end(), 0.0f);
-    }
-
     for (size_t ni : order) {
       const auto tNodeStart = (cpuStatsEnabled_ || traceEnabled_) ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
-      // Sum upstream edges into work_, honoring toPort (future multi-port semantics)
-      std::fill(work_.begin(), work_.end(), 0.0f);
-      auto upIt = upstream_.find(ni);
-      // Optional: collect per-port sums
-      std::unordered_map<uint32_t, std::vector<float>> portSums;
-      if (upIt != upstream_.end()) {
-        for (const auto& u : upIt->second) {
-          const auto& src = outBuffers_[u.fromIndex];
-          const float g = u.gain;
-          auto& buf = portSums[u.toPort];
-          if (buf.size() != total) buf.assign(total, 0.0f);
-          // Generalized channel adaptation N<->M using declared port channel counts
-          const uint32_t srcDeclared = (outPortChannels_.count(u.fromIndex) && outPortChannels_[u.fromIndex].count(u.fromPort))
-                                        ? outPortChannels_[u.fromIndex][u.fromPort] : 0u;
-          const uint32_t dstDeclared = (inPortChannels_.count(ni) && inPortChannels_[ni].count(u.toPort))
-                                        ? inPortChannels_[ni][u.toPort] : 0u;
-          adaptAndAccumulate(src.data(), buf, static_cast<uint32_t>(ctx.frames), channels, srcDeclared, dstDeclared, g);
+      const PerfCounters::Sample perfStart = perf ? perf->read() : PerfCounters::Sample{};
+      auto& out = outBuffers_[ni];
+      BufferMeta& meta = meta_[ni];
+      if (!batched_.empty() && batched_[ni]) {
+        // Rendered by its batch kernel this block
+        batched_[ni] = 0u;
+        meta.block = blockSerial_;
+        const BatchResult& r = batchResults_[ni];
+        if (r.slept) {
+          nodeSkips_[ni] += 1u;
+          if (statsEnabled_ && ni < nodeAccums_.size()) nodeAccums_[ni].count += static_cast<uint64_t>(total);
+        } else {
+          meta.zero = !r.ran;
+          if (statsEnabled_) accumulateStats(ni, out.data(), ctx.frames, channels);
         }
+        continue;
       }
-      // Default mixing policy: only use port 0 as the node's main input.
-      // Additional ports (e.g., sidechain) are not mixed into the main input and are provided
-      // to port-aware nodes via portSums (e.g., CompressorNode reads port 1 separately).
-      if (!portSums.empty()) {
-        auto it0 = portSums.find(0u);
-        if (it0 != portSums.end()) work_ = it0->second; else std::fill(work_.begin(), work_.end(), 0.0f);
+      if (out.size() != total) { out.assign(total, 0.0f); meta.zero = true; }
+      const NodeKind kind = kinds_[ni];
+      // Inserts sum port 0 straight into their own buffer (the first edge overwrites, so no
+      // clear and no copy) and a compressor's port 1 into scWork_. Generators ignore inputs.
+      // Zero buffers and nodes not yet run this block contribute nothing.
+      bool haveMain = false, haveSc = false;
+      if (kind != NodeKind::Generator) {
+        auto upIt = upstream_.find(ni);
+        if (upIt != upstream_.end()) {
+          for (const auto& u : upIt->second) {
+            const BufferMeta& src = meta_[u.fromIndex];
+            if (src.zero || src.block != blockSerial_) continue;
+            if (u.toPort == 0u) {
+              adaptAndAccumulate(outBuffers_[u.fromIndex].data(), out.data(), ctx.frames, channels, u.srcDeclared, u.dstDeclared, u.gain, !haveMain);
+              countSum(total, !haveMain);
+              haveMain = true;
+            } else if (u.toPort == 1u && kind == NodeKind::Compressor) {
+              if (scWork_.size() != total) scWork_.assign(total, 0.0f);
+              adaptAndAccumulate(outBuffers_[u.fromIndex].data(), scWork_.data(), ctx.frames, channels, u.srcDeclared, u.dstDeclared, u.gain, !haveSc);
+              countSum(total, !haveSc);
+              haveSc = true;
+            }
+          }
+        }
       }
+      // A buffer the node may not fully overwrite starts from zero (cleared only if it isn't already)
+      if (!haveMain && !meta.zero) { std::fill(out.begin(), out.end(), 0.0f); meta.zero = true; countClear(total); }
+      meta.block = blockSerial_;
       Node* node = nodes_[ni].node.get();
-      if (auto* d = dynamic_cast<DelayNode*>(node)) {
-        // process effect in-place over summed input
-        // copy work_ into node out buffer, then process in place
-        auto& out = outBuffers_[ni];
-        std::copy(work_.begin(), work_.end(), out.begin());
-        d->processInPlace(ctx, out.data(), channels);
-        if (statsEnabled_) accumulateStats(ni, out.data(), ctx.frames, channels);
-      } else if (auto* c = dynamic_cast<CompressorNode*>(node)) {
-        // If sidechain is provided on port 1, use it; else self-detect
-        auto& out = outBuffers_[ni];
-        std::copy(work_.begin(), work_.end(), out.begin());
-        scWork_.assign(total, 0.0f);
-        auto itSC = portSums.find(1u);
-        if (itSC != portSums.end()) scWork_ = itSC->second;
-        c->applySidechain(ctx, out.data(), scWork_.data(), channels);
-        if (statsEnabled_) accumulateStats(ni, out.data(), ctx.frames, channels);
-      } else if (auto* m = dynamic_cast<MeterNode*>(node)) {
-        // pass-through input to output
-        auto& out = outBuffers_[ni];
-        std::copy(work_.begin(), work_.end(), out.begin());
-        m->updateFromBuffer(out.data(), ctx.frames, channels);
-        if (statsEnabled_) accumulateStats(ni, out.data(), ctx.frames, channels);
+      // The node's own event span (if any): only nodes with events split their block
+      ProcessContext nctx = ctx; nctx.events = nullptr; nctx.eventCount = 0;
+      if (ctx.eventCount > 0 && !nodeEvents_[ni].empty()) {
+        nctx.events = nodeEvents_[ni].data();
+        nctx.eventCount = static_cast<uint32_t>(nodeEvents_[ni].size());
+      }
+      // Sleep: a node whose inputs are all silent (generators: always) may report that this block
+      // would be silent too; its buffer then stays zero and downstream sums skip it
+      // A compressor sharing its group's detector: the group's first member this block analyses the key
+      SidechainDetector* shared = (kind == NodeKind::Compressor && sharedDetector_[ni] >= 0) ? detectors_[static_cast<size_t>(sharedDetector_[ni])].get() : nullptr;
+      if (shared && shared->serial != blockSerial_) {
+        if (!haveSc && zeros_.size() < total) zeros_.assign(total, 0.0f);
+        shared->analyse(haveSc ? scWork_.data() : zeros_.data(), ctx.frames, channels);
+        shared->serial = blockSerial_;
+      }
+      bool silent = false;
+      if (idleSkip_ && !haveMain && !haveSc && nctx.eventCount == 0) silent = (kind == NodeKind::Meter) || (kind == NodeKind::Tap) || node->skipIfSilent(nctx);
+      if (silent) {
+        if (kind == NodeKind::Meter) static_cast<MeterNode*>(node)->updateFromBuffer(out.data(), ctx.frames, channels);
+        if (kind == NodeKind::Tap) static_cast<WiretapNode*>(node)->processInPlace(ctx, out.data(), channels); // records the silence
+        nodeSkips_[ni] += 1u;
+        if (statsEnabled_ && ni < nodeAccums_.size()) nodeAccums_[ni].count += static_cast<uint64_t>(total);
       } else {
-        // generator/process node writes its own output (ignores inputs)
-        node->process(ctx, outBuffers_[ni].data(), channels);
-        if (statsEnabled_) accumulateStats(ni, outBuffers_[ni].data(), ctx.frames, channels);
+        if (kind == NodeKind::Compressor && !haveSc && zeros_.size() < total) zeros_.assign(total, 0.0f);
+        auto dispatch = [&](ProcessContext c, uint32_t off) {
+          const size_t at = static_cast<size_t>(off) * channels;
+          switch (kind) {
+            case NodeKind::Delay:
+              // process effect in-place over the summed input
+              static_cast<DelayNode*>(node)->processInPlace(c, out.data() + at, channels);
+              break;
+            case NodeKind::Compressor:
+              // Sidechain from port 1 when connected; otherwise the detector sees silence
+              if (shared) static_cast<CompressorNode*>(node)->applyDetected(c, out.data() + at, *shared, off, channels);
+              else static_cast<CompressorNode*>(node)->applySidechain(c, out.data() + at, (haveSc ? scWork_.data() : zeros_.data()) + at, channels);
+              break;
+            case NodeKind::Meter:
+              // pass-through input to output
+              static_cast<MeterNode*>(node)->updateFromBuffer(out.data() + at, c.frames, channels);
+              break;
+            case NodeKind::Tap:
+              // records and passes its input through
+              static_cast<WiretapNode*>(node)->processInPlace(c, out.data() + at, channels);
+              break;
+            default:
+              // generator/process node writes its own output (ignores inputs)
+              node->process(c, out.data() + at, channels);
+              break;
+          }
+        };
+        bool ran = true;
+        if (nctx.eventCount == 0) {
+          dispatch(nctx, 0);
+        } else {
+          // Generators may still sleep through the runs between their events
+          ran = false;
+          runWithEvents(*node, nctx, [&](ProcessContext sub, uint32_t off) {
+            if (idleSkip_ && kind == NodeKind::Generator && node->skipIfSilent(sub)) return;
+            dispatch(sub, off);
+            ran = true;
+          });
+        }
+        meta.zero = !ran || ((kind == NodeKind::Meter || kind == NodeKind::Tap) && !haveMain);
+        if (statsEnabled_) accumulateStats(ni, out.data(), ctx.frames, channels);
+      }
+      PerfCounters::Sample perfDelta{};
+      if (perf) {
+        perfDelta = perf->read() - perfStart;
+        NodePerf& np = nodePerf_[ni];
+        for (uint32_t e = 0; e < PerfCounters::kEventCount; ++e) np.counts.v[e] += perfDelta.v[e];
+        np.frames += ctx.frames;
       }
       if (cpuStatsEnabled_ || traceEnabled_) {
         const auto tNodeEnd = std::chrono::steady_clock::now();
@@ -195,45 +356,28 @@ public:
           const double ts_us = static_cast<double>(
             std::chrono::duration_cast<std::chrono::microseconds>(tNodeStart - traceEpoch_).count());
           const double dur_us = ns / 1000.0;
-          trace_.push_back(TraceEvt{nodes_[ni].id, ts_us, dur_us});
+          trace_.push_back(TraceEvt{nodes_[ni].id, ts_us, dur_us, perf != nullptr, perfDelta});
         }
       }
     }
 
-    // Mix sinks to interleavedOut
-    for (size_t i = 0; i < total; ++i) interleavedOut[i] = 0.0f;
-    // Apply dry sends from connections
-    if (!connections_.empty()) {
-      std::unordered_map<std::string,size_t> idToIdx;
-      idToIdx.reserve(nodes_.size());
-      for (size_t i = 0; i < nodes_.size(); ++i) idToIdx.emplace(nodes_[i].id, i);
-      for (const auto& e : connections_) {
-        auto itF = idToIdx.find(e.from);
-        if (itF == idToIdx.end()) continue;
-        // Prevent double-count: if a source is explicitly mixed via mixer inputs,
-        // suppress its dry sends to the final mix.
-        if (!mixerInputIds_.empty()) {
-          const std::string& fromId = nodes_[itF->second].id;
-          if (mixerInputIds_.count(fromId)) continue;
-        }
-        const float dry = e.dryPercent * (1.0f/100.0f);
-        if (dry <= 0.0f) continue;
-        const auto& src = outBuffers_[itF->second];
-        for (size_t i = 0; i < total; ++i) interleavedOut[i] += src[i] * dry;
-      }
+    // Mix dry sends, then sinks / mixer inputs, to interleavedOut; the first contribution
+    // overwrites, so the output is only cleared when nothing sounds
+    bool first = true;
+    for (const auto& s : drySends_) {
+      if (meta_[s.index].zero) continue;
+      countSum(total, first);
+      mixInto(interleavedOut, outBuffers_[s.index].data(), total, s.gain, first);
     }
     for (size_t idx = 0; idx < nodes_.size(); ++idx) {
-      const bool isSink = (downstream_.find(idx) == downstream_.end());
-      float gain = 0.0f;
-      if (mixer_) {
-        for (const auto& ch : mixer_->channels()) if (ch.id == nodes_[idx].id) { gain = ch.gain; break; }
-      }
-      if (gain == 0.0f && isSink) gain = 1.0f;
-      if (gain == 0.0f) continue;
-      const auto& src = outBuffers_[idx];
-      for (size_t i = 0; i < total; ++i) interleavedOut[i] += src[i] * gain;
+      const float gain = mixGains_[idx];
+      if (gain == 0.0f || meta_[idx].zero) continue;
+      countSum(total, first);
+      mixInto(interleavedOut, outBuffers_[idx].data(), total, gain, first);
     }
+    if (first) { std::fill(interleavedOut, interleavedOut + total, 0.0f); countClear(total); }
     if (mixer_) mixer_->process(ctx, interleavedOut, channels);
+    if (memTracking_) memPeak_ = std::max(memPeak_, memoryBytes());
     if (cpuStatsEnabled_) {
       const auto tBlockEnd = std::chrono::steady_clock::now();
       const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(tBlockEnd - tBlockStart).count());
@@ -257,10 +401,40 @@ private:
   std::vector<float> temp_{};
   std::vector<GraphSpec::Connection> connections_{};
   std::vector<std::vector<float>> outBuffers_{};
-  std::vector<float> work_{};
   std::vector<float> scWork_{};
+  std::vector<float> zeros_{};
+  // Metadata carried alongside each node buffer: zero = every sample is 0 (the node skipped,
+  // or a meter saw no input); block = serial of the last block that wrote it
+  struct BufferMeta { bool zero = true; uint64_t block = 0; };
+  std::vector<BufferMeta> meta_{};
+  uint64_t blockSerial_ = 0;
+  bool idleSkip_ = true;
+  // Lane batching: the block begun by beginBlock, and per node whether its kernel rendered it
+  bool laneBatching_ = false;
+  bool blockBegun_ = false;
+  bool blockEvents_ = false;
+  ProcessContext blockCtx_{};
+  std::vector<uint8_t> batched_{};
+  std::vector<BatchResult> batchResults_{};
+  std::vector<BatchLane> batchLanes_{};
+  std::vector<uint64_t> nodeSkips_{};
+  // Resolved once per topology rebuild instead of per block
+  enum class NodeKind : uint8_t { Generator, Delay, Compressor, Meter, Tap };
+  std::vector<NodeKind> kinds_{};
+  std::vector<float> mixGains_{};               // sink / mixer-input gain per node (0 = not mixed)
+  struct DrySend { size_t index; float gain; };
+  std::vector<DrySend> drySends_{};
+  std::unordered_map<std::string_view, size_t> nodeIndexById_{};
+  std::vector<std::vector<Command>> nodeEvents_{};
+  std::vector<AutomationLane> automation_{};
+  struct LaneState { size_t lane; size_t node; size_t cursor; float last; bool sent; };
+  std::vector<LaneState> laneStates_{}; // lanes whose node exists
+  std::vector<std::unique_ptr<SidechainDetector>> detectors_{}; // shared by compressor groups
+  std::vector<int32_t> sharedDetector_{};                       // per node: index into detectors_ or -1
+  double sampleRate_ = 48000.0;
+  uint32_t maxBlock_ = 1024;
 
-  struct UpEdge { size_t fromIndex; float gain; uint32_t fromPort; uint32_t toPort; };
+  struct UpEdge { size_t fromIndex; float gain; uint32_t fromPort; uint32_t toPort; uint32_t srcDeclared; uint32_t dstDeclared; };
   std::unordered_map<size_t, std::vector<UpEdge>> upstream_{};
   std::unordered_map<size_t, std::vector<size_t>> downstream_{};
   std::vector<size_t> topoOrder_{};
@@ -279,12 +453,24 @@ private:
   // CPU stats
   bool cpuStatsEnabled_ = false;
   long double cpuNsSum_ = 0.0L; double cpuNsMax_ = 0.0; double cpuPctSum_ = 0.0; double cpuPctMax_ = 0.0; uint64_t cpuBlocks_ = 0; uint64_t cpuOverruns_ = 0;
+  // Bytes the graph itself moves between node buffers (clears, edge sums, output mix), not node DSP
+  uint64_t bufferBytes_ = 0;
+  void countClear(size_t floats) { if (cpuStatsEnabled_) bufferBytes_ += floats * sizeof(float); }
+  // An overwriting sum reads src and writes dst; an accumulating one also reads dst
+  void countSum(size_t floats, bool overwrite) { if (cpuStatsEnabled_) bufferBytes_ += floats * sizeof(float) * (overwrite ? 2u : 3u); }
   std::vector<long double> nodeNsSum_{}; std::vector<double> nodeNsMax_{}; std::vector<uint64_t> nodeCalls_{};
+  // Largest memoryBytes() seen after a block (enableMemoryTracking)
+  bool memTracking_ = false;
+  size_t memPeak_ = 0;
+  // Hardware counter deltas per node (enablePerfCounters)
+  bool perfEnabled_ = false;
+  struct NodePerf { PerfCounters::Sample counts; uint64_t frames = 0; };
+  std::vector<NodePerf> nodePerf_{};
 
   // Optional performance trace (Chrome trace JSON events)
   bool traceEnabled_ = false;
   std::string tracePath_{};
-  struct TraceEvt { std::string name; double ts_us; double dur_us; };
+  struct TraceEvt { std::string name; double ts_us; double dur_us; bool hasPerf; PerfCounters::Sample perf; };
   std::vector<TraceEvt> trace_{};
   std::chrono::steady_clock::time_point traceEpoch_{};
 
@@ -309,10 +495,19 @@ public:
   void enableCpuStats(bool on) {
     cpuStatsEnabled_ = on;
     if (on) {
-      cpuNsSum_ = 0.0L; cpuNsMax_ = 0.0; cpuPctSum_ = 0.0; cpuPctMax_ = 0.0; cpuBlocks_ = 0; cpuOverruns_ = 0;
+      cpuNsSum_ = 0.0L; cpuNsMax_ = 0.0; cpuPctSum_ = 0.0; cpuPctMax_ = 0.0; cpuBlocks_ = 0; cpuOverruns_ = 0; bufferBytes_ = 0;
       nodeNsSum_.assign(nodes_.size(), 0.0L); nodeNsMax_.assign(nodes_.size(), 0.0); nodeCalls_.assign(nodes_.size(), 0u);
+      nodeSkips_.assign(nodes_.size(), 0u);
     }
   }
+  // Attribute hardware counter deltas (cycles, instructions, cache and branch misses) to each
+  // node's process call. Returns false when the calling thread can't open perf counters; render
+  // threads without counters then skip the attribution.
+  bool enablePerfCounters(bool on) {
+    perfEnabled_ = on;
+    nodePerf_.assign(nodes_.size(), NodePerf{});
+    return !on || PerfCounters::forThisThread().available();
+  }
   void enableTrace(const char* path) {
     if (path && *path) { traceEnabled_ = true; tracePath_ = path; trace_.clear(); traceEpoch_ = std::chrono::steady_clock::time_point{}; }
   }
@@ -323,9 +518,13 @@ public:
     std::fprintf(f, "{\n  \"traceEvents\": [\n");
     for (size_t i = 0; i < trace_.size(); ++i) {
       const auto& e = trace_[i];
-      std::fprintf(f,
-        "    {\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}%s\n",
-        e.name.c_str(), e.ts_us, e.dur_us, (i + 1 < trace_.size()) ? "," : "");
+      std::fprintf(f, "    {\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1", e.name.c_str(), e.ts_us, e.dur_us);
+      if (e.hasPerf) {
+        std::fprintf(f, ",\"args\":{\"cycles\":%llu,\"instructions\":%llu,\"cacheMisses\":%llu,\"branchMisses\":%llu}",
+          static_cast<unsigned long long>(e.perf.v[PerfCounters::Cycles]), static_cast<unsigned long long>(e.perf.v[PerfCounters::Instructions]),
+          static_cast<unsigned long long>(e.perf.v[PerfCounters::CacheMisses]), static_cast<unsigned long long>(e.perf.v[PerfCounters::BranchMisses]));
+      }
+      std::fprintf(f, "}%s\n", (i + 1 < trace_.size()) ? "," : "");
     }
     std::fprintf(f, "  ]\n}\n");
     std::fclose(f);
@@ -347,24 +546,105 @@ public:
     return out;
   }
 
-  struct CpuSummary { double avgMs; double maxMs; double avgPercent; double maxPercent; uint64_t blocks; uint64_t overruns; };
+  // bufferKB: graph buffer traffic per block; bufferGBps: that traffic over the blocks' wall time
+  struct CpuSummary { double avgMs; double maxMs; double avgPercent; double maxPercent; uint64_t blocks; uint64_t overruns; double bufferKB; double bufferGBps; };
   CpuSummary getCpuSummary() const {
     const double avgNs = (cpuBlocks_ > 0) ? static_cast<double>(cpuNsSum_ / static_cast<long double>(cpuBlocks_)) : 0.0;
     const double avgPct = (cpuBlocks_ > 0) ? (cpuPctSum_ / static_cast<double>(cpuBlocks_)) : 0.0;
-    return CpuSummary{ avgNs / 1e6, cpuNsMax_ / 1e6, avgPct, cpuPctMax_, cpuBlocks_, cpuOverruns_ };
+    const double bytes = static_cast<double>(bufferBytes_);
+    const double kb = (cpuBlocks_ > 0) ? bytes / 1024.0 / static_cast<double>(cpuBlocks_) : 0.0;
+    const double gbps = (cpuNsSum_ > 0.0L) ? bytes / static_cast<double>(cpuNsSum_) : 0.0;
+    return CpuSummary{ avgNs / 1e6, cpuNsMax_ / 1e6, avgPct, cpuPctMax_, cpuBlocks_, cpuOverruns_, kb, gbps };
   }
-  struct NodeCpu { std::string id; double avgUs; double maxUs; };
+  // Idle skipping is on by default; turning it off processes every node every block (A/B checks)
+  void setIdleSkip(bool on) { idleSkip_ = on; }
+  // Realtime renderers: wiretaps drop blocks instead of waiting for their writer thread
+  void setRealtime(bool on) {
+    for (auto& e : nodes_) if (auto* w = dynamic_cast<WiretapNode*>(e.node.get())) w->setRealtime(on);
+  }
+  bool idleSkip() const { return idleSkip_; }
+  // Digest of all node state carried into the next block (loop convergence); false when any
+  // node can't report its state or automation lanes make the output depend on absolute time
+  bool hashState(StateHash& h) const {
+    if (!laneStates_.empty()) return false;
+    for (const auto& e : nodes_) if (!e.node->hashState(h)) return false;
+    for (const auto& d : detectors_) d->hashState(h);
+    return !mixer_ || mixer_->hashState(h);
+  }
+  struct NodeCpu { std::string id; double avgUs; double maxUs; double skippedPct; };
   std::vector<NodeCpu> getPerNodeCpu() const {
     std::vector<NodeCpu> v; v.reserve(nodes_.size());
     for (size_t i = 0; i < nodes_.size(); ++i) {
       const double avgNs = (nodeCalls_.size() > i && nodeCalls_[i] > 0)
         ? static_cast<double>(nodeNsSum_[i] / static_cast<long double>(nodeCalls_[i])) : 0.0;
       const double maxNs = (nodeNsMax_.size() > i) ? nodeNsMax_[i] : 0.0;
-      v.push_back(NodeCpu{nodes_[i].id, avgNs / 1e3, maxNs / 1e3});
+      const double skipped = (nodeCalls_.size() > i && nodeCalls_[i] > 0 && nodeSkips_.size() > i)
+        ? 100.0 * static_cast<double>(nodeSkips_[i]) / static_cast<double>(nodeCalls_[i]) : 0.0;
+      v.push_back(NodeCpu{nodes_[i].id, avgNs / 1e3, maxNs / 1e3, skipped});
     }
     return v;
   }
 
+  // Memory held by the graph for --mem-report: per node its own buffers (Node::memoryBytes) and
+  // its output buffer; graph scratch (sidechain sums, shared detectors), routed events and the
+  // trace. peakBytes is the largest total seen after a block while tracking is enabled.
+  struct NodeMemory { std::string id; size_t nodeBytes; size_t bufferBytes; };
+  struct MemoryReport { std::vector<NodeMemory> nodes; size_t scratchBytes = 0; size_t eventBytes = 0; size_t traceBytes = 0; size_t totalBytes = 0; size_t peakBytes = 0; };
+  void enableMemoryTracking(bool on) { memTracking_ = on; memPeak_ = 0; }
+  MemoryReport memoryReport() const {
+    MemoryReport r;
+    r.nodes.reserve(nodes_.size());
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      const size_t buf = i < outBuffers_.size() ? vectorBytes(outBuffers_[i]) : 0u;
+      r.nodes.push_back(NodeMemory{nodes_[i].id, nodes_[i].node->memoryBytes(), buf});
+      r.totalBytes += r.nodes.back().nodeBytes + buf;
+    }
+    r.scratchBytes = vectorBytes(scWork_) + vectorBytes(zeros_);
+    for (const auto& d : detectors_) r.scratchBytes += d->memoryBytes();
+    r.eventBytes = nestedVectorBytes(nodeEvents_);
+    r.traceBytes = vectorBytes(trace_);
+    r.totalBytes += r.scratchBytes + r.eventBytes + r.traceBytes;
+    r.peakBytes = std::max(memPeak_, r.totalBytes);
+    return r;
+  }
+  size_t memoryBytes() const {
+    size_t n = vectorBytes(scWork_) + vectorBytes(zeros_) + nestedVectorBytes(nodeEvents_) + vectorBytes(trace_);
+    for (const auto& e : nodes_) n += e.node->memoryBytes();
+    for (const auto& b : outBuffers_) n += vectorBytes(b);
+    for (const auto& d : detectors_) n += d->memoryBytes();
+    return n;
+  }
+
+  // Per node: instructions per cycle and cycles / misses per sample frame (enablePerfCounters)
+  struct NodePerfSummary { std::string id; double ipc; double cyclesPerSample; double cacheMissesPerSample; double branchMissesPerSample; };
+  // Empty when no block was counted
+  std::vector<NodePerfSummary> getPerNodePerf() const {
+    std::vector<NodePerfSummary> v;
+    if (std::none_of(nodePerf_.begin(), nodePerf_.end(), [](const NodePerf& p) { return p.frames > 0; })) return v;
+    v.reserve(nodes_.size());
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      const NodePerf p = i < nodePerf_.size() ? nodePerf_[i] : NodePerf{};
+      const double cycles = static_cast<double>(p.counts.v[PerfCounters::Cycles]);
+      const double frames = p.frames > 0 ? static_cast<double>(p.frames) : 1.0;
+      v.push_back(NodePerfSummary{nodes_[i].id,
+        cycles > 0.0 ? static_cast<double>(p.counts.v[PerfCounters::Instructions]) / cycles : 0.0,
+        cycles / frames,
+        static_cast<double>(p.counts.v[PerfCounters::CacheMisses]) / frames,
+        static_cast<double>(p.counts.v[PerfCounters::BranchMisses]) / frames});
+    }
+    return v;
+  }
+
+  // Topology and one output buffer (with its zero flag) per node
+  void ensureNodeBuffers() {
+    if (topoDirty_ || (topoOrder_.empty() && insertionOrder_.empty())) rebuildTopology();
+    if (outBuffers_.size() != nodes_.size() || meta_.size() != nodes_.size()) {
+      outBuffers_.assign(nodes_.size(), std::vector<float>());
+      meta_.assign(nodes_.size(), BufferMeta{});
+      nodeSkips_.assign(nodes_.size(), 0u);
+    }
+  }
+
   void rebuildTopology() {
     insertionOrder_.clear(); insertionOrder_.reserve(nodes_.size());
     for (size_t i = 0; i < nodes_.size(); ++i) insertionOrder_.push_back(i);
@@ -377,7 +657,9 @@ public:
       auto itF = idToIdx.find(e.from), itT = idToIdx.find(e.to);
       if (itF == idToIdx.end() || itT == idToIdx.end()) continue;
       const float g = e.gainPercent * (1.0f/100.0f);
-      upstream_[itT->second].push_back(UpEdge{itF->second, g, e.fromPort, e.toPort});
+      upstream_[itT->second].push_back(UpEdge{itF->second, g, e.fromPort, e.toPort,
+                                              declaredChannels(outPortChannels_, itF->second, e.fromPort),
+                                              declaredChannels(inPortChannels_, itT->second, e.toPort)});
       downstream_[itF->second].push_back(itT->second);
       indeg[itT->second]++;
     }
@@ -396,16 +678,117 @@ public:
       // cycle or disconnected nodes; keep insertion order as fallback
       topoOrder_.clear();
     }
+    // Per-node dispatch kind and mix gains (mixer gains are fixed once the mixer is set)
+    kinds_.assign(nodes_.size(), NodeKind::Generator);
+    mixGains_.assign(nodes_.size(), 0.0f);
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      Node* n = nodes_[i].node.get();
+      if (dynamic_cast<DelayNode*>(n)) kinds_[i] = NodeKind::Delay;
+      else if (dynamic_cast<CompressorNode*>(n)) kinds_[i] = NodeKind::Compressor;
+      else if (dynamic_cast<MeterNode*>(n)) kinds_[i] = NodeKind::Meter;
+      else if (dynamic_cast<WiretapNode*>(n)) kinds_[i] = NodeKind::Tap;
+      float gain = 0.0f;
+      if (mixer_) {
+        for (const auto& ch : mixer_->channels()) if (ch.id == nodes_[i].id) { gain = ch.gain; break; }
+      }
+      if (gain == 0.0f && downstream_.find(i) == downstream_.end()) gain = 1.0f;
+      mixGains_[i] = gain;
+    }
+    groupSidechains();
+    // Dry sends in connection order; sources mixed via mixer inputs are suppressed (no double count)
+    drySends_.clear();
+    for (const auto& e : connections_) {
+      auto itF = idToIdx.find(e.from);
+      if (itF == idToIdx.end() || mixerInputIds_.count(e.from)) continue;
+      const float dry = e.dryPercent * (1.0f/100.0f);
+      if (dry > 0.0f) drySends_.push_back(DrySend{itF->second, dry});
+    }
+    // Event routing by node id (views into nodes_ ids; rebuilt whenever nodes change)
+    nodeIndexById_.clear();
+    for (size_t i = 0; i < nodes_.size(); ++i) nodeIndexById_[std::string_view(nodes_[i].id)] = i;
+    nodeEvents_.assign(nodes_.size(), std::vector<Command>());
+    for (auto& v : nodeEvents_) v.reserve(32);
+    laneStates_.clear();
+    for (size_t i = 0; i < automation_.size(); ++i) {
+      auto it = nodeIndexById_.find(std::string_view(automation_[i].nodeId));
+      if (it != nodeIndexById_.end() && !automation_[i].empty()) laneStates_.push_back(LaneState{i, it->second, 0, 0.0f, false});
+    }
     topoDirty_ = false;
   }
 
+  // Ramp each automated parameter to its lane's value at the block end. Lanes take over from the
+  // block that ends past their first point; an unchanged value is not sent again.
+  void applyAutomation(SampleTime blockStart, uint32_t frames, double sampleRate) {
+    const SampleTime end = blockStart + frames;
+    for (auto& st : laneStates_) {
+      const AutomationLane& lane = automation_[st.lane];
+      if (end <= lane.times.front()) continue;
+      const float v = lane.valueAt(end, st.cursor);
+      if (st.sent && v == st.last) continue;
+      nodes_[st.node].node->automate(lane.paramId, v, frames, sampleRate);
+      st.last = v; st.sent = true;
+    }
+  }
+
+  // Compressors keyed by the same port-1 edges (same sources, order, gains and declared channels)
+  // with equal detector settings share one detector. Needs a topo order, so that every member
+  // runs after the whole key and sees the same sum.
+  void groupSidechains() {
+    detectors_.clear();
+    sharedDetector_.assign(nodes_.size(), -1);
+    if (topoOrder_.empty()) return;
+    struct Group { std::vector<UpEdge> key; SidechainDetector::Config config; std::vector<size_t> members; };
+    std::vector<Group> groups;
+    auto sameEdge = [](const UpEdge& a, const UpEdge& b) {
+      return a.fromIndex == b.fromIndex && a.gain == b.gain && a.fromPort == b.fromPort &&
+             a.srcDeclared == b.srcDeclared && a.dstDeclared == b.dstDeclared;
+    };
+    for (size_t i : topoOrder_) {
+      if (kinds_[i] != NodeKind::Compressor) continue;
+      auto it = upstream_.find(i);
+      if (it == upstream_.end()) continue;
+      std::vector<UpEdge> key;
+      for (const auto& u : it->second) if (u.toPort == 1u) key.push_back(u);
+      if (key.empty()) continue;
+      SidechainDetector::Config config = static_cast<CompressorNode*>(nodes_[i].node.get())->detectorConfig();
+      auto g = std::find_if(groups.begin(), groups.end(), [&](const Group& x) {
+        return x.config == config && std::equal(x.key.begin(), x.key.end(), key.begin(), key.end(), sameEdge);
+      });
+      if (g == groups.end()) groups.push_back(Group{std::move(key), std::move(config), {i}});
+      else g->members.push_back(i);
+    }
+    for (const auto& g : groups) {
+      if (g.members.size() < 2) continue;
+      auto d = std::make_unique<SidechainDetector>();
+      d->configure(g.config);
+      d->prepare(sampleRate_, maxBlock_);
+      for (size_t m : g.members) sharedDetector_[m] = static_cast<int32_t>(detectors_.size());
+      detectors_.push_back(std::move(d));
+    }
+  }
+
+  // Split a block's events into per-node spans in eventBefore order; unknown ids are ignored
+  void routeEvents(const ProcessContext& ctx) {
+    for (auto& v : nodeEvents_) v.clear();
+    for (uint32_t i = 0; i < ctx.eventCount; ++i) {
+      const Command& c = ctx.events[i];
+      if (!c.nodeId) continue;
+      auto it = nodeIndexById_.find(std::string_view(c.nodeId));
+      if (it == nodeIndexById_.end()) continue;
+      auto& v = nodeEvents_[it->second];
+      v.push_back(c);
+      for (size_t k = v.size() - 1; k > 0 && eventBefore(v[k], v[k - 1]); --k) std::swap(v[k], v[k - 1]);
+    }
+  }
+
 private:
   // Adapt src declared channels to dst declared channels within a graph that runs at 'graphCh' channels
   // and accumulate into dst buffer with gain. Declared channel count 0 means "graph default".
-  void adaptAndAccumulate(const float* src, std::vector<float>& dst,
-                          uint32_t frames, uint32_t graphCh,
-                          uint32_t srcDeclared, uint32_t dstDeclared,
-                          float gain) {
+  // overwrite: dst holds no earlier contribution, so write instead of add (saves clearing it first).
+  static void adaptAndAccumulate(const float* src, float* dst,
+                                 uint32_t frames, uint32_t graphCh,
+                                 uint32_t srcDeclared, uint32_t dstDeclared,
+                                 float gain, bool overwrite = false) {
     const size_t total = static_cast<size_t>(frames) * static_cast<size_t>(graphCh);
     const uint32_t srcCh = (srcDeclared == 0u) ? graphCh : srcDeclared;
     const uint32_t dstCh = (dstDeclared == 0u) ? graphCh : dstDeclared;
@@ -417,23 +800,29 @@ private:
         double sum = 0.0;
         for (uint32_t c = 0; c < graphCh; ++c) sum += static_cast<double>(src[static_cast<size_t>(f)*graphCh + c]);
         const float m = static_cast<float>(sum / static_cast<double>(graphCh));
-        for (uint32_t c = 0; c < graphCh; ++c) dst[static_cast<size_t>(f)*graphCh + c] += m * gain;
+        float* d = dst + static_cast<size_t>(f)*graphCh;
+        for (uint32_t c = 0; c < graphCh; ++c) d[c] = overwrite ? m * gain : d[c] + m * gain;
       }
       return;
     }
 
     // Otherwise, pass-through channel-wise (graph channels act as max width).
-    // If declared counts differ but both >1, use modulo mapping as a simple adapter.
-    if (srcCh == dstCh) {
-      for (size_t i = 0; i < total; ++i) dst[i] += src[i] * gain;
-      return;
-    }
-    for (uint32_t f = 0; f < frames; ++f) {
-      for (uint32_t c = 0; c < graphCh; ++c) {
-        const uint32_t s = (c % graphCh); // graph-sized interleaved
-        dst[static_cast<size_t>(f)*graphCh + c] += src[static_cast<size_t>(f)*graphCh + s] * gain;
-      }
-    }
+    // If declared counts differ but both >1, use modulo mapping as a simple adapter
+    // (with graph-sized interleaving the mapping is the identity).
+    if (overwrite) { for (size_t i = 0; i < total; ++i) dst[i] = src[i] * gain; }
+    else { for (size_t i = 0; i < total; ++i) dst[i] += src[i] * gain; }
+  }
+
+  static void mixInto(float* dst, const float* src, size_t n, float gain, bool& first) {
+    if (first) { for (size_t i = 0; i < n; ++i) dst[i] = src[i] * gain; first = false; }
+    else { for (size_t i = 0; i < n; ++i) dst[i] += src[i] * gain; }
+  }
+
+  static uint32_t declaredChannels(const std::unordered_map<size_t, std::unordered_map<uint32_t, uint32_t>>& ports, size_t node, uint32_t port) {
+    auto itN = ports.find(node);
+    if (itN == ports.end()) return 0u;
+    auto itP = itN->second.find(port);
+    return itP != itN->second.end() ? itP->second : 0u;
   }
 };
 
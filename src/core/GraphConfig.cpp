@@ -1,4 +1,5 @@
 #include "GraphConfig.hpp"
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
@@ -187,19 +188,39 @@ GraphSpec loadGraphSpecFromJsonFile(const std::string& path) {
 
       if (cs.paramId == 0 && !cs.paramName.empty()) {
         auto it = nodeIdToType.find(cs.nodeId);
-        const std::string nodeType = (it != nodeIdToType.end()) ? it->second : std::string();
-        auto mapParam = [](const std::string& type, const std::string& name) -> uint16_t {
-          if (type == "kick") return resolveParamIdByName(kKickParamMap, name);
-          if (type == "clap") return resolveParamIdByName(kClapParamMap, name);
-          if (type == "tb303_ext") return resolveParamIdByName(kTb303ParamMap, name);
-          return 0;
-        };
-        cs.paramId = mapParam(nodeType, cs.paramName);
+        cs.paramId = paramIdForNodeType(it != nodeIdToType.end() ? it->second : std::string(), cs.paramName);
       }
       spec.commands.push_back(cs);
     }
   }
 
+  if (j.contains("automation")) {
+    for (const auto& a : j.at("automation")) {
+      AutomationLane lane;
+      lane.nodeId = a.value("nodeId", "");
+      lane.paramName = a.value("param", "");
+      lane.paramId = static_cast<uint16_t>(a.value("paramId", 0));
+      if (lane.paramId == 0 && !lane.paramName.empty()) {
+        auto it = nodeIdToType.find(lane.nodeId);
+        lane.paramId = paramIdForNodeType(it != nodeIdToType.end() ? it->second : std::string(), lane.paramName);
+      }
+      if (lane.nodeId.empty() || lane.paramId == 0) {
+        std::fprintf(stderr, "Warning: automation lane %s/%s has no node or resolvable param (ignored)\n", lane.nodeId.c_str(), lane.paramName.c_str());
+        continue;
+      }
+      if (a.contains("points")) {
+        for (const auto& pt : a.at("points")) {
+          AutomationLane::Shape shape;
+          const std::string curve = pt.value("curve", "linear");
+          if (!AutomationLane::parseShape(curve, shape)) throw std::runtime_error("Unknown automation curve '" + curve + "' for " + lane.nodeId);
+          lane.addPoint(static_cast<uint64_t>(pt.value("sampleTime", 0)), pt.value("value", 0.0f), shape, pt.value("c1", 0.0f), pt.value("c2", 0.0f));
+        }
+      }
+      lane.sort();
+      if (!lane.empty()) spec.automation.push_back(std::move(lane));
+    }
+  }
+
   if (j.contains("transport")) {
     spec.hasTransport = true;
     const auto& t = j.at("transport");
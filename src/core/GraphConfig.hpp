@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include "Automation.hpp"
 
 struct NodeSpec {
   struct ModLfoSpec {
@@ -77,6 +78,7 @@ struct GraphSpec {
     float rampMs = 0.0f;
   };
   std::vector<CommandSpec> commands;
+  std::vector<AutomationLane> automation; // parameter curves (frames); see Automation.hpp
 
   struct TransportLock { uint32_t step = 0; std::string paramName; uint16_t paramId = 0; float value = 0.0f; float rampMs = 0.0f; };
   struct TransportPattern {
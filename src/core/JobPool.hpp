@@ -4,6 +4,7 @@
 #include <vector>
 #include <functional>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 
@@ -34,6 +35,21 @@ public:
     cv_.notify_one();
   }
 
+  size_t threads() const { return workers_.size(); }
+
+  // Run one queued job on the calling thread; false when the queue is empty
+  bool runOne() {
+    std::function<void()> job;
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      if (jobs_.empty()) return false;
+      job = std::move(jobs_.back());
+      jobs_.pop_back();
+    }
+    job();
+    return true;
+  }
+
 private:
   void workerLoop() {
     for (;;) {
@@ -56,4 +72,42 @@ private:
   bool stop_;
 };
 
+// A set of jobs to wait for. wait() runs queued jobs while it waits, so a job running on the
+// pool can fan out into the same pool (batch job -> session racks / FLAC frames) without
+// parking a worker. Without a pool, run() executes inline.
+class JobGroup {
+public:
+  explicit JobGroup(JobPool* pool) : pool_(pool) {}
+  ~JobGroup() { wait(); }
+  JobGroup(const JobGroup&) = delete;
+  JobGroup& operator=(const JobGroup&) = delete;
+
+  void run(std::function<void()> job) {
+    if (!pool_) { job(); return; }
+    { std::lock_guard<std::mutex> lock(m_); ++pending_; }
+    pool_->submit([this, job = std::move(job)] {
+      job();
+      // Decrement under the lock: wait() returns only after the last job let go of the group
+      std::lock_guard<std::mutex> lock(m_);
+      if (--pending_ == 0) cv_.notify_all();
+    });
+  }
 
+  void wait() {
+    for (;;) {
+      {
+        std::lock_guard<std::mutex> lock(m_);
+        if (pending_ == 0) return;
+      }
+      if (pool_ && pool_->runOne()) continue;
+      std::unique_lock<std::mutex> lock(m_);
+      cv_.wait_for(lock, std::chrono::milliseconds(1), [this] { return pending_ == 0; });
+    }
+  }
+
+private:
+  JobPool* pool_;
+  uint32_t pending_ = 0;
+  std::mutex m_;
+  std::condition_variable cv_;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "Node.hpp"
+
+// Lane batching (--simd-lanes): generator nodes of one type render together through a shared
+// kernel, one node per SIMD lane, instead of one node at a time. Graph::collectBatchLanes hands
+// out a graph's batchable generators for a block (from one graph, or from every rack of a
+// session rendering in lockstep); renderBatchLanes groups them by kernel and runs each group.
+// A batched node renders the same bits as Graph::process would render it alone.
+
+// Per node and block: ran = some run rendered (else the buffer stayed zero); slept = the whole
+// block was skipped as silent (Graph counts it as an idle skip)
+struct BatchResult { bool ran = false; bool slept = false; };
+
+class BatchKernel;
+
+struct BatchLane {
+  Node* node = nullptr;
+  const BatchKernel* kernel = nullptr;
+  ProcessContext ctx{};       // the node's block and its own event span (see runWithEvents)
+  float* out = nullptr;       // interleaved ctx.frames x channels, zeroed
+  bool idleSkip = true;
+  BatchResult* result = nullptr;
+};
+
+class BatchKernel {
+public:
+  virtual ~BatchKernel() = default;
+  static constexpr uint32_t kMaxLanes = 8;
+  // Render one block of up to kMaxLanes lanes, all of this kernel's node type
+  virtual void render(BatchLane* lanes, uint32_t count, uint32_t channels) const = 0;
+};
+
+// Drive up to kMaxLanes lanes through their block with each node's events and idle skips exactly
+// as Graph::process does for a single node: a node without events sleeps through the whole
+// block or renders all of it; a node with events is split at its own event offsets and may
+// sleep through each run. The lanes' runs are cut at the union of their split points;
+// render(lanes, count, offset, frames) renders [offset, offset + frames) of the listed lanes.
+template <typename RenderFn>
+inline void runBatchLanes(BatchLane* lanes, uint32_t count, RenderFn&& render) {
+  count = std::min(count, BatchKernel::kMaxLanes);
+  uint32_t ei[BatchKernel::kMaxLanes] = {}, runEnd[BatchKernel::kMaxLanes] = {};
+  bool live[BatchKernel::kMaxLanes] = {}, sleep[BatchKernel::kMaxLanes] = {};
+  uint32_t frames = 0;
+  for (uint32_t v = 0; v < count; ++v) {
+    BatchLane& l = lanes[v];
+    frames = std::max(frames, l.ctx.frames);
+    *l.result = BatchResult{};
+    ProcessContext whole = l.ctx; whole.events = nullptr; whole.eventCount = 0;
+    l.result->slept = l.idleSkip && l.ctx.eventCount == 0 && l.node->skipIfSilent(whole);
+    live[v] = !l.result->slept;
+  }
+  BatchLane* run[BatchKernel::kMaxLanes];
+  uint32_t done = 0;
+  while (done < frames) {
+    uint32_t end = frames, n = 0;
+    for (uint32_t v = 0; v < count; ++v) {
+      BatchLane& l = lanes[v];
+      const ProcessContext& c = l.ctx;
+      if (!live[v] || done >= c.frames) continue; // slept, or a shorter (final) block is done
+      if (done == runEnd[v]) {
+        // This node's own run starts here: deliver its events, find the run end, maybe sleep
+        while (ei[v] < c.eventCount && c.events[ei[v]].sampleTime <= c.blockStart + done) l.node->handleEvent(c.events[ei[v]++]);
+        runEnd[v] = c.frames;
+        if (ei[v] < c.eventCount && c.events[ei[v]].sampleTime < c.blockStart + c.frames) runEnd[v] = static_cast<uint32_t>(c.events[ei[v]].sampleTime - c.blockStart);
+        sleep[v] = false;
+        if (c.eventCount > 0 && l.idleSkip) {
+          ProcessContext sub = c;
+          sub.frames = runEnd[v] - done; sub.blockStart = c.blockStart + done; sub.events = nullptr; sub.eventCount = 0;
+          sleep[v] = l.node->skipIfSilent(sub);
+        }
+        if (!sleep[v]) l.result->ran = true;
+      }
+      end = std::min(end, runEnd[v]);
+      if (!sleep[v]) run[n++] = &l;
+    }
+    if (n > 0) render(run, n, done, end - done);
+    done = end;
+  }
+  for (uint32_t v = 0; v < count; ++v) {
+    if (!live[v]) continue;
+    const ProcessContext& c = lanes[v].ctx;
+    while (ei[v] < c.eventCount) lanes[v].node->handleEvent(c.events[ei[v]++]); // past the block end, as runWithEvents
+  }
+}
+
+// Render all lanes: grouped by kernel (lane order is otherwise kept), kMaxLanes at a time
+inline void renderBatchLanes(BatchLane* lanes, size_t count, uint32_t channels) {
+  for (size_t i = 1; i < count; ++i) {
+    for (size_t k = i; k > 0 && std::less<const BatchKernel*>()(lanes[k].kernel, lanes[k - 1].kernel); --k) std::swap(lanes[k], lanes[k - 1]);
+  }
+  for (size_t first = 0; first < count;) {
+    size_t last = first;
+    while (last < count && lanes[last].kernel == lanes[first].kernel && last - first < BatchKernel::kMaxLanes) ++last;
+    lanes[first].kernel->render(lanes + first, static_cast<uint32_t>(last - first), channels);
+    first = last;
+  }
+}
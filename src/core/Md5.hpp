@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Minimal MD5 (RFC 1321) for the FLAC STREAMINFO signature; incremental like sha1_detail.
+namespace md5_detail {
+  struct Ctx {
+    uint32_t h[4];
+    uint64_t lenBytes;
+    uint8_t  buf[64];
+    size_t   bufUsed;
+  };
+
+  inline uint32_t rol(uint32_t x, uint32_t n) { return (x << n) | (x >> (32 - n)); }
+
+  inline void init(Ctx& c) {
+    c.h[0] = 0x67452301u; c.h[1] = 0xefcdab89u; c.h[2] = 0x98badcfeu; c.h[3] = 0x10325476u;
+    c.lenBytes = 0; c.bufUsed = 0; std::memset(c.buf, 0, sizeof(c.buf));
+  }
+
+  inline void processBlock(Ctx& c, const uint8_t* p) {
+    static const uint32_t K[64] = {
+      0xd76aa478u, 0xe8c7b756u, 0x242070dbu, 0xc1bdceeeu, 0xf57c0fafu, 0x4787c62au, 0xa8304613u, 0xfd469501u,
+      0x698098d8u, 0x8b44f7afu, 0xffff5bb1u, 0x895cd7beu, 0x6b901122u, 0xfd987193u, 0xa679438eu, 0x49b40821u,
+      0xf61e2562u, 0xc040b340u, 0x265e5a51u, 0xe9b6c7aau, 0xd62f105du, 0x02441453u, 0xd8a1e681u, 0xe7d3fbc8u,
+      0x21e1cde6u, 0xc33707d6u, 0xf4d50d87u, 0x455a14edu, 0xa9e3e905u, 0xfcefa3f8u, 0x676f02d9u, 0x8d2a4c8au,
+      0xfffa3942u, 0x8771f681u, 0x6d9d6122u, 0xfde5380cu, 0xa4beea44u, 0x4bdecfa9u, 0xf6bb4b60u, 0xbebfbc70u,
+      0x289b7ec6u, 0xeaa127fau, 0xd4ef3085u, 0x04881d05u, 0xd9d4d039u, 0xe6db99e5u, 0x1fa27cf8u, 0xc4ac5665u,
+      0xf4292244u, 0x432aff97u, 0xab9423a7u, 0xfc93a039u, 0x655b59c3u, 0x8f0ccc92u, 0xffeff47du, 0x85845dd1u,
+      0x6fa87e4fu, 0xfe2ce6e0u, 0xa3014314u, 0x4e0811a1u, 0xf7537e82u, 0xbd3af235u, 0x2ad7d2bbu, 0xeb86d391u
+    };
+    static const uint32_t S[64] = {
+      7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+      5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+      4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+      6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+    };
+    uint32_t m[16];
+    for (int i = 0; i < 16; ++i) {
+      m[i] = static_cast<uint32_t>(p[4*i]) | (static_cast<uint32_t>(p[4*i+1]) << 8)
+           | (static_cast<uint32_t>(p[4*i+2]) << 16) | (static_cast<uint32_t>(p[4*i+3]) << 24);
+    }
+    uint32_t a = c.h[0], b = c.h[1], c2 = c.h[2], d = c.h[3];
+    for (int i = 0; i < 64; ++i) {
+      uint32_t f, g;
+      if (i < 16)      { f = (b & c2) | (~b & d); g = static_cast<uint32_t>(i); }
+      else if (i < 32) { f = (d & b) | (~d & c2); g = static_cast<uint32_t>(5 * i + 1) & 15u; }
+      else if (i < 48) { f = b ^ c2 ^ d;          g = static_cast<uint32_t>(3 * i + 5) & 15u; }
+      else             { f = c2 ^ (b | ~d);       g = static_cast<uint32_t>(7 * i) & 15u; }
+      const uint32_t tmp = d;
+      d = c2; c2 = b;
+      b = b + rol(a + f + K[i] + m[g], S[i]);
+      a = tmp;
+    }
+    c.h[0] += a; c.h[1] += b; c.h[2] += c2; c.h[3] += d;
+  }
+
+  inline void update(Ctx& c, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    c.lenBytes += static_cast<uint64_t>(len);
+    while (len > 0) {
+      size_t take = std::min(len, 64 - c.bufUsed);
+      std::memcpy(c.buf + c.bufUsed, p, take);
+      c.bufUsed += take; p += take; len -= take;
+      if (c.bufUsed == 64) { processBlock(c, c.buf); c.bufUsed = 0; }
+    }
+  }
+
+  inline void finalize(Ctx& c, uint8_t out[16]) {
+    const uint64_t lenBits = c.lenBytes * 8ull;
+    c.buf[c.bufUsed++] = 0x80;
+    if (c.bufUsed > 56) { while (c.bufUsed < 64) c.buf[c.bufUsed++] = 0; processBlock(c, c.buf); c.bufUsed = 0; }
+    while (c.bufUsed < 56) c.buf[c.bufUsed++] = 0;
+    for (int i = 0; i < 8; ++i) c.buf[c.bufUsed++] = static_cast<uint8_t>((lenBits >> (i*8)) & 0xFF);
+    processBlock(c, c.buf);
+    for (int i = 0; i < 4; ++i) {
+      out[4*i+0] = static_cast<uint8_t>(c.h[i] & 0xFF);
+      out[4*i+1] = static_cast<uint8_t>((c.h[i] >> 8) & 0xFF);
+      out[4*i+2] = static_cast<uint8_t>((c.h[i] >> 16) & 0xFF);
+      out[4*i+3] = static_cast<uint8_t>((c.h[i] >> 24) & 0xFF);
+    }
+  }
+}
+
+inline std::string computeMd5Hex(const void* data, size_t len) {
+  md5_detail::Ctx c; md5_detail::init(c);
+  md5_detail::update(c, data, len);
+  uint8_t dig[16]; md5_detail::finalize(c, dig);
+  static const char* hex = "0123456789abcdef";
+  std::string out; out.reserve(32);
+  for (int i = 0; i < 16; ++i) { out.push_back(hex[(dig[i] >> 4) & 0xF]); out.push_back(hex[dig[i] & 0xF]); }
+  return out;
+}
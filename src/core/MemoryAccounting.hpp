@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#if defined(__APPLE__) || defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+// Explicit memory accounting for --mem-report: components report the bytes they hold in
+// buffers (Node::memoryBytes, Graph::memoryReport, SessionGraph::memoryBytes); capacities are
+// counted, not sizes, since that is what stays allocated.
+template <typename T>
+inline size_t vectorBytes(const std::vector<T>& v) { return v.capacity() * sizeof(T); }
+
+template <typename T>
+inline size_t nestedVectorBytes(const std::vector<std::vector<T>>& v) {
+  size_t n = vectorBytes(v);
+  for (const auto& inner : v) n += vectorBytes(inner);
+  return n;
+}
+
+// "12.3 KiB" style
+inline std::string formatBytes(uint64_t bytes) {
+  char buf[32];
+  if (bytes < 1024) std::snprintf(buf, sizeof(buf), "%llu B", static_cast<unsigned long long>(bytes));
+  else if (bytes < 1024ull * 1024ull) std::snprintf(buf, sizeof(buf), "%.1f KiB", static_cast<double>(bytes) / 1024.0);
+  else if (bytes < 1024ull * 1024ull * 1024ull) std::snprintf(buf, sizeof(buf), "%.1f MiB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+  else std::snprintf(buf, sizeof(buf), "%.2f GiB", static_cast<double>(bytes) / (1024.0 * 1024.0 * 1024.0));
+  return buf;
+}
+
+// Peak resident set size of the process (0 when unknown)
+inline uint64_t processPeakRssBytes() {
+#if defined(__APPLE__)
+  struct rusage ru{};
+  return getrusage(RUSAGE_SELF, &ru) == 0 ? static_cast<uint64_t>(ru.ru_maxrss) : 0; // bytes
+#elif defined(__linux__)
+  struct rusage ru{};
+  return getrusage(RUSAGE_SELF, &ru) == 0 ? static_cast<uint64_t>(ru.ru_maxrss) * 1024ull : 0; // KiB
+#else
+  return 0;
+#endif
+}
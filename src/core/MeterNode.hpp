@@ -19,6 +19,7 @@ public:
     peak_.store(p); rms_.store(r);
   }
   void handleEvent(const Command&) override {}
+  bool hashState(StateHash&) const override { return true; } // readbacks only
 
   // Readbacks (non-RT)
   double peak() const { return peak_.load(); }
@@ -33,6 +33,8 @@ public:
     }
   }
 
+  bool hashState(StateHash& h) const override { h.add(masterGain_, softClip_); return true; }
+
   const std::vector<MixerChannel>& channels() const { return channels_; }
   float masterGain() const { return masterGain_; }
   bool softClip() const { return softClip_; }
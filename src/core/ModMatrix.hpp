@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <array>
 #include <cmath>
+#include "StateHash.hpp"
 
 // Lightweight, fixed-capacity modulation matrix suitable for realtime use.
 // - No dynamic allocations
@@ -50,6 +51,14 @@ public:
     return out;
   }
 
+  // Advance the phase one sample without evaluating the waveform (same arithmetic as next())
+  void advance() {
+    phase_ += phaseInc_;
+    if (phase_ >= 1.0f) phase_ -= 1.0f;
+  }
+
+  void hashState(StateHash& h) const { h.add(wave_, freqHz_, phase_, phaseInc_); }
+
 private:
   static float wrap01(float x) { while (x < 0.0f) x += 1.0f; while (x >= 1.0f) x -= 1.0f; return x; }
   void updatePhaseInc() {
@@ -228,6 +237,38 @@ public:
     }
   }
 
+  // Equivalent to `frames` calls to tick(), for a node that skips a silent block. Without
+  // LFO-to-LFO routes the waveforms are only evaluated for the final sample (cached in last).
+  void skip(uint32_t frames) {
+    if (frames == 0 || numSources_ == 0) return;
+    for (size_t r = 0; r < numRoutes_; ++r) {
+      if (routes_[r].active && routes_[r].target != Route::Target::DestParam) {
+        for (uint32_t i = 0; i < frames; ++i) tick();
+        return;
+      }
+    }
+    for (size_t i = 0; i < numSources_; ++i) {
+      Source& s = sources_[i];
+      if (!s.active) continue;
+      float desiredHz = s.baseFreqHz;
+      if (desiredHz < 0.01f) desiredHz = 0.01f;
+      for (uint32_t k = 0; k < frames; ++k) {
+        s.smoothedFreqHz += s.freqSlewAlpha * (desiredHz - s.smoothedFreqHz);
+        s.lfo.setDynamicFreqHz(s.smoothedFreqHz);
+        if (k + 1 < frames) s.lfo.advance(); else s.last = s.lfo.next();
+      }
+    }
+  }
+
+  // True when a route modulates destParamId (sumFor may then change every sample)
+  bool drivesParam(uint16_t destParamId) const {
+    for (size_t i = 0; i < numRoutes_; ++i) {
+      const Route& r = routes_[i];
+      if (r.active && r.target == Route::Target::DestParam && r.destParamId == destParamId) return true;
+    }
+    return false;
+  }
+
   // Sum contributions for a destination parameter id
   float sumFor(uint16_t destParamId) const {
     float acc = 0.0f;
@@ -252,6 +293,15 @@ public:
     return acc;
   }
 
+  // Routes are fixed configuration; sources carry phase and slew state
+  void hashState(StateHash& h) const {
+    for (size_t i = 0; i < numSources_; ++i) {
+      const Source& s = sources_[i];
+      s.lfo.hashState(h);
+      h.add(s.id, s.last, s.active, s.baseFreqHz, s.smoothedFreqHz);
+    }
+  }
+
 private:
   int findSourceIndex(uint16_t id) const {
     for (size_t i = 0; i < numSources_; ++i) if (sources_[i].id == id) return static_cast<int>(i);
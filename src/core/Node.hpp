@@ -1,13 +1,23 @@
 #pragma once
 
+#include <cmath>
 #include <cstdint>
 #include <string>
+#include <utility>
 #include "Command.hpp"
+#include "Random.hpp"
+#include "StateHash.hpp"
+
+class BatchKernel; // KernelBatch.hpp
 
 struct ProcessContext {
   double sampleRate = 48000.0;
   uint32_t frames = 0;
   SampleTime blockStart = 0; // absolute sample start of this block
+  // Optional events inside this block (sampleTime in [blockStart, blockStart + frames)), in
+  // eventBefore order. Graph::process routes each node its own span; see runWithEvents.
+  const Command* events = nullptr;
+  uint32_t eventCount = 0;
 };
 
 class Node {
@@ -21,10 +31,64 @@ public:
   virtual void processInPlace(ProcessContext ctx, float* interleaved, uint32_t channels) { (void)ctx; (void)interleaved; (void)channels; }
   // Optional: report algorithmic latency in samples (for preroll/compensation)
   virtual uint32_t latencySamples() const { return 0; }
-  // Optional: handle control events prior to processing a block (currently block-accurate)
+  // Optional: handle a control event; the graph delivers it at its sample offset (runWithEvents)
   virtual void handleEvent(const Command&) {}
+  // Optional: ramp a parameter to value over the next `frames` (automation lanes, once per block).
+  // Default: a SetParamRamp delivered through handleEvent, so the node's own smoothing applies.
+  virtual void automate(uint16_t paramId, float value, uint32_t frames, double sampleRate) {
+    Command c{}; c.type = CommandType::SetParamRamp; c.paramId = paramId; c.value = value;
+    c.rampMs = static_cast<float>(1000.0 * static_cast<double>(frames) / sampleRate);
+    handleEvent(c);
+  }
+  // Optional: key for the node's random stream (derived from the graph randomSeed and node id)
+  virtual void setRandomKey(uint64_t key) { (void)key; }
+  // Optional: called by the graph before process()/processInPlace() when the node's input for
+  // this block is silent (generators: always). Return true when the block's output would be all
+  // zeros; the node must then advance whatever state process() would have advanced (LFO phases,
+  // counters) so that skipping is sample-exact. The graph treats a skipped node's output as silence.
+  virtual bool skipIfSilent(ProcessContext ctx) { (void)ctx; return false; }
+  // Optional: add every bit of state that carries into the next block to h (see StateHash).
+  // Return false when the node can't, or when its output depends on absolute time (noise
+  // indexed by blockStart, file writes); loop replication is then off for the whole graph.
+  virtual bool hashState(StateHash& h) const { (void)h; return false; }
+  // Optional: bytes held in the node's own buffers (delay lines, scratch, taps) for --mem-report
+  virtual size_t memoryBytes() const { return 0; }
+  // Optional: shared kernel that renders generators of this type together, one per SIMD lane
+  // (lane batching, see KernelBatch.hpp); nullptr renders through process() only
+  virtual const BatchKernel* batchKernel() const { return nullptr; }
 };
 
+// Event order within a block: by time; at equal times SetParam/SetParamRamp latch before Triggers
+inline bool eventBefore(const Command& a, const Command& b) {
+  if (a.sampleTime != b.sampleTime) return a.sampleTime < b.sampleTime;
+  return a.type != CommandType::Trigger && b.type == CommandType::Trigger;
+}
+
+// Stable in-place insertion sort into eventBefore order (no allocation; inputs are nearly sorted)
+inline void sortEvents(Command* first, Command* last) {
+  for (Command* i = first + (first != last ? 1 : 0); i < last; ++i) {
+    for (Command* k = i; k > first && eventBefore(*k, *(k - 1)); --k) std::swap(*k, *(k - 1));
+  }
+}
+
+// Render one block of a node whose ctx carries its event span: the block is split only at this
+// node's event offsets, each event is delivered (handleEvent) before the run that starts at its
+// time, and run(sub, offsetFrames) renders each run (sub carries no events).
+template <typename RunFn>
+inline void runWithEvents(Node& node, const ProcessContext& ctx, RunFn&& run) {
+  uint32_t done = 0, ei = 0;
+  while (done < ctx.frames) {
+    while (ei < ctx.eventCount && ctx.events[ei].sampleTime <= ctx.blockStart + done) node.handleEvent(ctx.events[ei++]);
+    uint32_t end = ctx.frames;
+    if (ei < ctx.eventCount && ctx.events[ei].sampleTime < ctx.blockStart + ctx.frames) end = static_cast<uint32_t>(ctx.events[ei].sampleTime - ctx.blockStart);
+    ProcessContext sub = ctx;
+    sub.frames = end - done; sub.blockStart = ctx.blockStart + done; sub.events = nullptr; sub.eventCount = 0;
+    run(sub, done);
+    done = end;
+  }
+  while (ei < ctx.eventCount) node.handleEvent(ctx.events[ei++]); // past the block end: deliver late rather than drop
+}
+
 // Observability helpers (MVP): compute peak/RMS of a buffer segment.
 inline void measurePeakRms(const float* interleaved, uint32_t frames, uint32_t channels, double& outPeak, double& outRms) {
   double peak = 0.0; long double sumSq = 0.0L;
@@ -14,6 +14,7 @@
 #include "../instruments/mam_chip/MamChipFactory.hpp"
 #include "SpectralDuckerNode.hpp"
 #include "../instruments/tb303/Tb303ExtNode.hpp"
+#include "../instruments/sampler/SamplerFactory.hpp"
 #include <type_traits>
 // Mixer is not created via NodeFactory; it is set on Graph from GraphSpec.mixer
 
@@ -210,12 +211,14 @@ inline std::unique_ptr<Node> createNodeFromSpec(const NodeSpec& spec) {
   if (spec.type == "wiretap") {
     std::string path = "wiretap.wav";
     bool enabled = true;
+    double bufferSeconds = 2.0;
     try {
       nlohmann::json j = nlohmann::json::parse(spec.paramsJson);
       if (j.contains("path")) path = j.value("path", path);
       enabled = j.value("enabled", true);
+      bufferSeconds = j.value("bufferSeconds", bufferSeconds);
     } catch (...) {}
-    return std::make_unique<WiretapNode>(path, enabled);
+    return std::make_unique<WiretapNode>(path, enabled, bufferSeconds);
   }
   if (spec.type == "tb303_ext") {
     Tb303ExtParams p{};
@@ -271,6 +274,9 @@ inline std::unique_ptr<Node> createNodeFromSpec(const NodeSpec& spec) {
   if (spec.type == "mam_chip") {
     return makeMamChipFromParamsJson(spec.paramsJson);
   }
+  if (spec.type == "sampler") {
+    return makeSamplerFromParamsJson(spec.paramsJson);
+  }
   // Unknown node type
   std::fprintf(stderr, "Warning: Unknown node type '%s' (id='%s')\n", spec.type.c_str(), spec.id.c_str());
   return nullptr;
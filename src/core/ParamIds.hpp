@@ -25,3 +25,18 @@ namespace ClapParam {
 }
 
 
+
+namespace SamplerParam {
+  constexpr uint16_t NOTE_SEMITONES = 1;
+  constexpr uint16_t ROOT_NOTE = 2;
+  constexpr uint16_t TUNE_CENTS = 3;
+  constexpr uint16_t GAIN = 4;
+  constexpr uint16_t PAN = 5;
+  constexpr uint16_t VELOCITY = 6;
+  constexpr uint16_t START_MS = 7;
+  constexpr uint16_t ATTACK_MS = 8;
+  constexpr uint16_t RELEASE_MS = 9;
+  constexpr uint16_t GATE_MS = 10;
+  constexpr uint16_t LOOP = 11;
+  constexpr uint16_t NOTE_OFF = 12; // releases voices playing this note
+}
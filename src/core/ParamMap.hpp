@@ -148,22 +148,95 @@ static constexpr ParamDef kTb303Params[] = {
 static constexpr ParamMap kTb303ParamMap{ "tb303_ext", kTb303Params, sizeof(kTb303Params)/sizeof(kTb303Params[0]) };
 
 
-// MAMIC (mam_chip) - initial musical API (single-voice scaffold)
+// MAMIC (mam_chip) - multi-voice chip. Ids 1..30 are global (voice-wide params set every voice);
+// per-voice params live at kMamChipVoiceParamBase + (N-1) * kMamChipVoiceParamStride + slot.
+static constexpr uint16_t kMamChipVoiceParamBase = 100;
+static constexpr uint16_t kMamChipVoiceParamStride = 16;
+static constexpr uint16_t kMamChipMaxVoices = 8;
+
+#define MAMIC_VOICE_PARAMS(N) \
+  {100 + 16 * ((N) - 1) + 0, "VOICE_" #N "_NOTE_SEMITONES", "st",  0.f, 127.f,  60.f, "step"},   \
+  {100 + 16 * ((N) - 1) + 1, "VOICE_" #N "_WAVE",           "",    0.f,   3.f,   0.f, "step"},   \
+  {100 + 16 * ((N) - 1) + 2, "VOICE_" #N "_PULSE_WIDTH",    "",  0.05f, 0.95f,  0.5f, "linear"}, \
+  {100 + 16 * ((N) - 1) + 3, "VOICE_" #N "_GAIN",           "",    0.f,  1.5f,  1.0f, "linear"}, \
+  {100 + 16 * ((N) - 1) + 4, "VOICE_" #N "_PAN",            "",   -1.f,   1.f,  0.0f, "linear"}, \
+  {100 + 16 * ((N) - 1) + 5, "VOICE_" #N "_NOISE_MIX",      "",    0.f,   1.f,  0.0f, "linear"}, \
+  {100 + 16 * ((N) - 1) + 6, "VOICE_" #N "_SYNC",           "",    0.f,   1.f,  0.0f, "step"},   \
+  {100 + 16 * ((N) - 1) + 7, "VOICE_" #N "_RING",           "",    0.f,   1.f,  0.0f, "step"},   \
+  {100 + 16 * ((N) - 1) + 8, "VOICE_" #N "_FINE_CENTS",     "ct", -100.f, 100.f, 0.0f, "step"},  \
+  {100 + 16 * ((N) - 1) + 9, "VOICE_" #N "_GATE",           "",    0.f,   1.f,  0.0f, "step"}
+
 static constexpr ParamDef kMamChipParams[] = {
-  {1,  "WAVE",           "",   0.f,   2.f,   0.f,   "step"},   // 0=square,1=tri,2=saw
-  {2,  "NOTE_SEMITONES", "st",  0.f, 127.f, 60.f,   "step"},
-  {3,  "VELOCITY",       "",    0.f,   1.f,  1.0f,  "step"},
-  {4,  "PULSE_WIDTH",    "",   0.05f, 0.95f, 0.5f,  "linear"},
-  {5,  "GAIN",           "",    0.f,   1.5f, 0.9f,  "linear"},
-  {6,  "PAN",            "",   -1.f,   1.f,  0.0f,  "linear"},
-  {7,  "ATTACK_MS",      "ms",  0.f,  400.f, 10.f,  "linear"},
-  {8,  "DECAY_MS",       "ms",  0.f, 1000.f, 120.f, "linear"},
-  {9,  "SUSTAIN",        "",    0.f,   1.f,  0.7f,  "linear"},
-  {10, "RELEASE_MS",     "ms",  0.f, 1000.f, 200.f, "linear"},
-  {11, "NOISE_MIX",      "",    0.f,   1.f,  0.0f,  "linear"},
-  {12, "MODE",           "",    0.f,   1.f,  0.0f,  "step"}    // 0=psg,1=sidish (future)
+  {1,  "WAVE",              "",   0.f,   3.f,   0.f,   "step"},   // 0=pulse,1=tri,2=saw,3=noise
+  {2,  "NOTE_SEMITONES",    "st", 0.f, 127.f,  60.f,   "step"},   // note for the next Trigger (mono: retunes)
+  {3,  "VELOCITY",          "",   0.f,   1.f,  1.0f,   "step"},   // used when Trigger carries no value
+  {4,  "PULSE_WIDTH",       "",   0.05f, 0.95f, 0.5f,  "linear"},
+  {5,  "GAIN",              "",   0.f,   1.5f, 0.9f,   "linear"}, // master gain
+  {6,  "PAN",               "",  -1.f,   1.f,  0.0f,   "linear"},
+  {7,  "ATTACK_MS",         "ms", 0.f,  400.f, 10.f,   "linear"},
+  {8,  "DECAY_MS",          "ms", 0.f, 1000.f, 120.f,  "linear"},
+  {9,  "SUSTAIN",           "",   0.f,   1.f,  0.7f,   "linear"},
+  {10, "RELEASE_MS",        "ms", 0.f, 1000.f, 200.f,  "linear"},
+  {11, "NOISE_MIX",         "",   0.f,   1.f,  0.0f,   "linear"},
+  {12, "MODE",              "",   0.f,   2.f,  0.0f,   "step"},   // 0=psg,1=sidish,2=custom (preset tag)
+  {13, "NUM_VOICES",        "",   1.f,   8.f,  1.0f,   "step"},   // 1 = classic mono voice
+  {14, "GATE_MS",           "ms", 0.f, 10000.f, 0.f,   "step"},   // auto-release after Trigger; 0 = hold
+  {15, "NOTE_OFF",          "st", 0.f, 127.f,  0.0f,   "step"},   // releases voices playing this note
+  {16, "GLIDE_MS",          "ms", 0.f, 2000.f, 0.0f,   "step"},
+  {17, "FINE_CENTS",        "ct",-100.f, 100.f, 0.0f,  "step"},
+  {18, "SYNC",              "",   0.f,   1.f,  0.0f,   "step"},   // hard-sync each voice to the previous one
+  {19, "RING",              "",   0.f,   1.f,  0.0f,   "step"},   // ring-modulate each voice by the previous one
+  {20, "FILTER_TYPE",       "",   0.f,   3.f,  0.0f,   "step"},   // 0=off,1=lp,2=bp,3=hp
+  {21, "FILTER_CUTOFF_HZ",  "Hz", 20.f, 20000.f, 8000.f, "expo"},
+  {22, "FILTER_RESO",       "",   0.f,   1.f,  0.2f,   "linear"},
+  {23, "FILTER_DRIVE",      "",   0.f,   1.f,  0.0f,   "linear"},
+  {24, "GRIT_BITDEPTH",     "bit",0.f,  16.f,  0.0f,   "step"},   // 0 = off
+  {25, "GRIT_SRRATE",       "Hz", 0.f, 48000.f, 0.0f,  "step"},   // 0 = off
+  {26, "NOISE_SHARED",      "",   0.f,   1.f,  0.0f,   "step"},
+  {27, "NOISE_LEVEL_GLOBAL","",   0.f,   1.f,  0.0f,   "linear"}, // added to every voice's noise mix
+  {28, "NOISE_TYPE",        "",   0.f,   1.f,  0.0f,   "step"},   // 0=white,1=lfsr (always shared)
+  {29, "NOISE_CLOCK_HZ",    "Hz", 0.f, 48000.f, 0.0f,  "step"},   // lfsr clock; 0 = sample rate
+  {30, "ALIAS",             "",   0.f,   1.f,  0.0f,   "step"},   // 1 = naive (aliasing) oscillators
+  MAMIC_VOICE_PARAMS(1), MAMIC_VOICE_PARAMS(2), MAMIC_VOICE_PARAMS(3), MAMIC_VOICE_PARAMS(4),
+  MAMIC_VOICE_PARAMS(5), MAMIC_VOICE_PARAMS(6), MAMIC_VOICE_PARAMS(7), MAMIC_VOICE_PARAMS(8)
 };
 
+#undef MAMIC_VOICE_PARAMS
+
 static constexpr ParamMap kMamChipParamMap{ "mam_chip", kMamChipParams, sizeof(kMamChipParams)/sizeof(kMamChipParams[0]) };
 
+// Sampler
+static constexpr ParamDef kSamplerParams[] = {
+  {1,  "NOTE_SEMITONES", "st", 0.f,   127.f,   60.f,  "step"},   // note for the next Trigger
+  {2,  "ROOT_NOTE",      "st", 0.f,   127.f,   60.f,  "step"},
+  {3,  "TUNE_CENTS",     "ct", -1200.f, 1200.f, 0.f,  "step"},
+  {4,  "GAIN",           "",   0.f,   2.f,     1.0f,  "linear"},
+  {5,  "PAN",            "",  -1.f,   1.f,     0.0f,  "step"},
+  {6,  "VELOCITY",       "",   0.f,   1.f,     1.0f,  "step"},
+  {7,  "START_MS",       "ms", 0.f,   600000.f, 0.f,  "step"},
+  {8,  "ATTACK_MS",      "ms", 0.f,   5000.f,  0.f,   "step"},
+  {9,  "RELEASE_MS",     "ms", 0.f,   10000.f, 30.f,  "step"},
+  {10, "GATE_MS",        "ms", 0.f,   600000.f, 0.f,  "step"},   // auto-release after Trigger; 0 = play out
+  {11, "LOOP",           "bool", 0.f, 1.f,     0.f,   "step"},
+  {12, "NOTE_OFF",       "st", 0.f,   127.f,   0.f,   "step"},
+};
+
+static constexpr ParamMap kSamplerParamMap{ "sampler", kSamplerParams, sizeof(kSamplerParams)/sizeof(kSamplerParams[0]) };
+
 
+// Param table for a node type string (nullptr when the type has no named params)
+inline const ParamMap* paramMapForNodeType(const std::string& type) {
+  if (type == kKickParamMap.nodeType) return &kKickParamMap;
+  if (type == kClapParamMap.nodeType) return &kClapParamMap;
+  if (type == kTb303ParamMap.nodeType) return &kTb303ParamMap;
+  if (type == kMamChipParamMap.nodeType) return &kMamChipParamMap;
+  if (type == kSamplerParamMap.nodeType) return &kSamplerParamMap;
+  return nullptr;
+}
+
+// Param name -> id for a node type (0 = unknown type or name). The one resolver for spec
+// commands, automation lanes and session commands.
+inline uint16_t paramIdForNodeType(const std::string& type, const std::string& name) {
+  const ParamMap* map = paramMapForNodeType(type);
+  return map ? resolveParamIdByName(*map, name) : 0;
+}
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <array>
+#include "StateHash.hpp"
 
 // Tiny fixed-capacity parameter smoother registry for realtime use
 // No dynamic allocations; linear lookup (small N)
@@ -89,12 +92,40 @@ public:
     return e.current;
   }
 
+  // Advance `samples` steps at once and return the value at the end of the span.
+  // For block-rate consumers that interpolate start→end themselves instead of calling next() per sample.
+  float advance(uint16_t id, uint32_t samples) {
+    const int idx = findIndex(id);
+    if (idx < 0) return 0.0f;
+    Entry& e = entries_[static_cast<size_t>(idx)];
+    if (e.samplesLeft == 0 || samples == 0) return e.current;
+    const uint32_t k = std::min(samples, e.samplesLeft);
+    if (e.smoothing == Smoothing::Expo) e.current = e.target + (e.current - e.target) * std::pow(1.0f - e.expoAlpha, static_cast<float>(k));
+    else e.current += e.deltaPerSample * static_cast<float>(k);
+    e.samplesLeft -= k;
+    if (e.samplesLeft == 0) e.current = e.target;
+    return e.current;
+  }
+
+  // True when no parameter is mid-ramp (next() would return current() for every id)
+  bool settled() const {
+    for (size_t i = 0; i < size_; ++i) if (entries_[i].samplesLeft > 0) return false;
+    return true;
+  }
+
   float current(uint16_t id) const {
     const int idx = findIndex(id);
     if (idx < 0) return 0.0f;
     return entries_[static_cast<size_t>(idx)].current;
   }
 
+  void hashState(StateHash& h) const {
+    for (size_t i = 0; i < size_; ++i) {
+      const Entry& e = entries_[i];
+      h.add(e.id, e.current, e.target, e.deltaPerSample, e.samplesLeft, e.smoothing, e.expoAlpha);
+    }
+  }
+
 private:
   struct Entry {
     uint16_t id;
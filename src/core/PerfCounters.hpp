@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters of the calling thread (Linux perf_event_open): cycles, instructions, cache
+// misses and branch misses in one group, counted in user space only. Each render thread opens
+// its own group (forThisThread); where perf events are unavailable (other OS, no PMU in a VM,
+// perf_event_paranoid) available() is false and read() returns zeros.
+class PerfCounters {
+public:
+  enum Event : uint32_t { Cycles = 0, Instructions, CacheMisses, BranchMisses, kEventCount };
+  struct Sample {
+    uint64_t v[kEventCount] = {0, 0, 0, 0};
+    Sample operator-(const Sample& o) const { Sample d; for (uint32_t i = 0; i < kEventCount; ++i) d.v[i] = v[i] - o.v[i]; return d; }
+  };
+
+  PerfCounters() { open(); }
+  ~PerfCounters() { close(); }
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // The calling thread's group, opened on first use
+  static PerfCounters& forThisThread() {
+    static thread_local PerfCounters counters;
+    return counters;
+  }
+
+  bool available() const { return leader_ >= 0; }
+  // Counters the PMU did not provide read as 0
+  bool has(Event e) const { return slot_[e] >= 0; }
+
+  Sample read() const {
+    Sample s;
+#if defined(__linux__)
+    if (leader_ < 0) return s;
+    struct { uint64_t nr; uint64_t values[kEventCount]; } buf{};
+    if (::read(leader_, &buf, sizeof(buf)) <= 0) return s;
+    for (uint32_t e = 0; e < kEventCount; ++e) {
+      if (slot_[e] >= 0 && static_cast<uint64_t>(slot_[e]) < buf.nr) s.v[e] = buf.values[slot_[e]];
+    }
+#endif
+    return s;
+  }
+
+private:
+  void open() {
+#if defined(__linux__)
+    static const uint64_t kConfig[kEventCount] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+    int members = 0;
+    for (uint32_t e = 0; e < kEventCount; ++e) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = kConfig[e];
+      if (leader_ < 0) attr.disabled = 1; // the group leader starts disabled (attr is zeroed)
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      const int fd = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0));
+      if (fd < 0) {
+        if (e == Cycles) return; // no leader: counters unavailable
+        continue;
+      }
+      if (leader_ < 0) leader_ = fd;
+      fds_[e] = fd;
+      slot_[e] = members++;
+    }
+    if (::ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) != 0 ||
+        ::ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) != 0) close();
+#endif
+  }
+  void close() {
+#if defined(__linux__)
+    for (uint32_t e = 0; e < kEventCount; ++e) {
+      if (fds_[e] >= 0) ::close(fds_[e]);
+      fds_[e] = -1; slot_[e] = -1;
+    }
+#endif
+    leader_ = -1;
+  }
+
+  int leader_ = -1;
+  int fds_[kEventCount] = {-1, -1, -1, -1};
+  int slot_[kEventCount] = {-1, -1, -1, -1}; // position in the group read, -1 = not counted
+};
@@ -1,16 +1,64 @@
 #pragma once
 
-#include <random>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 
-// Simple global RNG for deterministic behavior when a seed is provided.
-// Not thread-safe for concurrent mutation; seed once on startup.
-inline std::mt19937& globalRng() {
-  static std::mt19937 rng{std::random_device{}()};
-  return rng;
+// Counter-based random streams (SplitMix64 finaliser applied to key + index * gamma).
+// Every draw is a pure function of (key, index), so a stream can be sampled at any absolute
+// position: chunked, parallel or partially skipped renders see the same numbers as a straight run.
+// Streams are keyed per node from the graph randomSeed and the node id (see deriveRngKey).
+
+inline uint64_t rngMix64(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+// FNV-1a; stable across platforms and runs (std::hash is not)
+inline uint64_t rngHashString(const std::string& s) {
+  uint64_t h = 0xCBF29CE484222325ull;
+  for (unsigned char c : s) { h ^= c; h *= 0x100000001B3ull; }
+  return h;
 }
 
-inline void setGlobalSeed(uint32_t seed) {
-  if (seed != 0) globalRng().seed(seed);
+// Stream key for one node: seed 0 (unspecified) still yields distinct, reproducible streams per id
+inline uint64_t deriveRngKey(uint64_t seed, const std::string& streamId) {
+  return rngMix64(rngMix64(seed) ^ rngHashString(streamId));
 }
 
+class RngStream {
+public:
+  static constexpr uint64_t kGamma = 0x9E3779B97F4A7C15ull;
+
+  RngStream() = default;
+  explicit RngStream(uint64_t key) : key_(key) {}
+
+  void setKey(uint64_t key) { key_ = key; counter_ = 0; }
+  uint64_t key() const { return key_; }
+  void seek(uint64_t index) { counter_ = index; }
+  uint64_t position() const { return counter_; }
+
+  uint64_t at(uint64_t index) const { return rngMix64(key_ + (index + 1) * kGamma); }
+  uint64_t nextU64() { return at(counter_++); }
+  uint32_t nextU32() { return static_cast<uint32_t>(nextU64() >> 32); }
+  float nextUnit() { return toUnit(nextU64()); }
+  float nextBipolar() { return toBipolar(nextU64()); }
+
+  // Block fill; iterations are independent, so the loop vectorises
+  void fillBipolar(float* out, uint32_t n) { fillBipolarAt(out, n, counter_); counter_ += n; }
+  void fillBipolarAt(float* out, uint32_t n, uint64_t index) const {
+    for (uint32_t i = 0; i < n; ++i) out[i] = toBipolar(at(index + i));
+  }
+  void fillUnitAt(float* out, uint32_t n, uint64_t index) const {
+    for (uint32_t i = 0; i < n; ++i) out[i] = toUnit(at(index + i));
+  }
+
+  // [0,1) from the top 24 bits; [-1,1) from the top 32 bits as signed
+  static float toUnit(uint64_t x) { return static_cast<float>(static_cast<uint32_t>(x >> 40)) * (1.0f / 16777216.0f); }
+  static float toBipolar(uint64_t x) { return static_cast<float>(static_cast<int32_t>(static_cast<uint32_t>(x >> 32))) * (1.0f / 2147483648.0f); }
 
+private:
+  uint64_t key_ = 0;
+  uint64_t counter_ = 0;
+};
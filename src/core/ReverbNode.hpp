@@ -1,5 +1,6 @@
 #pragma once
 
+#include "MemoryAccounting.hpp"
 #include "Node.hpp"
 #include <vector>
 #include <algorithm>
@@ -66,6 +67,21 @@ public:
     }
   }
 
+  // Comb lines hashed from their current positions; the undamped feedback rarely reaches exact
+  // zero, so reverb tails usually keep a graph from converging
+  bool hashState(StateHash& h) const override {
+    h.add(roomSize, damp, mix, lpL_, lpR_);
+    auto line = [&](const std::vector<float>& d, size_t idx) {
+      if (d.empty()) return;
+      const size_t p = idx % d.size();
+      h.floats(d.data() + p, d.size() - p);
+      h.floats(d.data(), p);
+    };
+    line(delayL_, idxL_); line(delayR_, idxR_);
+    return true;
+  }
+  size_t memoryBytes() const override { return vectorBytes(delayL_) + vectorBytes(delayR_); }
+
 private:
   void initDelayLines() {
     // Delay lengths as primes near ~30..80ms at 48k
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "MemoryAccounting.hpp"
+#include "StateHash.hpp"
+
+// Sidechain key analysis for compressors and duckers: mono fold, optional detector high-pass,
+// band filters and envelope followers, one envelope value per frame and band. Every consumer
+// owns one; a graph or session bus whose consumers share a key and equal detector settings
+// analyses the key once per block into a shared detector and lets each consumer read it.
+class SidechainDetector {
+public:
+  struct BiquadState { float z1 = 0, z2 = 0; };
+  struct Biquad {
+    float b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    float process(float x, BiquadState& s) const {
+      const float y = b0*x + b1*s.z1 + b2*s.z2 - a1*s.z1 - a2*s.z2; // Direct Form I (simplified)
+      s.z2 = s.z1; s.z1 = y;
+      return y;
+    }
+  };
+  static Biquad designBandpass(float sampleRate, float centerHz, float q) {
+    const float w0 = 2.0f * static_cast<float>(M_PI) * (centerHz / sampleRate);
+    const float cosw = std::cos(w0), sinw = std::sin(w0);
+    const float alpha = sinw / (2.0f * q);
+    float b0 = alpha, b1 = 0, b2 = -alpha;
+    float a0 = 1 + alpha; float a1 = -2 * cosw; float a2 = 1 - alpha;
+    Biquad biq{}; biq.b0 = b0/a0; biq.b1 = b1/a0; biq.b2 = b2/a0; biq.a1 = a1/a0; biq.a2 = a2/a0; return biq;
+  }
+
+  struct Config {
+    bool bands = false;          // false: one broadband |L|,|R| follower (compressor)
+    float attackMs = 10.0f;
+    float releaseMs = 100.0f;
+    float hpfHz = 0.0f;          // bands: detector high-pass (<= 1 Hz: off)
+    std::vector<float> centerHz; // bands: bandpass centers and Qs
+    std::vector<float> q;
+    bool operator==(const Config& o) const {
+      return bands == o.bands && attackMs == o.attackMs && releaseMs == o.releaseMs &&
+             (!bands || (hpfHz == o.hpfHz && centerHz == o.centerHz && q == o.q));
+    }
+    bool operator!=(const Config& o) const { return !(*this == o); }
+  };
+
+  SidechainDetector() { allocate(); }
+
+  // Block stamp of the last analyse() for owners that analyse a shared detector once per block
+  uint64_t serial = 0;
+
+  // New settings keep the envelopes unless the band count changes
+  void configure(const Config& cfg) {
+    const bool resize = cfg.bands != config_.bands || cfg.centerHz.size() != config_.centerHz.size();
+    config_ = cfg;
+    updateCoefs();
+    if (resize) allocate();
+  }
+  const Config& config() const { return config_; }
+
+  void prepare(double sampleRate, uint32_t maxBlock) {
+    sampleRate_ = sampleRate > 0.0 ? sampleRate : 48000.0;
+    capacity_ = std::max(maxBlock, 1u);
+    updateCoefs();
+    allocate();
+  }
+  void reset() {
+    std::fill(levels_.begin(), levels_.end(), 0.0f);
+    for (auto& s : states_) s = BiquadState{};
+    hpfPrevX_ = 0.0f; hpfPrevY_ = 0.0f;
+    serial = 0;
+  }
+
+  size_t bandCount() const { return levels_.size(); }
+  // Envelope of band b for the frames of the last analyse()
+  const float* envelope(size_t band) const { return env_.data() + band * capacity_; }
+
+  // Analyse frames of the interleaved key
+  void analyse(const float* sc, uint32_t frames, uint32_t channels) {
+    if (channels == 0 || frames == 0) return;
+    if (frames > capacity_) {
+      capacity_ = frames;
+      env_.assign(levels_.size() * capacity_, 0.0f);
+      mono_.assign(config_.bands ? capacity_ : 0u, 0.0f);
+    }
+    if (!config_.bands) {
+      // Mono from the first two channels by averaging magnitudes
+      float env = levels_[0];
+      float* out = env_.data();
+      for (uint32_t i = 0; i < frames; ++i) {
+        float x = 0.0f;
+        if (channels == 1) {
+          x = std::fabs(sc[i]);
+        } else {
+          const float L = sc[2 * static_cast<size_t>(i)];
+          const float R = sc[2 * static_cast<size_t>(i) + 1];
+          x = 0.5f * (std::fabs(L) + std::fabs(R));
+        }
+        const float coef = (x > env) ? attackCoef_ : releaseCoef_;
+        env = x + coef * (env - x);
+        out[i] = env;
+      }
+      levels_[0] = env;
+      return;
+    }
+    for (uint32_t i = 0; i < frames; ++i) {
+      double sum = 0.0;
+      for (uint32_t c = 0; c < channels; ++c) sum += sc[static_cast<size_t>(i)*channels + c];
+      mono_[i] = static_cast<float>(sum / static_cast<double>(channels));
+    }
+    if (config_.hpfHz > 1.0f && hpfAlpha_ > 0.0f) {
+      for (uint32_t i = 0; i < frames; ++i) {
+        const float x = mono_[i];
+        const float y = hpfAlpha_ * (hpfPrevY_ + x - hpfPrevX_);
+        hpfPrevX_ = x; hpfPrevY_ = y; mono_[i] = y;
+      }
+    }
+    for (size_t bi = 0; bi < levels_.size(); ++bi) {
+      const Biquad& q = filters_[bi];
+      BiquadState& st = states_[bi];
+      float env = levels_[bi];
+      float* out = env_.data() + bi * capacity_;
+      for (uint32_t i = 0; i < frames; ++i) {
+        const float rect = std::fabs(q.process(mono_[i], st));
+        const float coef = (rect > env) ? attackCoef_ : releaseCoef_;
+        env = rect + coef * (env - rect);
+        out[i] = env;
+      }
+      levels_[bi] = env;
+    }
+  }
+
+  // Broadband follower over a silent key: the envelope releases toward zero
+  void releaseSilent(uint32_t frames) {
+    float& env = levels_[0];
+    for (uint32_t i = 0; i < frames && env != 0.0f; ++i) env = releaseCoef_ * env;
+  }
+
+  size_t memoryBytes() const {
+    return vectorBytes(filters_) + vectorBytes(states_) + vectorBytes(levels_) + vectorBytes(env_) + vectorBytes(mono_);
+  }
+
+  void hashState(StateHash& h) const {
+    h.add(config_.bands, attackCoef_, releaseCoef_, hpfPrevX_, hpfPrevY_);
+    h.floats(levels_.data(), levels_.size());
+    for (const auto& s : states_) h.add(s.z1, s.z2);
+  }
+
+private:
+  void updateCoefs() {
+    const float attT = std::max(0.0001f, config_.attackMs / 1000.0f);
+    const float relT = std::max(0.0001f, config_.releaseMs / 1000.0f);
+    attackCoef_ = std::exp(-1.0f / static_cast<float>(sampleRate_ * attT));
+    releaseCoef_ = std::exp(-1.0f / static_cast<float>(sampleRate_ * relT));
+    if (config_.bands && config_.hpfHz > 1.0f) {
+      const double dt = 1.0 / std::max(1.0, sampleRate_);
+      const double RC = 1.0 / (2.0 * M_PI * static_cast<double>(config_.hpfHz));
+      hpfAlpha_ = static_cast<float>(RC / (RC + dt));
+    } else hpfAlpha_ = 0.0f;
+    filters_.clear();
+    if (config_.bands) {
+      for (size_t i = 0; i < config_.centerHz.size(); ++i) {
+        const float q = i < config_.q.size() ? config_.q[i] : 1.0f;
+        filters_.push_back(designBandpass(static_cast<float>(sampleRate_), config_.centerHz[i], std::max(0.1f, q)));
+      }
+    }
+  }
+  void allocate() {
+    const size_t n = config_.bands ? config_.centerHz.size() : 1u;
+    levels_.assign(n, 0.0f);
+    states_.assign(config_.bands ? n : 0u, BiquadState{});
+    env_.assign(n * capacity_, 0.0f);
+    mono_.assign(config_.bands ? capacity_ : 0u, 0.0f);
+    hpfPrevX_ = 0.0f; hpfPrevY_ = 0.0f;
+  }
+
+  Config config_{};
+  double sampleRate_ = 48000.0;
+  uint32_t capacity_ = 1;
+  float attackCoef_ = 0.0f;
+  float releaseCoef_ = 0.0f;
+  float hpfAlpha_ = 0.0f;
+  float hpfPrevX_ = 0.0f, hpfPrevY_ = 0.0f;
+  std::vector<Biquad> filters_{};
+  std::vector<BiquadState> states_{};
+  std::vector<float> levels_{};  // running envelope per band
+  std::vector<float> env_{};     // per band: capacity_ frames of envelope
+  std::vector<float> mono_{};
+};
@@ -38,60 +38,52 @@ public:
     maxBlock_ = maxBlock;
     lookaheadSamples_ = static_cast<uint32_t>(std::max(0.0, std::floor((lookaheadMs / 1000.0f) * static_cast<float>(sampleRate_) + 0.5)));
     ensureDelayCapacity(lastChannels_ == 0 ? 2u : lastChannels_);
-    updateDetectorHpf();
     setupBands();
   }
   void reset() override {
     CompressorNode::reset();
-    for (auto& s : states_) s = BiquadState{};
-    for (auto& e : envs_) e = 0.0f;
     std::fill(delay_.begin(), delay_.end(), 0.0f);
     writeIndexFrames_ = 0;
-    scPrevX_ = 0.0f; scPrevY_ = 0.0f;
     for (auto& perBand : mainStates_) for (auto& st : perBand) st = BiquadState{};
     std::fill(lastBandGain_.begin(), lastBandGain_.end(), 1.0f);
     std::fill(holdRemain_.begin(), holdRemain_.end(), 0u);
   }
 
-  void applySidechain(ProcessContext ctx, float* mainInterleaved, const float* scInterleaved, uint32_t channels) override {
+  // Band filters, hold counters and the lookahead line carry state; always process
+  bool skipIfSilent(ProcessContext ctx) override { (void)ctx; return false; }
+  // Band and lookahead state is not hashed: graphs with a ducker always render every loop
+  bool hashState(StateHash&) const override { return false; }
+  size_t memoryBytes() const override {
+    return CompressorNode::memoryBytes() + vectorBytes(gains_) + vectorBytes(filters_) + vectorBytes(delay_) + nestedVectorBytes(mainStates_) +
+           vectorBytes(lastBandGain_) + vectorBytes(holdRemain_) + vectorBytes(holdSamplesPerBand_);
+  }
+
+  SidechainDetector::Config detectorConfig() const override {
+    SidechainDetector::Config c;
+    c.bands = true; c.attackMs = attackMs; c.releaseMs = releaseMs; c.hpfHz = scHpfHz;
+    for (const auto& b : bands) { c.centerHz.push_back(b.centerHz); c.q.push_back(b.q); }
+    return c;
+  }
+
+  void applyDetected(ProcessContext ctx, float* mainInterleaved, const SidechainDetector& det, uint32_t offset, uint32_t channels) override {
     const uint32_t frames = ctx.frames;
     if (channels == 0 || frames == 0) return;
     if (lastChannels_ != channels || delay_.empty()) ensureDelayCapacity(channels);
     lastChannels_ = channels;
-    // Build mono sidechain
-    scMono_.assign(frames, 0.0f);
-    for (uint32_t i = 0; i < frames; ++i) {
-      double sum = 0.0;
-      for (uint32_t c = 0; c < channels; ++c) sum += scInterleaved[static_cast<size_t>(i)*channels + c];
-      scMono_[i] = static_cast<float>(sum / static_cast<double>(channels));
-    }
-    // Optional detector HPF
-    if (scHpfHz > 1.0f && scHpfAlpha_ > 0.0f) {
-      for (uint32_t i = 0; i < frames; ++i) {
-        const float x = scMono_[i];
-        const float y = scHpfAlpha_ * (scPrevY_ + x - scPrevX_);
-        scPrevX_ = x; scPrevY_ = y; scMono_[i] = y;
-      }
-    }
-    // For each band: filter detector -> envelope -> per-band gain via threshold/ratio/knee/hold; combine via min
+    // For each band: detector envelope -> per-band gain via threshold/ratio/knee/hold; combine via min
     if (filters_.size() != bands.size()) setupBands();
-    if (envs_.size() != bands.size()) envs_.assign(bands.size(), 0.0f);
-    if (states_.size() != bands.size()) states_.assign(bands.size(), BiquadState{});
     if (lastBandGain_.size() != bands.size()) lastBandGain_.assign(bands.size(), 1.0f);
     if (holdRemain_.size() != bands.size()) holdRemain_.assign(bands.size(), 0u);
+    const size_t nBands = std::min(bands.size(), det.bandCount());
 
     gains_.assign(frames, 1.0f);
-    for (size_t bi = 0; bi < bands.size(); ++bi) {
+    for (size_t bi = 0; bi < nBands; ++bi) {
       const Band& b = bands[bi];
       const float depthLin = std::pow(10.0f, b.depthDb / 20.0f);
-      const Biquad& q = filters_[bi];
-      BiquadState& st = states_[bi];
-      float env = envs_[bi];
+      const float* envs = det.envelope(bi) + offset;
       uint32_t hold = holdRemain_[bi];
       for (uint32_t i = 0; i < frames; ++i) {
-        const float rect = std::fabs(q.process(scMono_[i], st));
-        const float coef = (rect > env) ? attackCoef_ : releaseCoef_;
-        env = rect + coef * (env - rect);
+        const float env = envs[i];
         float g = 1.0f;
         // Convert to dB for static curve
         const float envDb = (env > 1e-8f) ? 20.0f * std::log10(env) : -80.0f;
@@ -121,7 +113,6 @@ public:
         g = std::max(depthLin, g);
         gains_[i] = std::min(gains_[i], g);
       }
-      envs_[bi] = env;
       holdRemain_[bi] = hold;
     }
     // Apply per-sample band-combined gain to main signal (two modes)
@@ -193,9 +184,8 @@ public:
   uint32_t latencySamples() const override { return lookaheadSamples_; }
 
 private:
-  // Simple biquad peaking EQ structure
-  struct BiquadState { float z1=0,z2=0; };
-  struct Biquad { float b0=1,b1=0,b2=0,a1=0,a2=0; float process(float x, BiquadState& s) const; };
+  using BiquadState = SidechainDetector::BiquadState;
+  using Biquad = SidechainDetector::Biquad;
   static Biquad designPeaking(float sampleRate, float centerHz, float q, float gainDb) {
     const float A = std::pow(10.0f, gainDb / 40.0f);
     const float w0 = 2.0f * static_cast<float>(M_PI) * (centerHz / sampleRate);
@@ -209,19 +199,9 @@ private:
     float a2 = 1 - alpha / A;
     Biquad biq{}; biq.b0 = b0/a0; biq.b1 = b1/a0; biq.b2 = b2/a0; biq.a1 = a1/a0; biq.a2 = a2/a0; return biq;
   }
-  static Biquad designBandpass(float sampleRate, float centerHz, float q) {
-    const float w0 = 2.0f * static_cast<float>(M_PI) * (centerHz / sampleRate);
-    const float cosw = std::cos(w0), sinw = std::sin(w0);
-    const float alpha = sinw / (2.0f * q);
-    float b0 = alpha, b1 = 0, b2 = -alpha;
-    float a0 = 1 + alpha; float a1 = -2 * cosw; float a2 = 1 - alpha;
-    Biquad biq{}; biq.b0 = b0/a0; biq.b1 = b1/a0; biq.b2 = b2/a0; biq.a1 = a1/a0; biq.a2 = a2/a0; return biq;
-  }
   void setupBands() {
     filters_.clear(); filters_.reserve(bands.size());
-    for (const auto& b : bands) filters_.push_back(designBandpass(static_cast<float>(sampleRate_), b.centerHz, std::max(0.1f, b.q)));
-    states_.assign(bands.size(), BiquadState{});
-    envs_.assign(bands.size(), 0.0f);
+    for (const auto& b : bands) filters_.push_back(SidechainDetector::designBandpass(static_cast<float>(sampleRate_), b.centerHz, std::max(0.1f, b.q)));
     lastBandGain_.assign(bands.size(), 1.0f);
     holdRemain_.assign(bands.size(), 0u);
     holdSamplesPerBand_.assign(bands.size(), 0u);
@@ -241,21 +221,10 @@ private:
     if (mainStates_.size() != bands.size()) mainStates_.assign(bands.size(), std::vector<BiquadState>());
     for (auto& v : mainStates_) if (v.size() != channels) v.assign(channels, BiquadState{});
   }
-  void updateDetectorHpf() {
-    if (scHpfHz > 1.0f) {
-      const double dt = 1.0 / std::max(1.0, sampleRate_);
-      const double RC = 1.0 / (2.0 * M_PI * static_cast<double>(scHpfHz));
-      scHpfAlpha_ = static_cast<float>(RC / (RC + dt));
-    } else scHpfAlpha_ = 0.0f;
-  }
-
   double sampleRate_ = 48000.0;
   uint32_t maxBlock_ = 0;
-  std::vector<float> scMono_{};
   std::vector<float> gains_{};
-  std::vector<Biquad> filters_{};
-  std::vector<BiquadState> states_{};
-  std::vector<float> envs_{};
+  std::vector<Biquad> filters_{}; // band filters for the dynamic EQ path
   // Lookahead delay line (interleaved)
   std::vector<float> delay_{};
   uint32_t lookaheadSamples_ = 0;
@@ -264,19 +233,8 @@ private:
   uint32_t lastChannels_ = 0;
   // Dynamic EQ state (per band x channel)
   std::vector<std::vector<BiquadState>> mainStates_{};
-  // Detector HPF state
-  float scPrevX_ = 0.0f, scPrevY_ = 0.0f;
-  float scHpfAlpha_ = 0.0f;
   // Per-band hold and last gain
   std::vector<float> lastBandGain_{};
   std::vector<uint32_t> holdRemain_{};
   std::vector<uint32_t> holdSamplesPerBand_{};
 };
-
-inline float SpectralDuckerNode::Biquad::process(float x, SpectralDuckerNode::BiquadState& s) const {
-  const float y = b0*x + b1*s.z1 + b2*s.z2 - a1*s.z1 - a2*s.z2; // Direct Form I (simplified)
-  s.z2 = s.z1; s.z1 = y;
-  return y;
-}
-
-
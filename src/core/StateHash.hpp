@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// FNV-1a digest of a node's carried state (phases, envelopes, filter and delay memory, ramps,
+// latched params). Used by the loop-aware offline renderer to prove that a loop left every node
+// exactly where the previous loop did. Values are added field by field, never as raw structs,
+// so padding bytes do not leak in.
+class StateHash {
+public:
+  void bytes(const void* p, size_t n) {
+    const unsigned char* b = static_cast<const unsigned char*>(p);
+    for (size_t i = 0; i < n; ++i) { h_ ^= b[i]; h_ *= 0x100000001B3ull; }
+  }
+  template <typename... T> StateHash& add(const T&... v) { (addOne(v), ...); return *this; }
+  void floats(const float* p, size_t n) { bytes(p, n * sizeof(float)); }
+  uint64_t value() const { return h_; }
+
+private:
+  template <typename T> void addOne(const T& v) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "hash fields, not structs");
+    bytes(&v, sizeof(T));
+  }
+  uint64_t h_ = 0xCBF29CE484222325ull;
+};
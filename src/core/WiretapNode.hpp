@@ -1,15 +1,19 @@
 #pragma once
 
 #include "Node.hpp"
-#include "../io/AudioFileWriter.hpp"
-#include <vector>
+#include "../io/AudioStreamWriter.hpp"
+#include <algorithm>
+#include <cstdio>
 #include <string>
 
-// WiretapNode: pass-through insert that records its input to a file (offline-safe)
+// WiretapNode: pass-through insert that streams its input to a float WAV file. Blocks go
+// through a preallocated ring to a background writer thread (AudioStreamWriter), so the tap
+// holds bufferSeconds of stereo audio however long the render runs. Offline renders wait for
+// the writer when the ring is full; realtime renders (setRealtime) drop and count the block.
 class WiretapNode : public Node {
 public:
-  explicit WiretapNode(std::string path, bool enabled = true)
-    : path_(std::move(path)), enabled_(enabled) {}
+  explicit WiretapNode(std::string path, bool enabled = true, double bufferSeconds = 2.0)
+    : path_(std::move(path)), enabled_(enabled), bufferSeconds_(bufferSeconds > 0.05 ? bufferSeconds : 0.05) {}
 
   ~WiretapNode() override {
     flush();
@@ -17,39 +21,48 @@ public:
 
   const char* name() const override { return "wiretap"; }
 
-  void prepare(double sampleRate, uint32_t /*maxBlock*/) override {
+  // Each prepare starts a new file (the previous stream, if any, is finalized first)
+  void prepare(double sampleRate, uint32_t maxBlock) override {
+    flush();
     sampleRate_ = sampleRate > 0.0 ? sampleRate : 48000.0;
-    outTap_.clear(); channels_ = 0; wrote_ = false;
+    if (!enabled_ || path_.empty()) return;
+    AudioFileSpec spec; spec.format = FileFormat::Wav; spec.bitDepth = BitDepth::Float32; spec.sampleRate = static_cast<uint32_t>(sampleRate_ + 0.5);
+    const size_t ringSamples = std::max<size_t>(static_cast<size_t>(bufferSeconds_ * sampleRate_) * 2u, static_cast<size_t>(maxBlock) * 16u);
+    stream_.setRealtime(realtime_);
+    stream_.start(path_, spec, ringSamples);
   }
 
   void reset() override {
-    // no-op: we flush late to capture whole render
+    // no-op: the stream runs until flush() or the next prepare()
   }
 
   void process(ProcessContext, float*, uint32_t) override {}
 
   void processInPlace(ProcessContext ctx, float* interleaved, uint32_t channels) override {
-    if (!enabled_ || path_.empty()) return;
-    if (channels_ == 0) channels_ = channels;
-    const size_t n = static_cast<size_t>(ctx.frames) * channels;
-    const size_t prev = outTap_.size();
-    outTap_.resize(prev + n);
-    std::memcpy(outTap_.data() + prev, interleaved, n * sizeof(float));
+    stream_.push(interleaved, ctx.frames, channels);
   }
 
+  // Realtime renderers: never wait for the writer on the audio thread
+  void setRealtime(bool on) { realtime_ = on; stream_.setRealtime(on); }
+
+  size_t memoryBytes() const override { return stream_.memoryBytes(); }
+  uint64_t droppedFrames() const { return stream_.droppedFrames(); }
+
+  // Drain the ring and finalize the file
   void flush() {
-    if (!enabled_ || path_.empty() || outTap_.empty() || wrote_) return;
-    AudioFileSpec spec; spec.format = FileFormat::Wav; spec.bitDepth = BitDepth::Float32; spec.sampleRate = static_cast<uint32_t>(sampleRate_ + 0.5); spec.channels = channels_ > 0 ? channels_ : 2;
-    try { writeWithExtAudioFile(path_, spec, outTap_); wrote_ = true; } catch (...) { /* swallow for debug use */ }
+    if (!stream_.running()) return;
+    stream_.stop();
+    if (stream_.droppedFrames() > 0) {
+      std::fprintf(stderr, "Warning: wiretap %s dropped %llu frames (writer fell behind; raise bufferSeconds)\n",
+                   path_.c_str(), static_cast<unsigned long long>(stream_.droppedFrames()));
+    }
   }
 
 private:
   std::string path_;
   bool enabled_ = true;
+  double bufferSeconds_ = 2.0;
+  bool realtime_ = false;
   double sampleRate_ = 48000.0;
-  uint32_t channels_ = 0;
-  std::vector<float> outTap_{};
-  bool wrote_ = false;
+  AudioStreamWriter stream_;
 };
-
-
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Float exp and sin for lane loops (structure-of-arrays kernels such as KickLanes): arithmetic,
+// int conversions and selects only, so a loop over lanes that calls them vectorises. Scalar
+// code rendering the same voice calls them too, so both paths produce the same bits, and the
+// result doesn't depend on the platform libm.
+namespace lane_math {
+
+// 2^n for integral n in [-126, 127]
+inline float exp2i(int32_t n) {
+  const int32_t bits = (n + 127) << 23;
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+// e^x within ~2 ulp (Cephes expf polynomial). Clamped to [-87.3, 88]: the low end returns the
+// smallest normal float instead of a denormal; NaN maps to the low end.
+inline float expf(float x) {
+  x = x > -87.33654f ? x : -87.33654f;
+  x = x < 88.0f ? x : 88.0f;
+  // x = k ln2 + r, |r| <= ln2/2; k rounded to nearest (valid for |k| < 2^22)
+  const float k = (x * 1.44269504088896341f + 12582912.0f) - 12582912.0f;
+  const float r = (x - k * 0.693359375f) + k * 2.12194440e-4f;
+  const float z = r * r;
+  float p = 1.9875691500e-4f;
+  p = p * r + 1.3981999507e-3f;
+  p = p * r + 8.3334519073e-3f;
+  p = p * r + 4.1665795894e-2f;
+  p = p * r + 1.6666665459e-1f;
+  p = p * r + 5.0000001201e-1f;
+  const float e = p * z + r + 1.0f;
+  return e * exp2i(static_cast<int32_t>(k));
+}
+
+// sin(x) within ~2 ulp for |x| < 8192 (three-part pi/2 reduction, Cephes polynomials);
+// accuracy degrades gracefully beyond
+inline float sinf(float x) {
+  const float k = (x * 0.63661977236758134f + 12582912.0f) - 12582912.0f;
+  const float r = ((x - k * 1.5703125f) - k * 4.837512969970703125e-4f) - k * 7.54978995489188216e-8f;
+  const float z = r * r;
+  const float s = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * r + r;
+  const float c = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+  const int32_t q = static_cast<int32_t>(k);
+  const float v = (q & 1) ? c : s;
+  return (q & 2) ? -v : v;
+}
+
+} // namespace lane_math
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ClapSynth.hpp"
+#include <algorithm>
 #include "../../core/Node.hpp"
 #include "../../core/ParamIds.hpp"
 #include "../../core/ParameterRegistry.hpp"
@@ -25,6 +26,7 @@ public:
     mod_.prepare(sampleRate);
   }
   void reset() override { synth_.reset(); }
+  void setRandomKey(uint64_t key) override { synth_.setNoiseSeed(static_cast<uint32_t>(key >> 32) ^ static_cast<uint32_t>(key)); }
   void process(ProcessContext ctx, float* interleavedOut, uint32_t channels) override {
     for (uint32_t i = 0; i < ctx.frames; ++i) {
       mod_.tick();
@@ -51,6 +53,15 @@ public:
     }
   }
 
+  bool skipIfSilent(ProcessContext ctx) override {
+    if (!synth_.idle() || !params_.settled()) return false;
+    mod_.skip(ctx.frames);
+    // Leave gain/decay as the block's last sample would
+    nodeGain_ = std::max(0.0f, params_.current(ClapParam::GAIN) + mod_.sumFor(ClapParam::GAIN));
+    synth_.params().ampDecayMs = std::max(1.0f, params_.current(ClapParam::AMP_DECAY_MS) + mod_.sumFor(ClapParam::AMP_DECAY_MS));
+    return true;
+  }
+
   void handleEvent(const Command& cmd) override {
     if (cmd.type == CommandType::Trigger) {
       // Use gain as velocity proxy if VELOCITY param is not defined in ParamIds
@@ -73,6 +84,11 @@ public:
       else if (cmd.paramId == ClapParam::AMP_DECAY_MS) params_.rampTo(ClapParam::AMP_DECAY_MS, cmd.value, cmd.rampMs);
     }
   }
+  bool hashState(StateHash& h) const override {
+    synth_.hashState(h); params_.hashState(h); mod_.hashState(h);
+    h.add(nodeGain_);
+    return true;
+  }
 private:
   ClapSynth synth_;
   ParameterRegistry<> params_;
@@ -12,7 +12,12 @@ void ClapSynth::reset() {
   active_ = false;
   triggeredOnce_ = false;
   framesUntilNextTrigger_ = 0;
-  rngState_ = 0x12345678u;
+  rngState_ = noiseSeed_;
+}
+
+void ClapSynth::setNoiseSeed(uint32_t seed) {
+  noiseSeed_ = seed != 0 ? seed : 0x12345678u; // xorshift must not start at zero
+  rngState_ = noiseSeed_;
 }
 
 void ClapSynth::trigger() {
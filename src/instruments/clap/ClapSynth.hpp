@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include "../../core/StateHash.hpp"
 
 struct ClapParams {
   float ampDecayMs = 180.0f;
@@ -15,9 +16,18 @@ public:
   void setSampleRate(double sr);
   double sampleRate() const;
   void reset();
+  // Seed for the noise burst; reset() rewinds to it so retriggered renders repeat exactly
+  void setNoiseSeed(uint32_t seed);
   void trigger();
   void trigger(float velocity);
   float process();
+  // Not sounding and nothing scheduled: process() returns 0 without touching state
+  bool idle() const { return !active_ && !params_.loop; }
+  // rngState_ runs on across triggers, so a sounding clap never repeats a loop exactly
+  void hashState(StateHash& h) const {
+    h.add(params_.ampDecayMs, params_.gain, params_.bpm, params_.loop);
+    h.add(tSec_, framesUntilNextTrigger_, active_, triggeredOnce_, rngState_, velocity_);
+  }
   const ClapParams& params() const;
   ClapParams& params();
 
@@ -30,6 +40,7 @@ private:
   uint64_t framesUntilNextTrigger_ = 0;
   bool active_ = false;
   bool triggeredOnce_ = false;
+  uint32_t noiseSeed_ = 0x12345678u;
   uint32_t rngState_ = 0x12345678u;
   float velocity_ = 1.0f; // 0..1, applied to output
 };
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "KickSynth.hpp"
+#include "../../dsp/LaneMath.hpp"
+
+// Up to 8 kick voices stored structure-of-arrays for the batch kernel (see KickNode): load()
+// copies a KickSynth's voice and its settled parameters into one lane, render() runs L lanes per
+// sample with branch-free lane loops so they vectorise, store() writes the voice back. The
+// arithmetic is KickSynth::process() in select form, so a lane renders the same bits.
+class KickLanes {
+public:
+  static constexpr uint32_t kMaxLanes = 8;
+
+  // Lanes count frames in doubles: a loop needs a finite period and counters below 2^53
+  // (bpm 0 with loop on, an undefined period, stays on KickSynth::process)
+  static bool fits(const KickSynth& synth) {
+    const KickParams& p = synth.params();
+    const double limit = 9007199254740992.0;
+    if (static_cast<double>(synth.voice().framesUntilNextTrigger) >= limit) return false;
+    if (!p.loop) return true;
+    const double period = 60.0 / static_cast<double>(p.bpm) * synth.sampleRate() + 0.5;
+    return p.bpm > 0.0f && period < limit;
+  }
+
+  void load(uint32_t v, const KickSynth& synth, float nodeGain) {
+    const KickParams& p = synth.params();
+    const KickSynth::Voice s = synth.voice();
+    const double sr = synth.sampleRate();
+    phase_[v] = s.phase; tSec_[v] = s.tSec; untilTrigger_[v] = static_cast<double>(s.framesUntilNextTrigger);
+    active_[v] = s.active ? 1 : 0; triggeredOnce_[v] = s.triggeredOnce ? 1 : 0;
+    loop_[v] = p.loop ? 1 : 0;
+    period_[v] = p.loop ? static_cast<double>(static_cast<uint64_t>(60.0 / static_cast<double>(p.bpm) * sr + 0.5)) : 0.0;
+    sr_[v] = sr; dt_[v] = 1.0 / sr; clickSec_[v] = 1.5 / sr;
+    startF_[v] = p.startFreqHz; endF_[v] = p.endFreqHz;
+    tauPitch_[v] = p.pitchDecayMs * 0.001f; tauAmp_[v] = p.ampDecayMs * 0.001f;
+    click_[v] = p.click;
+    gain_[v] = p.gain; velocity_[v] = s.velocity;
+    nodeGain_[v] = nodeGain;
+  }
+
+  // The phase wraps here rather than per sample (it only matters after ~1e12 radians)
+  void store(uint32_t v, KickSynth& synth) const {
+    KickSynth::Voice s = synth.voice();
+    s.phase = phase_[v] > 1e12 ? std::fmod(phase_[v], 2.0 * M_PI) : phase_[v];
+    s.tSec = tSec_[v]; s.framesUntilNextTrigger = static_cast<uint64_t>(untilTrigger_[v]);
+    s.active = active_[v] != 0; s.triggeredOnce = triggeredOnce_[v] != 0;
+    synth.setVoice(s);
+  }
+
+  // A lane that renders silence (fills a 4- or 8-wide pass)
+  void clear(uint32_t v) {
+    phase_[v] = 0.0; tSec_[v] = 0.0; untilTrigger_[v] = 0.0; period_[v] = 0.0;
+    active_[v] = 0; triggeredOnce_[v] = 1; loop_[v] = 0;
+    sr_[v] = 48000.0; dt_[v] = 0.0; clickSec_[v] = 0.0;
+    startF_[v] = 0.0f; endF_[v] = 0.0f; tauPitch_[v] = 1.0f; tauAmp_[v] = 1.0f;
+    click_[v] = 0.0f; gain_[v] = 0.0f; velocity_[v] = 0.0f; nodeGain_[v] = 0.0f;
+  }
+
+  // n samples of lanes 0..L-1 into out, frame-major (out[i * L + v]), node gain applied
+  template <uint32_t L>
+  void render(uint32_t n, float* out) {
+    for (uint32_t i = 0; i < n; ++i) {
+      for (uint32_t v = 0; v < L; ++v) {
+        // Loop retrigger every period, or the first sample's one-shot trigger
+        const bool loop = loop_[v] != 0;
+        const double until = untilTrigger_[v];
+        const bool due = until == 0.0;
+        const bool fire = loop ? due : triggeredOnce_[v] == 0;
+        // Held state is updated as x + 0 (exact) rather than x = cond ? y : x, which compilers
+        // turn into a conditional store and then don't vectorise
+        untilTrigger_[v] = until + (loop ? (due ? period_[v] : until - 1.0) - until : 0.0);
+        triggeredOnce_[v] = triggeredOnce_[v] | (loop ? 0 : 1);
+        const double t = fire ? 0.0 : tSec_[v];
+        const double ph0 = fire ? 0.0 : phase_[v];
+        const bool on = fire | (active_[v] != 0);
+
+        const float aEnv = lane_math::expf(static_cast<float>(-t) / tauAmp_[v]);
+        const float fEnv = lane_math::expf(static_cast<float>(-t) / tauPitch_[v]);
+        const float freq = endF_[v] + (startF_[v] - endF_[v]) * fEnv;
+        const double inc = (2.0 * M_PI) * static_cast<double>(freq) / sr_[v];
+        const double ph = ph0 + inc;
+        const float s = lane_math::sinf(static_cast<float>(ph));
+        const float click = t < clickSec_[v] ? click_[v] : 0.0f;
+        const float sample = (aEnv * s + click) * gain_[v] * velocity_[v];
+
+        out[static_cast<size_t>(i) * L + v] = (on ? sample : 0.0f) * nodeGain_[v];
+        phase_[v] = ph0 + (on ? inc : 0.0);
+        tSec_[v] = t + (on ? dt_[v] : 0.0);
+        active_[v] = (on & !(aEnv < 0.00005f)) ? 1 : 0;
+      }
+    }
+  }
+
+private:
+  alignas(64) double phase_[kMaxLanes] = {};
+  alignas(64) double tSec_[kMaxLanes] = {};
+  alignas(64) double sr_[kMaxLanes] = {};
+  alignas(64) double dt_[kMaxLanes] = {};
+  alignas(64) double clickSec_[kMaxLanes] = {};
+  alignas(64) double untilTrigger_[kMaxLanes] = {}; // frame counts (exact below 2^53)
+  alignas(64) double period_[kMaxLanes] = {};
+  alignas(32) int32_t active_[kMaxLanes] = {};
+  alignas(32) int32_t triggeredOnce_[kMaxLanes] = {};
+  alignas(32) int32_t loop_[kMaxLanes] = {};
+  alignas(32) float startF_[kMaxLanes] = {};
+  alignas(32) float endF_[kMaxLanes] = {};
+  alignas(32) float tauPitch_[kMaxLanes] = {};
+  alignas(32) float tauAmp_[kMaxLanes] = {};
+  alignas(32) float click_[kMaxLanes] = {};
+  alignas(32) float gain_[kMaxLanes] = {};
+  alignas(32) float velocity_[kMaxLanes] = {};
+  alignas(32) float nodeGain_[kMaxLanes] = {};
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "KickSynth.hpp"
+#include "KickLanes.hpp"
+#include "../../core/KernelBatch.hpp"
 #include "../../core/Node.hpp"
 #include "../../core/ParamIds.hpp"
 #include "../../core/ParameterRegistry.hpp"
@@ -36,16 +38,7 @@ public:
     // Simple: mono -> copy to all channels
     for (uint32_t i = 0; i < ctx.frames; ++i) {
       mod_.tick();
-      // Smooth params
-      nodeGain_ = params_.next(KickParam::GAIN);
-      {
-        const float baseF0 = params_.next(KickParam::F0);
-        const float modF0 = baseF0 + mod_.sumFor(KickParam::F0);
-        synth_.params().startFreqHz = modF0;
-      }
-      synth_.params().endFreqHz = params_.next(KickParam::FEND);
-      synth_.params().pitchDecayMs = params_.next(KickParam::PITCH_DECAY_MS);
-      synth_.params().ampDecayMs = params_.next(KickParam::AMP_DECAY_MS);
+      pullParams();
       const float s = synth_.process();
       for (uint32_t ch = 0; ch < channels; ++ch) {
         interleavedOut[i * channels + ch] = s * nodeGain_;
@@ -53,6 +46,13 @@ public:
     }
   }
 
+  bool skipIfSilent(ProcessContext ctx) override {
+    if (!synth_.idle() || !params_.settled()) return false;
+    mod_.skip(ctx.frames);
+    pullParams();
+    return true;
+  }
+
   void handleEvent(const Command& cmd) override {
     if (cmd.type == CommandType::Trigger) {
       // Use GAIN as a proxy for velocity for now or extend ParamMap for VELOCITY if needed
@@ -83,12 +83,93 @@ public:
     }
   }
 
+  bool hashState(StateHash& h) const override {
+    synth_.hashState(h); params_.hashState(h); mod_.hashState(h);
+    h.add(nodeGain_);
+    return true;
+  }
+
+  const BatchKernel* batchKernel() const override;
+  // Lane batching: with no ramp running and no LFO route to F0 the parameters hold for a whole
+  // run, so the voice can render from a KickLanes lane instead of process()
+  bool laneReady() const { return params_.settled() && !mod_.drivesParam(KickParam::F0) && KickLanes::fits(synth_); }
+  void loadLane(KickLanes& lanes, uint32_t v) { pullParams(); lanes.load(v, synth_, nodeGain_); }
+  // After `frames` samples in the lane; the LFOs advance as process() would have ticked them
+  void storeLane(const KickLanes& lanes, uint32_t v, uint32_t frames) {
+    lanes.store(v, synth_);
+    mod_.skip(frames);
+    pullParams();
+  }
+
 private:
+  // Smoothed + modulated values for the current sample
+  void pullParams() {
+    nodeGain_ = params_.next(KickParam::GAIN);
+    synth_.params().startFreqHz = params_.next(KickParam::F0) + mod_.sumFor(KickParam::F0);
+    synth_.params().endFreqHz = params_.next(KickParam::FEND);
+    synth_.params().pitchDecayMs = params_.next(KickParam::PITCH_DECAY_MS);
+    synth_.params().ampDecayMs = params_.next(KickParam::AMP_DECAY_MS);
+  }
+
   KickSynth synth_;
   ParameterRegistry<> params_;
   ModMatrix<> mod_;
   float nodeGain_ = 1.0f;
 };
 
+// Kick nodes rendered together (runBatchLanes), up to 8 per KickLanes pass; a node mid-ramp or
+// with an LFO on F0 renders its runs through process() as it would alone
+class KickBatchKernel : public BatchKernel {
+public:
+  void render(BatchLane* lanes, uint32_t count, uint32_t channels) const override {
+    KickLanes kl;
+    runBatchLanes(lanes, count, [&](BatchLane** run, uint32_t n, uint32_t off, uint32_t frames) {
+      KickNode* nodes[kMaxLanes];
+      float* outs[kMaxLanes];
+      uint32_t k = 0;
+      for (uint32_t i = 0; i < n; ++i) {
+        auto* node = static_cast<KickNode*>(run[i]->node);
+        float* out = run[i]->out + static_cast<size_t>(off) * channels;
+        if (!node->laneReady()) {
+          ProcessContext sub = run[i]->ctx;
+          sub.frames = frames; sub.blockStart += off; sub.events = nullptr; sub.eventCount = 0;
+          node->process(sub, out, channels);
+          continue;
+        }
+        node->loadLane(kl, k);
+        nodes[k] = node; outs[k] = out; ++k;
+      }
+      if (k == 0) return;
+      // 1, 4 or 8 lanes per pass; unused lanes render silence
+      const uint32_t width = k == 1 ? 1u : (k <= 4 ? 4u : 8u);
+      for (uint32_t v = k; v < width; ++v) kl.clear(v);
+      alignas(32) float buf[kChunk * kMaxLanes];
+      for (uint32_t at = 0; at < frames; at += kChunk) {
+        const uint32_t m = std::min(kChunk, frames - at);
+        if (width == 1u) kl.render<1>(m, buf);
+        else if (width == 4u) kl.render<4>(m, buf);
+        else kl.render<8>(m, buf);
+        // Mono lane -> every channel of the node's interleaved buffer
+        for (uint32_t v = 0; v < k; ++v) {
+          float* o = outs[v] + static_cast<size_t>(at) * channels;
+          for (uint32_t i = 0; i < m; ++i) {
+            const float s = buf[static_cast<size_t>(i) * width + v];
+            for (uint32_t ch = 0; ch < channels; ++ch) o[static_cast<size_t>(i) * channels + ch] = s;
+          }
+        }
+      }
+      for (uint32_t v = 0; v < k; ++v) nodes[v]->storeLane(kl, v, frames);
+    });
+  }
+
+private:
+  static constexpr uint32_t kChunk = 256;
+};
+
+inline const BatchKernel* KickNode::batchKernel() const {
+  static const KickBatchKernel kernel;
+  return &kernel;
+}
+
 
 
@@ -1,5 +1,6 @@
 #include "KickSynth.hpp"
 #include <cmath>
+#include "../../dsp/LaneMath.hpp"
 
 KickSynth::KickSynth(const KickParams& params, double sampleRate)
 : params_(params), sampleRate_(sampleRate) {}
@@ -46,14 +47,15 @@ float KickSynth::process() {
   if (active_) {
     const float tauPitch = params_.pitchDecayMs * 0.001f;
     const float tauAmp = params_.ampDecayMs * 0.001f;
-    const float aEnv = std::exp(static_cast<float>(-tSec_) / tauAmp);
-    const float fEnv = std::exp(static_cast<float>(-tSec_) / tauPitch);
+    // lane_math: the same bits as the lane kernel (KickLanes)
+    const float aEnv = lane_math::expf(static_cast<float>(-tSec_) / tauAmp);
+    const float fEnv = lane_math::expf(static_cast<float>(-tSec_) / tauPitch);
     const float freq = params_.endFreqHz + (params_.startFreqHz - params_.endFreqHz) * fEnv;
 
     phase_ += (2.0 * M_PI) * static_cast<double>(freq) / sr;
     if (phase_ > 1e12) phase_ = std::fmod(phase_, 2.0 * M_PI);
 
-    const float s = std::sin(static_cast<float>(phase_));
+    const float s = lane_math::sinf(static_cast<float>(phase_));
     const float click = (tSec_ < (1.5 / sr)) ? params_.click : 0.0f;
     sample = (aEnv * s + click) * params_.gain * velocity_;
 
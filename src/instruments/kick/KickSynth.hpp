@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include "../../core/StateHash.hpp"
 
 struct KickParams {
   float startFreqHz = 100.0f;
@@ -23,8 +24,29 @@ public:
   void trigger();
   void trigger(float velocity);
   float process();
+  // Not sounding and nothing scheduled: process() returns 0 without touching state
+  bool idle() const { return !active_ && !params_.loop && triggeredOnce_; }
+  void hashState(StateHash& h) const {
+    h.add(params_.startFreqHz, params_.endFreqHz, params_.pitchDecayMs, params_.ampDecayMs, params_.gain,
+          params_.bpm, params_.durationSec, params_.click, params_.loop);
+    h.add(phase_, tSec_, framesUntilNextTrigger_, active_, triggeredOnce_, velocity_);
+  }
   const KickParams& params() const;
   KickParams& params();
+  // Voice state carried between samples; KickLanes loads it into a lane and stores it back
+  struct Voice {
+    double phase;
+    double tSec;
+    uint64_t framesUntilNextTrigger;
+    bool active;
+    bool triggeredOnce;
+    float velocity;
+  };
+  Voice voice() const { return Voice{phase_, tSec_, framesUntilNextTrigger_, active_, triggeredOnce_, velocity_}; }
+  void setVoice(const Voice& v) {
+    phase_ = v.phase; tSec_ = v.tSec; framesUntilNextTrigger_ = v.framesUntilNextTrigger;
+    active_ = v.active; triggeredOnce_ = v.triggeredOnce; velocity_ = v.velocity;
+  }
 
 private:
   KickParams params_{};
@@ -5,36 +5,86 @@
 #include <string>
 #include <nlohmann/json.hpp>
 
+// wave: accept string enum ("square"|"pulse"|"tri"|"saw"|"noise") or numeric
+inline float mamChipWaveFromJson(const nlohmann::json& v) {
+  if (!v.is_string()) return static_cast<float>(v.get<int>());
+  const std::string w = v.get<std::string>();
+  if (w == "tri" || w == "triangle") return 1.0f;
+  if (w == "saw" || w == "sawtooth") return 2.0f;
+  if (w == "noise") return 3.0f;
+  return 0.0f; // square/pulse
+}
+
 inline std::unique_ptr<MamChipNode> makeMamChipFromParamsJson(const std::string& paramsJson) {
   auto node = std::make_unique<MamChipNode>();
+  auto set = [&](uint16_t id, float value) { Command c{}; c.type = CommandType::SetParam; c.paramId = id; c.value = value; node->handleEvent(c); };
   try {
     if (!paramsJson.empty()) {
       nlohmann::json j = nlohmann::json::parse(paramsJson);
-      // wave: accept string enum ("square"|"tri"|"saw") or numeric
-      if (j.contains("wave"))       {
-        Command c{}; c.type=CommandType::SetParam; c.paramId=1;  c.value = 0.0f;
-        if (j["wave"].is_string()) {
-          const std::string w = j.value("wave", std::string("square"));
-          if (w == "square" || w == "pulse") c.value = 0.0f;
-          else if (w == "tri" || w == "triangle") c.value = 1.0f;
-          else if (w == "saw" || w == "sawtooth") c.value = 2.0f;
+      // Mode presets first (docs/MAMIC.md); explicit keys below override them
+      if (j.contains("mode") && j["mode"].is_string()) {
+        const std::string m = j.value("mode", std::string("psg"));
+        if (m == "psg") { set(12, 0); set(13, 3); set(26, 1); set(28, 1); set(20, 0); }
+        else if (m == "sidish") { set(12, 1); set(13, 3); set(20, 1); set(21, 4000); set(22, 0.3f); set(23, 0.2f); }
+        else if (m == "custom") { set(12, 2); set(13, 8); }
+      }
+      if (j.contains("wave"))       set(1, mamChipWaveFromJson(j["wave"]));
+      if (j.contains("note"))       set(2, static_cast<float>(j.value("note", 60)));
+      if (j.contains("velocity"))   set(3, j.value("velocity", 1.0f));
+      if (j.contains("gain"))       set(5, j.value("gain", 0.9f));
+      if (j.contains("masterGain")) set(5, j.value("masterGain", 0.9f));
+      if (j.contains("pan"))        set(6, j.value("pan", 0.0f));
+      if (j.contains("attackMs"))   set(7, j.value("attackMs", 10.0f));
+      if (j.contains("decayMs"))    set(8, j.value("decayMs", 120.0f));
+      if (j.contains("sustain"))    set(9, j.value("sustain", 0.7f));
+      if (j.contains("releaseMs"))  set(10, j.value("releaseMs", 200.0f));
+      if (j.contains("pulseWidth")) set(4, j.value("pulseWidth", 0.5f));
+      if (j.contains("noiseMix"))   set(11, j.value("noiseMix", 0.0f));
+      if (j.contains("numVoices"))  set(13, static_cast<float>(j.value("numVoices", 1)));
+      if (j.contains("gateMs"))     set(14, j.value("gateMs", 0.0f));
+      if (j.contains("glideMs"))    set(16, j.value("glideMs", 0.0f));
+      if (j.contains("fineCents"))  set(17, j.value("fineCents", 0.0f));
+      if (j.contains("sync"))       set(18, j.value("sync", 0.0f));
+      if (j.contains("ring"))       set(19, j.value("ring", 0.0f));
+      if (j.contains("filterType")) {
+        float t = 0.0f;
+        if (j["filterType"].is_string()) {
+          const std::string f = j.value("filterType", std::string("off"));
+          t = (f == "lp") ? 1.0f : (f == "bp") ? 2.0f : (f == "hp") ? 3.0f : 0.0f;
         } else {
-          c.value = static_cast<float>(j.value("wave", 0));
+          t = static_cast<float>(j.value("filterType", 0));
+        }
+        set(20, t);
+      }
+      if (j.contains("filterCutoff"))     set(21, j.value("filterCutoff", 8000.0f));
+      if (j.contains("filterReso"))       set(22, j.value("filterReso", 0.2f));
+      if (j.contains("filterDrive"))      set(23, j.value("filterDrive", 0.0f));
+      if (j.contains("gritBitDepth"))     set(24, j.value("gritBitDepth", 0.0f));
+      if (j.contains("gritSrRate"))       set(25, j.value("gritSrRate", 0.0f));
+      if (j.contains("noiseShared"))      set(26, j.value("noiseShared", 0.0f));
+      if (j.contains("noiseLevelGlobal")) set(27, j.value("noiseLevelGlobal", 0.0f));
+      if (j.contains("noiseType"))        set(28, j["noiseType"].is_string() ? (j.value("noiseType", std::string("white")) == "lfsr" ? 1.0f : 0.0f) : j.value("noiseType", 0.0f));
+      if (j.contains("noiseClockHz"))     set(29, j.value("noiseClockHz", 0.0f));
+      if (j.contains("alias"))            set(30, j.value("alias", 0.0f));
+      // Per-voice overrides: "voices": [ { "wave": "tri", "note": 64, "pan": -0.5, ... }, ... ]
+      if (j.contains("voices") && j["voices"].is_array()) {
+        uint16_t n = 0;
+        for (const auto& v : j["voices"]) {
+          if (n >= kMamChipMaxVoices) break;
+          const uint16_t base = static_cast<uint16_t>(kMamChipVoiceParamBase + n * kMamChipVoiceParamStride);
+          if (v.contains("note"))       set(static_cast<uint16_t>(base + 0), static_cast<float>(v.value("note", 60)));
+          if (v.contains("wave"))       set(static_cast<uint16_t>(base + 1), mamChipWaveFromJson(v["wave"]));
+          if (v.contains("pulseWidth")) set(static_cast<uint16_t>(base + 2), v.value("pulseWidth", 0.5f));
+          if (v.contains("gain"))       set(static_cast<uint16_t>(base + 3), v.value("gain", 1.0f));
+          if (v.contains("pan"))        set(static_cast<uint16_t>(base + 4), v.value("pan", 0.0f));
+          if (v.contains("noiseMix"))   set(static_cast<uint16_t>(base + 5), v.value("noiseMix", 0.0f));
+          if (v.contains("sync"))       set(static_cast<uint16_t>(base + 6), v.value("sync", 0.0f));
+          if (v.contains("ring"))       set(static_cast<uint16_t>(base + 7), v.value("ring", 0.0f));
+          if (v.contains("fineCents"))  set(static_cast<uint16_t>(base + 8), v.value("fineCents", 0.0f));
+          ++n;
         }
-        node->handleEvent(c);
       }
-      if (j.contains("note"))       { Command c{}; c.type=CommandType::SetParam; c.paramId=2;  c.value = static_cast<float>(j.value("note", 60));      node->handleEvent(c); }
-      if (j.contains("gain"))       { Command c{}; c.type=CommandType::SetParam; c.paramId=5;  c.value = static_cast<float>(j.value("gain", 0.9));     node->handleEvent(c); }
-      if (j.contains("pan"))        { Command c{}; c.type=CommandType::SetParam; c.paramId=6;  c.value = static_cast<float>(j.value("pan", 0.0));      node->handleEvent(c); }
-      if (j.contains("attackMs"))   { Command c{}; c.type=CommandType::SetParam; c.paramId=7;  c.value = static_cast<float>(j.value("attackMs", 10));  node->handleEvent(c); }
-      if (j.contains("decayMs"))    { Command c{}; c.type=CommandType::SetParam; c.paramId=8;  c.value = static_cast<float>(j.value("decayMs", 120));  node->handleEvent(c); }
-      if (j.contains("sustain"))    { Command c{}; c.type=CommandType::SetParam; c.paramId=9;  c.value = static_cast<float>(j.value("sustain", 0.7));  node->handleEvent(c); }
-      if (j.contains("releaseMs"))  { Command c{}; c.type=CommandType::SetParam; c.paramId=10; c.value = static_cast<float>(j.value("releaseMs", 200)); node->handleEvent(c); }
-      if (j.contains("pulseWidth")) { Command c{}; c.type=CommandType::SetParam; c.paramId=4;  c.value = static_cast<float>(j.value("pulseWidth", 0.5)); node->handleEvent(c); }
-      if (j.contains("noiseMix"))   { Command c{}; c.type=CommandType::SetParam; c.paramId=11; c.value = static_cast<float>(j.value("noiseMix", 0.0)); node->handleEvent(c); }
     }
   } catch (...) {}
   return node;
 }
-
-
@@ -1,112 +1,186 @@
 #pragma once
 
+#include "../../core/MemoryAccounting.hpp"
 #include "../../core/Node.hpp"
 #include "../../core/ParamMap.hpp"
 #include "../../core/ParameterRegistry.hpp"
+#include "MamChipSynth.hpp"
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
+// MAMIC node: parameter/event front end for MamChipSynth (see docs/MAMIC.md).
+// Global voice params (WAVE, PULSE_WIDTH, PAN, ...) set every voice; VOICE_N_* set one voice.
+// Trigger allocates a voice for the pending NOTE_SEMITONES; NOTE_OFF / GATE_MS release it.
 class MamChipNode : public Node {
 public:
   MamChipNode() { initParams(); }
 
   const char* name() const override { return "mam_chip"; }
 
-  void prepare(double sampleRate, uint32_t /*maxBlock*/) override {
+  void prepare(double sampleRate, uint32_t maxBlock) override {
     sr_ = sampleRate > 0.0 ? sampleRate : 48000.0;
     params_.prepare(sr_);
-    phase_ = 0.0f; env_ = 0.0f; envStage_ = Stage::Idle;
+    synth_.prepare(sr_, maxBlock > 0 ? maxBlock : 1024u);
+    mixL_.assign(maxBlock > 0 ? maxBlock : 1024u, 0.0f);
+    mixR_.assign(mixL_.size(), 0.0f);
   }
-  void reset() override { phase_ = 0.0f; env_ = 0.0f; envStage_ = Stage::Idle; }
+  void reset() override { synth_.reset(); }
+  void setRandomKey(uint64_t key) override { synth_.setRandomKey(key); }
 
   void handleEvent(const Command& cmd) override {
     if (cmd.type == CommandType::Trigger) {
-      // Start envelope
-      envStage_ = Stage::Attack; env_ = 0.0f; envT_ = 0.0f;
+      synth_.noteOn(pendingNote_, cmd.value > 0.0f ? cmd.value : pendingVelocity_);
       return;
     }
-    if (cmd.type == CommandType::SetParam) params_.setImmediate(cmd.paramId, cmd.value);
-    else if (cmd.type == CommandType::SetParamRamp) params_.rampTo(cmd.paramId, cmd.value, cmd.rampMs);
+    const float rampMs = (cmd.type == CommandType::SetParamRamp) ? cmd.rampMs : 0.0f;
+    applyParam(cmd.paramId, cmd.value, rampMs);
   }
 
   void process(ProcessContext ctx, float* interleavedOut, uint32_t channels) override {
     const uint32_t n = ctx.frames;
     if (channels == 0 || n == 0) return;
-    const float note = params_.current(2); // NOTE_SEMITONES
-    const float gain = params_.current(5);
-    const float pan = params_.current(6);
-    const float pw = params_.current(4);
-    const int wave = static_cast<int>(params_.current(1) + 0.5f);
-    const float noiseMix = params_.current(11);
-
-    const float freq = 440.0f * std::pow(2.0f, (note - 69.0f) / 12.0f);
-    const float phaseInc = static_cast<float>(freq / sr_);
-    const float panL = std::cos(0.25f * static_cast<float>(M_PI) * (pan + 1.0f));
-    const float panR = std::sin(0.25f * static_cast<float>(M_PI) * (pan + 1.0f));
-
+    if (mixL_.size() < n) { mixL_.resize(n); mixR_.resize(n); }
+    // Smoothed globals advance once per block; the synth interpolates gain across it
+    const float g0 = params_.current(kGain), g1 = params_.advance(kGain, n);
+    const float cutoff = params_.current(kCutoff); params_.advance(kCutoff, n);
+    const float reso = params_.current(kReso); params_.advance(kReso, n);
+    const float drive = params_.current(kDrive); params_.advance(kDrive, n);
+    synth_.setNoiseLevelGlobal(params_.current(kNoiseGlobal)); params_.advance(kNoiseGlobal, n);
+    synth_.render(ctx.blockStart, n, mixL_.data(), mixR_.data(), g0, g1, cutoff, reso, drive);
+    if (channels == 1) {
+      for (uint32_t i = 0; i < n; ++i) interleavedOut[i] = (mixL_[i] + mixR_[i]) * 0.70710678f;
+      return;
+    }
     for (uint32_t i = 0; i < n; ++i) {
-      // Envelope (simple ADSR)
-      stepEnvelope();
-      float osc = generateWave(wave, pw);
-      // White noise (very simple)
-      float nz = (static_cast<float>(rand()) / RAND_MAX) * 2.0f - 1.0f;
-      float s = (1.0f - noiseMix) * osc + noiseMix * nz;
-      s *= env_ * gain;
-      if (channels == 1) {
-        interleavedOut[i] = s;
-      } else {
-        interleavedOut[2 * static_cast<size_t>(i)    ] = s * panL;
-        interleavedOut[2 * static_cast<size_t>(i) + 1] = s * panR;
-      }
-      phase_ += phaseInc; if (phase_ >= 1.0f) phase_ -= 1.0f;
+      float* frame = interleavedOut + static_cast<size_t>(i) * channels;
+      frame[0] = mixL_[i]; frame[1] = mixR_[i];
+      for (uint32_t c = 2; c < channels; ++c) frame[c] = 0.0f;
     }
   }
 
+  bool skipIfSilent(ProcessContext ctx) override {
+    const uint32_t n = ctx.frames;
+    synth_.setNoiseLevelGlobal(params_.current(kNoiseGlobal));
+    if (!synth_.skipSilent(n)) return false;
+    for (uint16_t id : {kGain, kCutoff, kReso, kDrive, kNoiseGlobal}) params_.advance(id, n);
+    return true;
+  }
+
+  uint32_t activeVoices() const { return synth_.activeVoices(); }
+  size_t memoryBytes() const override { return vectorBytes(mixL_) + vectorBytes(mixR_); }
+
 private:
-  enum class Stage { Idle, Attack, Decay, Sustain, Release };
-  void stepEnvelope() {
-    const float attMs = params_.current(7);
-    const float decMs = params_.current(8);
-    const float sus = params_.current(9);
-    const float relMs = params_.current(10);
-    const float dt = 1000.0f / static_cast<float>(sr_);
-    switch (envStage_) {
-      case Stage::Idle: env_ = 0.0f; break;
-      case Stage::Attack: env_ += (dt / std::max(1e-3f, attMs)); if (env_ >= 1.0f) { env_ = 1.0f; envStage_ = Stage::Decay; } break;
-      case Stage::Decay: env_ -= (dt / std::max(1e-3f, decMs)) * (1.0f - sus); if (env_ <= sus) { env_ = sus; envStage_ = Stage::Sustain; } break;
-      case Stage::Sustain: /* hold */ break;
-      case Stage::Release: env_ -= (dt / std::max(1e-3f, relMs)) * (env_); if (env_ <= 0.0f) { env_ = 0.0f; envStage_ = Stage::Idle; } break;
+  // Global param ids (see kMamChipParams)
+  enum : uint16_t {
+    kWave = 1, kNote = 2, kVelocity = 3, kPulseWidth = 4, kGain = 5, kPan = 6,
+    kAttack = 7, kDecay = 8, kSustain = 9, kRelease = 10, kNoiseMix = 11, kMode = 12,
+    kNumVoices = 13, kGateMs = 14, kNoteOff = 15, kGlideMs = 16, kFineCents = 17, kSync = 18, kRing = 19,
+    kFilterType = 20, kCutoff = 21, kReso = 22, kDrive = 23, kGritBits = 24, kGritSr = 25,
+    kNoiseShared = 26, kNoiseGlobal = 27, kNoiseType = 28, kNoiseClock = 29, kAlias = 30
+  };
+  // Per-voice slots (kMamChipVoiceParamBase + (N-1) * stride + slot)
+  enum : uint16_t { kVNote = 0, kVWave, kVPulseWidth, kVGain, kVPan, kVNoiseMix, kVSync, kVRing, kVFine, kVGate };
+
+  uint32_t rampSamples(float rampMs) const { return rampMs > 0.0f ? static_cast<uint32_t>(0.001 * rampMs * sr_ + 0.5) : 0u; }
+
+  void applyParam(uint16_t id, float value, float rampMs) {
+    const uint32_t ramp = rampSamples(rampMs);
+    if (id >= kMamChipVoiceParamBase && id < kMamChipVoiceParamBase + kMamChipVoiceParamStride * kMamChipMaxVoices) {
+      const int voice = (id - kMamChipVoiceParamBase) / kMamChipVoiceParamStride;
+      applyVoiceParam(voice, static_cast<uint16_t>((id - kMamChipVoiceParamBase) % kMamChipVoiceParamStride), value, ramp);
+      return;
+    }
+    switch (id) {
+      case kNote:
+        pendingNote_ = value;
+        if (synth_.numVoices() == 1) synth_.setNote(0, value); // mono: retune (glides if GLIDE_MS)
+        break;
+      case kVelocity: pendingVelocity_ = value; break;
+      case kWave: case kPulseWidth: case kPan: case kNoiseMix: case kFineCents: case kSync: case kRing:
+        applyVoiceParam(-1, globalToVoiceSlot(id), value, ramp);
+        break;
+      case kAttack: attackMs_ = value; updateEnvelope(); break;
+      case kDecay: decayMs_ = value; updateEnvelope(); break;
+      case kSustain: sustain_ = value; updateEnvelope(); break;
+      case kRelease: releaseMs_ = value; updateEnvelope(); break;
+      case kMode: break; // preset tag; presets are applied by the factory
+      case kNumVoices: synth_.setNumVoices(static_cast<uint32_t>(std::max(1.0f, value) + 0.5f)); break;
+      case kGateMs: synth_.setGateMs(value); break;
+      case kNoteOff: synth_.noteOff(value); break;
+      case kGlideMs: synth_.setGlideMs(value); break;
+      case kFilterType: synth_.setFilterType(static_cast<int32_t>(value + 0.5f)); break;
+      case kGritBits: gritBits_ = value; synth_.setGrit(gritBits_, gritSr_); break;
+      case kGritSr: gritSr_ = value; synth_.setGrit(gritBits_, gritSr_); break;
+      case kNoiseShared: noiseShared_ = value >= 0.5f; synth_.setNoise(noiseShared_, noiseLfsr_, noiseClock_); break;
+      case kNoiseType: noiseLfsr_ = value >= 0.5f; synth_.setNoise(noiseShared_, noiseLfsr_, noiseClock_); break;
+      case kNoiseClock: noiseClock_ = value; synth_.setNoise(noiseShared_, noiseLfsr_, noiseClock_); break;
+      case kAlias: synth_.setAlias(value >= 0.5f); break;
+      case kGain: case kCutoff: case kReso: case kDrive: case kNoiseGlobal:
+        if (ramp > 0) params_.rampTo(id, value, rampMs); else params_.setImmediate(id, value);
+        break;
+      default: break;
     }
   }
 
-  float generateWave(int wave, float pulseWidth) {
-    // Simple band-limited-ish: fall back to naive plus tiny smoothing for MVP
-    float x = phase_;
-    switch (wave) {
-      case 0: return (x < pulseWidth ? 1.0f : -1.0f); // square/pulse (placeholder)
-      case 1: return 2.0f * std::fabs(2.0f * (x - std::floor(x + 0.5f))) - 1.0f; // triangle-ish (naive)
-      case 2: return 2.0f * x - 1.0f; // saw (naive)
-      default: return 0.0f;
+  static uint16_t globalToVoiceSlot(uint16_t id) {
+    switch (id) {
+      case kWave: return kVWave;
+      case kPulseWidth: return kVPulseWidth;
+      case kPan: return kVPan;
+      case kNoiseMix: return kVNoiseMix;
+      case kFineCents: return kVFine;
+      case kSync: return kVSync;
+      default: return kVRing;
     }
   }
 
-  double sr_ = 48000.0;
-  ParameterRegistry<32> params_;
-  float phase_ = 0.0f;
-  float env_ = 0.0f, envT_ = 0.0f;
-  Stage envStage_ = Stage::Idle;
+  void applyVoiceParam(int voice, uint16_t slot, float value, uint32_t ramp) {
+    switch (slot) {
+      case kVNote: synth_.setNote(voice, value); break;
+      case kVWave: synth_.setWave(voice, static_cast<int32_t>(value + 0.5f)); break;
+      case kVPulseWidth: synth_.setPulseWidth(voice, value, ramp); break;
+      case kVGain: synth_.setGain(voice, value, ramp); break;
+      case kVPan: synth_.setPan(voice, value, ramp); break;
+      case kVNoiseMix: synth_.setNoiseMix(voice, value, ramp); break;
+      case kVSync: synth_.setSync(voice, value >= 0.5f); break;
+      case kVRing: synth_.setRing(voice, value >= 0.5f); break;
+      case kVFine: synth_.setFineCents(voice, value); break;
+      case kVGate:
+        if (voice < 0) break;
+        if (value > 0.0f) synth_.voiceOn(static_cast<uint32_t>(voice), value);
+        else synth_.releaseVoice(static_cast<uint32_t>(voice));
+        break;
+      default: break;
+    }
+  }
+
+  void updateEnvelope() { synth_.setEnvelope(attackMs_, decayMs_, sustain_, releaseMs_); }
 
   void initParams() {
-    // Initialize known params with defaults from kMamChipParamMap
+    // Apply ParamMap defaults for the global ids; smoothed ones live in the registry
     for (size_t i = 0; i < kMamChipParamMap.count; ++i) {
       const auto& d = kMamChipParamMap.defs[i];
-      params_.ensureParam(d.id, d.defaultValue);
-      // Map smoothing string to this registry's enum
-      ParameterRegistry<32>::Smoothing s = ParameterRegistry<32>::Smoothing::Linear;
-      if (std::string(d.smoothing) == std::string("step")) s = ParameterRegistry<32>::Smoothing::Step;
-      else if (std::string(d.smoothing) == std::string("expo")) s = ParameterRegistry<32>::Smoothing::Expo;
-      params_.setSmoothing(d.id, s);
+      if (d.id >= kMamChipVoiceParamBase) break;
+      if (d.id == kGain || d.id == kCutoff || d.id == kReso || d.id == kDrive || d.id == kNoiseGlobal) {
+        params_.ensureParam(d.id, d.defaultValue);
+        ParameterRegistry<8>::Smoothing s = ParameterRegistry<8>::Smoothing::Linear;
+        if (std::string(d.smoothing) == std::string("step")) s = ParameterRegistry<8>::Smoothing::Step;
+        else if (std::string(d.smoothing) == std::string("expo")) s = ParameterRegistry<8>::Smoothing::Expo;
+        params_.setSmoothing(d.id, s);
+      } else {
+        applyParam(d.id, d.defaultValue, 0.0f);
+      }
     }
   }
-};
-
 
+  double sr_ = 48000.0;
+  MamChipSynth synth_{};
+  ParameterRegistry<8> params_;
+  std::vector<float> mixL_, mixR_;
+  float pendingNote_ = 60.0f, pendingVelocity_ = 1.0f;
+  float attackMs_ = 10.0f, decayMs_ = 120.0f, sustain_ = 0.7f, releaseMs_ = 200.0f;
+  float gritBits_ = 0.0f, gritSr_ = 0.0f;
+  bool noiseShared_ = false, noiseLfsr_ = false;
+  float noiseClock_ = 0.0f;
+};
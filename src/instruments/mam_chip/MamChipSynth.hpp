@@ -0,0 +1,433 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "../../core/Random.hpp"
+
+// MAMIC voice engine. Voices are stored structure-of-arrays: every per-voice quantity is one
+// lane of a fixed 8-wide array, and render() runs 4 or 8 lanes per sample with branch-free
+// lane loops so they vectorise. Voices mix to stereo, then share drive, filter and grit.
+class MamChipSynth {
+public:
+  static constexpr uint32_t kMaxVoices = 8;
+  enum Wave : int32_t { kPulse = 0, kTriangle = 1, kSaw = 2, kNoise = 3 };
+  enum FilterType : int32_t { kFilterOff = 0, kLowpass = 1, kBandpass = 2, kHighpass = 3 };
+
+  void prepare(double sampleRate, uint32_t maxBlock) {
+    sr_ = sampleRate > 0.0 ? sampleRate : 48000.0;
+    maxBlock_ = maxBlock > 0 ? maxBlock : 1024u;
+    laneNoise_.assign(static_cast<size_t>(maxBlock_) * kMaxVoices, 0.0f);
+    sharedNoise_.assign(maxBlock_, 0.0f);
+    for (uint32_t v = 0; v < kMaxVoices; ++v) retune(v);
+    updateEnvelope();
+    setGlideMs(glideMs_);
+    reset();
+  }
+
+  void reset() {
+    for (uint32_t v = 0; v < kMaxVoices; ++v) {
+      phase_[v] = 0.0f; env_[v] = 0.0f; stage_[v] = kIdle; gateLeft_[v] = 0; age_[v] = 0;
+      inc_[v] = incTarget_[v];
+    }
+    ic1_[0] = ic1_[1] = ic2_[0] = ic2_[1] = 0.0f;
+    holdL_ = holdR_ = 0.0f; holdPhase_ = 1.0f;
+    lfsr_ = 1u; lfsrPhase_ = 0.0f; lfsrOut_ = 1.0f;
+    serial_ = 0;
+  }
+
+  void setRandomKey(uint64_t key) { rng_.setKey(key); }
+
+  // --- Global settings ---
+  void setNumVoices(uint32_t n) { numVoices_ = std::max(1u, std::min(n, kMaxVoices)); }
+  uint32_t numVoices() const { return numVoices_; }
+  void setEnvelope(float attackMs, float decayMs, float sustain, float releaseMs) {
+    attackMs_ = attackMs; decayMs_ = decayMs; sustain_ = std::max(0.0f, std::min(1.0f, sustain)); releaseMs_ = releaseMs;
+    updateEnvelope();
+  }
+  void setGateMs(float ms) { gateMs_ = std::max(0.0f, ms); }
+  void setGlideMs(float ms) {
+    glideMs_ = std::max(0.0f, ms);
+    glideCoef_ = glideMs_ <= 0.0f ? 1.0f : static_cast<float>(1.0 - std::exp(-1.0 / (0.001 * glideMs_ * sr_)));
+  }
+  void setNoise(bool shared, bool lfsr, float clockHz) { noiseShared_ = shared; noiseLfsr_ = lfsr; noiseClockHz_ = std::max(0.0f, clockHz); }
+  void setNoiseLevelGlobal(float level) { noiseGlobal_ = std::max(0.0f, std::min(1.0f, level)); }
+  void setFilterType(int32_t t) { filterType_ = std::max(0, std::min(3, t)); }
+  void setGrit(float bitDepth, float srHz) { gritBits_ = bitDepth; gritSrHz_ = std::max(0.0f, srHz); }
+  void setAlias(bool on) { alias_ = on; }
+
+  // --- Per-voice settings; voice < 0 applies to every lane ---
+  void setWave(int voice, int32_t wave) { forLanes(voice, [&](uint32_t v){ wave_[v] = std::max(0, std::min(3, wave)); }); }
+  void setNote(int voice, float note) { forLanes(voice, [&](uint32_t v){ note_[v] = note; retune(v); }); }
+  void setFineCents(int voice, float cents) { forLanes(voice, [&](uint32_t v){ fine_[v] = cents; retune(v); }); }
+  void setSync(int voice, bool on) { forLanes(voice, [&](uint32_t v){ sync_[v] = on ? 1 : 0; }); }
+  void setRing(int voice, bool on) { forLanes(voice, [&](uint32_t v){ ring_[v] = on ? 1.0f : 0.0f; }); }
+  void setPulseWidth(int voice, float pw, uint32_t rampSamples) { forLanes(voice, [&](uint32_t v){ pw_.rampTo(v, std::max(0.05f, std::min(0.95f, pw)), rampSamples); }); }
+  void setGain(int voice, float g, uint32_t rampSamples) { forLanes(voice, [&](uint32_t v){ gain_.rampTo(v, g, rampSamples); }); }
+  void setPan(int voice, float pan, uint32_t rampSamples) { forLanes(voice, [&](uint32_t v){ pan_.rampTo(v, std::max(-1.0f, std::min(1.0f, pan)), rampSamples); }); }
+  void setNoiseMix(int voice, float mix, uint32_t rampSamples) { forLanes(voice, [&](uint32_t v){ noiseMix_.rampTo(v, std::max(0.0f, std::min(1.0f, mix)), rampSamples); }); }
+
+  // --- Voice allocation ---
+  // Free voice first, then a voice already playing this note, then the quietest releasing
+  // voice, then the oldest. Returns the lane that was started.
+  uint32_t noteOn(float note, float velocity) {
+    uint32_t lane = 0;
+    if (numVoices_ > 1) {
+      int idle = -1, same = -1, released = -1, oldest = 0;
+      for (uint32_t v = 0; v < numVoices_; ++v) {
+        if (stage_[v] == kIdle) { if (idle < 0) idle = static_cast<int>(v); continue; }
+        if (same < 0 && note_[v] == note) same = static_cast<int>(v);
+        if (stage_[v] == kRelease && (released < 0 || env_[v] < env_[released])) released = static_cast<int>(v);
+        if (age_[v] < age_[oldest] || stage_[oldest] == kIdle) oldest = static_cast<int>(v);
+      }
+      lane = static_cast<uint32_t>(idle >= 0 ? idle : same >= 0 ? same : released >= 0 ? released : oldest);
+    }
+    note_[lane] = note; retune(lane);
+    startVoice(lane, velocity);
+    return lane;
+  }
+  void noteOff(float note) {
+    for (uint32_t v = 0; v < kMaxVoices; ++v) if (stage_[v] != kIdle && note_[v] == note) releaseVoice(v);
+  }
+  void voiceOn(uint32_t v, float velocity) { if (v < kMaxVoices) startVoice(v, velocity); }
+  void releaseVoice(uint32_t v) { if (v < kMaxVoices && stage_[v] != kIdle) stage_[v] = kRelease; }
+
+  uint32_t activeVoices() const {
+    uint32_t n = 0;
+    for (uint32_t v = 0; v < kMaxVoices; ++v) n += (stage_[v] != kIdle) ? 1u : 0u;
+    return n;
+  }
+
+  // Render `frames` stereo samples into outL/outR (overwritten). Master gain is interpolated
+  // start→end; filter settings are taken once per block. blockStart indexes the noise streams.
+  void render(uint64_t blockStart, uint32_t frames, float* outL, float* outR,
+              float gainStart, float gainEnd, float cutoffHz, float reso, float drive) {
+    uint32_t done = 0;
+    while (done < frames) {
+      const uint32_t n = std::min(frames - done, maxBlock_);
+      renderChunk(blockStart + done, n, outL + done, outR + done, gainStart, gainEnd, done, frames, cutoffHz, reso, drive);
+      done += n;
+    }
+  }
+
+  // Advance `frames` samples that render() would produce as silence: every lane idle and the
+  // shared filter and grit hold at rest. Runs the same chunking, lane ramps, idle lane phases,
+  // LFSR and hold clock as render(). Returns false, without touching state, otherwise.
+  bool skipSilent(uint32_t frames) {
+    if (activeVoices() != 0 || holdL_ != 0.0f || holdR_ != 0.0f) return false;
+    if (filterType_ != kFilterOff && (ic1_[0] != 0.0f || ic1_[1] != 0.0f || ic2_[0] != 0.0f || ic2_[1] != 0.0f)) return false;
+    uint32_t done = 0;
+    while (done < frames) {
+      const uint32_t n = std::min(frames - done, maxBlock_);
+      pw_.beginBlock(n); gain_.beginBlock(n); pan_.beginBlock(n); noiseMix_.beginBlock(n);
+      if (noiseLfsr_ && noiseActive()) fillNoise(0, n); // the counter-based streams need no advance
+      if (numVoices_ <= 4) skipVoices<4>(n); else skipVoices<8>(n);
+      pw_.endBlock(n); gain_.endBlock(n); pan_.endBlock(n); noiseMix_.endBlock(n);
+      if (gritSrHz_ > 0.0f) {
+        const float step = static_cast<float>(gritSrHz_ / sr_);
+        for (uint32_t i = 0; i < n; ++i) {
+          holdPhase_ += step;
+          if (holdPhase_ >= 1.0f) holdPhase_ -= std::floor(holdPhase_);
+        }
+      }
+      done += n;
+    }
+    return true;
+  }
+
+private:
+  enum Stage : int32_t { kIdle = 0, kAttack = 1, kDecay = 2, kSustain = 3, kRelease = 4 };
+  static constexpr float kEnvFloor = 1.0e-5f;
+
+  // Per-lane linear ramp; each block turns it into a start value plus a per-sample increment
+  struct LaneRamp {
+    alignas(32) float value[kMaxVoices];
+    alignas(32) float perSample[kMaxVoices];
+    float target[kMaxVoices];
+    float delta[kMaxVoices];
+    uint32_t left[kMaxVoices];
+    explicit LaneRamp(float init) {
+      for (uint32_t v = 0; v < kMaxVoices; ++v) { value[v] = target[v] = init; delta[v] = perSample[v] = 0.0f; left[v] = 0; }
+    }
+    void rampTo(uint32_t v, float x, uint32_t samples) {
+      target[v] = x;
+      if (samples == 0) { value[v] = x; left[v] = 0; delta[v] = 0.0f; return; }
+      delta[v] = (x - value[v]) / static_cast<float>(samples); left[v] = samples;
+    }
+    void beginBlock(uint32_t n) {
+      for (uint32_t v = 0; v < kMaxVoices; ++v) {
+        const uint32_t k = std::min(n, left[v]);
+        const float end = (left[v] == k) ? target[v] : value[v] + delta[v] * static_cast<float>(k);
+        perSample[v] = (k > 0) ? (end - value[v]) / static_cast<float>(n) : 0.0f;
+        left[v] -= k;
+      }
+    }
+    void endBlock(uint32_t n) { for (uint32_t v = 0; v < kMaxVoices; ++v) value[v] += perSample[v] * static_cast<float>(n); }
+  };
+
+  template <typename Fn>
+  void forLanes(int voice, Fn&& fn) {
+    if (voice < 0) { for (uint32_t v = 0; v < kMaxVoices; ++v) fn(v); }
+    else if (static_cast<uint32_t>(voice) < kMaxVoices) fn(static_cast<uint32_t>(voice));
+  }
+
+  void retune(uint32_t v) {
+    const double hz = 440.0 * std::pow(2.0, (static_cast<double>(note_[v]) + 0.01 * static_cast<double>(fine_[v]) - 69.0) / 12.0);
+    incTarget_[v] = static_cast<float>(std::min(0.49, hz / sr_));
+    if (stage_[v] == kIdle || glideCoef_ >= 1.0f) inc_[v] = incTarget_[v];
+  }
+
+  void startVoice(uint32_t v, float velocity) {
+    if (stage_[v] == kIdle) inc_[v] = incTarget_[v];
+    velocity_[v] = velocity;
+    env_[v] = 0.0f;
+    stage_[v] = kAttack;
+    gateLeft_[v] = gateMs_ > 0.0f ? static_cast<int32_t>(std::min(2.0e9, 0.001 * gateMs_ * sr_ + 0.5)) : INT32_MAX;
+    age_[v] = ++serial_;
+  }
+
+  void updateEnvelope() {
+    const float dt = static_cast<float>(1000.0 / sr_);
+    attackInc_ = dt / std::max(1e-3f, attackMs_);
+    decayRate_ = (dt / std::max(1e-3f, decayMs_)) * (1.0f - sustain_);
+    releaseCoef_ = std::min(1.0f, dt / std::max(1e-3f, releaseMs_));
+  }
+
+  // polyBLEP residual of a unit step at phase 0 (dt = phase increment; 0 disables)
+  static inline float polyBlep(float t, float dt) {
+    const float a = t / std::max(dt, 1e-9f);
+    const float b = (t - 1.0f) / std::max(dt, 1e-9f);
+    return (t < dt) ? (a + a - a * a - 1.0f) : (t > 1.0f - dt) ? (b * b + b + b + 1.0f) : 0.0f;
+  }
+  // polyBLAMP residual of a unit slope change at phase 0
+  static inline float polyBlamp(float t, float dt) {
+    const float a = t / std::max(dt, 1e-9f) - 1.0f;
+    const float b = (t - 1.0f) / std::max(dt, 1e-9f) + 1.0f;
+    return (t < dt) ? (-(1.0f / 3.0f) * a * a * a) : (t > 1.0f - dt) ? ((1.0f / 3.0f) * b * b * b) : 0.0f;
+  }
+  static inline float wrap01(float x) { return x - std::floor(x); }
+  static inline float softSat(float x) {
+    const float c = std::max(-3.0f, std::min(3.0f, x));
+    return c * (27.0f + c * c) / (27.0f + 9.0f * c * c);
+  }
+
+  void fillNoise(uint64_t blockStart, uint32_t n) {
+    if (noiseLfsr_) {
+      // 17-bit PSG-style LFSR (taps 17,14), clocked at noiseClockHz_ and held between clocks
+      const float step = noiseClockHz_ > 0.0f ? static_cast<float>(noiseClockHz_ / sr_) : 1.0f;
+      for (uint32_t i = 0; i < n; ++i) {
+        lfsrPhase_ += step;
+        while (lfsrPhase_ >= 1.0f) {
+          lfsrPhase_ -= 1.0f;
+          const uint32_t fb = (lfsr_ ^ (lfsr_ >> 3)) & 1u;
+          lfsr_ = (lfsr_ >> 1) | (fb << 16);
+          lfsrOut_ = (lfsr_ & 1u) ? 1.0f : -1.0f;
+        }
+        sharedNoise_[i] = lfsrOut_;
+      }
+    } else if (noiseShared_) {
+      rng_.fillBipolarAt(sharedNoise_.data(), n, blockStart);
+    } else {
+      rng_.fillBipolarAt(laneNoise_.data(), n * kMaxVoices, blockStart * kMaxVoices);
+    }
+  }
+
+  // One sample of phase advance (with glide) and hard sync for lanes 0..L-1
+  template <uint32_t L>
+  inline void stepPhases(const int32_t* prev, float* ph, float* wrapped, float glide) {
+    for (uint32_t v = 0; v < L; ++v) {
+      inc_[v] += (incTarget_[v] - inc_[v]) * glide;
+      float p = phase_[v] + inc_[v];
+      const bool w = p >= 1.0f;
+      p -= w ? 1.0f : 0.0f;
+      ph[v] = p; wrapped[v] = w ? 1.0f : 0.0f;
+    }
+    // Hard sync: restart when the source voice wrapped, keeping the sub-sample offset
+    for (uint32_t v = 0; v < L; ++v) {
+      const int32_t q = prev[v];
+      const bool doSync = sync_[v] != 0 && wrapped[q] > 0.0f;
+      const float synced = ph[q] * inc_[v] / std::max(inc_[q], 1e-9f);
+      phase_[v] = doSync ? wrap01(synced) : ph[v];
+    }
+  }
+
+  // Idle lanes keep running their phases (they feed sync/ring and set the start phase of the
+  // next note), so a skipped block still advances them
+  template <uint32_t L>
+  void skipVoices(uint32_t n) {
+    alignas(32) int32_t prev[L];
+    alignas(32) float ph[L], wrapped[L];
+    for (uint32_t v = 0; v < L; ++v) prev[v] = static_cast<int32_t>(v == 0 ? numVoices_ - 1 : v - 1);
+    for (uint32_t i = 0; i < n; ++i) stepPhases<L>(prev, ph, wrapped, glideCoef_);
+  }
+
+  template <uint32_t L>
+  void renderVoices(uint32_t n, float* mixL, float* mixR, bool noiseOn) {
+    const bool shared = noiseLfsr_ || noiseShared_;
+    const float aInc = attackInc_, dRate = decayRate_, sus = sustain_, rCoef = releaseCoef_, glide = glideCoef_;
+    const float bl = alias_ ? 0.0f : 1.0f;
+    alignas(32) float panL[L], panR[L], pw0[L], g0[L], nm0[L];
+    alignas(32) int32_t prev[L];
+    for (uint32_t v = 0; v < L; ++v) {
+      const float a = 0.25f * 3.14159265f * (pan_.value[v] + 1.0f);
+      panL[v] = std::cos(a); panR[v] = std::sin(a);
+      pw0[v] = pw_.value[v]; g0[v] = gain_.value[v] * velocity_[v]; nm0[v] = noiseMix_.value[v];
+      // Sync/ring source: the previous active voice (voice 1 follows the last, as on the SID)
+      prev[v] = static_cast<int32_t>(v == 0 ? numVoices_ - 1 : v - 1);
+    }
+    alignas(32) float ph[L], wrapped[L], s[L];
+    for (uint32_t i = 0; i < n; ++i) {
+      const float fi = static_cast<float>(i);
+      // Envelopes (select form so the lane loop vectorises)
+      for (uint32_t v = 0; v < L; ++v) {
+        const int32_t st = stage_[v];
+        const float e = env_[v];
+        const bool att = st == kAttack, dec = st == kDecay, rel = st == kRelease;
+        const bool gated = st >= kAttack && st <= kSustain;
+        const int32_t g = gateLeft_[v] - (gated ? 1 : 0);
+        const bool expire = gated && g <= 0;
+        float ne = e + (att ? aInc : 0.0f) - (dec ? dRate : 0.0f) - (rel ? rCoef * e : 0.0f);
+        int32_t ns = st;
+        ns = (att && ne >= 1.0f) ? int32_t(kDecay) : ns;   ne = (att && ne >= 1.0f) ? 1.0f : ne;
+        ns = (dec && ne <= sus) ? int32_t(kSustain) : ns;  ne = (dec && ne <= sus) ? sus : ne;
+        ns = (rel && ne <= kEnvFloor) ? int32_t(kIdle) : ns; ne = (rel && ne <= kEnvFloor) ? 0.0f : ne;
+        ns = expire ? int32_t(kRelease) : ns;
+        env_[v] = ne; stage_[v] = ns; gateLeft_[v] = g;
+      }
+      stepPhases<L>(prev, ph, wrapped, glide);
+      // Oscillators, noise, envelope, gain
+      const float* nzLane = laneNoise_.data() + static_cast<size_t>(i) * kMaxVoices;
+      const float nzShared = sharedNoise_[i];
+      for (uint32_t v = 0; v < L; ++v) {
+        const float p = phase_[v];
+        const float dt = inc_[v] * bl;
+        const float pw = pw0[v] + pw_.perSample[v] * fi;
+        const float saw = 2.0f * p - 1.0f - polyBlep(p, dt);
+        const float pulse = (p < pw ? 1.0f : -1.0f) + polyBlep(p, dt) - polyBlep(wrap01(p - pw + 1.0f), dt);
+        const float tri = 1.0f - 4.0f * std::fabs(p - 0.5f) + 8.0f * dt * (polyBlamp(p, dt) - polyBlamp(wrap01(p + 0.5f), dt));
+        const float nz = noiseOn ? (shared ? nzShared : nzLane[v]) : 0.0f;
+        const int32_t w = wave_[v];
+        float osc = (w == kPulse) ? pulse : (w == kTriangle) ? tri : (w == kSaw) ? saw : nz;
+        const float ringSign = phase_[prev[v]] < 0.5f ? 1.0f : -1.0f;
+        osc *= 1.0f + ring_[v] * (ringSign - 1.0f);
+        const float nm = std::min(1.0f, nm0[v] + noiseMix_.perSample[v] * fi + noiseGlobal_);
+        const float g = g0[v] + gain_.perSample[v] * velocity_[v] * fi;
+        s[v] = ((1.0f - nm) * osc + nm * nz) * env_[v] * g;
+      }
+      float l = 0.0f, r = 0.0f;
+      for (uint32_t v = 0; v < L; ++v) { l += s[v] * panL[v]; r += s[v] * panR[v]; }
+      mixL[i] = l; mixR[i] = r;
+    }
+  }
+
+  bool noiseActive() const {
+    bool on = noiseGlobal_ > 0.0f;
+    for (uint32_t v = 0; v < numVoices_ && !on; ++v) on = wave_[v] == kNoise || noiseMix_.value[v] > 0.0f || noiseMix_.perSample[v] != 0.0f;
+    return on;
+  }
+
+  void renderChunk(uint64_t blockStart, uint32_t n, float* outL, float* outR,
+                   float gainStart, float gainEnd, uint32_t offset, uint32_t total,
+                   float cutoffHz, float reso, float drive) {
+    pw_.beginBlock(n); gain_.beginBlock(n); pan_.beginBlock(n); noiseMix_.beginBlock(n);
+    const bool noiseOn = noiseActive();
+    if (noiseOn) fillNoise(blockStart, n);
+    // Inactive lanes still run (their envelope is 0); 4 lanes suffice for up to 4 voices
+    bool upper = false;
+    for (uint32_t v = 4; v < kMaxVoices; ++v) upper = upper || stage_[v] != kIdle;
+    if (numVoices_ <= 4 && !upper) renderVoices<4>(n, outL, outR, noiseOn);
+    else renderVoices<8>(n, outL, outR, noiseOn);
+    pw_.endBlock(n); gain_.endBlock(n); pan_.endBlock(n); noiseMix_.endBlock(n);
+
+    // Shared drive → state-variable filter (TPT form) → grit → master gain
+    if (drive > 0.0f) {
+      const float pre = 1.0f + 8.0f * drive, post = 1.0f / (1.0f + 2.0f * drive);
+      for (uint32_t i = 0; i < n; ++i) { outL[i] = softSat(outL[i] * pre) * post; outR[i] = softSat(outR[i] * pre) * post; }
+    }
+    if (filterType_ != kFilterOff) {
+      const double fc = std::max(20.0, std::min(static_cast<double>(cutoffHz), 0.45 * sr_));
+      const float g = static_cast<float>(std::tan(3.14159265358979 * fc / sr_));
+      const float k = 2.0f - 1.95f * std::max(0.0f, std::min(1.0f, reso));
+      const float a1 = 1.0f / (1.0f + g * (g + k)), a2 = g * a1, a3 = g * a2;
+      float* ch[2] = {outL, outR};
+      for (int c = 0; c < 2; ++c) {
+        float s1 = ic1_[c], s2 = ic2_[c];
+        float* x = ch[c];
+        for (uint32_t i = 0; i < n; ++i) {
+          const float v3 = x[i] - s2;
+          const float v1 = a1 * s1 + a2 * v3;
+          const float v2 = s2 + a2 * s1 + a3 * v3;
+          s1 = 2.0f * v1 - s1; s2 = 2.0f * v2 - s2;
+          x[i] = (filterType_ == kLowpass) ? v2 : (filterType_ == kBandpass) ? v1 : (x[i] - k * v1 - v2);
+        }
+        ic1_[c] = std::fabs(s1) < 1e-15f ? 0.0f : s1;
+        ic2_[c] = std::fabs(s2) < 1e-15f ? 0.0f : s2;
+      }
+    }
+    if (gritSrHz_ > 0.0f) {
+      const float step = static_cast<float>(gritSrHz_ / sr_);
+      for (uint32_t i = 0; i < n; ++i) {
+        holdPhase_ += step;
+        if (holdPhase_ >= 1.0f) { holdPhase_ -= std::floor(holdPhase_); holdL_ = outL[i]; holdR_ = outR[i]; }
+        outL[i] = holdL_; outR[i] = holdR_;
+      }
+    }
+    if (gritBits_ >= 1.0f) {
+      const float q = std::pow(2.0f, gritBits_ - 1.0f), iq = 1.0f / q;
+      for (uint32_t i = 0; i < n; ++i) { outL[i] = std::nearbyint(outL[i] * q) * iq; outR[i] = std::nearbyint(outR[i] * q) * iq; }
+    }
+    const float span = total > 0 ? (gainEnd - gainStart) / static_cast<float>(total) : 0.0f;
+    for (uint32_t i = 0; i < n; ++i) {
+      const float g = gainStart + span * static_cast<float>(offset + i);
+      outL[i] *= g; outR[i] *= g;
+    }
+  }
+
+  double sr_ = 48000.0;
+  uint32_t maxBlock_ = 1024;
+  uint32_t numVoices_ = 1;
+
+  // Lane state
+  alignas(32) float phase_[kMaxVoices] = {};
+  alignas(32) float inc_[kMaxVoices] = {};
+  alignas(32) float incTarget_[kMaxVoices] = {};
+  alignas(32) float env_[kMaxVoices] = {};
+  alignas(32) int32_t stage_[kMaxVoices] = {};
+  alignas(32) int32_t gateLeft_[kMaxVoices] = {};
+  alignas(32) int32_t wave_[kMaxVoices] = {};
+  alignas(32) int32_t sync_[kMaxVoices] = {};
+  alignas(32) float ring_[kMaxVoices] = {};
+  alignas(32) float velocity_[kMaxVoices] = {1, 1, 1, 1, 1, 1, 1, 1};
+  float note_[kMaxVoices] = {60, 60, 60, 60, 60, 60, 60, 60};
+  float fine_[kMaxVoices] = {};
+  uint64_t age_[kMaxVoices] = {};
+  LaneRamp pw_{0.5f};
+  LaneRamp gain_{1.0f};
+  LaneRamp pan_{0.0f};
+  LaneRamp noiseMix_{0.0f};
+  uint64_t serial_ = 0;
+
+  // Envelope / glide
+  float attackMs_ = 10.0f, decayMs_ = 120.0f, sustain_ = 0.7f, releaseMs_ = 200.0f;
+  float attackInc_ = 0.0f, decayRate_ = 0.0f, releaseCoef_ = 0.0f;
+  float gateMs_ = 0.0f;
+  float glideMs_ = 0.0f, glideCoef_ = 1.0f;
+
+  // Noise
+  RngStream rng_{};
+  bool noiseShared_ = false, noiseLfsr_ = false;
+  float noiseClockHz_ = 0.0f, noiseGlobal_ = 0.0f;
+  uint32_t lfsr_ = 1u;
+  float lfsrPhase_ = 0.0f, lfsrOut_ = 1.0f;
+  std::vector<float> laneNoise_;   // maxBlock x kMaxVoices, frame-major
+  std::vector<float> sharedNoise_;
+
+  // Shared processing
+  int32_t filterType_ = kFilterOff;
+  float ic1_[2] = {}, ic2_[2] = {};
+  float gritBits_ = 0.0f, gritSrHz_ = 0.0f;
+  float holdPhase_ = 1.0f, holdL_ = 0.0f, holdR_ = 0.0f;
+  bool alias_ = false;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// 8-tap windowed-sinc polyphase interpolator for sample playback at arbitrary rates.
+// The kernel is tabulated at kPhases fractional offsets; each output sample blends two
+// adjacent phase rows and takes an 8-wide dot product, which compiles to SIMD multiply-adds.
+// Taps cover src[i-3 .. i+4] around the integer read position i.
+// Playing faster than the source rate (step > 1) moves source content above the output
+// Nyquist, so one kernel is tabulated per quarter octave of step (up to 8x) with its cutoff
+// lowered to match.
+class PolyphaseInterpolator {
+public:
+  static constexpr int kTaps = 8;
+  static constexpr int kPhases = 64;
+  static constexpr int kLeft = 3; // taps before the read position
+  static constexpr int kBands = 13; // steps 1 .. 8 in quarter octaves
+
+  static const PolyphaseInterpolator& get() { static const PolyphaseInterpolator k; return k; }
+
+  // Kernel band for a playback step: the first whose step is at least this one
+  static int bandForStep(double step) {
+    if (step <= 1.0) return 0;
+    const int b = static_cast<int>(std::ceil(4.0 * std::log2(step) - 1e-9));
+    return std::min(b, kBands - 1);
+  }
+
+  // src points at the sample for integer position i; frac in [0,1)
+  inline float interpolate(const float* src, float frac, int band = 0) const {
+    const float p = frac * static_cast<float>(kPhases);
+    const int k = static_cast<int>(p);
+    const float t = p - static_cast<float>(k);
+    const float* a = table_[band] + k * kTaps;
+    const float* b = a + kTaps;
+    const float* s = src - kLeft;
+    float acc = 0.0f;
+    for (int j = 0; j < kTaps; ++j) acc += (a[j] + (b[j] - a[j]) * t) * s[j];
+    return acc;
+  }
+
+private:
+  PolyphaseInterpolator() {
+    for (int b = 0; b < kBands; ++b) fillTable(table_[b], 0.92 / std::exp2(b / 4.0));
+  }
+
+  // Blackman-windowed sinc at the given cutoff (fraction of Nyquist); each row normalised to
+  // unity DC gain
+  static void fillTable(float* table, double cutoff) {
+    constexpr double kPi = 3.14159265358979323846;
+    for (int ph = 0; ph <= kPhases; ++ph) {
+      const double frac = static_cast<double>(ph) / kPhases;
+      double sum = 0.0;
+      double row[kTaps];
+      for (int j = 0; j < kTaps; ++j) {
+        const double x = static_cast<double>(j - kLeft) - frac;
+        const double sinc = (std::fabs(x) < 1e-9) ? 1.0 : std::sin(kPi * cutoff * x) / (kPi * cutoff * x);
+        const double w = (x / (kTaps / 2.0) + 1.0) * 0.5; // 0..1 across the kernel span
+        const double win = (w <= 0.0 || w >= 1.0) ? 0.0 : 0.42 - 0.5 * std::cos(2.0 * kPi * w) + 0.08 * std::cos(4.0 * kPi * w);
+        row[j] = sinc * win;
+        sum += row[j];
+      }
+      for (int j = 0; j < kTaps; ++j) table[ph * kTaps + j] = static_cast<float>(row[j] / sum);
+    }
+  }
+
+  alignas(32) float table_[kBands][(kPhases + 1) * kTaps];
+};
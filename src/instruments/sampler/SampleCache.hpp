@@ -0,0 +1,281 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../../io/AudioFileReader.hpp"
+#include "../../io/MappedFile.hpp"
+
+// Process-wide sample memory counters for the metrics stream (relaxed atomics)
+struct SampleCacheStats {
+  std::atomic<uint64_t> samples{0};
+  std::atomic<uint64_t> decodedBytes{0};     // decoded float data held in RAM
+  std::atomic<uint64_t> mappedBytes{0};      // size of memory-mapped files
+  std::atomic<uint64_t> residentBytes{0};    // mapped bytes currently in memory (refreshed by the prefetcher)
+  std::atomic<uint64_t> prefetchedBytes{0};  // bytes pre-faulted by the prefetcher
+  std::atomic<uint64_t> prefetchRequests{0};
+  std::atomic<uint64_t> loadHits{0};         // SampleCache::load served from a live entry
+  std::atomic<uint64_t> loadMisses{0};       // SampleCache::load that read the file
+};
+inline SampleCacheStats& sampleCacheStats() { static SampleCacheStats s; return s; }
+
+enum class SamplePreload : uint8_t { Auto, Ram, Map };
+
+// One loaded sample. Small files are decoded to planar floats at load; large ones stay
+// memory-mapped and are decoded per block straight from the mapping, so opening a multi-GB
+// library only parses headers. Immutable after construction; shared across nodes.
+class SampleData {
+public:
+  SampleData(const std::string& path, SamplePreload preload, uint64_t mapThresholdBytes) : path_(path) {
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0) throw std::runtime_error("Cannot open sample: " + path);
+    const bool map = preload == SamplePreload::Map || (preload == SamplePreload::Auto && static_cast<uint64_t>(st.st_size) > mapThresholdBytes);
+    auto& stats = sampleCacheStats();
+    if (map) {
+      file_.open(path);
+      info_ = parseAudioFileHeader(file_.data(), file_.size());
+      stats.mappedBytes.fetch_add(file_.size(), std::memory_order_relaxed);
+    } else {
+      planar_ = readAudioFilePlanar(path, info_);
+      stats.decodedBytes.fetch_add(decodedBytes(), std::memory_order_relaxed);
+    }
+    stats.samples.fetch_add(1, std::memory_order_relaxed);
+  }
+  ~SampleData() {
+    auto& stats = sampleCacheStats();
+    if (mapped()) stats.mappedBytes.fetch_sub(file_.size(), std::memory_order_relaxed);
+    else stats.decodedBytes.fetch_sub(decodedBytes(), std::memory_order_relaxed);
+    stats.samples.fetch_sub(1, std::memory_order_relaxed);
+  }
+  SampleData(const SampleData&) = delete;
+  SampleData& operator=(const SampleData&) = delete;
+
+  const std::string& path() const { return path_; }
+  const AudioFileInfo& info() const { return info_; }
+  uint32_t channels() const { return info_.channels; }
+  uint32_t sampleRate() const { return info_.sampleRate; }
+  uint64_t frames() const { return info_.frames; }
+  bool mapped() const { return file_.data() != nullptr; }
+
+  // Frames [start, start+n) of channel ch into out; silence outside the sample. Realtime-safe
+  // (mapped data may page-fault unless the prefetcher has warmed the range).
+  void readChannel(uint32_t ch, int64_t start, uint32_t n, float* out) const {
+    if (mapped()) { decodeChannel(info_, file_.data(), ch, start, n, out); return; }
+    const std::vector<float>& src = planar_[ch];
+    const int64_t total = static_cast<int64_t>(src.size());
+    const int64_t lo = std::max<int64_t>(start, 0), hi = std::min<int64_t>(start + n, total);
+    if (hi <= lo) { std::fill(out, out + n, 0.0f); return; }
+    const size_t before = static_cast<size_t>(lo - start), count = static_cast<size_t>(hi - lo);
+    std::fill(out, out + before, 0.0f);
+    std::memcpy(out + before, src.data() + lo, count * sizeof(float));
+    std::fill(out + before + count, out + n, 0.0f);
+  }
+
+  // Pre-fault the mapped bytes behind [start, start+frames); returns bytes covered
+  size_t touchFrames(uint64_t start, uint64_t frames) const {
+    if (!mapped() || start >= info_.frames) return 0;
+    frames = std::min(frames, info_.frames - start);
+    return file_.touch(static_cast<size_t>(info_.dataOffset + start * info_.bytesPerFrame), static_cast<size_t>(frames * info_.bytesPerFrame));
+  }
+  size_t residentBytes() const { return mapped() ? file_.residentBytes() : 0; }
+
+private:
+  uint64_t decodedBytes() const {
+    uint64_t b = 0;
+    for (const auto& c : planar_) b += c.size() * sizeof(float);
+    return b;
+  }
+
+  std::string path_;
+  AudioFileInfo info_{};
+  MappedFile file_;
+  std::vector<std::vector<float>> planar_;
+};
+
+// Background pre-toucher. Heads of upcoming samples are warmed in request (trigger) order;
+// playing voices publish their read position and the thread keeps lookaheadSec of pages
+// ahead of each one resident. The audio thread only does relaxed atomic stores.
+class SamplePrefetcher {
+public:
+  struct Cursor {
+    static constexpr uint32_t kSlots = 8;
+    std::shared_ptr<const SampleData> sample;
+    std::atomic<int64_t> frame[kSlots];   // written by the audio thread; -1 = idle
+    int64_t warmedEnd[kSlots];            // prefetcher-thread only
+    Cursor() { for (uint32_t i = 0; i < kSlots; ++i) { frame[i].store(-1, std::memory_order_relaxed); warmedEnd[i] = -1; } }
+  };
+
+  ~SamplePrefetcher() { stop(); }
+
+  void setLookaheadSec(double s) { lookaheadSec_ = std::max(0.05, s); }
+  void setResidencyProbe(std::function<uint64_t()> fn) { std::lock_guard<std::mutex> lk(mu_); probe_ = std::move(fn); }
+
+  void warmHead(std::shared_ptr<const SampleData> s, uint64_t startFrame, uint64_t frames) {
+    if (!s || !s->mapped()) return;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      heads_.push_back(HeadRequest{std::move(s), startFrame, frames});
+    }
+    sampleCacheStats().prefetchRequests.fetch_add(1, std::memory_order_relaxed);
+    ensureRunning();
+    cv_.notify_one();
+  }
+
+  void track(const std::shared_ptr<Cursor>& c) {
+    if (!c || !c->sample || !c->sample->mapped()) return;
+    { std::lock_guard<std::mutex> lk(mu_); cursors_.push_back(c); }
+    ensureRunning();
+    cv_.notify_one();
+  }
+
+  void stop() {
+    if (!running_.exchange(false)) return;
+    cv_.notify_one();
+    if (thread_.joinable()) thread_.join();
+  }
+
+private:
+  struct HeadRequest { std::shared_ptr<const SampleData> sample; uint64_t start; uint64_t frames; };
+
+  void ensureRunning() {
+    bool expected = false;
+    if (running_.compare_exchange_strong(expected, true)) thread_ = std::thread([this]{ run(); });
+  }
+
+  void run() {
+    auto lastProbe = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<Cursor>> live;
+    while (running_.load()) {
+      std::deque<HeadRequest> heads;
+      std::function<uint64_t()> probe;
+      {
+        std::unique_lock<std::mutex> lk(mu_);
+        // Poll playing cursors every 2 ms; with none, sleep until a head or cursor is queued
+        auto wake = [&]{ return !heads_.empty() || !running_.load(); };
+        if (cursors_.empty()) cv_.wait(lk, [&]{ return wake() || !cursors_.empty(); });
+        else cv_.wait_for(lk, std::chrono::milliseconds(2), wake);
+        heads.swap(heads_);
+        live.clear();
+        cursors_.erase(std::remove_if(cursors_.begin(), cursors_.end(), [&](const std::weak_ptr<Cursor>& w) {
+          auto c = w.lock(); if (!c) return true; live.push_back(std::move(c)); return false; }), cursors_.end());
+        probe = probe_;
+      }
+      auto& stats = sampleCacheStats();
+      for (const auto& h : heads) stats.prefetchedBytes.fetch_add(h.sample->touchFrames(h.start, h.frames), std::memory_order_relaxed);
+      for (const auto& c : live) {
+        const int64_t ahead = static_cast<int64_t>(lookaheadSec_ * c->sample->sampleRate());
+        for (uint32_t s = 0; s < Cursor::kSlots; ++s) {
+          const int64_t f = c->frame[s].load(std::memory_order_relaxed);
+          if (f < 0) { c->warmedEnd[s] = -1; continue; }
+          // Warm in half-lookahead steps so a voice never runs into cold pages
+          if (c->warmedEnd[s] >= f + ahead / 2) continue;
+          const int64_t from = std::max(f, c->warmedEnd[s]);
+          const int64_t to = f + ahead;
+          stats.prefetchedBytes.fetch_add(c->sample->touchFrames(static_cast<uint64_t>(from), static_cast<uint64_t>(to - from)), std::memory_order_relaxed);
+          c->warmedEnd[s] = to;
+        }
+      }
+      const auto now = std::chrono::steady_clock::now();
+      if (probe && now - lastProbe >= std::chrono::seconds(1)) {
+        stats.residentBytes.store(probe(), std::memory_order_relaxed);
+        lastProbe = now;
+      }
+    }
+  }
+
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::deque<HeadRequest> heads_;
+  std::vector<std::weak_ptr<Cursor>> cursors_;
+  std::function<uint64_t()> probe_;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+  double lookaheadSec_ = 2.0;
+};
+
+// Shared, reference-counted sample cache keyed by path. Entries live as long as some node
+// holds them; loading the same path twice returns the same SampleData.
+class SampleCache {
+public:
+  static SampleCache& instance() { static SampleCache cache; return cache; }
+
+  // The file is read outside the lock so loads of other paths do not wait on it; if two
+  // threads load the same new path at once, the first to finish wins and both share it
+  std::shared_ptr<const SampleData> load(const std::string& path, SamplePreload preload = SamplePreload::Auto) {
+    if (auto s = find(path)) { sampleCacheStats().loadHits.fetch_add(1, std::memory_order_relaxed); return s; }
+    auto loaded = std::make_shared<const SampleData>(path, preload, mapThresholdBytes_);
+    sampleCacheStats().loadMisses.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lk(mu_);
+    auto& entry = entries_[path];
+    if (auto s = entry.lock()) return s;
+    entry = loaded;
+    if (pinLoaded_) pinned_.push_back(loaded);
+    return loaded;
+  }
+
+  // Keep samples loaded from now on alive after their last node is gone, so a long-lived
+  // process (--serve-batch) reuses them across renders; off releases the pinned ones
+  void setPinLoaded(bool on) {
+    std::lock_guard<std::mutex> lk(mu_);
+    pinLoaded_ = on;
+    if (!on) pinned_.clear();
+  }
+
+  void setMapThresholdBytes(uint64_t b) { mapThresholdBytes_ = b; }
+  SamplePrefetcher& prefetcher() { return prefetcher_; }
+
+  // Resident bytes of all live mapped samples (mincore); non-realtime
+  uint64_t residentBytes() {
+    std::vector<std::shared_ptr<const SampleData>> live;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      for (auto it = entries_.begin(); it != entries_.end();) {
+        if (auto s = it->second.lock()) { live.push_back(std::move(s)); ++it; }
+        else it = entries_.erase(it);
+      }
+    }
+    uint64_t b = 0;
+    for (const auto& s : live) b += s->residentBytes();
+    return b;
+  }
+
+  void printSummary(FILE* out) const {
+    const auto& st = sampleCacheStats();
+    std::fprintf(out, "Sample cache: samples=%llu decoded=%.1fMB mapped=%.1fMB resident=%.1fMB prefetched=%.1fMB\n",
+                 static_cast<unsigned long long>(st.samples.load()), static_cast<double>(st.decodedBytes.load()) / 1048576.0,
+                 static_cast<double>(st.mappedBytes.load()) / 1048576.0, static_cast<double>(st.residentBytes.load()) / 1048576.0,
+                 static_cast<double>(st.prefetchedBytes.load()) / 1048576.0);
+  }
+
+private:
+  SampleCache() { prefetcher_.setResidencyProbe([this]{ return residentBytes(); }); }
+  ~SampleCache() { prefetcher_.stop(); }
+
+  std::shared_ptr<const SampleData> find(const std::string& path) {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = entries_.find(path);
+    return it != entries_.end() ? it->second.lock() : nullptr;
+  }
+
+  std::mutex mu_;
+  std::unordered_map<std::string, std::weak_ptr<const SampleData>> entries_;
+  std::vector<std::shared_ptr<const SampleData>> pinned_;
+  bool pinLoaded_ = false;
+  uint64_t mapThresholdBytes_ = 16ull << 20;
+  SamplePrefetcher prefetcher_;
+};
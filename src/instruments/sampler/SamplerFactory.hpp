@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "SamplerNode.hpp"
+#include "../../core/ParamMap.hpp"
+
+// params: path, note, rootNote, tuneCents, gain, pan, velocity, startMs, attackMs, releaseMs,
+// gateMs, loop, preload ("auto"|"ram"|"map"). A sample that fails to load yields a silent node.
+inline std::unique_ptr<SamplerNode> makeSamplerFromParamsJson(const std::string& paramsJson) {
+  SamplerNode::Settings s;
+  std::string path;
+  SamplePreload preload = SamplePreload::Auto;
+  try {
+    if (!paramsJson.empty()) {
+      nlohmann::json j = nlohmann::json::parse(paramsJson);
+      path = j.value("path", std::string());
+      s.note = static_cast<float>(j.value("note", 60.0));
+      s.rootNote = static_cast<float>(j.value("rootNote", 60.0));
+      s.tuneCents = static_cast<float>(j.value("tuneCents", 0.0));
+      s.gain = clampToRange(kSamplerParamMap, "GAIN", static_cast<float>(j.value("gain", 1.0)));
+      s.pan = clampToRange(kSamplerParamMap, "PAN", static_cast<float>(j.value("pan", 0.0)));
+      s.velocity = clampToRange(kSamplerParamMap, "VELOCITY", static_cast<float>(j.value("velocity", 1.0)));
+      s.startMs = static_cast<float>(j.value("startMs", 0.0));
+      s.attackMs = static_cast<float>(j.value("attackMs", 0.0));
+      s.releaseMs = static_cast<float>(j.value("releaseMs", 30.0));
+      s.gateMs = static_cast<float>(j.value("gateMs", 0.0));
+      s.loop = j.value("loop", false);
+      const std::string pl = j.value("preload", std::string("auto"));
+      if (pl == "ram") preload = SamplePreload::Ram;
+      else if (pl == "map") preload = SamplePreload::Map;
+    }
+  } catch (...) {}
+  std::shared_ptr<const SampleData> sample;
+  if (path.empty()) {
+    std::fprintf(stderr, "Warning: sampler has no 'path'\n");
+  } else {
+    try { sample = SampleCache::instance().load(path, preload); }
+    catch (const std::exception& e) { std::fprintf(stderr, "Warning: sampler: %s\n", e.what()); }
+  }
+  return std::make_unique<SamplerNode>(std::move(sample), s);
+}
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../../core/MemoryAccounting.hpp"
+#include "../../core/Node.hpp"
+#include "../../core/GainRamp.hpp"
+#include "../../core/ParamIds.hpp"
+#include "PolyphaseInterpolator.hpp"
+#include "SampleCache.hpp"
+
+// Sample playback node: up to kVoices overlapping one-shots (or loops) of one shared sample,
+// pitched by NOTE_SEMITONES relative to ROOT_NOTE through the polyphase interpolator.
+// Mapped samples are read straight from the mapping; each voice publishes its read position
+// so the SampleCache prefetcher keeps the pages ahead of it resident.
+class SamplerNode : public Node {
+public:
+  static constexpr uint32_t kVoices = SamplePrefetcher::Cursor::kSlots;
+
+  struct Settings {
+    float note = 60.0f;       // note for the next Trigger
+    float rootNote = 60.0f;   // note at which the sample plays at its recorded pitch
+    float tuneCents = 0.0f;
+    float gain = 1.0f;
+    float pan = 0.0f;
+    float velocity = 1.0f;    // used when Trigger carries no value
+    float startMs = 0.0f;     // playback start offset into the sample
+    float attackMs = 0.0f;
+    float releaseMs = 30.0f;
+    float gateMs = 0.0f;      // auto-release after Trigger; 0 = play to the end
+    bool loop = false;
+  };
+
+  SamplerNode(std::shared_ptr<const SampleData> sample, const Settings& s) : sample_(std::move(sample)), set_(s) {
+    for (auto& w : window_) w.assign(kWindow, 0.0f);
+    gain_.setImmediate(s.gain);
+    if (sample_ && sample_->mapped()) {
+      cursor_ = std::make_shared<SamplePrefetcher::Cursor>();
+      cursor_->sample = sample_;
+      SampleCache::instance().prefetcher().track(cursor_);
+    }
+  }
+
+  const char* name() const override { return "sampler"; }
+  const std::shared_ptr<const SampleData>& sample() const { return sample_; }
+  // First frame a Trigger plays from (for pre-warming)
+  uint64_t startFrame() const { return sample_ ? static_cast<uint64_t>(std::max(0.0f, set_.startMs) * 0.001 * sample_->sampleRate()) : 0u; }
+
+  void prepare(double sampleRate, uint32_t maxBlock) override {
+    sr_ = sampleRate > 0.0 ? sampleRate : 48000.0;
+    const size_t n = maxBlock > 0 ? maxBlock : 1024u;
+    mixL_.assign(n, 0.0f); mixR_.assign(n, 0.0f); gains_.assign(n, 0.0f);
+  }
+  void reset() override {
+    for (uint32_t v = 0; v < kVoices; ++v) { voices_[v].active = false; publish(v); }
+  }
+
+  void handleEvent(const Command& cmd) override {
+    if (cmd.type == CommandType::Trigger) { noteOn(set_.note, cmd.value > 0.0f ? cmd.value : set_.velocity); return; }
+    const float v = cmd.value;
+    switch (cmd.paramId) {
+      case SamplerParam::NOTE_SEMITONES: set_.note = v; break;
+      case SamplerParam::ROOT_NOTE: set_.rootNote = v; break;
+      case SamplerParam::TUNE_CENTS: set_.tuneCents = v; break;
+      case SamplerParam::GAIN:
+        if (cmd.type == CommandType::SetParamRamp) gain_.rampTo(v, cmd.rampMs, sr_); else gain_.setImmediate(v);
+        break;
+      case SamplerParam::PAN: set_.pan = std::clamp(v, -1.0f, 1.0f); break;
+      case SamplerParam::VELOCITY: set_.velocity = v; break;
+      case SamplerParam::START_MS: set_.startMs = v; break;
+      case SamplerParam::ATTACK_MS: set_.attackMs = v; break;
+      case SamplerParam::RELEASE_MS: set_.releaseMs = v; break;
+      case SamplerParam::GATE_MS: set_.gateMs = v; break;
+      case SamplerParam::LOOP: set_.loop = v >= 0.5f; break;
+      case SamplerParam::NOTE_OFF:
+        for (auto& vc : voices_) if (vc.active && vc.note == v) release(vc);
+        break;
+      default: break;
+    }
+  }
+
+  void process(ProcessContext ctx, float* interleavedOut, uint32_t channels) override {
+    const uint32_t n = ctx.frames;
+    if (channels == 0 || n == 0) return;
+    if (mixL_.size() < n) { mixL_.resize(n); mixR_.resize(n); gains_.resize(n); }
+    std::fill(mixL_.begin(), mixL_.begin() + n, 0.0f);
+    std::fill(mixR_.begin(), mixR_.begin() + n, 0.0f);
+    if (sample_) {
+      for (uint32_t v = 0; v < kVoices; ++v) {
+        if (voices_[v].active) renderVoice(voices_[v], n);
+        publish(v);
+      }
+    }
+    gain_.render(gains_.data(), n);
+    multiplyGains(mixL_.data(), gains_.data(), n);
+    multiplyGains(mixR_.data(), gains_.data(), n);
+    if (channels == 1) {
+      for (uint32_t i = 0; i < n; ++i) interleavedOut[i] = (mixL_[i] + mixR_[i]) * 0.70710678f;
+      return;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+      float* frame = interleavedOut + static_cast<size_t>(i) * channels;
+      frame[0] = mixL_[i]; frame[1] = mixR_[i];
+      for (uint32_t c = 2; c < channels; ++c) frame[c] = 0.0f;
+    }
+  }
+
+  bool skipIfSilent(ProcessContext ctx) override {
+    (void)ctx;
+    return activeVoices() == 0 && gain_.steady(); // idle voices already published -1
+  }
+
+  // Scratch and resampling windows; the sample data is shared and counted by the SampleCache
+  size_t memoryBytes() const override {
+    return vectorBytes(window_[0]) + vectorBytes(window_[1]) + vectorBytes(mixL_) + vectorBytes(mixR_) + vectorBytes(gains_);
+  }
+
+  // Idle voices are fully rewritten by the next noteOn; ages count relative to the newest
+  bool hashState(StateHash& h) const override {
+    h.add(set_.note, set_.rootNote, set_.tuneCents, set_.pan, set_.velocity, set_.startMs, set_.attackMs,
+          set_.releaseMs, set_.gateMs, set_.loop);
+    gain_.hashState(h);
+    for (const auto& v : voices_) {
+      h.add(v.active);
+      if (!v.active) continue;
+      h.add(v.releasing, v.wrapped, v.pos, v.step, v.env, v.envInc, v.releaseDec, v.gateLeft, v.note, v.gainL, v.gainR, ageCounter_ - v.age);
+    }
+    return true;
+  }
+
+  uint32_t activeVoices() const {
+    uint32_t c = 0;
+    for (const auto& v : voices_) c += v.active ? 1u : 0u;
+    return c;
+  }
+
+private:
+  static constexpr uint32_t kWindow = 4096;     // source frames decoded per chunk
+  static constexpr double kMaxStep = 8.0;       // +3 octaves at equal rates
+
+  struct Voice {
+    bool active = false;
+    bool releasing = false;
+    double pos = 0.0;       // source frame position
+    double step = 1.0;      // source frames per output frame
+    float env = 0.0f, envInc = 0.0f, releaseDec = 0.0f;
+    int64_t gateLeft = -1;  // output frames until auto-release; -1 = none
+    float note = 60.0f;
+    float gainL = 1.0f, gainR = 1.0f;
+    uint64_t age = 0;
+    bool wrapped = false;   // looped back to the start at least once
+  };
+
+  void noteOn(float note, float velocity) {
+    Voice* vc = &voices_[0];
+    for (auto& v : voices_) {
+      if (!v.active) { vc = &v; break; }
+      if (v.age < vc->age) vc = &v; // steal the oldest
+    }
+    const double srcSr = sample_ ? static_cast<double>(sample_->sampleRate()) : sr_;
+    const double semis = static_cast<double>(note - set_.rootNote) + set_.tuneCents / 100.0;
+    vc->step = std::min(kMaxStep, std::pow(2.0, semis / 12.0) * srcSr / sr_);
+    vc->pos = static_cast<double>(startFrame());
+    vc->wrapped = false;
+    vc->note = note;
+    vc->active = true;
+    vc->releasing = false;
+    const float attack = static_cast<float>(set_.attackMs * 0.001 * sr_);
+    vc->env = attack >= 1.0f ? 0.0f : 1.0f;
+    vc->envInc = attack >= 1.0f ? 1.0f / attack : 0.0f;
+    vc->gateLeft = set_.gateMs > 0.0f ? static_cast<int64_t>(set_.gateMs * 0.001 * sr_) : -1;
+    vc->age = ++ageCounter_;
+    // Mono sources pan equal-power; stereo sources use a balance control
+    const float vel = std::max(0.0f, velocity);
+    if (sample_ && sample_->channels() >= 2) {
+      vc->gainL = vel * std::min(1.0f, 1.0f - set_.pan);
+      vc->gainR = vel * std::min(1.0f, 1.0f + set_.pan);
+    } else {
+      vc->gainL = vel * std::cos(0.25f * 3.14159265f * (set_.pan + 1.0f));
+      vc->gainR = vel * std::sin(0.25f * 3.14159265f * (set_.pan + 1.0f));
+    }
+  }
+
+  void release(Voice& vc) {
+    if (vc.releasing) return;
+    vc.releasing = true;
+    vc.gateLeft = -1;
+    const float rel = static_cast<float>(set_.releaseMs * 0.001 * sr_);
+    vc.releaseDec = rel >= 1.0f ? vc.env / rel : vc.env;
+  }
+
+  void renderVoice(Voice& vc, uint32_t frames) {
+    const PolyphaseInterpolator& interp = PolyphaseInterpolator::get();
+    const double total = static_cast<double>(sample_->frames());
+    const uint32_t srcChannels = std::min<uint32_t>(sample_->channels(), 2u);
+    const int band = PolyphaseInterpolator::bandForStep(vc.step);
+    // Longest run whose source window fits the scratch buffers
+    const uint32_t maxRun = std::max<uint32_t>(1u, static_cast<uint32_t>((kWindow - 2 * PolyphaseInterpolator::kTaps) / vc.step));
+    uint32_t done = 0;
+    while (done < frames && vc.active) {
+      uint32_t run = std::min(frames - done, maxRun);
+      // Looping voices stop a run at the sample end and wrap before the next one
+      if (set_.loop && vc.pos < total) run = std::min<uint32_t>(run, static_cast<uint32_t>(std::ceil((total - vc.pos) / vc.step)));
+      run = std::max(run, 1u);
+      const int64_t base = static_cast<int64_t>(std::floor(vc.pos)) - PolyphaseInterpolator::kLeft;
+      const uint32_t span = static_cast<uint32_t>(std::ceil(vc.step * run)) + PolyphaseInterpolator::kTaps + 1;
+      for (uint32_t c = 0; c < srcChannels; ++c) readWindow(vc, c, base, span, window_[c].data());
+      const float* srcL = window_[0].data();
+      const float* srcR = window_[srcChannels > 1 ? 1 : 0].data();
+      float* outL = mixL_.data() + done;
+      float* outR = mixR_.data() + done;
+      double p = vc.pos;
+      uint32_t i = 0;
+      for (; i < run; ++i) {
+        const double fl = std::floor(p);
+        const size_t idx = static_cast<size_t>(static_cast<int64_t>(fl) - base);
+        const float frac = static_cast<float>(p - fl);
+        const float sL = interp.interpolate(srcL + idx, frac, band);
+        const float sR = (srcR == srcL) ? sL : interp.interpolate(srcR + idx, frac, band);
+        outL[i] += sL * vc.env * vc.gainL;
+        outR[i] += sR * vc.env * vc.gainR;
+        p += vc.step;
+        if (!advanceEnvelope(vc)) { ++i; break; }
+      }
+      vc.pos = p;
+      done += i;
+      if (!vc.active) break;
+      if (vc.pos >= total) {
+        if (set_.loop && total > 0.0) { vc.pos = std::fmod(vc.pos - total, total); vc.wrapped = true; }
+        else if (vc.pos >= total + PolyphaseInterpolator::kTaps) vc.active = false; // interpolation tail played out
+      }
+    }
+  }
+
+  // Source frames [base, base+n) of channel c. Looping voices read the taps past the end from
+  // the loop start, and (once wrapped) the taps before the start from the loop end, so the
+  // seam interpolates across real signal instead of silence.
+  void readWindow(const Voice& vc, uint32_t c, int64_t base, uint32_t n, float* out) const {
+    const int64_t total = static_cast<int64_t>(sample_->frames());
+    if (!set_.loop || total <= 0) { sample_->readChannel(c, base, n, out); return; }
+    uint32_t done = 0;
+    if (base < 0 && !vc.wrapped) {
+      const uint32_t lead = static_cast<uint32_t>(std::min<int64_t>(-base, n));
+      std::fill(out, out + lead, 0.0f);
+      done = lead;
+    }
+    while (done < n) {
+      int64_t at = (base + done) % total;
+      if (at < 0) at += total;
+      const uint32_t len = static_cast<uint32_t>(std::min<int64_t>(n - done, total - at));
+      sample_->readChannel(c, at, len, out + done);
+      done += len;
+    }
+  }
+
+  // Per-sample envelope step; returns false when the voice has finished its release
+  bool advanceEnvelope(Voice& vc) {
+    if (vc.releasing) {
+      vc.env -= vc.releaseDec;
+      if (vc.env <= 0.0f) { vc.env = 0.0f; vc.active = false; return false; }
+      return true;
+    }
+    if (vc.envInc > 0.0f) { vc.env += vc.envInc; if (vc.env >= 1.0f) { vc.env = 1.0f; vc.envInc = 0.0f; } }
+    if (vc.gateLeft > 0 && --vc.gateLeft == 0) release(vc);
+    return true;
+  }
+
+  void publish(uint32_t v) {
+    if (!cursor_) return;
+    cursor_->frame[v].store(voices_[v].active ? static_cast<int64_t>(voices_[v].pos) : -1, std::memory_order_relaxed);
+  }
+
+  std::shared_ptr<const SampleData> sample_;
+  std::shared_ptr<SamplePrefetcher::Cursor> cursor_;
+  Settings set_;
+  double sr_ = 48000.0;
+  Voice voices_[kVoices];
+  uint64_t ageCounter_ = 0;
+  GainRamp gain_;
+  std::vector<float> window_[2];
+  std::vector<float> mixL_, mixR_, gains_;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../../core/Graph.hpp"
+#include "../../core/GraphConfig.hpp"
+#include "../../offline/TransportGenerator.hpp"
+#include "SamplerNode.hpp"
+
+// Queue the heads of every mapped sampler sample on the prefetcher, earliest first trigger
+// first (transport patterns and explicit Trigger commands). Returns immediately; pages are
+// faulted in on the prefetcher thread while the engine starts. idPrefix is prepended to spec
+// node ids when the graph holds them rack-prefixed ("rack:node").
+inline void warmSamplerHeads(Graph& graph, const GraphSpec& spec, const std::string& idPrefix = std::string(), double headSec = 0.5) {
+  std::vector<std::pair<std::string, SamplerNode*>> samplers;
+  graph.forEachNode([&](const std::string& id, Node& n) {
+    if (auto* s = dynamic_cast<SamplerNode*>(&n)) if (s->sample() && s->sample()->mapped()) samplers.emplace_back(id, s);
+  });
+  if (samplers.empty()) return;
+  std::unordered_map<std::string, uint64_t> firstHit;
+  auto note = [&](const std::string& id, uint64_t t) {
+    auto it = firstHit.find(idPrefix + id);
+    if (it == firstHit.end() || t < it->second) firstHit[idPrefix + id] = t;
+  };
+  for (const auto& c : spec.commands) if (c.type == "Trigger") note(c.nodeId, c.sampleTime);
+  if (spec.hasTransport) {
+    // First hits only: a few bars cover every pattern's opening bar
+    GraphSpec::Transport head = spec.transport;
+    uint32_t bars = 1;
+    for (const auto& p : head.patterns) bars = std::max<uint32_t>(bars, std::max<uint32_t>(p.lengthBars, static_cast<uint32_t>(p.stepsBars.size())));
+    head.lengthBars = std::min(std::max<uint32_t>(head.lengthBars, 1u), bars);
+    for (const auto& c : generateCommandsFromTransport(head, spec.sampleRate)) if (c.type == "Trigger") note(c.nodeId, c.sampleTime);
+  }
+  auto hitOf = [&](const std::string& id) {
+    auto it = firstHit.find(id);
+    return it != firstHit.end() ? it->second : std::numeric_limits<uint64_t>::max();
+  };
+  std::stable_sort(samplers.begin(), samplers.end(), [&](const auto& a, const auto& b) { return hitOf(a.first) < hitOf(b.first); });
+  auto& pf = SampleCache::instance().prefetcher();
+  for (const auto& s : samplers) {
+    const auto& sample = s.second->sample();
+    pf.warmHead(sample, s.second->startFrame(), static_cast<uint64_t>(headSec * sample->sampleRate()));
+  }
+}
@@ -54,30 +54,7 @@ public:
     ctxSampleRate_ = ctx.sampleRate;
     for (uint32_t i = 0; i < ctx.frames; ++i) {
       mod_.tick();
-      // Pull parameter values
-      synth_.params().waveform = static_cast<int>(params_.next(Tb303Param::WAVEFORM) >= 0.5f ? 1 : 0);
-      synth_.params().tuneSemitones = params_.next(Tb303Param::TUNE_SEMITONES) + mod_.sumFor(Tb303Param::TUNE_SEMITONES);
-      synth_.params().glideMs = params_.next(Tb303Param::GLIDE_MS);
-      synth_.params().cutoffHz = params_.next(Tb303Param::CUTOFF_HZ) + mod_.sumFor(Tb303Param::CUTOFF_HZ);
-      synth_.params().resonance = params_.next(Tb303Param::RESONANCE);
-      synth_.params().envMod = params_.next(Tb303Param::ENV_MOD);
-      synth_.params().filterDecayMs = params_.next(Tb303Param::FILTER_DECAY_MS);
-      synth_.params().ampDecayMs = params_.next(Tb303Param::AMP_DECAY_MS);
-      synth_.params().ampGain = params_.next(Tb303Param::AMP_GAIN);
-      synth_.params().drive = params_.next(Tb303Param::DRIVE);
-      // ADSR optional
-      synth_.params().envMode = params_.current(200);
-      synth_.params().filterAttackMs = params_.current(201);
-      synth_.params().filterSustain = params_.current(202);
-      synth_.params().filterReleaseMs = params_.current(203);
-      synth_.params().ampAttackMs = params_.current(204);
-      synth_.params().ampSustain = params_.current(205);
-      synth_.params().ampReleaseMs = params_.current(206);
-      synth_.params().gateLenMs = params_.current(207);
-      // Filter algo/type/keytracking
-      synth_.params().filterAlgo = params_.current(300);
-      synth_.params().filterType = params_.current(301);
-      synth_.params().keytrack = params_.current(302);
+      pullParams();
       float s = synth_.process();
       // Optional equal-power pan when channels >= 2
       float pan = params_.current(14 /* PAN */);
@@ -150,13 +127,55 @@ public:
     }
   }
 
+  bool skipIfSilent(ProcessContext ctx) override {
+    ctxSampleRate_ = ctx.sampleRate;
+    if (!params_.settled()) return false;
+    pullParams(); // idle() reads ENV_MODE as this block would see it
+    if (!synth_.idle()) return false;
+    mod_.skip(ctx.frames);
+    pullParams();
+    return true;
+  }
+
   // Expose LFO routing
   bool addLfo(uint16_t id, ModLfo::Wave wave, float freqHz, float phase01) { return mod_.addLfo(id, wave, freqHz, phase01); }
   bool addRoute(uint16_t sourceId, uint16_t destParamId, float depth, float offset = 0.0f) { return mod_.addRoute(sourceId, destParamId, depth, offset); }
   bool addLfoFreqRoute(uint16_t sourceId, uint16_t lfoId, float depth, float offset = 0.0f) { return mod_.addLfoFreqRoute(sourceId, lfoId, depth, offset); }
   bool addRouteWithRange(uint16_t sourceId, uint16_t destParamId, float minV, float maxV, typename ModMatrix<>::Route::Map map) { return mod_.addRouteWithRange(sourceId, destParamId, minV, maxV, map); }
 
+  bool hashState(StateHash& h) const override {
+    synth_.hashState(h); params_.hashState(h); mod_.hashState(h);
+    return true;
+  }
+
 private:
+  // Smoothed + modulated parameter values for the current sample
+  void pullParams() {
+    synth_.params().waveform = static_cast<int>(params_.next(Tb303Param::WAVEFORM) >= 0.5f ? 1 : 0);
+    synth_.params().tuneSemitones = params_.next(Tb303Param::TUNE_SEMITONES) + mod_.sumFor(Tb303Param::TUNE_SEMITONES);
+    synth_.params().glideMs = params_.next(Tb303Param::GLIDE_MS);
+    synth_.params().cutoffHz = params_.next(Tb303Param::CUTOFF_HZ) + mod_.sumFor(Tb303Param::CUTOFF_HZ);
+    synth_.params().resonance = params_.next(Tb303Param::RESONANCE);
+    synth_.params().envMod = params_.next(Tb303Param::ENV_MOD);
+    synth_.params().filterDecayMs = params_.next(Tb303Param::FILTER_DECAY_MS);
+    synth_.params().ampDecayMs = params_.next(Tb303Param::AMP_DECAY_MS);
+    synth_.params().ampGain = params_.next(Tb303Param::AMP_GAIN);
+    synth_.params().drive = params_.next(Tb303Param::DRIVE);
+    // ADSR optional
+    synth_.params().envMode = params_.current(200);
+    synth_.params().filterAttackMs = params_.current(201);
+    synth_.params().filterSustain = params_.current(202);
+    synth_.params().filterReleaseMs = params_.current(203);
+    synth_.params().ampAttackMs = params_.current(204);
+    synth_.params().ampSustain = params_.current(205);
+    synth_.params().ampReleaseMs = params_.current(206);
+    synth_.params().gateLenMs = params_.current(207);
+    // Filter algo/type/keytracking
+    synth_.params().filterAlgo = params_.current(300);
+    synth_.params().filterType = params_.current(301);
+    synth_.params().keytrack = params_.current(302);
+  }
+
   Tb303ExtSynth synth_;
   ParameterRegistry<12> params_;
   ModMatrix<> mod_;
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <cmath>
+#include "../../core/StateHash.hpp"
 
 struct Tb303ExtParams {
   int waveform = 0;          // 0=saw, 1=square
@@ -55,7 +56,12 @@ public:
   }
   void noteOff() { gate_ = false; }
 
+  // ADSR mode with both envelopes finished: silent until the next noteOn
+  bool idle() const { return params_.envMode > 0.5f && fStage_ == Stage::Idle && aStage_ == Stage::Idle; }
+
   float process() {
+    // An idle ADSR voice holds its oscillator, glide and filter state instead of running them silently
+    if (idle()) return 0.0f;
     // Glide current frequency toward target
     const float glideSamples = static_cast<float>((params_.glideMs * 0.001) * sampleRate_ + 0.5);
     if (glideSamples > 1.0f) {
@@ -135,6 +141,14 @@ public:
     return sOut;
   }
 
+  void hashState(StateHash& h) const {
+    const Tb303ExtParams& p = params_;
+    h.add(p.waveform, p.tuneSemitones, p.glideMs, p.cutoffHz, p.resonance, p.envMod, p.filterDecayMs, p.ampDecayMs,
+          p.ampGain, p.accent, p.velocity, p.noteSemitones, p.drive, p.envMode, p.filterAttackMs, p.filterSustain,
+          p.filterReleaseMs, p.ampAttackMs, p.ampSustain, p.ampReleaseMs, p.gateLenMs, p.filterAlgo, p.filterType, p.keytrack);
+    h.add(phase_, envF_, envA_, y1_, y2_, y3_, gate_, curHz_, targetHz_, fStage_, aStage_, stageSamples_, lp_, bp_);
+  }
+
   Tb303ExtParams& params() { return params_; }
   const Tb303ExtParams& params() const { return params_; }
 
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Asynchronous sequential file writer. write() copies into one of a few page-aligned buffers
+// (sizes are multiples of 4 KiB, so full-buffer writes stay O_DIRECT friendly); a full buffer
+// is handed to a dedicated I/O thread and the caller continues in the next one, so producing
+// data and disk writes overlap. When every buffer is in flight the caller waits (bounded
+// backpressure, counted in stats().stalls). I/O errors surface as std::runtime_error from the
+// next write/flush/close.
+class AsyncFileWriter {
+public:
+  struct Stats {
+    uint64_t bytes = 0;
+    double seconds = 0.0;   // open to close
+    double ioSeconds = 0.0; // time the I/O thread spent in write calls
+    uint64_t stalls = 0;    // writes that waited for a free buffer
+    double mbPerSec() const { return seconds > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds : 0.0; }
+  };
+
+  static constexpr size_t kAlign = 4096;
+
+  explicit AsyncFileWriter(size_t bufferBytes = size_t{1} << 20, uint32_t buffers = 2)
+    : bufferBytes_(std::max(kAlign, (bufferBytes + kAlign - 1) / kAlign * kAlign)) {
+    for (uint32_t i = 0; i < std::max(2u, buffers); ++i) {
+      void* p = nullptr;
+      if (::posix_memalign(&p, kAlign, bufferBytes_) != 0) throw std::bad_alloc();
+      buffers_.push_back(Buffer{ std::unique_ptr<uint8_t, decltype(&std::free)>(static_cast<uint8_t*>(p), &std::free), 0 });
+    }
+  }
+  ~AsyncFileWriter() { try { close(); } catch (...) {} }
+  AsyncFileWriter(const AsyncFileWriter&) = delete;
+  AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+  void open(const std::string& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) throw std::runtime_error("Cannot open for writing: " + path + " (" + std::strerror(errno) + ")");
+    path_ = path;
+    stats_ = Stats{};
+    error_.clear();
+    free_.clear(); queue_.clear();
+    for (size_t i = 1; i < buffers_.size(); ++i) free_.push_back(i);
+    current_ = 0; buffers_[0].used = 0;
+    position_ = 0;
+    stop_ = false;
+    t0_ = std::chrono::steady_clock::now();
+    thread_ = std::thread([this] { run(); });
+  }
+
+  bool isOpen() const { return fd_ >= 0; }
+  uint64_t position() const { return position_; }
+  const Stats& stats() const { return stats_; }
+  size_t memoryBytes() const { return buffers_.size() * bufferBytes_; }
+
+  void write(const void* data, size_t bytes) {
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    while (bytes > 0) {
+      Buffer& b = buffers_[current_];
+      const size_t n = std::min(bytes, bufferBytes_ - b.used);
+      std::memcpy(b.data.get() + b.used, src, n);
+      b.used += n; src += n; bytes -= n; position_ += n;
+      if (b.used == bufferBytes_) submitCurrent();
+    }
+  }
+
+  // Submit the partly filled buffer and wait until everything is on disk
+  void flush() {
+    if (fd_ < 0) return;
+    if (buffers_[current_].used > 0) submitCurrent();
+    std::unique_lock<std::mutex> lk(m_);
+    done_.wait(lk, [&] { return queue_.empty() && busy_ == 0; });
+    throwIfFailed();
+  }
+
+  // Overwrite bytes already written (header patches); flushes first
+  void writeAt(uint64_t offset, const void* data, size_t bytes) {
+    flush();
+    if (::pwrite(fd_, data, bytes, static_cast<off_t>(offset)) != static_cast<ssize_t>(bytes)) {
+      throw std::runtime_error("Write failed: " + path_ + " (" + std::strerror(errno) + ")");
+    }
+  }
+
+  void close() {
+    if (fd_ < 0) return;
+    std::string err;
+    try { flush(); } catch (const std::exception& e) { err = e.what(); }
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      stop_ = true;
+    }
+    ready_.notify_all();
+    if (thread_.joinable()) thread_.join();
+    ::close(fd_);
+    fd_ = -1;
+    stats_.bytes = position_;
+    stats_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0_).count();
+    if (!err.empty()) throw std::runtime_error(err);
+  }
+
+private:
+  struct Buffer { std::unique_ptr<uint8_t, decltype(&std::free)> data; size_t used; };
+
+  void submitCurrent() {
+    std::unique_lock<std::mutex> lk(m_);
+    throwIfFailed();
+    queue_.push_back(current_);
+    ready_.notify_one();
+    if (free_.empty()) {
+      ++stats_.stalls;
+      done_.wait(lk, [&] { return !free_.empty() || !error_.empty(); });
+      throwIfFailed();
+    }
+    current_ = free_.front(); free_.pop_front();
+    buffers_[current_].used = 0;
+  }
+
+  void throwIfFailed() const {
+    if (!error_.empty()) throw std::runtime_error(error_);
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lk(m_);
+    while (true) {
+      ready_.wait(lk, [&] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) break;
+      const size_t idx = queue_.front(); queue_.pop_front();
+      ++busy_;
+      lk.unlock();
+      const auto t0 = std::chrono::steady_clock::now();
+      std::string err;
+      const Buffer& b = buffers_[idx];
+      size_t off = 0;
+      while (off < b.used) {
+        const ssize_t w = ::write(fd_, b.data.get() + off, b.used - off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) { err = "Write failed: " + path_ + " (" + std::strerror(errno) + ")"; break; }
+        off += static_cast<size_t>(w);
+      }
+      const double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+      lk.lock();
+      stats_.ioSeconds += dt;
+      if (!err.empty() && error_.empty()) error_ = err;
+      free_.push_back(idx);
+      --busy_;
+      done_.notify_all();
+    }
+  }
+
+  size_t bufferBytes_;
+  std::vector<Buffer> buffers_;
+  size_t current_ = 0;
+  uint64_t position_ = 0;
+  int fd_ = -1;
+  std::string path_;
+  Stats stats_{};
+  std::chrono::steady_clock::time_point t0_{};
+  // Shared with the I/O thread
+  std::mutex m_;
+  std::condition_variable ready_, done_;
+  std::deque<size_t> queue_, free_;
+  uint32_t busy_ = 0;
+  bool stop_ = false;
+  std::string error_;
+  std::thread thread_;
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Portable WAV/AIFF(-C) reader (no platform audio APIs). Parsing works on a byte span so the
+// same code serves whole-file reads and memory-mapped sample libraries; decoding converts any
+// supported PCM/float encoding to float on the fly.
+
+enum class SampleEncoding : uint8_t { U8, S8, S16, S24, S32, F32, F64 };
+
+struct AudioFileInfo {
+  uint32_t channels = 0;
+  uint32_t sampleRate = 0;
+  SampleEncoding encoding = SampleEncoding::S16;
+  bool bigEndian = false;
+  uint32_t bytesPerFrame = 0;
+  uint64_t dataOffset = 0; // byte offset of the first frame
+  uint64_t frames = 0;
+};
+
+namespace audio_reader_detail {
+inline uint16_t le16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+inline uint32_t le32(const uint8_t* p) { return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+inline uint16_t be16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+inline uint32_t be32(const uint8_t* p) { return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]); }
+
+// AIFF stores the sample rate as an 80-bit IEEE extended float
+inline double extended80(const uint8_t* p) {
+  const int exponent = ((p[0] & 0x7F) << 8) | p[1];
+  uint64_t mantissa = 0;
+  for (int i = 0; i < 8; ++i) mantissa = (mantissa << 8) | p[2 + i];
+  if (exponent == 0 && mantissa == 0) return 0.0;
+  const double v = static_cast<double>(mantissa) * std::pow(2.0, exponent - 16383 - 63);
+  return (p[0] & 0x80) ? -v : v;
+}
+
+inline uint32_t bytesFor(SampleEncoding e) {
+  switch (e) {
+    case SampleEncoding::U8: return 1;
+    case SampleEncoding::S8: return 1;
+    case SampleEncoding::S16: return 2;
+    case SampleEncoding::S24: return 3;
+    case SampleEncoding::S32: return 4;
+    case SampleEncoding::F32: return 4;
+    case SampleEncoding::F64: return 8;
+  }
+  return 2;
+}
+
+inline SampleEncoding intEncoding(uint32_t bits) {
+  if (bits <= 8) return SampleEncoding::U8;
+  if (bits <= 16) return SampleEncoding::S16;
+  if (bits <= 24) return SampleEncoding::S24;
+  return SampleEncoding::S32;
+}
+
+inline void finish(AudioFileInfo& info, uint64_t dataBytes, size_t fileSize) {
+  if (info.channels == 0 || info.sampleRate == 0) throw std::runtime_error("Audio file: missing format chunk");
+  info.bytesPerFrame = bytesFor(info.encoding) * info.channels;
+  if (info.dataOffset > fileSize) throw std::runtime_error("Audio file: data chunk out of range");
+  const uint64_t avail = static_cast<uint64_t>(fileSize) - info.dataOffset; // tolerate truncated files
+  info.frames = std::min(dataBytes, avail) / info.bytesPerFrame;
+}
+
+inline void parseWav(const uint8_t* d, size_t size, AudioFileInfo& info) {
+  size_t pos = 12;
+  uint64_t dataBytes = 0;
+  bool haveData = false;
+  while (pos + 8 <= size) {
+    const uint8_t* ck = d + pos;
+    const uint32_t len = le32(ck + 4);
+    if (std::memcmp(ck, "fmt ", 4) == 0 && pos + 8 + 16 <= size) {
+      uint16_t tag = le16(ck + 8);
+      info.channels = le16(ck + 10);
+      info.sampleRate = le32(ck + 12);
+      const uint16_t bits = le16(ck + 22);
+      if (tag == 0xFFFE && len >= 40 && pos + 8 + 26 <= size) tag = le16(ck + 32); // WAVE_FORMAT_EXTENSIBLE subformat
+      if (tag == 1) info.encoding = intEncoding(bits);
+      else if (tag == 3) info.encoding = (bits == 64) ? SampleEncoding::F64 : SampleEncoding::F32;
+      else throw std::runtime_error("WAV: unsupported format tag " + std::to_string(tag));
+      info.bigEndian = false;
+    } else if (std::memcmp(ck, "data", 4) == 0) {
+      info.dataOffset = pos + 8;
+      dataBytes = len;
+      haveData = true;
+      break;
+    }
+    pos += 8 + static_cast<size_t>(len) + (len & 1u);
+  }
+  if (!haveData) throw std::runtime_error("WAV: no data chunk");
+  finish(info, dataBytes, size);
+}
+
+inline void parseAiff(const uint8_t* d, size_t size, AudioFileInfo& info, bool aifc) {
+  size_t pos = 12;
+  uint64_t dataBytes = 0;
+  bool haveData = false;
+  uint16_t bits = 16;
+  info.bigEndian = true;
+  while (pos + 8 <= size) {
+    const uint8_t* ck = d + pos;
+    const uint32_t len = be32(ck + 4);
+    if (std::memcmp(ck, "COMM", 4) == 0 && pos + 8 + 18 <= size) {
+      info.channels = be16(ck + 8);
+      bits = be16(ck + 14);
+      info.sampleRate = static_cast<uint32_t>(extended80(ck + 16) + 0.5);
+      info.encoding = (bits <= 8) ? SampleEncoding::S8 : intEncoding(bits); // AIFF 8-bit is signed
+      if (aifc && len >= 22 && pos + 8 + 22 <= size) {
+        const uint8_t* comp = ck + 26;
+        if (std::memcmp(comp, "NONE", 4) == 0 || std::memcmp(comp, "twos", 4) == 0) {}
+        else if (std::memcmp(comp, "sowt", 4) == 0) info.bigEndian = false;
+        else if (std::memcmp(comp, "fl32", 4) == 0 || std::memcmp(comp, "FL32", 4) == 0) info.encoding = SampleEncoding::F32;
+        else if (std::memcmp(comp, "fl64", 4) == 0 || std::memcmp(comp, "FL64", 4) == 0) info.encoding = SampleEncoding::F64;
+        else throw std::runtime_error("AIFF-C: unsupported compression type");
+      }
+    } else if (std::memcmp(ck, "SSND", 4) == 0 && pos + 16 <= size) {
+      const uint32_t offset = be32(ck + 8);
+      info.dataOffset = pos + 16 + offset;
+      dataBytes = (len >= 8 + offset) ? len - 8 - offset : 0;
+      haveData = true;
+    }
+    pos += 8 + static_cast<size_t>(len) + (len & 1u);
+  }
+  if (!haveData) throw std::runtime_error("AIFF: no SSND chunk");
+  finish(info, dataBytes, size);
+}
+} // namespace audio_reader_detail
+
+// Throws std::runtime_error for unknown containers or encodings
+inline AudioFileInfo parseAudioFileHeader(const uint8_t* data, size_t size) {
+  using namespace audio_reader_detail;
+  AudioFileInfo info;
+  if (size < 12) throw std::runtime_error("Audio file: too short");
+  if (std::memcmp(data, "RIFF", 4) == 0 && std::memcmp(data + 8, "WAVE", 4) == 0) parseWav(data, size, info);
+  else if (std::memcmp(data, "FORM", 4) == 0 && std::memcmp(data + 8, "AIFF", 4) == 0) parseAiff(data, size, info, false);
+  else if (std::memcmp(data, "FORM", 4) == 0 && std::memcmp(data + 8, "AIFC", 4) == 0) parseAiff(data, size, info, true);
+  else throw std::runtime_error("Audio file: not WAV or AIFF");
+  return info;
+}
+
+// Decode `frames` frames of one channel starting at startFrame into out (contiguous floats).
+// Frames outside [0, info.frames) decode as silence, so callers can read interpolation margins freely.
+inline void decodeChannel(const AudioFileInfo& info, const uint8_t* data, uint32_t channel, int64_t startFrame, uint32_t frames, float* out) {
+  using namespace audio_reader_detail;
+  const uint32_t bps = bytesFor(info.encoding);
+  for (uint32_t i = 0; i < frames; ++i) {
+    const int64_t f = startFrame + static_cast<int64_t>(i);
+    if (f < 0 || static_cast<uint64_t>(f) >= info.frames) { out[i] = 0.0f; continue; }
+    const uint8_t* p = data + info.dataOffset + static_cast<uint64_t>(f) * info.bytesPerFrame + static_cast<uint64_t>(channel) * bps;
+    switch (info.encoding) {
+      case SampleEncoding::U8: out[i] = (static_cast<float>(p[0]) - 128.0f) * (1.0f / 128.0f); break;
+      case SampleEncoding::S8: out[i] = static_cast<float>(static_cast<int8_t>(p[0])) * (1.0f / 128.0f); break;
+      case SampleEncoding::S16: out[i] = static_cast<float>(static_cast<int16_t>(info.bigEndian ? be16(p) : le16(p))) * (1.0f / 32768.0f); break;
+      case SampleEncoding::S24: {
+        const uint32_t u = info.bigEndian ? (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8)
+                                          : (static_cast<uint32_t>(p[2]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[0]) << 8);
+        out[i] = static_cast<float>(static_cast<int32_t>(u)) * (1.0f / 2147483648.0f);
+        break;
+      }
+      case SampleEncoding::S32: out[i] = static_cast<float>(static_cast<int32_t>(info.bigEndian ? be32(p) : le32(p))) * (1.0f / 2147483648.0f); break;
+      case SampleEncoding::F32: {
+        const uint32_t u = info.bigEndian ? be32(p) : le32(p);
+        float v; std::memcpy(&v, &u, 4); out[i] = v;
+        break;
+      }
+      case SampleEncoding::F64: {
+        uint64_t u = 0;
+        for (int b = 0; b < 8; ++b) u |= static_cast<uint64_t>(p[info.bigEndian ? 7 - b : b]) << (8 * b);
+        double v; std::memcpy(&v, &u, 8); out[i] = static_cast<float>(v);
+        break;
+      }
+    }
+  }
+}
+
+// Whole-file read into planar float channels (portable, no mmap)
+inline std::vector<std::vector<float>> readAudioFilePlanar(const std::string& path, AudioFileInfo& info) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f.good()) throw std::runtime_error("Cannot open audio file: " + path);
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  info = parseAudioFileHeader(bytes.data(), bytes.size());
+  std::vector<std::vector<float>> planar(info.channels, std::vector<float>(static_cast<size_t>(info.frames)));
+  for (uint32_t c = 0; c < info.channels; ++c) decodeChannel(info, bytes.data(), c, 0, static_cast<uint32_t>(info.frames), planar[c].data());
+  return planar;
+}
@@ -8,7 +8,7 @@
 #include <vector>
 #include <stdexcept>
 
-enum class FileFormat { Wav, Aiff, Caf };
+enum class FileFormat { Wav, Aiff, Caf, Flac };
 enum class BitDepth { Pcm16, Pcm24, Float32 };
 
 struct AudioFileSpec {
@@ -23,6 +23,7 @@ inline OSType toFileType(FileFormat f) {
     case FileFormat::Wav: return kAudioFileWAVEType;
     case FileFormat::Aiff: return kAudioFileAIFFType;
     case FileFormat::Caf: return kAudioFileCAFType;
+    case FileFormat::Flac: return kAudioFileFLACType; // written by io/FlacEncoder.hpp, not ExtAudioFile
   }
   return kAudioFileWAVEType;
 }
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+#include "WavStreamWriter.hpp"
+#if defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+// Streams interleaved audio from a render thread to a WAV file. push() copies into a
+// preallocated single-producer/single-consumer sample ring; a background thread drains it
+// every few ms into a WavStreamWriter, so memory stays fixed however long the render runs.
+// When the ring is full, a realtime producer drops the block (counted in droppedFrames) and
+// an offline producer waits for the writer. The file opens with the first block's channel
+// count; stop() drains what is left and finalizes the file.
+class AudioStreamWriter {
+public:
+  ~AudioStreamWriter() { stop(); }
+
+  void start(const std::string& path, const AudioFileSpec& spec, size_t ringSamples) {
+    stop();
+    path_ = path; spec_ = spec;
+    ring_.assign(ringSamples + 1, 0.0f);
+    head_.store(0); tail_.store(0);
+    channels_.store(0); dropped_.store(0); failed_ = false;
+    running_.store(true);
+    thread_ = std::thread([this] { run(); });
+  }
+
+  void stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    drain();
+    try { writer_.close(); } catch (const std::exception& e) { std::fprintf(stderr, "Warning: %s\n", e.what()); }
+  }
+
+  bool running() const noexcept { return running_.load(std::memory_order_relaxed); }
+  void setRealtime(bool on) { realtime_.store(on, std::memory_order_relaxed); }
+
+  // Render thread: never allocates; returns false when the block was dropped or nothing runs
+  bool push(const float* interleaved, uint32_t frames, uint32_t channels) noexcept {
+    if (!running() || frames == 0 || channels == 0) return false;
+    if (channels_.load(std::memory_order_relaxed) == 0) channels_.store(channels, std::memory_order_release);
+    const size_t n = static_cast<size_t>(frames) * channels;
+    const size_t cap = ring_.size();
+    if (n >= cap) { dropped_.fetch_add(frames, std::memory_order_relaxed); return false; }
+    size_t head = head_.load(std::memory_order_relaxed);
+    while (freeSamples(head) < n) {
+      if (realtime_.load(std::memory_order_relaxed)) { dropped_.fetch_add(frames, std::memory_order_relaxed); return false; }
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    const size_t first = std::min(n, cap - head);
+    std::copy(interleaved, interleaved + first, ring_.data() + head);
+    std::copy(interleaved + first, interleaved + n, ring_.data());
+    head_.store((head + n) % cap, std::memory_order_release);
+    return true;
+  }
+
+  uint64_t droppedFrames() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+  uint64_t framesWritten() const { return writer_.framesWritten(); } // after stop()
+  size_t memoryBytes() const { return ring_.capacity() * sizeof(float) + chunk_.capacity() * sizeof(float) + writer_.memoryBytes(); }
+
+private:
+  size_t freeSamples(size_t head) const noexcept {
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    return (tail + ring_.size() - head - 1) % ring_.size();
+  }
+
+  void run() {
+#if defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#endif
+    while (running_.load()) {
+      drain();
+      std::this_thread::sleep_for(std::chrono::milliseconds(realtime_.load(std::memory_order_relaxed) ? 5 : 1));
+    }
+  }
+
+  // Writer thread: hand every whole frame in the ring to the file
+  void drain() {
+    const uint32_t channels = channels_.load(std::memory_order_acquire);
+    if (channels == 0) return;
+    const size_t cap = ring_.size();
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t avail = (head + cap - tail) % cap;
+    if (avail == 0) return;
+    if (!writer_.isOpen() && !failed_) {
+      AudioFileSpec s = spec_; s.channels = channels;
+      try { writer_.open(path_, s); }
+      catch (const std::exception& e) { std::fprintf(stderr, "Warning: %s\n", e.what()); failed_ = true; }
+    }
+    if (!failed_) {
+      const size_t first = std::min(avail, cap - tail);
+      try {
+        // Blocks are pushed whole, so a wrapped span splits only at the ring end
+        if (first % channels == 0) {
+          writer_.write(ring_.data() + tail, first / channels);
+          writer_.write(ring_.data(), (avail - first) / channels);
+        } else {
+          chunk_.assign(ring_.data() + tail, ring_.data() + tail + first);
+          chunk_.insert(chunk_.end(), ring_.data(), ring_.data() + (avail - first));
+          writer_.write(chunk_.data(), avail / channels);
+        }
+      } catch (const std::exception& e) {
+        std::fprintf(stderr, "Warning: %s (%s)\n", e.what(), path_.c_str());
+        writer_.close(); failed_ = true;
+      }
+    }
+    tail_.store((tail + avail) % cap, std::memory_order_release);
+  }
+
+  std::string path_;
+  AudioFileSpec spec_{};
+  std::vector<float> ring_;
+  std::vector<float> chunk_; // writer thread: a frame split across the ring end
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  std::atomic<uint32_t> channels_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<bool> running_{false};
+  std::atomic<bool> realtime_{false};
+  bool failed_ = false; // open or write failed: the rest is discarded
+  WavStreamWriter writer_;
+  std::thread thread_;
+};
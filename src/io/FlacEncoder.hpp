@@ -0,0 +1,512 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AudioFileWriter.hpp"
+#include "AsyncFileWriter.hpp"
+#include "../core/JobPool.hpp"
+#include "../core/Md5.hpp"
+
+// In-tree FLAC encoder for exports: fixed-blocksize frames, constant / verbatim / fixed
+// (orders 0-4) / LPC subframes (Levinson-Durbin on a Welch-windowed autocorrelation,
+// quantized coefficients) with partitioned Rice residuals, and left/side, side/right and
+// mid/side decorrelation for stereo. Frames are independent, so they are encoded in parallel
+// on a JobPool; output streams through an AsyncFileWriter and the STREAMINFO MD5 is computed
+// incrementally in frame order.
+namespace flac_detail {
+
+class BitWriter {
+public:
+  void clear() { out_.clear(); acc_ = 0; n_ = 0; }
+  // Append the low `bits` bits of value (bits <= 32), MSB first
+  void put(uint32_t bits, uint32_t value) {
+    if (bits == 0) return;
+    acc_ = (acc_ << bits) | (bits == 32 ? value : (value & ((1u << bits) - 1u)));
+    n_ += bits;
+    while (n_ >= 8) { n_ -= 8; out_.push_back(static_cast<uint8_t>(acc_ >> n_)); }
+  }
+  void putSigned(uint32_t bits, int32_t v) { put(bits, static_cast<uint32_t>(v)); }
+  void putUnary(uint32_t zeros) {
+    while (zeros >= 32) { put(32, 0); zeros -= 32; }
+    put(zeros + 1, 1);
+  }
+  void putRice(uint32_t k, int32_t v) {
+    const uint32_t u = (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+    putUnary(u >> k);
+    put(k, u);
+  }
+  void alignZero() { if (n_ > 0) put(8 - n_, 0); }
+  std::vector<uint8_t>& bytes() { return out_; }
+
+private:
+  std::vector<uint8_t> out_;
+  uint64_t acc_ = 0;
+  uint32_t n_ = 0;
+};
+
+inline uint8_t crc8(const uint8_t* p, size_t n) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < n; ++i) {
+    crc ^= p[i];
+    for (int b = 0; b < 8; ++b) crc = static_cast<uint8_t>((crc & 0x80) ? ((crc << 1) ^ 0x07) : (crc << 1));
+  }
+  return crc;
+}
+
+inline uint16_t crc16(const uint8_t* p, size_t n) {
+  static const auto table = [] {
+    std::vector<uint16_t> t(256);
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint16_t c = static_cast<uint16_t>(i << 8);
+      for (int b = 0; b < 8; ++b) c = static_cast<uint16_t>((c & 0x8000) ? ((c << 1) ^ 0x8005) : (c << 1));
+      t[i] = c;
+    }
+    return t;
+  }();
+  uint16_t crc = 0;
+  for (size_t i = 0; i < n; ++i) crc = static_cast<uint16_t>((crc << 8) ^ table[((crc >> 8) ^ p[i]) & 0xff]);
+  return crc;
+}
+
+struct Subframe {
+  enum class Type : uint8_t { Constant, Verbatim, Fixed, Lpc };
+  Type type = Type::Verbatim;
+  uint32_t order = 0;
+  uint32_t precision = 0;
+  int32_t shift = 0;
+  int32_t coefs[32] = {};
+  uint32_t partitionOrder = 0;
+  bool rice5 = false;            // 5-bit Rice parameters (some parameter > 14)
+  std::vector<uint32_t> params;  // Rice parameter per partition
+  std::vector<int32_t> residual; // n - order values
+  uint64_t bits = 0;
+};
+
+// Encodes one frame at a time; one instance per worker (holds scratch buffers)
+class FrameEncoder {
+public:
+  FrameEncoder(uint32_t channels, uint32_t bps, uint32_t sampleRate, uint32_t maxLpcOrder)
+    : channels_(channels), bps_(bps), sampleRate_(sampleRate), maxLpcOrder_(std::min(32u, maxLpcOrder)) {}
+
+  // interleaved: n frames of integer samples; returns the encoded frame
+  void encode(const int32_t* interleaved, uint32_t n, uint64_t frameIndex, std::vector<uint8_t>& out) {
+    chan_.resize(channels_ == 2 ? 4 : channels_);
+    for (auto& c : chan_) c.resize(n);
+    for (uint32_t ch = 0; ch < channels_; ++ch) {
+      for (uint32_t i = 0; i < n; ++i) chan_[ch][i] = interleaved[static_cast<size_t>(i) * channels_ + ch];
+    }
+    sub_.resize(chan_.size());
+    uint32_t assignment = channels_ - 1;
+    uint32_t pick[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    if (channels_ == 2) {
+      // chan_[2] = side (bps + 1 bits), chan_[3] = mid
+      for (uint32_t i = 0; i < n; ++i) {
+        const int32_t l = chan_[0][i], r = chan_[1][i];
+        chan_[2][i] = l - r;
+        chan_[3][i] = (l + r) >> 1;
+      }
+      for (uint32_t c = 0; c < 4; ++c) plan(chan_[c].data(), n, c == 2 ? bps_ + 1 : bps_, sub_[c]);
+      const uint64_t indep = sub_[0].bits + sub_[1].bits, ls = sub_[0].bits + sub_[2].bits;
+      const uint64_t sr = sub_[2].bits + sub_[1].bits, ms = sub_[3].bits + sub_[2].bits;
+      const uint64_t best = std::min(std::min(indep, ls), std::min(sr, ms));
+      if (best == indep) { assignment = 1; }
+      else if (best == ls) { assignment = 8; pick[1] = 2; }
+      else if (best == sr) { assignment = 9; pick[0] = 2; }
+      else { assignment = 10; pick[0] = 3; pick[1] = 2; }
+    } else {
+      for (uint32_t c = 0; c < channels_; ++c) plan(chan_[c].data(), n, bps_, sub_[c]);
+    }
+
+    BitWriter& w = bw_;
+    w.clear();
+    writeHeader(w, n, frameIndex, assignment);
+    for (uint32_t c = 0; c < channels_; ++c) {
+      const uint32_t k = pick[c];
+      writeSubframe(w, sub_[k], channels_ == 2 && k == 2 ? bps_ + 1 : bps_, n, chan_[k].data());
+    }
+    w.alignZero();
+    const uint16_t crc = crc16(w.bytes().data(), w.bytes().size());
+    w.put(16, crc);
+    out.swap(w.bytes());
+  }
+
+private:
+  // Choose the smallest subframe for one channel
+  void plan(const int32_t* x, uint32_t n, uint32_t bps, Subframe& best) {
+    bool constant = true;
+    for (uint32_t i = 1; i < n && constant; ++i) constant = x[i] == x[0];
+    if (constant) { best.type = Subframe::Type::Constant; best.bits = 8 + bps; return; }
+    best.type = Subframe::Type::Verbatim; best.bits = 8 + static_cast<uint64_t>(n) * bps;
+
+    // Fixed predictor: the order with the smallest residual magnitude
+    uint32_t fixedOrder = 0; uint64_t fixedSum = UINT64_MAX;
+    for (uint32_t o = 0; o <= 4 && o < n; ++o) {
+      uint64_t s = 0;
+      for (uint32_t i = o; i < n; ++i) s += static_cast<uint64_t>(std::llabs(fixedResidual(x, i, o)));
+      if (s < fixedSum) { fixedSum = s; fixedOrder = o; }
+    }
+    tryFixed(x, n, bps, fixedOrder, best);
+    if (maxLpcOrder_ > 0 && n > maxLpcOrder_ * 2) tryLpc(x, n, bps, best);
+  }
+
+  static int64_t fixedResidual(const int32_t* x, uint32_t i, uint32_t order) {
+    const int64_t a = x[i];
+    switch (order) {
+      case 0: return a;
+      case 1: return a - x[i-1];
+      case 2: return a - 2 * static_cast<int64_t>(x[i-1]) + x[i-2];
+      case 3: return a - 3 * static_cast<int64_t>(x[i-1]) + 3 * static_cast<int64_t>(x[i-2]) - x[i-3];
+      default: return a - 4 * static_cast<int64_t>(x[i-1]) + 6 * static_cast<int64_t>(x[i-2]) - 4 * static_cast<int64_t>(x[i-3]) + x[i-4];
+    }
+  }
+
+  void tryFixed(const int32_t* x, uint32_t n, uint32_t bps, uint32_t order, Subframe& best) {
+    Subframe& c = cand_;
+    c.type = Subframe::Type::Fixed; c.order = order;
+    c.residual.resize(n - order);
+    for (uint32_t i = order; i < n; ++i) {
+      const int64_t r = fixedResidual(x, i, order);
+      if (r > INT32_MAX || r < -INT32_MAX) return;
+      c.residual[i - order] = static_cast<int32_t>(r);
+    }
+    c.bits = 8 + static_cast<uint64_t>(order) * bps + riceBits(c, n);
+    if (c.bits < best.bits) std::swap(best, c);
+  }
+
+  void tryLpc(const int32_t* x, uint32_t n, uint32_t bps, Subframe& best) {
+    const uint32_t maxOrder = maxLpcOrder_;
+    // Welch-windowed autocorrelation
+    win_.resize(n);
+    const double half = 0.5 * static_cast<double>(n - 1);
+    for (uint32_t i = 0; i < n; ++i) {
+      const double t = (static_cast<double>(i) - half) / (half + 1.0);
+      win_[i] = static_cast<double>(x[i]) * (1.0 - t * t);
+    }
+    double autoc[33] = {};
+    for (uint32_t lag = 0; lag <= maxOrder; ++lag) {
+      double s = 0.0;
+      for (uint32_t i = lag; i < n; ++i) s += win_[i] * win_[i - lag];
+      autoc[lag] = s;
+    }
+    if (autoc[0] <= 0.0) return;
+    // Levinson-Durbin: lp[o - 1] holds the order-o predictor
+    double lp[32][32] = {};
+    double a[32] = {};
+    double err = autoc[0];
+    uint32_t orders = 0;
+    for (uint32_t i = 0; i < maxOrder; ++i) {
+      double r = -autoc[i + 1];
+      for (uint32_t j = 0; j < i; ++j) r -= a[j] * autoc[i - j];
+      r /= err;
+      a[i] = r;
+      for (uint32_t j = 0; j < i / 2; ++j) {
+        const double tmp = a[j];
+        a[j] += r * a[i - 1 - j];
+        a[i - 1 - j] += r * tmp;
+      }
+      if (i & 1u) a[i / 2] += a[i / 2] * r;
+      err *= (1.0 - r * r);
+      for (uint32_t j = 0; j <= i; ++j) lp[i][j] = -a[j];
+      orders = i + 1;
+      if (err <= 0.0) break;
+    }
+    // A few orders up to the maximum; full search is rarely worth the time
+    const uint32_t tries[4] = { std::min(orders, 2u), std::min(orders, std::max(2u, maxOrder / 4)), std::min(orders, std::max(2u, maxOrder / 2)), orders };
+    uint32_t last = 0;
+    for (uint32_t o : tries) {
+      if (o == 0 || o == last) continue;
+      last = o;
+      if (!quantize(lp[o - 1], o, bps, cand_)) continue;
+      if (!lpcResidual(x, n, cand_)) continue;
+      cand_.type = Subframe::Type::Lpc;
+      cand_.bits = 8 + static_cast<uint64_t>(o) * bps + 4 + 5 + static_cast<uint64_t>(o) * cand_.precision + riceBits(cand_, n);
+      if (cand_.bits < best.bits) std::swap(best, cand_);
+    }
+  }
+
+  bool quantize(const double* lp, uint32_t order, uint32_t bps, Subframe& c) const {
+    const uint32_t precision = bps <= 16 ? 13u : 15u;
+    double cmax = 0.0;
+    for (uint32_t i = 0; i < order; ++i) cmax = std::max(cmax, std::fabs(lp[i]));
+    if (cmax <= 0.0) return false;
+    int log2cmax = 0;
+    std::frexp(cmax, &log2cmax);
+    int shift = static_cast<int>(precision) - 1 - log2cmax;
+    shift = std::max(0, std::min(15, shift));
+    const int32_t qmax = (1 << (precision - 1)) - 1, qmin = -(1 << (precision - 1));
+    double errAcc = 0.0;
+    for (uint32_t i = 0; i < order; ++i) {
+      errAcc += lp[i] * static_cast<double>(1 << shift);
+      const double q = std::nearbyint(errAcc);
+      const int32_t qi = static_cast<int32_t>(std::max<double>(qmin, std::min<double>(qmax, q)));
+      c.coefs[i] = qi;
+      errAcc -= qi;
+    }
+    c.order = order; c.precision = precision; c.shift = shift;
+    return true;
+  }
+
+  static bool lpcResidual(const int32_t* x, uint32_t n, Subframe& c) {
+    const uint32_t order = c.order;
+    c.residual.resize(n - order);
+    for (uint32_t i = order; i < n; ++i) {
+      int64_t sum = 0;
+      for (uint32_t j = 0; j < order; ++j) sum += static_cast<int64_t>(c.coefs[j]) * x[i - 1 - j];
+      const int64_t r = static_cast<int64_t>(x[i]) - (sum >> c.shift);
+      if (r > INT32_MAX || r < -INT32_MAX) return false;
+      c.residual[i - order] = static_cast<int32_t>(r);
+    }
+    return true;
+  }
+
+  // Pick the partition order and Rice parameters; returns the residual's size in bits
+  uint64_t riceBits(Subframe& c, uint32_t n) {
+    const uint32_t order = c.order;
+    uint32_t maxPorder = 0;
+    while (maxPorder < 8 && (n % (2u << maxPorder)) == 0 && (n >> (maxPorder + 1)) > order) ++maxPorder;
+    // Zig-zag sums of the finest partitions, merged upwards
+    const uint32_t parts = 1u << maxPorder;
+    sums_.assign(parts, 0);
+    for (uint32_t p = 0; p < parts; ++p) {
+      const uint32_t start = p == 0 ? 0 : (p * (n >> maxPorder)) - order;
+      const uint32_t end = (p + 1) * (n >> maxPorder) - order;
+      uint64_t s = 0;
+      for (uint32_t i = start; i < end; ++i) s += (static_cast<uint32_t>(c.residual[i]) << 1) ^ static_cast<uint32_t>(c.residual[i] >> 31);
+      sums_[p] = s;
+    }
+    uint64_t bestBits = UINT64_MAX;
+    for (int po = static_cast<int>(maxPorder); po >= 0; --po) {
+      const uint32_t np = 1u << po;
+      const uint32_t group = 1u << (maxPorder - static_cast<uint32_t>(po));
+      params_.resize(np);
+      uint64_t bits = 0; bool rice5 = false;
+      for (uint32_t p = 0; p < np; ++p) {
+        uint64_t s = 0;
+        for (uint32_t g = 0; g < group; ++g) s += sums_[p * group + g];
+        const uint64_t cnt = (n >> po) - (p == 0 ? order : 0);
+        uint32_t k = 0;
+        while (k < 30 && (cnt << (k + 1)) < s) ++k;
+        // Estimated cost: unary quotients plus k bits and a stop bit per value
+        bits += cnt * (k + 1) + (k > 0 ? (s >> k) : s);
+        if (k > 14) rice5 = true;
+        params_[p] = k;
+      }
+      bits += 2 + 4 + static_cast<uint64_t>(np) * (rice5 ? 5 : 4);
+      if (bits < bestBits) { bestBits = bits; c.partitionOrder = static_cast<uint32_t>(po); c.rice5 = rice5; c.params = params_; }
+    }
+    return bestBits;
+  }
+
+  void writeHeader(BitWriter& w, uint32_t n, uint64_t frameIndex, uint32_t assignment) const {
+    w.put(14, 0x3FFE); w.put(1, 0); w.put(1, 0); // sync, reserved, fixed blocksize
+    uint32_t bsCode = 7;
+    for (uint32_t k = 0; k < 8; ++k) if (n == (256u << k)) bsCode = 8 + k;
+    if (bsCode == 7 && n <= 256) bsCode = 6;
+    uint32_t srCode = 0;
+    switch (sampleRate_) {
+      case 88200: srCode = 1; break; case 176400: srCode = 2; break; case 192000: srCode = 3; break;
+      case 8000: srCode = 4; break; case 16000: srCode = 5; break; case 22050: srCode = 6; break;
+      case 24000: srCode = 7; break; case 32000: srCode = 8; break; case 44100: srCode = 9; break;
+      case 48000: srCode = 10; break; case 96000: srCode = 11; break;
+      default:
+        if (sampleRate_ % 1000 == 0 && sampleRate_ / 1000 <= 255) srCode = 12;
+        else if (sampleRate_ <= 65535) srCode = 13;
+        else if (sampleRate_ % 10 == 0 && sampleRate_ / 10 <= 65535) srCode = 14;
+        break;
+    }
+    uint32_t ssCode = 0;
+    switch (bps_) { case 8: ssCode = 1; break; case 12: ssCode = 2; break; case 16: ssCode = 4; break; case 20: ssCode = 5; break; case 24: ssCode = 6; break; case 32: ssCode = 7; break; default: break; }
+    w.put(4, bsCode); w.put(4, srCode); w.put(4, assignment); w.put(3, ssCode); w.put(1, 0);
+    // Frame number, UTF-8 style
+    if (frameIndex < 0x80) {
+      w.put(8, static_cast<uint32_t>(frameIndex));
+    } else {
+      uint32_t bytes = 2;
+      while (bytes < 7 && frameIndex >= (1ull << (5 * bytes + 1))) ++bytes;
+      const uint32_t lead = bytes == 7 ? 0xFE : ((0xFF00u >> bytes) & 0xFFu);
+      w.put(8, lead | static_cast<uint32_t>(frameIndex >> (6 * (bytes - 1))));
+      for (int b = static_cast<int>(bytes) - 2; b >= 0; --b) w.put(8, 0x80u | static_cast<uint32_t>((frameIndex >> (6 * b)) & 0x3F));
+    }
+    if (bsCode == 6) w.put(8, n - 1);
+    else if (bsCode == 7) w.put(16, n - 1);
+    if (srCode == 12) w.put(8, sampleRate_ / 1000);
+    else if (srCode == 13) w.put(16, sampleRate_);
+    else if (srCode == 14) w.put(16, sampleRate_ / 10);
+    w.put(8, crc8(w.bytes().data(), w.bytes().size()));
+  }
+
+  static void writeSubframe(BitWriter& w, const Subframe& s, uint32_t bps, uint32_t n, const int32_t* x) {
+    w.put(1, 0);
+    switch (s.type) {
+      case Subframe::Type::Constant:
+        w.put(6, 0); w.put(1, 0); w.putSigned(bps, x[0]);
+        return;
+      case Subframe::Type::Verbatim:
+        w.put(6, 1); w.put(1, 0);
+        for (uint32_t i = 0; i < n; ++i) w.putSigned(bps, x[i]);
+        return;
+      case Subframe::Type::Fixed:
+        w.put(6, 8 | s.order); w.put(1, 0);
+        for (uint32_t i = 0; i < s.order; ++i) w.putSigned(bps, x[i]);
+        break;
+      case Subframe::Type::Lpc:
+        w.put(6, 32 | (s.order - 1)); w.put(1, 0);
+        for (uint32_t i = 0; i < s.order; ++i) w.putSigned(bps, x[i]);
+        w.put(4, s.precision - 1);
+        w.putSigned(5, s.shift);
+        for (uint32_t i = 0; i < s.order; ++i) w.putSigned(s.precision, s.coefs[i]);
+        break;
+    }
+    w.put(2, s.rice5 ? 1 : 0);
+    w.put(4, s.partitionOrder);
+    const uint32_t np = 1u << s.partitionOrder;
+    size_t r = 0;
+    for (uint32_t p = 0; p < np; ++p) {
+      const uint32_t k = s.params[p];
+      w.put(s.rice5 ? 5 : 4, k);
+      const uint32_t cnt = (n >> s.partitionOrder) - (p == 0 ? s.order : 0);
+      for (uint32_t i = 0; i < cnt; ++i) w.putRice(k, s.residual[r++]);
+    }
+  }
+
+  uint32_t channels_, bps_, sampleRate_, maxLpcOrder_;
+  std::vector<std::vector<int32_t>> chan_;
+  std::vector<Subframe> sub_;
+  Subframe cand_;
+  std::vector<double> win_;
+  std::vector<uint64_t> sums_;
+  std::vector<uint32_t> params_;
+  BitWriter bw_;
+};
+
+} // namespace flac_detail
+
+struct FlacEncodeOptions {
+  uint32_t blockSize = 4096;
+  uint32_t maxLpcOrder = 8; // 0 = fixed predictors only
+  uint32_t threads = 0;     // own pool size when no pool is given; 0 = hardware concurrency
+  JobPool* pool = nullptr;  // shared pool (batch service); frames then fan out into it
+};
+
+struct FlacEncodeStats {
+  uint64_t bytes = 0;
+  uint64_t frames = 0;
+  double seconds = 0.0; // encode + write, wall time
+  AsyncFileWriter::Stats io{};
+  std::string md5;
+};
+
+// Encode a finished render to FLAC (16- or 24-bit; Float32 specs are encoded as 24-bit).
+// Batches of frames are encoded on the pool while the previous batch is hashed and written.
+inline FlacEncodeStats writeFlacStreamed(const std::string& path, const AudioFileSpec& spec, const std::vector<float>& interleaved,
+                                         const FlacEncodeOptions& opt = FlacEncodeOptions{}) {
+  using namespace flac_detail;
+  if (spec.channels == 0 || spec.channels > 8) throw std::runtime_error("FLAC export supports 1-8 channels");
+  if (spec.sampleRate == 0 || spec.sampleRate > 655350) throw std::runtime_error("FLAC export: unsupported sample rate");
+  const auto t0 = std::chrono::steady_clock::now();
+  const uint32_t ch = spec.channels;
+  const uint32_t bps = spec.bitDepth == BitDepth::Pcm16 ? 16u : 24u;
+  const uint32_t bytesPerSample = bps / 8u;
+  const float scale = bps == 16 ? 32767.0f : 8388607.0f;
+  const uint32_t block = std::max(16u, std::min(65535u, opt.blockSize));
+  const uint64_t totalFrames = interleaved.size() / ch;
+  const uint64_t nFrames = (totalFrames + block - 1) / block;
+  const uint32_t threads = opt.pool ? static_cast<uint32_t>(std::max<size_t>(1, opt.pool->threads()))
+                        : (opt.threads > 0 ? opt.threads : std::max(1u, std::thread::hardware_concurrency()));
+
+  AsyncFileWriter io;
+  io.open(path);
+  // "fLaC" + STREAMINFO (patched at the end with frame sizes and the MD5)
+  uint8_t head[42] = { 'f', 'L', 'a', 'C', 0x80, 0, 0, 34 };
+  io.write(head, sizeof(head));
+
+  struct FrameOut { std::vector<uint8_t> bytes; std::vector<uint8_t> pcm; };
+  const uint32_t batch = threads * 4u;
+  std::vector<FrameOut> outs[2];
+  std::vector<std::unique_ptr<FrameEncoder>> encoders;
+  std::mutex encMutex;
+  std::unique_ptr<JobPool> ownPool;
+  if (!opt.pool && threads > 1) ownPool = std::make_unique<JobPool>(threads);
+
+  auto encodeFrame = [&](uint64_t fi, FrameOut& fo) {
+    std::unique_ptr<FrameEncoder> enc;
+    {
+      std::lock_guard<std::mutex> lk(encMutex);
+      if (!encoders.empty()) { enc = std::move(encoders.back()); encoders.pop_back(); }
+    }
+    if (!enc) enc = std::make_unique<FrameEncoder>(ch, bps, spec.sampleRate, opt.maxLpcOrder);
+    const uint64_t start = fi * block;
+    const uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(block, totalFrames - start));
+    std::vector<int32_t> ints(static_cast<size_t>(n) * ch);
+    fo.pcm.resize(ints.size() * bytesPerSample);
+    const float* src = interleaved.data() + static_cast<size_t>(start * ch);
+    uint8_t* p = fo.pcm.data();
+    for (size_t i = 0; i < ints.size(); ++i) {
+      // Same conversion as WavStreamWriter, so both exports carry identical samples
+      const float s = std::max(-1.0f, std::min(1.0f, src[i]));
+      const int32_t v = static_cast<int32_t>(std::lrint(s * scale));
+      ints[i] = v;
+      for (uint32_t b = 0; b < bytesPerSample; ++b) *p++ = static_cast<uint8_t>((static_cast<uint32_t>(v) >> (8 * b)) & 0xFF);
+    }
+    enc->encode(ints.data(), n, fi, fo.bytes);
+    std::lock_guard<std::mutex> lk(encMutex);
+    encoders.push_back(std::move(enc));
+  };
+
+  // Declared after encodeFrame: on unwind the groups wait for frames still in flight
+  JobGroup even(opt.pool ? opt.pool : ownPool.get()), odd(opt.pool ? opt.pool : ownPool.get());
+  JobGroup* groups[2] = { &even, &odd };
+  // Jobs are submitted last frame first: the pool pops LIFO
+  auto submit = [&](uint64_t firstFrame, int slot) {
+    const uint64_t count = std::min<uint64_t>(batch, nFrames - firstFrame);
+    outs[slot].resize(static_cast<size_t>(count));
+    for (uint64_t k = count; k-- > 0;) {
+      groups[slot]->run([&, firstFrame, slot, k] { encodeFrame(firstFrame + k, outs[slot][static_cast<size_t>(k)]); });
+    }
+  };
+
+  md5_detail::Ctx md5; md5_detail::init(md5);
+  uint32_t minFrameBytes = UINT32_MAX, maxFrameBytes = 0;
+  if (nFrames > 0) submit(0, 0);
+  for (uint64_t first = 0, b = 0; first < nFrames; first += batch, ++b) {
+    const int slot = static_cast<int>(b & 1u);
+    groups[slot]->wait();
+    // Next batch encodes while this one is hashed and written
+    if (first + batch < nFrames) submit(first + batch, slot ^ 1);
+    for (auto& fo : outs[slot]) {
+      md5_detail::update(md5, fo.pcm.data(), fo.pcm.size());
+      io.write(fo.bytes.data(), fo.bytes.size());
+      minFrameBytes = std::min(minFrameBytes, static_cast<uint32_t>(fo.bytes.size()));
+      maxFrameBytes = std::max(maxFrameBytes, static_cast<uint32_t>(fo.bytes.size()));
+    }
+  }
+
+  uint8_t digest[16]; md5_detail::finalize(md5, digest);
+  BitWriter si;
+  const uint32_t bs = static_cast<uint32_t>(std::min<uint64_t>(block, std::max<uint64_t>(totalFrames, 16)));
+  si.put(16, bs); si.put(16, bs);
+  si.put(24, nFrames > 0 ? minFrameBytes : 0); si.put(24, maxFrameBytes);
+  si.put(20, spec.sampleRate); si.put(3, ch - 1); si.put(5, bps - 1);
+  si.put(4, static_cast<uint32_t>(totalFrames >> 32)); si.put(32, static_cast<uint32_t>(totalFrames));
+  for (uint8_t d : digest) si.put(8, d);
+  io.writeAt(8, si.bytes().data(), si.bytes().size());
+  io.close();
+
+  FlacEncodeStats st;
+  st.io = io.stats();
+  st.bytes = st.io.bytes;
+  st.frames = nFrames;
+  st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  static const char* hex = "0123456789abcdef";
+  for (uint8_t d : digest) { st.md5.push_back(hex[d >> 4]); st.md5.push_back(hex[d & 0xF]); }
+  return st;
+}
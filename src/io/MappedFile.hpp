@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole file (POSIX). Pages are faulted in lazily by the OS;
+// touch() pre-faults a range from a non-realtime thread so the audio thread does not stall.
+class MappedFile {
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string& path) { open(path); }
+  ~MappedFile() { close(); }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  void open(const std::string& path) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open file: " + path);
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) { ::close(fd); throw std::runtime_error("Cannot stat file: " + path); }
+    size_ = static_cast<size_t>(st.st_size);
+    void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) { size_ = 0; throw std::runtime_error("mmap failed: " + path); }
+    data_ = static_cast<const uint8_t*>(p);
+  }
+  void close() {
+    if (data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr; size_ = 0;
+  }
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+  static size_t pageSize() { static const size_t ps = static_cast<size_t>(::sysconf(_SC_PAGESIZE)); return ps; }
+
+  // Hint and pre-fault [offset, offset+len); returns the number of bytes covered
+  size_t touch(size_t offset, size_t len) const {
+    if (!data_ || offset >= size_) return 0;
+    len = std::min(len, size_ - offset);
+    const size_t ps = pageSize();
+    const size_t start = offset - offset % ps;
+    ::madvise(const_cast<uint8_t*>(data_) + start, len + (offset - start), MADV_WILLNEED);
+    volatile uint8_t sink = 0;
+    for (size_t p = start; p < offset + len; p += ps) sink = static_cast<uint8_t>(sink ^ data_[p]);
+    (void)sink;
+    return len;
+  }
+
+  // Bytes currently resident in memory (mincore); non-realtime
+  size_t residentBytes() const {
+    if (!data_) return 0;
+    const size_t ps = pageSize();
+    const size_t pages = (size_ + ps - 1) / ps;
+#if defined(__APPLE__)
+    std::vector<char> vec(pages);
+#else
+    std::vector<unsigned char> vec(pages);
+#endif
+    if (::mincore(reinterpret_cast<char*>(const_cast<uint8_t*>(data_)), size_, vec.data()) != 0) return 0;
+    size_t resident = 0;
+    for (size_t i = 0; i < pages; ++i) if (vec[i] & 1) resident += ps;
+    return std::min(resident, size_);
+  }
+
+private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
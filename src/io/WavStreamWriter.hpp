@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "AudioFileWriter.hpp"
+#include "AsyncFileWriter.hpp"
+
+// Incremental WAV writer without CoreAudio: open() writes a header with zero sizes, write()
+// appends interleaved float frames converted to the spec's bit depth, close() patches the
+// RIFF and data sizes. Bytes go through an AsyncFileWriter, so conversion and disk writes
+// overlap. For writers that stream a render instead of holding it.
+class WavStreamWriter {
+public:
+  WavStreamWriter() = default;
+  ~WavStreamWriter() { try { close(); } catch (...) {} }
+  WavStreamWriter(const WavStreamWriter&) = delete;
+  WavStreamWriter& operator=(const WavStreamWriter&) = delete;
+
+  void open(const std::string& path, const AudioFileSpec& spec) {
+    close();
+    if (spec.format != FileFormat::Wav) throw std::runtime_error("WavStreamWriter: only WAV output is supported");
+    if (spec.channels == 0) throw std::runtime_error("WavStreamWriter: channels must be > 0");
+    io_.open(path);
+    spec_ = spec;
+    bytesPerSample_ = spec.bitDepth == BitDepth::Pcm16 ? 2u : (spec.bitDepth == BitDepth::Pcm24 ? 3u : 4u);
+    dataBytes_ = 0;
+    writeHeader();
+  }
+
+  bool isOpen() const { return io_.isOpen(); }
+  uint64_t framesWritten() const { return dataBytes_ / (static_cast<uint64_t>(bytesPerSample_) * spec_.channels); }
+
+  void write(const float* interleaved, uint64_t frames) {
+    if (!io_.isOpen() || frames == 0) return;
+    const size_t samples = static_cast<size_t>(frames) * spec_.channels;
+    size_t bytes = samples * bytesPerSample_;
+    if (spec_.bitDepth == BitDepth::Float32) {
+      io_.write(interleaved, bytes);
+    } else {
+      scratch_.resize(bytes);
+      uint8_t* p = scratch_.data();
+      for (size_t i = 0; i < samples; ++i) {
+        const float s = std::max(-1.0f, std::min(1.0f, interleaved[i]));
+        if (bytesPerSample_ == 2) {
+          const int16_t v = static_cast<int16_t>(std::lrint(s * 32767.0f));
+          *p++ = static_cast<uint8_t>(v & 0xff); *p++ = static_cast<uint8_t>((v >> 8) & 0xff);
+        } else {
+          const int32_t v = static_cast<int32_t>(std::lrint(s * 8388607.0f));
+          *p++ = static_cast<uint8_t>(v & 0xff); *p++ = static_cast<uint8_t>((v >> 8) & 0xff); *p++ = static_cast<uint8_t>((v >> 16) & 0xff);
+        }
+      }
+      io_.write(scratch_.data(), bytes);
+    }
+    dataBytes_ += bytes;
+  }
+
+  // Patch the header sizes and close (sizes saturate at the 4 GiB RIFF limit)
+  void close() {
+    if (!io_.isOpen()) return;
+    const uint32_t data = static_cast<uint32_t>(std::min<uint64_t>(dataBytes_, 0xffffffffull - 36ull));
+    uint8_t b[4];
+    le32(b, 36u + data); io_.writeAt(4, b, 4);
+    le32(b, data); io_.writeAt(40, b, 4);
+    io_.close();
+  }
+
+  // Bytes, wall time and MB/s of the last closed file
+  const AsyncFileWriter::Stats& ioStats() const { return io_.stats(); }
+  size_t memoryBytes() const { return io_.memoryBytes() + scratch_.capacity(); }
+
+private:
+  static void le32(uint8_t* b, uint32_t v) { b[0] = static_cast<uint8_t>(v); b[1] = static_cast<uint8_t>(v >> 8); b[2] = static_cast<uint8_t>(v >> 16); b[3] = static_cast<uint8_t>(v >> 24); }
+  void put16(uint16_t v) { const uint8_t b[2] = { static_cast<uint8_t>(v), static_cast<uint8_t>(v >> 8) }; io_.write(b, 2); }
+  void put32(uint32_t v) { uint8_t b[4]; le32(b, v); io_.write(b, 4); }
+
+  void writeHeader() {
+    const uint16_t formatTag = spec_.bitDepth == BitDepth::Float32 ? 3u : 1u; // IEEE float / PCM
+    const uint16_t blockAlign = static_cast<uint16_t>(bytesPerSample_ * spec_.channels);
+    io_.write("RIFF", 4); put32(36u);
+    io_.write("WAVE", 4);
+    io_.write("fmt ", 4); put32(16u);
+    put16(formatTag); put16(static_cast<uint16_t>(spec_.channels)); put32(spec_.sampleRate);
+    put32(spec_.sampleRate * blockAlign); put16(blockAlign); put16(static_cast<uint16_t>(bytesPerSample_ * 8u));
+    io_.write("data", 4); put32(0u);
+  }
+
+  AsyncFileWriter io_;
+  AudioFileSpec spec_{};
+  uint32_t bytesPerSample_ = 4;
+  uint64_t dataBytes_ = 0;
+  std::vector<uint8_t> scratch_;
+};
+
+// Write a finished render as WAV: samples are converted in chunks while the I/O thread writes
+// the previous ones. Returns the write statistics (bytes, seconds, MB/s).
+inline AsyncFileWriter::Stats writeWavStreamed(const std::string& path, const AudioFileSpec& spec, const std::vector<float>& interleaved) {
+  WavStreamWriter w;
+  w.open(path, spec);
+  const uint64_t frames = interleaved.size() / spec.channels;
+  const uint64_t chunk = 65536;
+  for (uint64_t f = 0; f < frames; f += chunk) {
+    w.write(interleaved.data() + static_cast<size_t>(f * spec.channels), std::min<uint64_t>(chunk, frames - f));
+  }
+  w.close();
+  return w.ioStats();
+}
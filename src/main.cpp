@@ -28,9 +28,15 @@
 #include "offline/OfflineParallelGraphRenderer.hpp"
 #include "session/SessionSpec.hpp"
 #include "session/SessionRuntime.hpp"
+#include "session/RackFreeze.hpp"
 #include "offline/OfflineTimelineRenderer.hpp"
+#include "offline/OfflineLoopRenderer.hpp"
 #include "offline/TransportGenerator.hpp"
+#include "offline/BatchRenderService.hpp"
+#include "offline/GraphExport.hpp"
 #include "io/AudioFileWriter.hpp"
+#include "io/WavStreamWriter.hpp"
+#include "io/FlacEncoder.hpp"
 #include "offline/OfflineProgress.hpp"
 #include "offline/OfflineTopoScheduler.hpp"
 #include "realtime/RealtimeRenderer.hpp"
@@ -40,13 +46,17 @@
 #include "core/Graph.hpp"
 #include "core/GraphConfig.hpp"
 #include "core/NodeFactory.hpp"
+#include "instruments/sampler/SamplerWarmup.hpp"
 #include "core/MixerNode.hpp"
 #include "instruments/kick/KickNode.hpp"
 #include "core/ParamMap.hpp"
 #include "core/Random.hpp"
 #include "core/GraphUtils.hpp"
+#include "core/MemoryAccounting.hpp"
 #include "core/SchemaValidate.hpp"
 #include "core/Sha1.hpp"
+#include "midi/MidiInputBridge.hpp"
+#include "offline/MidiCommandGenerator.hpp"
 
 // Use KickSynth (from dsp/) for both realtime and offline paths
 
@@ -107,6 +117,7 @@ static const char* toStr(FileFormat f) {
     case FileFormat::Wav: return "wav";
     case FileFormat::Aiff: return "aiff";
     case FileFormat::Caf: return "caf";
+    case FileFormat::Flac: return "flac";
   }
   return "wav";
 }
@@ -124,7 +135,7 @@ static void printUsage(const char* exe) {
   std::fprintf(stderr,
                "Usage: %s [--f0 Hz] [--fend Hz] [--pitch-decay ms] [--amp-decay ms]\n"
                "          [--gain 0..1] [--bpm N] [--click 0..1]\n"
-               "          [--wav path] [--sr Hz] [--pcm16] [--format wav|aiff|caf] [--bitdepth 16|24|32f] [--offline-threads N]\n"
+               "          [--wav path] [--sr Hz] [--pcm16] [--format wav|aiff|caf|flac] [--bitdepth 16|24|32f] [--offline-threads N]\n"
                "          [--rack path.json] [--quit-after sec]\\n\n"
                "\nOffline export controls (auto-duration by default):\n"
                "  --duration SEC     Hard duration (overrides auto)\n"
@@ -141,10 +152,35 @@ static void printUsage(const char* exe) {
                "  --meters-per-node  Print per-node peak/RMS after run/export (realtime at loop boundaries; offline after export)\n"
                "                      Realtime also prints per-bus meters when buses are defined in session.\n"
                "  --cpu-stats        Print block CPU avg/max and xrun count at end\n"
-               "  --cpu-stats-per-node  Print per-node avg/max us at end\n"
+               "  --cpu-stats-per-node  Print per-node avg/max us (and %% of blocks skipped as idle) at end\n"
+               "  --perf-counters    Linux: per-node hardware counters (IPC, cycles and cache/branch misses per sample)\n"
+               "                      in the per-node summary and --trace-json; ignored where perf events are unavailable\n"
+               "  --mem-report       Offline: print bytes held per node / rack / bus, buffer pools and the render, with the peak\n"
+               "  --no-idle-skip     Process every node every block (disables idle/silent node skipping)\n"
+               "  --no-loop-copy     Offline: render every transport/session loop instead of copying converged loops\n"
+               "  --simd-lanes       Offline: render same-type generators (kick) together, one node per SIMD lane;\n"
+               "                      a session batches them across its racks (same output)\n"
+               "  --freeze-cache DIR Realtime session: directory for frozen rack renders (default .mam_cache/freeze)\n"
                "  --rt-debug-feed   Debug realtime feeder (queue pushes, offsets)\n"
                "  --rt-debug-session Debug realtime session (initial/feeder enqueues)\n"
                "  --session path.json  Run a multi-rack session (realtime or offline when combined with --wav)\n"
+               "  --rt-workers N     Realtime session: render independent racks on N worker threads (default 0 = serial)\n"
+               "  --rt-spin-us US    Realtime worker spin time before sleeping (default 50)\n"
+               "  --rt-anticipate MS Realtime session: render racks MS ahead of the audio clock on worker threads\n"
+               "  --rt-anticipate-threads N  Threads for --rt-anticipate (default 1)\n"
+               "\nBatch rendering:\n"
+               "  --serve-batch jobs.jsonl  Render one export per JSON line in one process (shared pool and caches);\n"
+               "                      other export flags given here are the per-job defaults\n"
+               "  --batch-results PATH  NDJSON result lines (default stdout)\n"
+               "  --batch-jobs N     Jobs rendered at once (default = --offline-threads, or the core count)\n"
+               "  --batch-cache-mb N Rendered audio kept for repeat jobs (default 1024)\n"
+               "\nMIDI input:\n"
+               "  --midi-in SPEC     smf:<file.mid> | test[:bpm[:bars]] | alsa[:client:port] (Linux builds with MAM_WITH_ALSA)\n"
+               "  --midi-map path.json  Note/CC/pitch-bend to node/param mapping table\n"
+               "  --midi-clock-in    Follow incoming MIDI clock (tempo drives the map's clock.bpmTargets)\n"
+               "  --midi-clock-out   Realtime: send MIDI clock at the transport tempo (with or without --midi-in)\n"
+               "  --midi-latency-ms MS  Scheduling latency applied to live input (default 10)\n"
+               "  --midi-stats       Print MIDI latency/jitter summary at end\n"
                "\nDiagram export (Mermaid):\n"
                "  --export-mermaid-session path.json   Print session (racks/buses/routes) as Mermaid flowchart to stdout\n"
                "  --export-mermaid-graph path.json     Print graph (nodes/connections) as Mermaid flowchart to stdout\n"
@@ -282,6 +318,190 @@ static const char* internNodeId(const std::string& s) {
   return p;
 }
 
+// --perf-counters summary: per-node IPC and cycles / misses per sample frame
+static void printPerNodePerf(const Graph& graph) {
+  const auto per = graph.getPerNodePerf();
+  if (per.empty()) { std::fprintf(stderr, "Perf counters: no samples (unavailable on the render thread)\n"); return; }
+  std::fprintf(stderr, "Perf counters per node:\n");
+  for (const auto& n : per) {
+    std::fprintf(stderr, "  %s: ipc=%.2f cycles/sample=%.1f cache-misses/sample=%.4f branch-misses/sample=%.4f\n",
+                 n.id.c_str(), n.ipc, n.cyclesPerSample, n.cacheMissesPerSample, n.branchMissesPerSample);
+  }
+}
+
+// Export a finished render: WAV through the asynchronous streaming writer (reports MB/s),
+// FLAC through the in-tree encoder on `threads` workers, AIFF/CAF through ExtAudioFile
+static void writeExportFile(const std::string& path, const AudioFileSpec& spec, const std::vector<float>& interleaved, uint32_t threads) {
+  if (spec.format == FileFormat::Flac) {
+    if (spec.bitDepth == BitDepth::Float32) std::fprintf(stderr, "Note: FLAC is integer-only; encoding 24-bit\n");
+    FlacEncodeOptions opt; opt.threads = threads;
+    const FlacEncodeStats st = writeFlacStreamed(path, spec, interleaved, opt);
+    const uint64_t frames = spec.channels > 0 ? interleaved.size() / spec.channels : 0;
+    const uint64_t pcmBytes = frames * spec.channels * (spec.bitDepth == BitDepth::Pcm16 ? 2u : 3u);
+    const double audioSeconds = spec.sampleRate > 0 ? static_cast<double>(frames) / spec.sampleRate : 0.0;
+    std::fprintf(stderr, "Wrote %.1f MB FLAC in %.3fs (%.1f%% of PCM, %.0fx realtime, %llu frames, md5 %s)\n",
+                 static_cast<double>(st.bytes) / (1024.0 * 1024.0), st.seconds,
+                 pcmBytes > 0 ? 100.0 * static_cast<double>(st.bytes) / static_cast<double>(pcmBytes) : 0.0,
+                 st.seconds > 0.0 ? audioSeconds / st.seconds : 0.0, static_cast<unsigned long long>(st.frames), st.md5.c_str());
+    return;
+  }
+  if (spec.format != FileFormat::Wav) { writeWithExtAudioFile(path, spec, interleaved); return; }
+  const AsyncFileWriter::Stats st = writeWavStreamed(path, spec, interleaved);
+  std::fprintf(stderr, "Wrote %.1f MB in %.3fs (%.0f MB/s, I/O thread busy %.0f%%, %llu stalls)\n",
+               static_cast<double>(st.bytes) / (1024.0 * 1024.0), st.seconds, st.mbPerSec(),
+               st.seconds > 0.0 ? 100.0 * st.ioSeconds / st.seconds : 0.0, static_cast<unsigned long long>(st.stalls));
+}
+
+// --mem-report tail shared by graph and session exports: sample data and process RSS
+static void printSampleAndRssMemory() {
+  const auto& sc = sampleCacheStats();
+  if (sc.samples.load() > 0) {
+    std::fprintf(stderr, "  samples: decoded=%s mapped=%s\n", formatBytes(sc.decodedBytes.load()).c_str(), formatBytes(sc.mappedBytes.load()).c_str());
+  }
+  const uint64_t rss = processPeakRssBytes();
+  if (rss > 0) std::fprintf(stderr, "  process peak RSS=%s\n", formatBytes(rss).c_str());
+}
+
+// --mem-report for a graph export: per-node buffers, graph scratch and the render itself
+static void printGraphMemory(const Graph& graph, size_t schedulerBytes, size_t renderBytes) {
+  const Graph::MemoryReport r = graph.memoryReport();
+  std::fprintf(stderr, "Memory per node:\n");
+  for (const auto& n : r.nodes) {
+    std::fprintf(stderr, "  %s: %s (node=%s output=%s)\n", n.id.c_str(), formatBytes(n.nodeBytes + n.bufferBytes).c_str(),
+                 formatBytes(n.nodeBytes).c_str(), formatBytes(n.bufferBytes).c_str());
+  }
+  std::fprintf(stderr, "  graph scratch=%s events=%s trace=%s\n", formatBytes(r.scratchBytes).c_str(), formatBytes(r.eventBytes).c_str(), formatBytes(r.traceBytes).c_str());
+  if (schedulerBytes > 0) std::fprintf(stderr, "  topo scheduler pool=%s\n", formatBytes(schedulerBytes).c_str());
+  std::fprintf(stderr, "  render buffer=%s\n", formatBytes(renderBytes).c_str());
+  std::fprintf(stderr, "Memory total=%s peak=%s\n", formatBytes(r.totalBytes + schedulerBytes + renderBytes).c_str(),
+               formatBytes(r.peakBytes + schedulerBytes + renderBytes).c_str());
+  printSampleAndRssMemory();
+}
+
+// --mem-report for a session export
+static void printSessionMemory(const SessionRuntime::MemoryReport& m) {
+  std::fprintf(stderr, "Memory per rack:\n");
+  for (const auto& r : m.racks) {
+    std::fprintf(stderr, "  %s: graph=%s (peak %s) render=%s\n", r.id.c_str(), formatBytes(r.graphBytes).c_str(),
+                 formatBytes(r.graphPeakBytes).c_str(), formatBytes(r.audioBytes).c_str());
+  }
+  for (const auto& b : m.buses) std::fprintf(stderr, "  bus %s: %s\n", b.first.c_str(), formatBytes(b.second).c_str());
+  std::fprintf(stderr, "  session routing=%s mix=%s\n", formatBytes(m.routingBytes).c_str(), formatBytes(m.mixBytes).c_str());
+  std::fprintf(stderr, "Memory total=%s peak=%s\n", formatBytes(m.totalBytes).c_str(), formatBytes(m.peakBytes).c_str());
+  printSampleAndRssMemory();
+}
+
+struct MidiOptions {
+  std::string inSpec;
+  std::string mapPath;
+  bool clockIn = false;
+  bool clockOut = false;
+  double latencyMs = 10.0;
+  bool stats = false;
+  bool enabled() const { return !inSpec.empty(); }
+  // Realtime: the bridge runs for input and/or clock out
+  bool realtimeEnabled() const { return enabled() || clockOut; }
+};
+
+static MidiMapping loadMidiMappingOrEmpty(const MidiOptions& o, const std::unordered_map<std::string, std::string>& nodeTypes) {
+  if (o.mapPath.empty()) {
+    std::fprintf(stderr, "Warning: --midi-in without --midi-map; MIDI messages will not reach any node\n");
+    return MidiMapping{};
+  }
+  try {
+    return loadMidiMappingFromJsonFile(o.mapPath, nodeTypes);
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "Failed to load MIDI map: %s\n", e.what());
+    return MidiMapping{};
+  }
+}
+
+// Live MIDI path for realtime renderers: source -> bridge thread -> renderer's live queue
+struct MidiRuntime {
+  std::unique_ptr<MidiEventSource> source;
+  std::unique_ptr<MidiEventSink> clockSink;
+  MidiMapping mapping;
+  SpscCommandQueue<4096> queue;
+  std::unique_ptr<MidiInputBridge> bridge;
+};
+
+template <typename Renderer>
+static std::unique_ptr<MidiRuntime> startMidiInput(const MidiOptions& o, const std::unordered_map<std::string, std::string>& nodeTypes,
+                                                   Renderer& renderer, double clockBpm, bool diagnostics) {
+  if (!o.realtimeEnabled()) return nullptr;
+  auto rt = std::make_unique<MidiRuntime>();
+  if (o.enabled()) rt->source = createMidiEventSource(o.inSpec);
+  else rt->source = std::make_unique<IdleMidiSource>();
+  if (!rt->source) return nullptr;
+  if (o.enabled()) rt->mapping = loadMidiMappingOrEmpty(o, nodeTypes);
+  Renderer* r = &renderer;
+  rt->bridge = std::make_unique<MidiInputBridge>(*rt->source, rt->mapping, [r]{ return static_cast<SampleTime>(r->sampleCounter()); }, renderer.sampleRate());
+  rt->bridge->setCommandQueue(&rt->queue);
+  rt->bridge->setLatencyMs(o.latencyMs);
+  rt->bridge->setFollowClock(o.clockIn);
+  rt->bridge->setDiagnostics(diagnostics);
+  if (o.clockOut) {
+    rt->clockSink = createMidiClockSink();
+    rt->bridge->setClockOut(rt->clockSink.get(), clockBpm);
+  }
+  try {
+    rt->bridge->start();
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "MIDI input start failed: %s\n", e.what());
+    return nullptr;
+  }
+  // Registered only once started: the renderer drains this queue until it is stopped
+  renderer.setLiveCommandQueue(&rt->queue);
+  std::fprintf(stderr, "[midi] input=%s rules notes=%zu cc=%zu bend=%zu latency=%.1fms\n", rt->source->name(),
+               rt->mapping.notes.size(), rt->mapping.ccs.size(), rt->mapping.bends.size(), o.latencyMs);
+  return rt;
+}
+
+// Call after the renderer has stopped: its callback drains rt->queue, which this destroys
+template <typename Renderer>
+static void stopMidiInput(std::unique_ptr<MidiRuntime>& rt, const Renderer& renderer, bool printStats) {
+  if (!rt) return;
+  rt->bridge->stop();
+  if (printStats) {
+    rt->bridge->printSummary(stderr);
+    std::fprintf(stderr, "MIDI late events applied at block start: %llu\n", static_cast<unsigned long long>(renderer.liveLateEvents()));
+  }
+  rt.reset();
+}
+
+// Push a session command to its rack's render-ahead queue when the rack is anticipated, else to
+// the session queue; retries while the queue is full. Returns false on shutdown.
+template <typename Renderer, typename Queue>
+static bool pushSessionCommand(Renderer& srt, Queue& cmdQueue, const Command& cmd) {
+  if (auto* aq = srt.anticipatedQueue(cmd.nodeId)) {
+    while (gRunning.load() && !aq->push(cmd)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  } else {
+    while (gRunning.load() && !cmdQueue.push(cmd)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return gRunning.load();
+}
+
+// Render (or reuse) frozen racks and hand them to the realtime session renderer. Racks that
+// can't be frozen (no transport loop, I/O errors) stay live with a warning.
+template <typename Renderer, typename RackRT>
+static std::vector<std::unique_ptr<FrozenRack>> freezeSessionRacks(Renderer& srt, const SessionSpec& sess, const std::vector<std::unique_ptr<Graph>>& graphs,
+                                                                   const std::vector<RackRT>& rackRTs, uint32_t randomSeed, const std::string& cacheDir) {
+  std::vector<std::unique_ptr<FrozenRack>> frozen(rackRTs.size());
+  bool anySolo = false; for (const auto& rr : sess.racks) if (rr.solo) { anySolo = true; break; }
+  const uint32_t sr = static_cast<uint32_t>(srt.sampleRate() + 0.5);
+  for (size_t i = 0; i < rackRTs.size() && i < sess.racks.size() && i < graphs.size(); ++i) {
+    const auto& rr = sess.racks[i];
+    if (!rr.frozen || !(anySolo ? rr.solo : !rr.muted)) continue;
+    try {
+      frozen[i] = freezeRack(*graphs[i], rr.id, rr.path, rackRTs[i].baseCmds, sr, 2, rackRTs[i].loopLen, randomSeed, cacheDir);
+      srt.setFrozenRack(i, frozen[i].get());
+    } catch (const std::exception& e) {
+      std::fprintf(stderr, "Warning: rack '%s' stays live (freeze failed: %s)\n", rr.id.c_str(), e.what());
+    }
+  }
+  return frozen;
+}
+
 static int listNodesGraphJson(const std::string& path) {
   try {
     GraphSpec spec = loadGraphSpecFromJsonFile(path);
@@ -426,6 +646,7 @@ static int validateGraphJson(const std::string& path) {
           if (nodeType == "kick") pid = resolveParamIdByName(kKickParamMap, c.paramName);
           else if (nodeType == "clap") pid = resolveParamIdByName(kClapParamMap, c.paramName);
           else if (nodeType == "tb303_ext") pid = resolveParamIdByName(kTb303ParamMap, c.paramName);
+          else if (nodeType == "sampler") pid = resolveParamIdByName(kSamplerParamMap, c.paramName);
         }
         if (pid == 0) { std::fprintf(stderr, "Command missing/unknown param (node=%s)\n", c.nodeId.c_str()); errors++; }
       }
@@ -436,12 +657,6 @@ static int validateGraphJson(const std::string& path) {
       // Build nodeId->type for param name validation
       std::unordered_map<std::string, std::string> nodeIdToType;
       for (const auto& ns : spec.nodes) nodeIdToType.emplace(ns.id, ns.type);
-      auto mapParam = [](const std::string& type, const std::string& name) -> uint16_t {
-        if (type == std::string("kick")) return resolveParamIdByName(kKickParamMap, name);
-        if (type == std::string("clap")) return resolveParamIdByName(kClapParamMap, name);
-        if (type == std::string("tb303_ext")) return resolveParamIdByName(kTb303ParamMap, name);
-        return 0;
-      };
       for (const auto& p : spec.transport.patterns) {
         if (!hasNode(p.nodeId)) { std::fprintf(stderr, "Pattern references unknown node '%s'\n", p.nodeId.c_str()); errors++; }
         if (p.steps.empty()) { std::fprintf(stderr, "Pattern for node '%s' has empty steps\n", p.nodeId.c_str()); errors++; }
@@ -454,7 +669,7 @@ static int validateGraphJson(const std::string& path) {
           if (L.paramId == 0 && !L.paramName.empty()) {
             uint16_t pid = 0;
             auto it = nodeIdToType.find(p.nodeId);
-            if (it != nodeIdToType.end()) pid = mapParam(it->second, L.paramName);
+            if (it != nodeIdToType.end()) pid = paramIdForNodeType(it->second, L.paramName);
             if (pid == 0) { std::fprintf(stderr, "Lock has unknown param '%s' for node '%s'\n", L.paramName.c_str(), p.nodeId.c_str()); errors++; }
           }
         }
@@ -662,6 +877,10 @@ int main(int argc, char** argv) {
   bool pcm16 = false;
   double quitAfterSec = 0.0;
   uint32_t offlineThreads = 0; // 0=auto (fallback to single-thread renderer if 0)
+  uint32_t rtWorkers = 0;       // realtime session worker threads (0 = serial)
+  double rtSpinUs = 50.0;
+  double rtAnticipateMs = 0.0;  // render-ahead lookahead for session racks (0 = off)
+  uint32_t rtAnticipateThreads = 1;
   bool autoWavName = false;     // if --wav provided without filename, auto-name output
   // Export behavior controls
   double overrideDurationSec = -1.0; // < 0 means auto
@@ -692,12 +911,23 @@ int main(int argc, char** argv) {
   bool printSha1 = false;
   bool cpuStats = false;
   bool cpuStatsPerNode = false;
+  bool perfCounters = false;
+  bool memReport = false;
+  bool noIdleSkip = false;
+  bool noLoopCopy = false;
+  bool simdLanes = false;
+  std::string freezeCacheDir = ".mam_cache/freeze";
   bool rtDebugFeed = false;
   bool rtDebugSession = false;
   bool printTriggers = false;
   bool dumpEvents = false;
   bool schemaStrict = false;         // enforce JSON Schema on load
   bool printLatency = false;         // print preroll/latency info
+  MidiOptions midiOpts;
+  std::string serveBatchPath;        // jobs.jsonl for the batch render service
+  std::string batchResultsPath;      // NDJSON results (empty = stdout)
+  uint32_t batchJobs = 0;            // jobs in flight (0 = pool size)
+  double batchCacheMb = 1024.0;      // render cache budget
   // Startup banner (binary identity)
   {
     static const char* kMamVersion = "0.0.1";
@@ -746,6 +976,7 @@ int main(int argc, char** argv) {
         if (std::strcmp(f, "wav") == 0) outFormat = FileFormat::Wav;
         else if (std::strcmp(f, "aiff") == 0) outFormat = FileFormat::Aiff;
         else if (std::strcmp(f, "caf") == 0) outFormat = FileFormat::Caf;
+        else if (std::strcmp(f, "flac") == 0) outFormat = FileFormat::Flac;
       }
     } else if (std::strcmp(a, "--bitdepth") == 0) {
       need(1); {
@@ -758,6 +989,14 @@ int main(int argc, char** argv) {
       pcm16 = true;
     } else if (std::strcmp(a, "--offline-threads") == 0) {
       need(1); offlineThreads = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+    } else if (std::strcmp(a, "--rt-workers") == 0) {
+      need(1); rtWorkers = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+    } else if (std::strcmp(a, "--rt-spin-us") == 0) {
+      need(1); rtSpinUs = std::max(0.0, std::atof(argv[++i]));
+    } else if (std::strcmp(a, "--rt-anticipate") == 0) {
+      need(1); rtAnticipateMs = std::max(0.0, std::atof(argv[++i]));
+    } else if (std::strcmp(a, "--rt-anticipate-threads") == 0) {
+      need(1); rtAnticipateThreads = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
     } else if (std::strcmp(a, "--quit-after") == 0) {
       need(1); quitAfterSec = std::atof(argv[++i]);
     } else if (std::strcmp(a, "--bars") == 0) {
@@ -822,6 +1061,18 @@ int main(int argc, char** argv) {
       cpuStats = true;
     } else if (std::strcmp(a, "--cpu-stats-per-node") == 0) {
       cpuStatsPerNode = true;
+    } else if (std::strcmp(a, "--perf-counters") == 0) {
+      perfCounters = true;
+    } else if (std::strcmp(a, "--mem-report") == 0) {
+      memReport = true;
+    } else if (std::strcmp(a, "--no-idle-skip") == 0) {
+      noIdleSkip = true;
+    } else if (std::strcmp(a, "--no-loop-copy") == 0) {
+      noLoopCopy = true;
+    } else if (std::strcmp(a, "--simd-lanes") == 0) {
+      simdLanes = true;
+    } else if (std::strcmp(a, "--freeze-cache") == 0) {
+      need(1); freezeCacheDir = argv[++i];
     } else if (std::strcmp(a, "--rt-debug-feed") == 0) {
       rtDebugFeed = true;
     } else if (std::strcmp(a, "--rt-debug-session") == 0) {
@@ -854,6 +1105,26 @@ int main(int argc, char** argv) {
       need(1); listParamsType = argv[++i];
     } else if (std::strcmp(a, "--list-node-types") == 0) {
       listNodeTypes = true;
+    } else if (std::strcmp(a, "--midi-in") == 0) {
+      need(1); midiOpts.inSpec = argv[++i];
+    } else if (std::strcmp(a, "--midi-map") == 0) {
+      need(1); midiOpts.mapPath = argv[++i];
+    } else if (std::strcmp(a, "--midi-clock-in") == 0) {
+      midiOpts.clockIn = true;
+    } else if (std::strcmp(a, "--midi-clock-out") == 0) {
+      midiOpts.clockOut = true;
+    } else if (std::strcmp(a, "--midi-latency-ms") == 0) {
+      need(1); midiOpts.latencyMs = std::max(0.0, std::atof(argv[++i]));
+    } else if (std::strcmp(a, "--midi-stats") == 0) {
+      midiOpts.stats = true;
+    } else if (std::strcmp(a, "--serve-batch") == 0) {
+      need(1); serveBatchPath = argv[++i];
+    } else if (std::strcmp(a, "--batch-results") == 0) {
+      need(1); batchResultsPath = argv[++i];
+    } else if (std::strcmp(a, "--batch-jobs") == 0) {
+      need(1); batchJobs = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+    } else if (std::strcmp(a, "--batch-cache-mb") == 0) {
+      need(1); batchCacheMb = std::max(0.0, std::atof(argv[++i]));
     } else {
       std::fprintf(stderr, "Unknown option: %s\n", a);
       printUsage(argv[0]);
@@ -885,6 +1156,49 @@ int main(int argc, char** argv) {
     }
   }
 
+  // Batch render service: export flags on the command line become per-job defaults
+  if (!serveBatchPath.empty()) {
+    try {
+      BatchJob defaults;
+      defaults.sampleRate = static_cast<uint32_t>(offlineSr + 0.5);
+      defaults.format = outFormat;
+      defaults.bitDepth = pcm16 ? BitDepth::Pcm16 : outDepth;
+      defaults.overrides.durationSec = overrideDurationSec;
+      defaults.overrides.bars = overrideBars;
+      defaults.overrides.loopCount = overrideLoopCount;
+      defaults.overrides.loopMinutes = loopMinutes;
+      defaults.overrides.loopSeconds = loopSeconds;
+      defaults.overrides.startBar = overrideStartBar;
+      defaults.overrides.endBar = overrideEndBar;
+      defaults.overrides.tailMs = tailMs;
+      defaults.overrides.tailOverridden = tailOverridden;
+      defaults.randomSeed = randomSeedOverride;
+      defaults.normalize = doNormalize;
+      defaults.peakTargetDb = peakTargetDb;
+      defaults.topoScheduler = offlineScheduler == std::string("topo");
+      defaults.offlineBlock = offlineBlock;
+      defaults.loopCopy = !noLoopCopy;
+      defaults.laneBatching = simdLanes;
+      const std::vector<BatchJob> jobs = loadBatchJobs(serveBatchPath, defaults);
+      FILE* results = stdout;
+      if (!batchResultsPath.empty()) {
+        results = std::fopen(batchResultsPath.c_str(), "w");
+        if (!results) throw std::runtime_error("Cannot open batch results file: " + batchResultsPath);
+      }
+      BatchRenderService::Options bo;
+      bo.threads = offlineThreads;
+      bo.maxJobs = batchJobs;
+      bo.renderCacheBytes = static_cast<size_t>(batchCacheMb * 1024.0 * 1024.0);
+      BatchRenderService service(bo);
+      const size_t failed = service.run(jobs, results);
+      if (results != stdout) std::fclose(results);
+      return failed == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+      std::fprintf(stderr, "Batch render failed: %s\n", e.what());
+      return 1;
+    }
+  }
+
   params.loop = params.bpm > 0.0f;
   if (params.gain < 0.0f) params.gain = 0.0f;
   if (params.gain > 1.5f) params.gain = 1.5f;
@@ -991,6 +1305,14 @@ int main(int argc, char** argv) {
           auto conns = gs.connections; for (auto& c : conns) { c.from = rr.id + ":" + c.from; c.to = rr.id + ":" + c.to; }
           g->setConnections(conns);
         }
+        {
+          // This path runs every rack from session time 0 (no start offsets)
+          SessionSpec::RackRef at0 = rr; at0.startOffsetFrames = 0;
+          g->setAutomation(rackAutomationLanes(sess, at0, gs, rr.id + ":", 0, sessionSrU32, paramIdForNodeType));
+        }
+        g->setRandomSeed(randomSeedOverride != 0 ? randomSeedOverride : gs.randomSeed);
+        warmSamplerHeads(*g, gs, rr.id + ":");
+        if (noIdleSkip) g->setIdleSkip(false);
         // Synthesize commands
         std::vector<GraphSpec::CommandSpec> cmds = gs.commands;
         uint32_t effectiveBars = 0;
@@ -1009,14 +1331,7 @@ int main(int argc, char** argv) {
         if (!activeRack) cmds.clear();
         // Resolve params and prefix nodeIds
         std::unordered_map<std::string, std::string> nodeIdToType; for (const auto& ns : gs.nodes) nodeIdToType.emplace(ns.id, ns.type);
-        auto mapParam = [](const std::string& type, const std::string& name) -> uint16_t {
-          if (type == std::string("kick")) return resolveParamIdByName(kKickParamMap, name);
-          if (type == std::string("clap")) return resolveParamIdByName(kClapParamMap, name);
-          if (type == std::string("tb303_ext")) return resolveParamIdByName(kTb303ParamMap, name);
-          if (type == std::string("mam_chip")) return resolveParamIdByName(kMamChipParamMap, name);
-          return 0;
-        };
-        for (auto& c : cmds) { c.nodeId = rr.id + ":" + c.nodeId; if (c.paramId == 0 && !c.paramName.empty()) { auto it = nodeIdToType.find(c.nodeId.substr(rr.id.size()+1)); const std::string nodeType = (it != nodeIdToType.end()) ? it->second : std::string(); c.paramId = mapParam(nodeType, c.paramName);} }
+        for (auto& c : cmds) { c.nodeId = rr.id + ":" + c.nodeId; if (c.paramId == 0 && !c.paramName.empty()) { auto it = nodeIdToType.find(c.nodeId.substr(rr.id.size()+1)); const std::string nodeType = (it != nodeIdToType.end()) ? it->second : std::string(); c.paramId = paramIdForNodeType(nodeType, c.paramName);} }
         // Compute loopLen and framesPerBar from effective bars (after overrides)
         uint64_t loopLen = 0;
         uint64_t framesPerBar = 0;
@@ -1042,8 +1357,11 @@ int main(int argc, char** argv) {
       if (rackRTs.empty()) { std::fprintf(stderr, "[rt-session] error: no racks\n"); return 1; }
       size_t totalCmds = 0; for (const auto& r : rackRTs) totalCmds += r.baseCmds.size(); if (totalCmds == 0) std::fprintf(stderr, "[rt-session] error: synthesized zero commands across racks\n");
       // Start realtime renderer
+      std::vector<std::unique_ptr<FrozenRack>> frozenRacks; // outlives srt
       RealtimeSessionRenderer srt; SpscCommandQueue<16384> cmdQueue;
       srt.setCommandQueue(&cmdQueue); srt.setDiagnostics(printTriggers); srt.setDebug(rtDebugSession); srt.setMeters(printMeters || metersPerNode, metersIntervalSec);
+      srt.setWorkerPool(rtWorkers, rtSpinUs);
+      srt.setAnticipation(rtAnticipateMs, rtAnticipateThreads);
       if (!metricsNdjsonPath.empty()) srt.setMetricsNdjson(metricsNdjsonPath.c_str(), metricsScopeRacks, metricsScopeBuses);
       // Configure session xfaders (if any)
       {
@@ -1073,13 +1391,6 @@ int main(int argc, char** argv) {
       std::vector<Command> sessionInitCmds;
       if (!sess.commands.empty()) {
         // Use typeByFullNodeId from specs for param name resolution (prefixed ids)
-        auto mapParamId = [](const std::string& type, const std::string& name) -> uint16_t {
-          if (type == std::string("kick")) return resolveParamIdByName(kKickParamMap, name);
-          if (type == std::string("clap")) return resolveParamIdByName(kClapParamMap, name);
-          if (type == std::string("tb303_ext")) return resolveParamIdByName(kTb303ParamMap, name);
-          if (type == std::string("mam_chip")) return resolveParamIdByName(kMamChipParamMap, name);
-          return 0;
-        };
         for (const auto& sc : sess.commands) {
           double resolvedTimeSec = sc.timeSec;
 
@@ -1131,7 +1442,7 @@ int main(int argc, char** argv) {
           if (!sc.paramName.empty()) {
             auto it = typeByFullNodeId.find(sc.nodeId);
             const std::string nodeType = (it != typeByFullNodeId.end()) ? it->second : std::string();
-            pid = mapParamId(nodeType, sc.paramName);
+            pid = paramIdForNodeType(nodeType, sc.paramName);
           }
           cmd.paramId = pid;
           cmd.value = sc.value;
@@ -1176,6 +1487,8 @@ int main(int argc, char** argv) {
           }
         }
       }
+      // Frozen racks play pre-rendered loops (timing is final only after rescale/alignment)
+      frozenRacks = freezeSessionRacks(srt, sess, graphsOwned, rackRTs, randomSeedOverride, freezeCacheDir);
 
       // Initial enqueue (globally time-sorted merge across racks + session-level cmds)
       {
@@ -1213,11 +1526,14 @@ int main(int argc, char** argv) {
           if (a.paramId != b.paramId) return a.paramId < b.paramId;
           return a.value < b.value;
         });
-        size_t totalPushed = 0; for (const auto& ev : combined) { while (gRunning.load() && !cmdQueue.push(ev)) std::this_thread::sleep_for(std::chrono::milliseconds(1)); if (!gRunning.load()) break; totalPushed++; }
+        size_t totalPushed = 0; for (const auto& ev : combined) { if (!pushSessionCommand(srt, cmdQueue, ev)) break; totalPushed++; }
         std::fprintf(stderr, "[rt-session] init enqueued total cmds=%zu (combined)\n", totalPushed);
       }
       // Start audio after initial enqueue to ensure first triggers are applied in the very first block
       srt.begin();
+      double sessionClockBpm = 120.0;
+      for (const auto& r : rackRTs) if (r.framesPerBar > 0) { sessionClockBpm = 240.0 * srt.sampleRate() / static_cast<double>(r.framesPerBar); break; }
+      auto midiRt = startMidiInput(midiOpts, typeByFullNodeId, srt, sessionClockBpm, printTriggers);
       // Feeder thread
       std::thread feeder([&cmdQueue, &rackRTs, &srt, sess]() mutable {
         const uint64_t desiredAhead = static_cast<uint64_t>(3.0 * srt.sampleRate());
@@ -1240,7 +1556,7 @@ int main(int argc, char** argv) {
             while (!pq.empty() && gRunning.load()) {
               Item it = pq.top(); pq.pop(); const auto& c = rackRTs[it.ri].baseCmds[it.ci];
               Command cmd{}; cmd.sampleTime = c.sampleTime + nextOffset[it.ri]; cmd.nodeId = internNodeId(c.nodeId); cmd.type = (c.type == std::string("Trigger")) ? CommandType::Trigger : (c.type == std::string("SetParam")) ? CommandType::SetParam : CommandType::SetParamRamp; cmd.paramId = c.paramId; cmd.value = c.value; cmd.rampMs = c.rampMs; if (!c.paramName.empty()) cmd.paramNameStr = internNodeId(c.paramName); cmd.source = 0;
-              while (gRunning.load() && !cmdQueue.push(cmd)) std::this_thread::sleep_for(std::chrono::milliseconds(1)); if (!gRunning.load()) break;
+              if (!pushSessionCommand(srt, cmdQueue, cmd)) break;
               const size_t nextCi = it.ci + 1; if (nextCi < rackRTs[it.ri].baseCmds.size()) pq.push(Item{rackRTs[it.ri].baseCmds[nextCi].sampleTime + nextOffset[it.ri], it.ri, nextCi});
             }
             for (size_t idx : elig) nextOffset[idx] += rackRTs[idx].loopLen;
@@ -1255,7 +1571,9 @@ int main(int argc, char** argv) {
         if (isStdinReady()) { char buf[4]; (void)read(STDIN_FILENO, buf, sizeof(buf)); gRunning.store(false); break; }
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
       }
-      if (feeder.joinable()) feeder.join(); srt.stop();
+      if (feeder.joinable()) feeder.join();
+      srt.stop();
+      stopMidiInput(midiRt, srt, midiOpts.stats);
       return 0;
     } catch (const std::exception& e) { std::fprintf(stderr, "Realtime session failed: %s\n", e.what()); return 1; }
   }
@@ -1271,24 +1589,18 @@ int main(int argc, char** argv) {
       try {
         SessionSpec sess = loadSessionSpecFromJsonFile(sessionPath);
         if (offlineSr > 0.0) sess.sampleRate = sr;
-        SessionRuntime runtime; runtime.loadFromSpec(sess);
+        SessionRuntime runtime; runtime.randomSeedOverride = randomSeedOverride; runtime.laneBatching = simdLanes;
+        runtime.loadFromSpec(sess);
 
         // Handle loop-aware duration planning
         uint32_t maxLoops = 1;
-        if (sess.loop && sess.durationSec > 0.0) {
-          // For looping sessions, calculate frames for multiple loops
-          uint64_t singleLoopFrames = runtime.planTotalFrames(tailMs, false, 1);
-          if (singleLoopFrames > 0) {
-            double singleLoopSec = static_cast<double>(singleLoopFrames) / sr;
-            maxLoops = static_cast<uint32_t>(std::ceil(sess.durationSec / singleLoopSec));
-            totalFrames = runtime.planTotalFrames(tailMs, true, maxLoops);
+        totalFrames = runtime.planExportFrames(sess, tailMs, maxLoops);
+        if (sess.loop && sess.durationSec > 0.0 && totalFrames > 0) {
+          const double singleLoopSec = static_cast<double>(runtime.planTotalFrames(tailMs)) / sr;
+          if (singleLoopSec > 0.0) {
             std::fprintf(stderr, "[offline-session] looping session: %u loops (%.3fs each), total duration=%.3f sec\n",
               maxLoops, singleLoopSec, static_cast<double>(totalFrames) / sr);
-          } else {
-            totalFrames = runtime.planTotalFrames(tailMs);
           }
-        } else {
-          totalFrames = runtime.planTotalFrames(tailMs);
         }
 
         if (overrideDurationSec >= 0.0) totalFrames = static_cast<uint64_t>(overrideDurationSec * static_cast<double>(sr) + 0.5);
@@ -1296,18 +1608,19 @@ int main(int argc, char** argv) {
         std::vector<SessionRuntime::RackStats> rstats;
         runtime.setPerRackMeters(printMeters);
         runtime.setPerRackCpu(cpuStats || cpuStatsPerNode);
+        runtime.setMemReport(memReport);
 
         std::vector<float> interleaved;
         if (sess.loop && sess.durationSec > 0.0 && maxLoops > 1) {
           // Use loop-aware rendering for looping sessions
           std::fprintf(stderr, "[offline-session] rendering %u loops for session\n", maxLoops);
-          interleaved = runtime.renderOfflineWithLoop(totalFrames, maxLoops, printMeters ? &rstats : nullptr);
+          interleaved = runtime.renderOfflineWithLoop(totalFrames, maxLoops, printMeters ? &rstats : nullptr, !noLoopCopy);
         } else {
           // Standard rendering for non-looping sessions
           interleaved = runtime.renderOffline(totalFrames, printMeters ? &rstats : nullptr);
         }
         AudioFileSpec spec; spec.format = outFormat; spec.bitDepth = pcm16 ? BitDepth::Pcm16 : outDepth; spec.sampleRate = sr; spec.channels = channels;
-        writeWithExtAudioFile(wavPath, spec, interleaved);
+        writeExportFile(wavPath, spec, interleaved, offlineThreads);
         const double seconds = static_cast<double>(totalFrames) / static_cast<double>(sr);
         std::fprintf(stderr, "Exported session to %s (frames=%llu, %.3fs)\n", wavPath.c_str(), (unsigned long long)interleaved.size()/channels, seconds);
         if (printMeters && !rstats.empty()) {
@@ -1315,6 +1628,7 @@ int main(int argc, char** argv) {
             std::fprintf(stderr, "  Rack %s: peak=%.2f dBFS rms=%.2f dBFS\n", st.id.c_str(), st.peakDb, st.rmsDb);
           }
         }
+        if (memReport) printSessionMemory(runtime.memory);
         return 0;
       } catch (const std::exception& e) {
         std::fprintf(stderr, "Session render failed: %s\n", e.what());
@@ -1334,31 +1648,16 @@ int main(int argc, char** argv) {
         GraphSpec spec = loadGraphSpecFromJsonFile(graphPath);
         warnSidechainConnectivity(spec);
         warnDrySuppression(spec);
-        if (randomSeedOverride != 0) setGlobalSeed(randomSeedOverride);
-        else if (spec.randomSeed != 0) setGlobalSeed(spec.randomSeed);
-        for (const auto& ns : spec.nodes) {
-          auto node = createNodeFromSpec(ns);
-          if (node) graph.addNode(ns.id, std::move(node));
-        }
-        if (spec.hasMixer) {
-          std::vector<MixerChannel> chans;
-          for (const auto& inp : spec.mixer.inputs) {
-            MixerChannel mc; mc.id = inp.id; mc.gain = inp.gainPercent * (1.0f/100.0f);
-            chans.push_back(mc);
-          }
-          const float master = spec.mixer.masterPercent * (1.0f/100.0f);
-          graph.setMixer(std::make_unique<MixerNode>(std::move(chans), master, spec.mixer.softClip));
-        }
-      if (!spec.connections.empty()) {
-          graph.setConnections(spec.connections);
-        }
-      // Provide port descriptors to graph (for channel adapters)
-      graph.setPortDescriptors(spec.nodes);
+        buildGraphFromSpec(graph, spec, randomSeedOverride);
+      if (noIdleSkip) graph.setIdleSkip(false);
+      if (simdLanes) graph.setLaneBatching(true);
       if (printTopo) printTopoOrderFromSpec(spec);
       if (metersPerNode) graph.enableStats(true);
       if (cpuStats || cpuStatsPerNode) graph.enableCpuStats(true);
       if (!traceJsonPath.empty()) graph.enableTrace(traceJsonPath.c_str());
       if (cpuStats || cpuStatsPerNode) graph.enableCpuStats(true);
+      if (perfCounters && !graph.enablePerfCounters(true)) std::fprintf(stderr, "Warning: hardware perf counters unavailable (perf_event_open failed); --perf-counters ignored\n");
+      if (memReport) graph.enableMemoryTracking(true);
       } catch (const std::exception& e) {
         std::fprintf(stderr, "Failed to load graph JSON: %s\n", e.what());
         return 1;
@@ -1369,65 +1668,33 @@ int main(int argc, char** argv) {
       graph.addNode("kick_default", std::make_unique<KickNode>(p));
     }
     std::vector<float> interleaved;
+    size_t schedulerBytes = 0; // --mem-report: topo scheduler pool and scratch
     double prerollMsForSummary = 0.0; // computed when preroll is applied in offline export
     if (!graphPath.empty()) {
       try {
         GraphSpec spec2 = loadGraphSpecFromJsonFile(graphPath);
-        if (randomSeedOverride != 0) setGlobalSeed(randomSeedOverride);
-        else if (spec2.randomSeed != 0) setGlobalSeed(spec2.randomSeed);
+        ExportOverrides ov;
+        ov.durationSec = overrideDurationSec; ov.bars = overrideBars; ov.loopCount = overrideLoopCount;
+        ov.loopMinutes = loopMinutes; ov.loopSeconds = loopSeconds; ov.startBar = overrideStartBar; ov.endBar = overrideEndBar;
+        ov.tailMs = tailMs; ov.tailOverridden = tailOverridden;
         // Synthesize commands from transport, if present
-        std::vector<GraphSpec::CommandSpec> cmds = spec2.commands;
-        if (spec2.hasTransport) {
-          // Generate transport commands covering requested bars/loops
-          GraphSpec::Transport tgen = spec2.transport;
-          const uint32_t baseBars = spec2.transport.lengthBars ? spec2.transport.lengthBars : 1u;
-          uint32_t useBars = overrideBars > 0 ? overrideBars : baseBars;
-          uint32_t loops = overrideLoopCount > 0 ? overrideLoopCount : 1u;
-          if ((loopMinutes > 0.0 || loopSeconds > 0.0) && useBars > 0) {
-            const double targetSec = (loopMinutes > 0.0 ? loopMinutes * 60.0 : loopSeconds);
-            if (targetSec > 0.0) {
-              // compute seconds per bar with ramps by averaging first bar
-              const double bpm = spec2.transport.bpm > 0.0 ? spec2.transport.bpm : 120.0;
-              const double secPerBar = 4.0 * (60.0 / bpm);
-              const uint32_t perLoopBars = useBars;
-              const double perLoopSec = secPerBar * static_cast<double>(perLoopBars);
-              loops = static_cast<uint32_t>(std::ceil(targetSec / std::max(0.001, perLoopSec)));
-              if (loops == 0) loops = 1;
-            }
-          }
-          tgen.lengthBars = useBars * loops;
-          auto gen = generateCommandsFromTransport(tgen, sr);
-          // Optional slicing to a bar range [startBar, endBar)
-          if (overrideStartBar > 0 || overrideEndBar > 0) {
-            const uint32_t startBar = overrideStartBar;
-            const uint32_t endBar = (overrideEndBar > 0) ? overrideEndBar : tgen.lengthBars;
-            const double secPerBar = 4.0 * (60.0 / (tgen.bpm > 0.0 ? tgen.bpm : 120.0));
-            const uint64_t framesPerBar0 = static_cast<uint64_t>(secPerBar * static_cast<double>(sr) + 0.5);
-            const uint64_t startFrames = framesPerBar0 * static_cast<uint64_t>(startBar);
-            const uint64_t endFrames = framesPerBar0 * static_cast<uint64_t>(std::max(endBar, startBar));
-            gen.erase(std::remove_if(gen.begin(), gen.end(), [&](const auto& c){ return c.sampleTime < startFrames || c.sampleTime >= endFrames; }), gen.end());
-            for (auto& c : gen) c.sampleTime -= startFrames;
-          }
-          cmds.insert(cmds.end(), gen.begin(), gen.end());
-        }
-        // Resolve named params to IDs based on node type
-        {
-          std::unordered_map<std::string, std::string> nodeIdToType;
-          for (const auto& ns : spec2.nodes) nodeIdToType.emplace(ns.id, ns.type);
-          auto mapParam = [](const std::string& type, const std::string& name) -> uint16_t {
-            if (type == std::string("kick")) return resolveParamIdByName(kKickParamMap, name);
-            if (type == std::string("clap")) return resolveParamIdByName(kClapParamMap, name);
-            if (type == std::string("tb303_ext")) return resolveParamIdByName(kTb303ParamMap, name);
-            return 0;
-          };
-          for (auto& c : cmds) {
-            if (c.paramId == 0 && !c.paramName.empty()) {
-              auto it = nodeIdToType.find(c.nodeId);
-              const std::string nodeType = (it != nodeIdToType.end()) ? it->second : std::string();
-              c.paramId = mapParam(nodeType, c.paramName);
-            }
+        GraphExportPlan plan;
+        plan.cmds = spec2.commands;
+        appendTransportCommands(spec2, sr, ov, plan);
+        std::vector<GraphSpec::CommandSpec>& cmds = plan.cmds;
+        // Scheduled MIDI input (SMF/test generator) rendered straight into commands
+        if (midiOpts.enabled()) {
+          if (auto src = createMidiEventSource(midiOpts.inSpec)) {
+            std::unordered_map<std::string, std::string> nodeTypes;
+            for (const auto& ns : spec2.nodes) nodeTypes.emplace(ns.id, ns.type);
+            const MidiMapping mapping = loadMidiMappingOrEmpty(midiOpts, nodeTypes);
+            auto midiCmds = generateCommandsFromMidi(*src, mapping, sr, midiOpts.clockIn);
+            if (src->isLive()) std::fprintf(stderr, "Warning: live MIDI source ignored for offline export\n");
+            else std::fprintf(stderr, "[midi] %s: %zu commands over %.3fs\n", src->name(), midiCmds.size(), src->lengthSec());
+            cmds.insert(cmds.end(), midiCmds.begin(), midiCmds.end());
           }
         }
+        resolveCommandParamIds(spec2, cmds);
         // Optional event dump (offline): print synthesized commands with timing
         if (dumpEvents) {
           const double bpm = spec2.hasTransport ? spec2.transport.bpm : 120.0;
@@ -1435,54 +1702,18 @@ int main(int argc, char** argv) {
           dumpCommands(cmds, sr, bpm, res, "CMD");
         }
         // Determine totalFrames (auto unless overridden)
-        if (overrideDurationSec >= 0.0) {
-          totalFrames = static_cast<uint64_t>(overrideDurationSec * static_cast<double>(sr) + 0.5);
-        } else if (spec2.hasTransport) {
-          auto bpmAtBar = [&](uint32_t barIndex) -> double {
-            double bpm = spec2.transport.bpm;
-            for (const auto& p : spec2.transport.tempoRamps) { if (p.bar <= barIndex) bpm = p.bpm; }
-            return bpm;
-          };
-          auto framesPerBarAt = [&](uint32_t barIndex) -> uint64_t {
-            const double secPerBeat = 60.0 / bpmAtBar(barIndex);
-            const double secPerBar = 4.0 * secPerBeat;
-            return static_cast<uint64_t>(secPerBar * static_cast<double>(sr) + 0.5);
-          };
-          const uint32_t baseBars = spec2.transport.lengthBars ? spec2.transport.lengthBars : 1u;
-          const uint32_t useBars = overrideBars > 0 ? overrideBars : baseBars;
-          const uint32_t startBar = overrideStartBar;
-          const uint32_t endBar = (overrideEndBar > 0) ? overrideEndBar : useBars;
-          const uint32_t loops = overrideLoopCount > 0 ? overrideLoopCount : 1u;
-          const uint64_t spanBars = static_cast<uint64_t>((endBar > startBar ? (endBar - startBar) : 0u));
-          const uint64_t totalBars = spanBars * static_cast<uint64_t>(loops);
-          totalFrames = 0;
-          for (uint64_t b = 0; b < totalBars; ++b) totalFrames += framesPerBarAt(static_cast<uint32_t>(startBar + b));
-        } else if (!cmds.empty()) {
-          uint64_t last = 0; for (const auto& c : cmds) if (c.sampleTime > last) last = c.sampleTime;
-          totalFrames = last;
-        } else {
-          totalFrames = static_cast<uint64_t>(2.0 * static_cast<double>(sr) + 0.5);
-        }
-    // Add preroll (graph latency) and tail
-        // Suggest longer tail for long delays/reverb if not overridden
-        double tailMsLocal = tailMs;
-        if (!tailOverridden) {
-          double maxDelayMs = 0.0; bool hasReverb = false;
-          for (const auto& ns : spec2.nodes) {
-            if (ns.type == std::string("delay")) {
-              try { nlohmann::json pj = nlohmann::json::parse(ns.paramsJson); maxDelayMs = std::max(maxDelayMs, pj.value("delayMs", 0.0)); } catch (...) {}
-            } else if (ns.type == std::string("reverb")) {
-              hasReverb = true;
-            }
-          }
-          double suggested = 250.0;
-          if (maxDelayMs > 0.0) suggested = std::max(suggested, std::min(6000.0, maxDelayMs * 2.0));
-          if (hasReverb) suggested = std::max(suggested, 1000.0);
-          tailMsLocal = suggested;
-        }
-        const uint64_t preroll = computeGraphPrerollSamples(spec2, sr);
+        totalFrames = planContentFrames(spec2, sr, ov, cmds);
+        // Keep MIDI-driven exports long enough to cover the last mapped event
+        if (midiOpts.enabled() && overrideDurationSec < 0.0) {
+          for (const auto& c : cmds) totalFrames = std::max<uint64_t>(totalFrames, c.sampleTime);
+        }
+        // Add preroll (graph latency) and tail; longer tails for long delays/reverb unless overridden
+        plan.totalFrames = totalFrames;
+        addPrerollAndTail(spec2, sr, ov, plan);
+        totalFrames = plan.totalFrames;
+        const uint64_t preroll = plan.preroll;
+        const double tailMsLocal = plan.tailMs;
         prerollMsForSummary = 1000.0 * static_cast<double>(preroll) / static_cast<double>(sr);
-        totalFrames += preroll + static_cast<uint64_t>((tailMsLocal / 1000.0) * static_cast<double>(sr) + 0.5);
         // Print planned duration info when looping or bars override is used
         if (overrideBars > 0 || overrideLoopCount > 0 || loopMinutes > 0.0 || loopSeconds > 0.0) {
           const double plannedSec = static_cast<double>(totalFrames) / static_cast<double>(sr);
@@ -1496,6 +1727,9 @@ int main(int argc, char** argv) {
           sched.setBlockSize(offlineBlock);
           std::vector<GraphSpec::Connection> conns = spec2.connections;
           sched.render(graph, conns, cmds, sr, channels, totalFrames, interleaved);
+          schedulerBytes = sched.memoryBytes();
+        } else if (plan.loopFrames > 0 && !noLoopCopy) {
+          interleaved = renderGraphWithCommandsLooped(graph, cmds, sr, channels, totalFrames, plan.loopFrames, plan.loopCount);
         } else {
           interleaved = renderGraphWithCommands(graph, cmds, sr, channels, totalFrames);
         }
@@ -1516,6 +1750,7 @@ int main(int argc, char** argv) {
         std::vector<GraphSpec::Connection> conns;
         std::vector<GraphSpec::CommandSpec> empty;
         sched.render(graph, conns, empty, sr, channels, totalFrames, interleaved);
+        schedulerBytes = sched.memoryBytes();
       } else {
         interleaved = (offlineThreads > 1) ? renderGraphInterleavedParallel(graph, sr, channels, totalFrames, offlineThreads)
                                            : renderGraphInterleaved(graph, sr, channels, totalFrames);
@@ -1534,7 +1769,7 @@ int main(int argc, char** argv) {
         base = (dot == std::string::npos) ? fname : fname.substr(0, dot);
       }
       char buf[256];
-      std::snprintf(buf, sizeof(buf), "%s_%lluf.wav", base.c_str(), (unsigned long long)totalFrames);
+      std::snprintf(buf, sizeof(buf), "%s_%lluf.%s", base.c_str(), (unsigned long long)totalFrames, toStr(outFormat));
       wavPath = std::string(buf);
     }
 
@@ -1554,7 +1789,7 @@ int main(int argc, char** argv) {
         const double g = std::pow(10.0, appliedGainDb / 20.0);
         for (auto& s : interleaved) s = static_cast<float>(static_cast<double>(s) * g);
       }
-      writeWithExtAudioFile(wavPath, spec, interleaved);
+      writeExportFile(wavPath, spec, interleaved, offlineThreads);
       double peakDb = 0.0, rmsDb = 0.0;
       computePeakAndRms(interleaved, channels, peakDb, rmsDb);
       const double seconds = static_cast<double>(totalFrames) / static_cast<double>(sr);
@@ -1586,14 +1821,16 @@ int main(int argc, char** argv) {
       }
       if (cpuStats || cpuStatsPerNode) {
         const auto s = graph.getCpuSummary();
-        std::fprintf(stderr, "CPU block avg=%.3fms max=%.3fms (avg=%.1f%% max=%.1f%%) xruns=%llu blocks=%llu\n",
+        std::fprintf(stderr, "CPU block avg=%.3fms max=%.3fms (avg=%.1f%% max=%.1f%%) xruns=%llu blocks=%llu buffers=%.1fKB/block (%.2fGB/s)\n",
                      s.avgMs, s.maxMs, s.avgPercent, s.maxPercent,
-                     static_cast<unsigned long long>(s.overruns), static_cast<unsigned long long>(s.blocks));
+                     static_cast<unsigned long long>(s.overruns), static_cast<unsigned long long>(s.blocks), s.bufferKB, s.bufferGBps);
         if (cpuStatsPerNode) {
           const auto per = graph.getPerNodeCpu();
-          for (const auto& n : per) std::fprintf(stderr, "  %s: avg=%.1fus max=%.1fus\n", n.id.c_str(), n.avgUs, n.maxUs);
+          for (const auto& n : per) std::fprintf(stderr, "  %s: avg=%.1fus max=%.1fus skipped=%.0f%%\n", n.id.c_str(), n.avgUs, n.maxUs, n.skippedPct);
         }
       }
+      if (perfCounters) printPerNodePerf(graph);
+      if (memReport) printGraphMemory(graph, schedulerBytes, vectorBytes(interleaved));
     } catch (const std::exception& e) {
       std::fprintf(stderr, "Audio file write failed: %s\n", e.what());
       return 1;
@@ -1626,8 +1863,6 @@ int main(int argc, char** argv) {
         std::fprintf(stderr, "Graph preroll: %.3f ms\n", 1000.0 * static_cast<double>(preroll) / rtsr);
       }
       warnDrySuppression(spec);
-      if (randomSeedOverride != 0) setGlobalSeed(randomSeedOverride);
-      else if (spec.randomSeed != 0) setGlobalSeed(spec.randomSeed);
       for (const auto& ns : spec.nodes) {
         auto node = createNodeFromSpec(ns);
         if (node) graph.addNode(ns.id, std::move(node));
@@ -1644,10 +1879,15 @@ int main(int argc, char** argv) {
       if (!spec.connections.empty()) {
         graph.setConnections(spec.connections);
       }
+      graph.setAutomation(spec.automation);
       // Provide port descriptors to graph (for future adapters)
       graph.setPortDescriptors(spec.nodes);
+      graph.setRandomSeed(randomSeedOverride != 0 ? randomSeedOverride : spec.randomSeed);
+      warmSamplerHeads(graph, spec);
+      if (noIdleSkip) graph.setIdleSkip(false);
       if (metersPerNode) graph.enableStats(true);
       if (cpuStats || cpuStatsPerNode) graph.enableCpuStats(true);
+      if (perfCounters) graph.enablePerfCounters(true); // counters open on the audio thread's first block
     } catch (const std::exception& e) {
       std::fprintf(stderr, "Failed to load graph JSON: %s\n", e.what());
       return 1;
@@ -1705,18 +1945,11 @@ int main(int argc, char** argv) {
       {
         std::unordered_map<std::string, std::string> nodeIdToType;
         for (const auto& ns : spec.nodes) nodeIdToType.emplace(ns.id, ns.type);
-        auto mapParam = [](const std::string& type, const std::string& name) -> uint16_t {
-          if (type == std::string("kick")) return resolveParamIdByName(kKickParamMap, name);
-          if (type == std::string("clap")) return resolveParamIdByName(kClapParamMap, name);
-          if (type == std::string("tb303_ext")) return resolveParamIdByName(kTb303ParamMap, name);
-          if (type == std::string("mam_chip")) return resolveParamIdByName(kMamChipParamMap, name);
-          return 0;
-        };
         for (auto& c : baseCmds) {
           if (c.paramId == 0 && !c.paramName.empty()) {
             auto it = nodeIdToType.find(c.nodeId);
             const std::string nodeType = (it != nodeIdToType.end()) ? it->second : std::string();
-            c.paramId = mapParam(nodeType, c.paramName);
+            c.paramId = paramIdForNodeType(nodeType, c.paramName);
           }
         }
       }
@@ -1806,6 +2039,10 @@ int main(int argc, char** argv) {
           for (auto& c : conns) { c.from = rr.id + ":" + c.from; c.to = rr.id + ":" + c.to; }
           g->setConnections(conns);
         }
+        g->setAutomation(rackAutomationLanes(sess, rr, gs, rr.id + ":", rr.startOffsetFrames, sessionSrU32, paramIdForNodeType));
+        g->setRandomSeed(randomSeedOverride != 0 ? randomSeedOverride : gs.randomSeed);
+        warmSamplerHeads(*g, gs, rr.id + ":");
+        if (noIdleSkip) g->setIdleSkip(false);
         graphsPtrs.push_back(g.get());
         graphsOwned.push_back(std::move(g));
 
@@ -1827,19 +2064,12 @@ int main(int argc, char** argv) {
         // Resolve named params and prefix nodeIds
         std::unordered_map<std::string, std::string> nodeIdToType;
         for (const auto& ns : gs.nodes) nodeIdToType.emplace(ns.id, ns.type);
-        auto mapParam = [](const std::string& type, const std::string& name) -> uint16_t {
-          if (type == std::string("kick")) return resolveParamIdByName(kKickParamMap, name);
-          if (type == std::string("clap")) return resolveParamIdByName(kClapParamMap, name);
-          if (type == std::string("tb303_ext")) return resolveParamIdByName(kTb303ParamMap, name);
-          if (type == std::string("mam_chip")) return resolveParamIdByName(kMamChipParamMap, name);
-          return 0;
-        };
         for (auto& c : cmds) {
           c.nodeId = rr.id + ":" + c.nodeId;
           if (c.paramId == 0 && !c.paramName.empty()) {
             auto it = nodeIdToType.find(c.nodeId.substr(rr.id.size()+1));
             const std::string nodeType = (it != nodeIdToType.end()) ? it->second : std::string();
-            c.paramId = mapParam(nodeType, c.paramName);
+            c.paramId = paramIdForNodeType(nodeType, c.paramName);
           }
         }
         // Apply per-rack start offset in frames (positive delays start; negative advances and clips pre-zero events)
@@ -1877,11 +2107,13 @@ int main(int argc, char** argv) {
       if (totalCmds == 0) { std::fprintf(stderr, "[rt-session] error: synthesized zero commands across racks\n"); }
 
       // Start realtime session renderer
+      std::vector<std::unique_ptr<FrozenRack>> frozenRacks; // outlives srt
       RealtimeSessionRenderer srt;
       srt.setCommandQueue(&cmdQueue);
       srt.setDiagnostics(printTriggers);
       // Enable periodic per-rack meters when --meters is provided (or keep per-node flag compatibility)
       srt.setMeters(printMeters || metersPerNode, metersIntervalSec);
+      srt.setAnticipation(rtAnticipateMs, rtAnticipateThreads);
       if (!metricsNdjsonPath.empty()) srt.setMetricsNdjson(metricsNdjsonPath.c_str(), metricsScopeRacks, metricsScopeBuses);
       // Configure session xfaders (if any)
       {
@@ -1896,6 +2128,7 @@ int main(int argc, char** argv) {
         rracks.push_back(RealtimeSessionRenderer::Rack{graphsOwned[i].get(), sess.racks[i].id, 1.0f, sess.racks[i].muted, sess.racks[i].solo});
       }
       srt.start(rracks, sess.buses, sess.routes, offlineSr > 0.0 ? offlineSr : 48000.0, 2);
+      frozenRacks = freezeSessionRacks(srt, sess, graphsOwned, rackRTs, randomSeedOverride, freezeCacheDir);
 
       // Initial horizon: push one loop per rack (prefixed ids)
       {
@@ -1906,7 +2139,8 @@ int main(int argc, char** argv) {
           if (i >= activeFlags.size() || !activeFlags[i]) continue;
           size_t pushed = 0;
           for (const auto& c : rackRTs[i].baseCmds) {
-          Command cmd{}; cmd.sampleTime = c.sampleTime; cmd.nodeId = internNodeId(c.nodeId); if (c.type == std::string("Trigger")) cmd.type = CommandType::Trigger; else if (c.type == std::string("SetParam")) cmd.type = CommandType::SetParam; else if (c.type == std::string("SetParamRamp")) cmd.type = CommandType::SetParamRamp; cmd.paramId = c.paramId; cmd.value = c.value; cmd.rampMs = c.rampMs; if (!c.paramName.empty()) cmd.paramNameStr = internNodeId(c.paramName); (void)cmdQueue.push(cmd);
+          Command cmd{}; cmd.sampleTime = c.sampleTime; cmd.nodeId = internNodeId(c.nodeId); if (c.type == std::string("Trigger")) cmd.type = CommandType::Trigger; else if (c.type == std::string("SetParam")) cmd.type = CommandType::SetParam; else if (c.type == std::string("SetParamRamp")) cmd.type = CommandType::SetParamRamp; cmd.paramId = c.paramId; cmd.value = c.value; cmd.rampMs = c.rampMs; if (!c.paramName.empty()) cmd.paramNameStr = internNodeId(c.paramName);
+            if (auto* aq = srt.anticipatedQueue(cmd.nodeId)) (void)aq->push(cmd); else (void)cmdQueue.push(cmd);
             ++pushed;
           }
           if (rtDebugSession) std::fprintf(stderr, "[rt-session] init enqueued rack=%s cmds=%zu\n", rackRTs[i].rackId.c_str(), pushed);
@@ -1931,7 +2165,7 @@ int main(int argc, char** argv) {
               size_t pushed = 0;
               for (auto c : rackRTs[i].baseCmds) {
                 Command cmd{}; cmd.sampleTime = c.sampleTime + nextOffset[i]; cmd.nodeId = internNodeId(c.nodeId); if (c.type == std::string("Trigger")) cmd.type = CommandType::Trigger; else if (c.type == std::string("SetParam")) cmd.type = CommandType::SetParam; else if (c.type == std::string("SetParamRamp")) cmd.type = CommandType::SetParamRamp; cmd.paramId = c.paramId; cmd.value = c.value; cmd.rampMs = c.rampMs; if (!c.paramName.empty()) cmd.paramNameStr = internNodeId(c.paramName);
-                while (gRunning.load() && !cmdQueue.push(cmd)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                pushSessionCommand(srt, cmdQueue, cmd);
                 ++pushed;
                 if (!gRunning.load()) break;
               }
@@ -2105,6 +2339,19 @@ int main(int argc, char** argv) {
       }
     } catch (...) {}
   }
+  std::unique_ptr<MidiRuntime> midiRt;
+  if (midiOpts.realtimeEnabled()) {
+    std::unordered_map<std::string, std::string> nodeTypes;
+    if (!graphPath.empty()) {
+      try {
+        GraphSpec spec = loadGraphSpecFromJsonFile(graphPath);
+        for (const auto& ns : spec.nodes) nodeTypes.emplace(ns.id, ns.type);
+      } catch (...) {}
+    } else {
+      nodeTypes.emplace("kick_default", "kick");
+    }
+    midiRt = startMidiInput(midiOpts, nodeTypes, rt, diagBpm, printTriggers);
+  }
   double elapsedSec = 0.0;
   uint64_t lastPrintedLoop = 0;
   while (gRunning.load()) {
@@ -2136,14 +2383,15 @@ int main(int argc, char** argv) {
         }
         if (cpuStats || cpuStatsPerNode) {
           const auto s = graph.getCpuSummary();
-          std::fprintf(stderr, "CPU block avg=%.3fms max=%.3fms (avg=%.1f%% max=%.1f%%) xruns=%llu blocks=%llu\n",
+          std::fprintf(stderr, "CPU block avg=%.3fms max=%.3fms (avg=%.1f%% max=%.1f%%) xruns=%llu blocks=%llu buffers=%.1fKB/block (%.2fGB/s)\n",
                        s.avgMs, s.maxMs, s.avgPercent, s.maxPercent,
-                       static_cast<unsigned long long>(s.overruns), static_cast<unsigned long long>(s.blocks));
+                       static_cast<unsigned long long>(s.overruns), static_cast<unsigned long long>(s.blocks), s.bufferKB, s.bufferGBps);
           if (cpuStatsPerNode) {
             const auto per = graph.getPerNodeCpu();
-            for (const auto& n : per) std::fprintf(stderr, "  %s: avg=%.1fus max=%.1fus\n", n.id.c_str(), n.avgUs, n.maxUs);
+            for (const auto& n : per) std::fprintf(stderr, "  %s: avg=%.1fus max=%.1fus skipped=%.0f%%\n", n.id.c_str(), n.avgUs, n.maxUs, n.skippedPct);
           }
         }
+        if (perfCounters) printPerNodePerf(graph);
         if (metersPerNode) {
           const auto meters = graph.getNodeMeters(2);
           for (const auto& m : meters) {
@@ -2168,6 +2416,7 @@ int main(int argc, char** argv) {
   }
 
   rt.stop();
+  stopMidiInput(midiRt, rt, midiOpts.stats);
   if (metersPerNode) {
     const auto meters = graph.getNodeMeters(2);
     for (const auto& m : meters) {
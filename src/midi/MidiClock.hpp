@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "../core/Command.hpp"
+#include "MidiMessage.hpp"
+
+// Follows incoming MIDI clock (24 PPQN) and transport messages.
+// Tick intervals are smoothed with a one-pole filter; gaps longer than half a second
+// restart the estimate (clock paused or source switched).
+class MidiClockFollower {
+public:
+  // Returns true when the smoothed tempo moved by more than the report threshold
+  bool onMessage(const MidiMessage& m) {
+    if (m.status == midi_status::kStart) { running_ = true; ticks_ = 0; havePrev_ = false; ++starts_; return false; }
+    if (m.status == midi_status::kContinue) { running_ = true; havePrev_ = false; return false; }
+    if (m.status == midi_status::kStop) { running_ = false; ++stops_; return false; }
+    if (!m.isClock()) return false;
+    ++ticks_;
+    if (havePrev_) {
+      const double dt = m.timeSec - prevSec_;
+      if (dt > 0.0 && dt < 0.5) {
+        if (intervalSec_ <= 0.0) intervalSec_ = dt;
+        const double dev = dt - intervalSec_;
+        intervalSec_ += kAlpha * dev;
+        jitterSumSq_ += dev * dev; ++jitterCount_;
+        if (std::fabs(dev) > jitterMaxSec_) jitterMaxSec_ = std::fabs(dev);
+      } else {
+        intervalSec_ = 0.0;
+      }
+    }
+    prevSec_ = m.timeSec; havePrev_ = true;
+    const double b = bpm();
+    if (b > 0.0 && std::fabs(b - reportedBpm_) >= kReportThresholdBpm) { reportedBpm_ = b; return true; }
+    return false;
+  }
+  double bpm() const { return (intervalSec_ > 0.0) ? 60.0 / (24.0 * intervalSec_) : 0.0; }
+  bool running() const { return running_; }
+  uint64_t ticks() const { return ticks_; }
+  uint64_t starts() const { return starts_; }
+  uint64_t stops() const { return stops_; }
+  double jitterRmsMs() const { return jitterCount_ ? 1000.0 * std::sqrt(jitterSumSq_ / static_cast<double>(jitterCount_)) : 0.0; }
+  double jitterMaxMs() const { return 1000.0 * jitterMaxSec_; }
+
+private:
+  static constexpr double kAlpha = 0.05;
+  static constexpr double kReportThresholdBpm = 0.25;
+  bool running_ = false;
+  bool havePrev_ = false;
+  double prevSec_ = 0.0;
+  double intervalSec_ = 0.0;
+  double reportedBpm_ = 0.0;
+  uint64_t ticks_ = 0, starts_ = 0, stops_ = 0;
+  double jitterSumSq_ = 0.0; uint64_t jitterCount_ = 0; double jitterMaxSec_ = 0.0;
+};
+
+// Generates MIDI clock tick positions in sample time for a fixed tempo.
+// Tick positions are computed from the tick index (no accumulated rounding drift).
+class MidiClockGenerator {
+public:
+  MidiClockGenerator(double bpm, double sampleRate, SampleTime origin = 0)
+    : bpm_(bpm > 0.0 ? bpm : 120.0), sampleRate_(sampleRate), origin_(origin) {}
+  // Re-anchor at the next pending tick so the grid stays continuous across tempo changes
+  void setBpm(double bpm) {
+    if (!(bpm > 0.0)) return;
+    origin_ = nextTickSample(); tick_ = 0;
+    bpm_ = bpm;
+  }
+  SampleTime nextTickSample() const {
+    const double framesPerTick = sampleRate_ * 60.0 / (bpm_ * 24.0);
+    return origin_ + static_cast<SampleTime>(std::llround(static_cast<double>(tick_) * framesPerTick));
+  }
+  // Invoke fn(tickSample) for every tick strictly before endSample
+  template <typename Fn>
+  void emitUntil(SampleTime endSample, Fn&& fn) {
+    for (SampleTime s = nextTickSample(); s < endSample; s = nextTickSample()) { fn(s); ++tick_; }
+  }
+  double bpm() const { return bpm_; }
+
+private:
+  double bpm_ = 120.0;
+  double sampleRate_ = 48000.0;
+  SampleTime origin_ = 0;
+  uint64_t tick_ = 0;
+};
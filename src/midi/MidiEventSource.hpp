@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "MidiMessage.hpp"
+#include "SmfReader.hpp"
+#if defined(__linux__) && defined(MAM_WITH_ALSA)
+#include <alsa/asoundlib.h>
+#endif
+
+// Pluggable source of timestamped MIDI messages.
+// Scheduled sources (SMF playback, test generator) know their timeline ahead of time and are
+// polled with a look-ahead horizon; live sources return whatever arrived since the last poll.
+class MidiEventSource {
+public:
+  virtual ~MidiEventSource() = default;
+  virtual const char* name() const = 0;
+  // True when timestamps are arrival times on the steady clock (seconds)
+  virtual bool isLive() const = 0;
+  virtual void start() {}
+  virtual void stop() {}
+  // Append messages with timeSec < untilSec (scheduled) or all pending messages (live)
+  virtual void poll(double untilSec, std::vector<MidiMessage>& out) = 0;
+  // Scheduled sources: true once every message has been delivered
+  virtual bool finished() const { return false; }
+  // Scheduled sources: timeline length in seconds (0 = unknown/unbounded)
+  virtual double lengthSec() const { return 0.0; }
+};
+
+// Destination for outgoing MIDI (clock out). Messages are sent immediately.
+class MidiEventSink {
+public:
+  virtual ~MidiEventSink() = default;
+  virtual const char* name() const = 0;
+  virtual void send(const MidiMessage& m) = 0;
+};
+
+inline double midiSteadyNowSec() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Standard MIDI File playback
+class SmfEventSource : public MidiEventSource {
+public:
+  explicit SmfEventSource(const std::string& path) : file_(loadSmfFile(path)) {}
+  explicit SmfEventSource(SmfFile f) : file_(std::move(f)) {}
+  const char* name() const override { return "smf"; }
+  bool isLive() const override { return false; }
+  void start() override { cursor_ = 0; }
+  void poll(double untilSec, std::vector<MidiMessage>& out) override {
+    while (cursor_ < file_.events.size() && file_.events[cursor_].timeSec < untilSec) out.push_back(file_.events[cursor_++]);
+  }
+  bool finished() const override { return cursor_ >= file_.events.size(); }
+  double lengthSec() const override { return file_.events.empty() ? 0.0 : file_.events.back().timeSec; }
+  const SmfFile& file() const { return file_; }
+
+private:
+  SmfFile file_;
+  size_t cursor_ = 0;
+};
+
+// Deterministic in-process generator: four-on-the-floor notes, an off-beat hat note,
+// a CC sweep on every 16th and MIDI clock at 24 PPQN. Useful for exercising the
+// mapping/timing path without hardware or files.
+class TestGeneratorSource : public MidiEventSource {
+public:
+  TestGeneratorSource(double bpm, uint32_t bars) : bpm_(bpm > 0.0 ? bpm : 120.0), bars_(bars) {}
+  const char* name() const override { return "test"; }
+  bool isLive() const override { return false; }
+  void start() override { tick_ = 0; }
+  void poll(double untilSec, std::vector<MidiMessage>& out) override {
+    const double secPerTick = 60.0 / (bpm_ * 24.0);
+    const uint64_t endTick = totalTicks();
+    while ((endTick == 0 || tick_ < endTick) && static_cast<double>(tick_) * secPerTick < untilSec) {
+      const double t = static_cast<double>(tick_) * secPerTick;
+      MidiMessage clk; clk.timeSec = t; clk.status = midi_status::kClock;
+      out.push_back(clk);
+      if (tick_ % 6 == 0) {
+        const uint64_t sixteenth = tick_ / 6;
+        MidiMessage cc; cc.timeSec = t; cc.status = midi_status::kControlChange;
+        cc.data1 = 74; cc.data2 = static_cast<uint8_t>((sixteenth * 8u) % 128u);
+        out.push_back(cc);
+        if (sixteenth % 4 == 0) {
+          MidiMessage on; on.timeSec = t; on.status = midi_status::kNoteOn; on.data1 = 36; on.data2 = 112;
+          out.push_back(on);
+        } else if (sixteenth % 4 == 2) {
+          MidiMessage on; on.timeSec = t; on.status = midi_status::kNoteOn; on.data1 = 42; on.data2 = 80;
+          out.push_back(on);
+        }
+      }
+      ++tick_;
+    }
+  }
+  bool finished() const override { const uint64_t e = totalTicks(); return e != 0 && tick_ >= e; }
+  double lengthSec() const override { return static_cast<double>(totalTicks()) * 60.0 / (bpm_ * 24.0); }
+
+private:
+  uint64_t totalTicks() const { return static_cast<uint64_t>(bars_) * 4u * 24u; }
+  double bpm_ = 120.0;
+  uint32_t bars_ = 4;
+  uint64_t tick_ = 0;
+};
+
+// Live source that never delivers anything: runs the bridge for clock out without --midi-in
+class IdleMidiSource : public MidiEventSource {
+public:
+  const char* name() const override { return "none"; }
+  bool isLive() const override { return true; }
+  void poll(double, std::vector<MidiMessage>&) override {}
+};
+
+#if defined(__linux__) && defined(MAM_WITH_ALSA)
+// Live input from the ALSA sequencer. Optionally connects from "client:port" (e.g. "20:0").
+class AlsaSeqEventSource : public MidiEventSource {
+public:
+  explicit AlsaSeqEventSource(const std::string& connectFrom) : connectFrom_(connectFrom) {}
+  ~AlsaSeqEventSource() override { stop(); }
+  const char* name() const override { return "alsa"; }
+  bool isLive() const override { return true; }
+  void start() override {
+    if (seq_) return;
+    if (snd_seq_open(&seq_, "default", SND_SEQ_OPEN_INPUT, SND_SEQ_NONBLOCK) < 0) { seq_ = nullptr; throw std::runtime_error("snd_seq_open failed"); }
+    snd_seq_set_client_name(seq_, "mam");
+    port_ = snd_seq_create_simple_port(seq_, "mam in", SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE, SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+    if (!connectFrom_.empty()) {
+      snd_seq_addr_t addr{};
+      if (snd_seq_parse_address(seq_, &addr, connectFrom_.c_str()) == 0) snd_seq_connect_from(seq_, port_, addr.client, addr.port);
+      else std::fprintf(stderr, "Warning: cannot parse ALSA address '%s'\n", connectFrom_.c_str());
+    }
+  }
+  void stop() override { if (seq_) { snd_seq_close(seq_); seq_ = nullptr; } }
+  void poll(double, std::vector<MidiMessage>& out) override {
+    if (!seq_) return;
+    snd_seq_event_t* ev = nullptr;
+    while (snd_seq_event_input(seq_, &ev) >= 0 && ev) {
+      MidiMessage m; m.timeSec = midiSteadyNowSec();
+      switch (ev->type) {
+        case SND_SEQ_EVENT_NOTEON: m.status = static_cast<uint8_t>(midi_status::kNoteOn | (ev->data.note.channel & 0x0F)); m.data1 = ev->data.note.note; m.data2 = ev->data.note.velocity; break;
+        case SND_SEQ_EVENT_NOTEOFF: m.status = static_cast<uint8_t>(midi_status::kNoteOff | (ev->data.note.channel & 0x0F)); m.data1 = ev->data.note.note; m.data2 = ev->data.note.velocity; break;
+        case SND_SEQ_EVENT_CONTROLLER: m.status = static_cast<uint8_t>(midi_status::kControlChange | (ev->data.control.channel & 0x0F)); m.data1 = static_cast<uint8_t>(ev->data.control.param & 0x7F); m.data2 = static_cast<uint8_t>(ev->data.control.value & 0x7F); break;
+        case SND_SEQ_EVENT_PITCHBEND: {
+          const int v = ev->data.control.value + 8192;
+          m.status = static_cast<uint8_t>(midi_status::kPitchBend | (ev->data.control.channel & 0x0F)); m.data1 = static_cast<uint8_t>(v & 0x7F); m.data2 = static_cast<uint8_t>((v >> 7) & 0x7F); break;
+        }
+        case SND_SEQ_EVENT_CLOCK: m.status = midi_status::kClock; break;
+        case SND_SEQ_EVENT_START: m.status = midi_status::kStart; break;
+        case SND_SEQ_EVENT_CONTINUE: m.status = midi_status::kContinue; break;
+        case SND_SEQ_EVENT_STOP: m.status = midi_status::kStop; break;
+        default: continue;
+      }
+      out.push_back(m);
+    }
+  }
+
+private:
+  std::string connectFrom_;
+  snd_seq_t* seq_ = nullptr;
+  int port_ = -1;
+};
+
+// Clock/transport output through an ALSA sequencer port (subscribers receive direct events)
+class AlsaSeqEventSink : public MidiEventSink {
+public:
+  AlsaSeqEventSink() {
+    if (snd_seq_open(&seq_, "default", SND_SEQ_OPEN_OUTPUT, 0) < 0) { seq_ = nullptr; throw std::runtime_error("snd_seq_open failed"); }
+    snd_seq_set_client_name(seq_, "mam");
+    port_ = snd_seq_create_simple_port(seq_, "mam clock", SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ, SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+  }
+  ~AlsaSeqEventSink() override { if (seq_) snd_seq_close(seq_); }
+  const char* name() const override { return "alsa"; }
+  void send(const MidiMessage& m) override {
+    if (!seq_) return;
+    snd_seq_event_t ev; snd_seq_ev_clear(&ev);
+    snd_seq_ev_set_source(&ev, port_); snd_seq_ev_set_subs(&ev); snd_seq_ev_set_direct(&ev);
+    switch (m.status) {
+      case midi_status::kClock: ev.type = SND_SEQ_EVENT_CLOCK; break;
+      case midi_status::kStart: ev.type = SND_SEQ_EVENT_START; break;
+      case midi_status::kContinue: ev.type = SND_SEQ_EVENT_CONTINUE; break;
+      case midi_status::kStop: ev.type = SND_SEQ_EVENT_STOP; break;
+      default: return;
+    }
+    snd_seq_event_output_direct(seq_, &ev);
+  }
+
+private:
+  snd_seq_t* seq_ = nullptr;
+  int port_ = -1;
+};
+#endif
+
+// Fallback sink: counts messages so clock-out timing can still be measured without a port
+class CountingMidiSink : public MidiEventSink {
+public:
+  const char* name() const override { return "null"; }
+  void send(const MidiMessage&) override { ++sent_; }
+  uint64_t sent() const { return sent_; }
+
+private:
+  uint64_t sent_ = 0;
+};
+
+// Source factory. Spec forms: "smf:<path>", "test[:bpm[:bars]]", "alsa[:client:port]".
+// Returns nullptr (with a warning) when the source is unknown or unavailable on this platform.
+inline std::unique_ptr<MidiEventSource> createMidiEventSource(const std::string& spec) {
+  const auto colon = spec.find(':');
+  const std::string kind = spec.substr(0, colon);
+  const std::string rest = (colon == std::string::npos) ? std::string() : spec.substr(colon + 1);
+  try {
+    if (kind == "smf") return std::make_unique<SmfEventSource>(rest);
+    if (kind == "test") {
+      double bpm = 120.0; uint32_t bars = 4;
+      if (!rest.empty()) {
+        bpm = std::atof(rest.c_str());
+        const auto c2 = rest.find(':');
+        if (c2 != std::string::npos) bars = static_cast<uint32_t>(std::max(1, std::atoi(rest.c_str() + c2 + 1)));
+      }
+      return std::make_unique<TestGeneratorSource>(bpm, bars);
+    }
+    if (kind == "alsa") {
+#if defined(__linux__) && defined(MAM_WITH_ALSA)
+      return std::make_unique<AlsaSeqEventSource>(rest);
+#else
+      std::fprintf(stderr, "Warning: ALSA MIDI input not available in this build (configure with MAM_WITH_ALSA on Linux)\n");
+      return nullptr;
+#endif
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "Warning: MIDI source '%s' failed: %s\n", spec.c_str(), e.what());
+    return nullptr;
+  }
+  std::fprintf(stderr, "Warning: unknown MIDI source '%s' (expected smf:<path>, test[:bpm[:bars]] or alsa[:client:port])\n", spec.c_str());
+  return nullptr;
+}
+
+inline std::unique_ptr<MidiEventSink> createMidiClockSink() {
+#if defined(__linux__) && defined(MAM_WITH_ALSA)
+  try { return std::make_unique<AlsaSeqEventSink>(); } catch (...) {}
+#endif
+  return std::make_unique<CountingMidiSink>();
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../core/Command.hpp"
+#include "MidiClock.hpp"
+#include "MidiEventSource.hpp"
+#include "MidiMapping.hpp"
+
+// Maps steady-clock seconds to renderer sample time.
+// The renderer's sample counter advances once per audio block, so raw (counter - wall*sr)
+// offsets form a saw-tooth one block deep. We track the upper envelope (the instant a block
+// starts) with a fast attack and a very slow release so block quantization and scheduler
+// wakeup noise do not leak into event timestamps, while clock drift is still followed.
+class MidiTimestampMapper {
+public:
+  void setSampleRate(double sr) { sampleRate_ = sr; }
+  void observe(double wallSec, SampleTime counter) {
+    const double raw = static_cast<double>(counter) - wallSec * sampleRate_;
+    if (!init_) { offset_ = raw; init_ = true; return; }
+    const double dev = raw - offset_;
+    offset_ += (dev > 0.0) ? 0.5 * dev : 1.0e-4 * dev;
+  }
+  bool ready() const { return init_; }
+  double toSampleTimeD(double wallSec) const { return wallSec * sampleRate_ + offset_; }
+  SampleTime toSampleTime(double wallSec) const {
+    const double s = toSampleTimeD(wallSec);
+    return (s > 0.0) ? static_cast<SampleTime>(std::llround(s)) : 0ull;
+  }
+
+private:
+  double sampleRate_ = 48000.0;
+  double offset_ = 0.0;
+  bool init_ = false;
+};
+
+// Latency summary (input arrival → rendered by the renderer); jitter is the standard deviation
+struct MidiLatencyStats {
+  uint64_t count = 0;
+  double sumMs = 0.0, sumSqMs = 0.0, maxMs = 0.0;
+  void add(double ms) { ++count; sumMs += ms; sumSqMs += ms * ms; if (ms > maxMs) maxMs = ms; }
+  double avgMs() const { return count ? sumMs / static_cast<double>(count) : 0.0; }
+  double jitterMs() const {
+    if (count < 2) return 0.0;
+    const double mean = avgMs();
+    const double var = sumSqMs / static_cast<double>(count) - mean * mean;
+    return (var > 0.0) ? std::sqrt(var) : 0.0;
+  }
+};
+
+// Pumps a MidiEventSource into a command queue on its own thread (the queue's single producer).
+// Scheduled sources are anchored at the renderer position when the bridge starts and read
+// ahead by lookaheadMs; live sources are stamped on arrival and delayed by latencyMs so that
+// every event lands sample-accurately in a future block instead of "as soon as possible".
+class MidiInputBridge {
+public:
+  struct Stats {
+    uint64_t messages = 0;
+    uint64_t commands = 0;
+    uint64_t dropped = 0;       // queue full
+    uint64_t clamped = 0;       // would have been scheduled in the past
+    MidiLatencyStats latency{}; // arrival until the renderer's sample counter passed the event
+    double clockInBpm = 0.0;
+    uint64_t clockInTicks = 0;
+    double clockInJitterMs = 0.0;
+    uint64_t clockOutTicks = 0;
+    MidiLatencyStats clockOutLateness{};
+  };
+
+  MidiInputBridge(MidiEventSource& source, const MidiMapping& mapping, std::function<SampleTime()> counter, double sampleRate)
+    : source_(source), mapping_(mapping), counter_(std::move(counter)), sampleRate_(sampleRate) {
+    mapper_.setSampleRate(sampleRate);
+  }
+  ~MidiInputBridge() { stop(); }
+
+  template <size_t N>
+  void setCommandQueue(SpscCommandQueue<N>* q) { queue_ = reinterpret_cast<void*>(q); queuePush_ = [](void* p, const Command& c){ return static_cast<SpscCommandQueue<N>*>(p)->push(c); }; }
+  void setLatencyMs(double ms) { latencyMs_ = (ms >= 0.0) ? ms : 0.0; }
+  void setLookaheadMs(double ms) { lookaheadMs_ = (ms > 1.0) ? ms : 1.0; }
+  void setFollowClock(bool enabled) { followClock_ = enabled; }
+  void setClockOut(MidiEventSink* sink, double bpm) { clockSink_ = sink; clockOutBpm_ = bpm; }
+  void setDiagnostics(bool enabled) { diag_ = enabled; }
+
+  void start() {
+    if (running_.load()) return;
+    source_.start();
+    running_.store(true);
+    thread_ = std::thread([this]{ run(); });
+  }
+  void stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    source_.stop();
+  }
+  // Valid after stop()
+  const Stats& stats() const { return stats_; }
+
+  void printSummary(FILE* out) const {
+    std::fprintf(out, "MIDI %s: messages=%llu commands=%llu dropped=%llu clamped=%llu latency avg=%.3fms max=%.3fms jitter=%.3fms (arrival to rendered, excl. device output latency)\n",
+                 source_.name(), static_cast<unsigned long long>(stats_.messages), static_cast<unsigned long long>(stats_.commands),
+                 static_cast<unsigned long long>(stats_.dropped), static_cast<unsigned long long>(stats_.clamped),
+                 stats_.latency.avgMs(), stats_.latency.maxMs, stats_.latency.jitterMs());
+    if (followClock_) {
+      std::fprintf(out, "MIDI clock in: ticks=%llu bpm=%.2f jitter=%.3fms\n",
+                   static_cast<unsigned long long>(stats_.clockInTicks), stats_.clockInBpm, stats_.clockInJitterMs);
+    }
+    if (clockSink_) {
+      std::fprintf(out, "MIDI clock out (%s): ticks=%llu bpm=%.2f lateness avg=%.3fms max=%.3fms\n",
+                   clockSink_->name(), static_cast<unsigned long long>(stats_.clockOutTicks), clockOutBpm_,
+                   stats_.clockOutLateness.avgMs(), stats_.clockOutLateness.maxMs);
+    }
+  }
+
+private:
+  void run() {
+    const double framesPerMs = sampleRate_ / 1000.0;
+    const SampleTime latencyFrames = static_cast<SampleTime>(std::llround(latencyMs_ * framesPerMs));
+    const SampleTime lookaheadFrames = static_cast<SampleTime>(std::llround(lookaheadMs_ * framesPerMs));
+    const SampleTime anchor = counter_() + latencyFrames;
+    const double anchorSec = midiSteadyNowSec(); // scheduled sources: wall time of timeline 0
+    MidiClockGenerator clockGen(clockOutBpm_, sampleRate_, anchor);
+    std::vector<MidiMessage> msgs; msgs.reserve(256);
+    pending_.clear(); pending_.reserve(kMaxPending);
+    std::vector<Command> cmds; cmds.reserve(256);
+    while (running_.load()) {
+      const double now = midiSteadyNowSec();
+      const SampleTime counter = counter_();
+      mapper_.observe(now, counter);
+      // Delivered: the renderer's counter (advanced after each rendered block) has passed the event
+      size_t keep = 0;
+      for (const Pending& p : pending_) {
+        if (p.st < counter) stats_.latency.add((now - p.arrivalSec) * 1000.0);
+        else pending_[keep++] = p;
+      }
+      pending_.resize(keep);
+      msgs.clear();
+      if (source_.isLive()) {
+        source_.poll(0.0, msgs);
+      } else {
+        const double untilSec = (static_cast<double>(counter + lookaheadFrames) - static_cast<double>(anchor)) / sampleRate_;
+        if (untilSec > 0.0) source_.poll(untilSec, msgs);
+      }
+      for (const auto& m : msgs) {
+        ++stats_.messages;
+        SampleTime st = 0;
+        double arrivalSec = 0.0;
+        if (source_.isLive()) {
+          st = mapper_.toSampleTime(m.timeSec) + latencyFrames;
+          arrivalSec = m.timeSec;
+        } else {
+          st = anchor + static_cast<SampleTime>(std::llround(m.timeSec * sampleRate_));
+          arrivalSec = anchorSec + m.timeSec;
+        }
+        if (st < counter) { st = counter; ++stats_.clamped; }
+        cmds.clear();
+        if (followClock_ && (m.isClock() || m.isTransport())) {
+          if (clockIn_.onMessage(m)) {
+            mapping_.tempoCommands(clockIn_.bpm(), st, cmds);
+            if (diag_) std::fprintf(stderr, "[midi] clock tempo %.2f bpm\n", clockIn_.bpm());
+          }
+          if (diag_ && m.isTransport()) std::fprintf(stderr, "[midi] transport %s\n", m.status == midi_status::kStop ? "stop" : "start");
+        }
+        mapping_.translate(m, st, cmds);
+        bool pushed = false;
+        for (const auto& c : cmds) {
+          if (queuePush_ && queuePush_(queue_, c)) { ++stats_.commands; pushed = true; } else ++stats_.dropped;
+        }
+        if (pushed && pending_.size() < kMaxPending) pending_.push_back(Pending{arrivalSec, st});
+      }
+      if (clockSink_) {
+        const SampleTime nowSample = mapper_.toSampleTime(now);
+        clockGen.emitUntil(nowSample + 1, [&](SampleTime tickAt) {
+          MidiMessage clk; clk.timeSec = now; clk.status = midi_status::kClock;
+          clockSink_->send(clk);
+          ++stats_.clockOutTicks;
+          stats_.clockOutLateness.add(static_cast<double>(nowSample - std::min(nowSample, tickAt)) / framesPerMs);
+        });
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stats_.clockInBpm = clockIn_.bpm();
+    stats_.clockInTicks = clockIn_.ticks();
+    stats_.clockInJitterMs = clockIn_.jitterRmsMs();
+  }
+
+  // A message whose commands are queued, until the renderer has rendered past it
+  struct Pending { double arrivalSec; SampleTime st; };
+  static constexpr size_t kMaxPending = 4096;
+
+  MidiEventSource& source_;
+  const MidiMapping& mapping_;
+  std::function<SampleTime()> counter_;
+  double sampleRate_ = 48000.0;
+  MidiTimestampMapper mapper_{};
+  MidiClockFollower clockIn_{};
+  void* queue_ = nullptr; using PushFn = bool(*)(void*, const Command&); PushFn queuePush_ = nullptr;
+  double latencyMs_ = 10.0;
+  double lookaheadMs_ = 100.0;
+  bool followClock_ = false;
+  MidiEventSink* clockSink_ = nullptr;
+  double clockOutBpm_ = 120.0;
+  bool diag_ = false;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+  Stats stats_{};
+  std::vector<Pending> pending_{};
+};
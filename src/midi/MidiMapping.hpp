@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cmath>
+#include <nlohmann/json.hpp>
+#include "../core/Command.hpp"
+#include "../core/ParamMap.hpp"
+#include "MidiMessage.hpp"
+
+// MIDI → command mapping table loaded from JSON:
+// {
+//   "notes": [ { "note": 36, "channel": -1, "nodeId": "kick1" },
+//              { "note": -1, "nodeId": "bass", "noteParam": "NOTE_SEMITONES", "velocityParam": "VELOCITY" },
+//              { "note": -1, "nodeId": "chip", "noteParam": "NOTE_SEMITONES", "noteOffParam": "NOTE_OFF" } ],
+//   "cc":    [ { "cc": 74, "nodeId": "bass", "param": "CUTOFF_HZ", "min": 200, "max": 4000, "curve": "exp", "rampMs": 5 } ],
+//   "pitchBend": [ { "nodeId": "bass", "param": "PITCH_BEND" } ],
+//   "clock": { "bpmTargets": [ { "nodeId": "kick1", "param": "BPM" } ] }
+// }
+// channel -1 (default) matches any channel; note -1 matches any note. Param names resolve
+// through the node type's ParamMap; numeric "paramId" may be given instead. When min/max
+// are omitted the parameter's declared range is used.
+struct MidiMapping {
+  struct ParamTarget {
+    std::string nodeId;
+    std::string paramName;
+    uint16_t paramId = 0;
+    float minValue = 0.0f;
+    float maxValue = 1.0f;
+    bool expCurve = false;
+    float rampMs = 0.0f;
+  };
+  struct NoteRule {
+    int note = -1;
+    int channel = -1;
+    std::string nodeId;
+    std::string noteParamName; uint16_t noteParamId = 0; int noteOffset = 0;
+    std::string velocityParamName; uint16_t velocityParamId = 0;
+    std::string noteOffParamName; uint16_t noteOffParamId = 0; // note-off → SetParam(note) for polyphonic nodes
+  };
+  struct CcRule { int cc = 0; int channel = -1; ParamTarget target; };
+  struct BendRule { int channel = -1; ParamTarget target; };
+
+  std::vector<NoteRule> notes;
+  std::vector<CcRule> ccs;
+  std::vector<BendRule> bends;
+  std::vector<ParamTarget> bpmTargets;
+
+  bool empty() const { return notes.empty() && ccs.empty() && bends.empty() && bpmTargets.empty(); }
+
+  // Translate one message into commands at sampleTime. Command string pointers reference this
+  // mapping and stay valid for its lifetime. Returns number of commands appended.
+  size_t translate(const MidiMessage& m, SampleTime sampleTime, std::vector<Command>& out) const {
+    const size_t before = out.size();
+    const int ch = m.channel();
+    if (m.isNoteOn()) {
+      const float vel = static_cast<float>(m.data2) / 127.0f;
+      for (const auto& r : notes) {
+        if ((r.note >= 0 && r.note != m.data1) || (r.channel >= 0 && r.channel != ch)) continue;
+        if (r.noteParamId != 0) out.push_back(makeSet(sampleTime, r.nodeId, r.noteParamId, static_cast<float>(static_cast<int>(m.data1) + r.noteOffset), 0.0f, r.noteParamName));
+        if (r.velocityParamId != 0) out.push_back(makeSet(sampleTime, r.nodeId, r.velocityParamId, vel, 0.0f, r.velocityParamName));
+        Command t{}; t.sampleTime = sampleTime; t.nodeId = r.nodeId.c_str(); t.type = CommandType::Trigger; t.value = vel;
+        out.push_back(t);
+      }
+    } else if (m.isNoteOff()) {
+      for (const auto& r : notes) {
+        if (r.noteOffParamId == 0 || (r.note >= 0 && r.note != m.data1) || (r.channel >= 0 && r.channel != ch)) continue;
+        out.push_back(makeSet(sampleTime, r.nodeId, r.noteOffParamId, static_cast<float>(static_cast<int>(m.data1) + r.noteOffset), 0.0f, r.noteOffParamName));
+      }
+    } else if (m.isControlChange()) {
+      const float norm = static_cast<float>(m.data2) / 127.0f;
+      for (const auto& r : ccs) {
+        if (r.cc != m.data1 || (r.channel >= 0 && r.channel != ch)) continue;
+        out.push_back(makeTargetSet(sampleTime, r.target, norm));
+      }
+    } else if (m.isPitchBend()) {
+      const int raw = (static_cast<int>(m.data2) << 7) | static_cast<int>(m.data1);
+      const float norm = static_cast<float>(raw) / 16383.0f;
+      for (const auto& r : bends) {
+        if (r.channel >= 0 && r.channel != ch) continue;
+        out.push_back(makeTargetSet(sampleTime, r.target, norm));
+      }
+    }
+    return out.size() - before;
+  }
+
+  // Tempo commands for clock-following targets
+  void tempoCommands(double bpm, SampleTime sampleTime, std::vector<Command>& out) const {
+    for (const auto& t : bpmTargets) out.push_back(makeSet(sampleTime, t.nodeId, t.paramId, static_cast<float>(bpm), 0.0f, t.paramName));
+  }
+
+private:
+  static Command makeSet(SampleTime st, const std::string& nodeId, uint16_t pid, float v, float rampMs, const std::string& pname) {
+    Command c{};
+    c.sampleTime = st;
+    c.nodeId = nodeId.c_str();
+    c.type = (rampMs > 0.0f) ? CommandType::SetParamRamp : CommandType::SetParam;
+    c.paramId = pid;
+    c.value = v;
+    c.rampMs = rampMs;
+    c.paramNameStr = pname.empty() ? nullptr : pname.c_str();
+    return c;
+  }
+  static Command makeTargetSet(SampleTime st, const ParamTarget& t, float norm) {
+    float v = t.minValue + (t.maxValue - t.minValue) * norm;
+    if (t.expCurve && t.minValue > 0.0f && t.maxValue > 0.0f) v = t.minValue * std::pow(t.maxValue / t.minValue, norm);
+    return makeSet(st, t.nodeId, t.paramId, v, t.rampMs, t.paramName);
+  }
+};
+
+// nodeTypeById maps (possibly rack-prefixed) node ids to node types for param name resolution
+inline MidiMapping loadMidiMappingFromJsonFile(const std::string& path, const std::unordered_map<std::string, std::string>& nodeTypeById) {
+  nlohmann::json j;
+  {
+    std::ifstream f(path);
+    if (!f.good()) throw std::runtime_error("Cannot open MIDI map: " + path);
+    f >> j;
+  }
+  auto resolve = [&](const std::string& nodeId, const std::string& name, uint16_t& pid, float* minV, float* maxV) {
+    auto it = nodeTypeById.find(nodeId);
+    if (it == nodeTypeById.end()) std::fprintf(stderr, "Warning: MIDI map references unknown node '%s'\n", nodeId.c_str());
+    const ParamMap* pm = (it != nodeTypeById.end()) ? paramMapForNodeType(it->second) : nullptr;
+    if (pid == 0 && !name.empty() && pm) pid = resolveParamIdByName(*pm, name);
+    if (pid == 0 && !name.empty()) std::fprintf(stderr, "Warning: MIDI map param '%s' unknown for node '%s'\n", name.c_str(), nodeId.c_str());
+    if (pm && pid != 0 && minV && maxV) {
+      for (size_t i = 0; i < pm->count; ++i) {
+        if (pm->defs[i].id == pid) { *minV = pm->defs[i].minValue; *maxV = pm->defs[i].maxValue; break; }
+      }
+    }
+  };
+  auto parseTarget = [&](const nlohmann::json& e) {
+    MidiMapping::ParamTarget t;
+    t.nodeId = e.value("nodeId", std::string());
+    t.paramName = e.value("param", std::string());
+    t.paramId = static_cast<uint16_t>(e.value("paramId", 0));
+    resolve(t.nodeId, t.paramName, t.paramId, &t.minValue, &t.maxValue);
+    t.minValue = e.value("min", t.minValue);
+    t.maxValue = e.value("max", t.maxValue);
+    t.expCurve = (e.value("curve", std::string("linear")) == "exp");
+    t.rampMs = e.value("rampMs", 0.0f);
+    return t;
+  };
+  MidiMapping m;
+  if (j.contains("notes")) {
+    for (const auto& e : j.at("notes")) {
+      MidiMapping::NoteRule r;
+      r.note = e.value("note", -1);
+      r.channel = e.value("channel", -1);
+      r.nodeId = e.value("nodeId", std::string());
+      r.noteParamName = e.value("noteParam", std::string());
+      r.noteOffset = e.value("noteOffset", 0);
+      r.velocityParamName = e.value("velocityParam", std::string());
+      resolve(r.nodeId, r.noteParamName, r.noteParamId, nullptr, nullptr);
+      resolve(r.nodeId, r.velocityParamName, r.velocityParamId, nullptr, nullptr);
+      r.noteOffParamName = e.value("noteOffParam", std::string());
+      resolve(r.nodeId, r.noteOffParamName, r.noteOffParamId, nullptr, nullptr);
+      if (!r.nodeId.empty()) m.notes.push_back(std::move(r));
+    }
+  }
+  if (j.contains("cc")) {
+    for (const auto& e : j.at("cc")) {
+      MidiMapping::CcRule r;
+      r.cc = e.value("cc", 0);
+      r.channel = e.value("channel", -1);
+      r.target = parseTarget(e);
+      if (r.target.paramId != 0) m.ccs.push_back(std::move(r));
+    }
+  }
+  if (j.contains("pitchBend")) {
+    for (const auto& e : j.at("pitchBend")) {
+      MidiMapping::BendRule r;
+      r.channel = e.value("channel", -1);
+      r.target = parseTarget(e);
+      if (r.target.paramId != 0) m.bends.push_back(std::move(r));
+    }
+  }
+  if (j.contains("clock") && j.at("clock").contains("bpmTargets")) {
+    for (const auto& e : j.at("clock").at("bpmTargets")) {
+      auto t = parseTarget(e);
+      if (t.paramId != 0) m.bpmTargets.push_back(std::move(t));
+    }
+  }
+  return m;
+}
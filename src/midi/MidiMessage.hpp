@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+// A single short MIDI message with a timestamp on its source clock (seconds).
+// For file/generator sources the clock starts at 0 on playback start; live sources
+// stamp messages with the steady clock at arrival.
+struct MidiMessage {
+  double timeSec = 0.0;
+  uint8_t status = 0;
+  uint8_t data1 = 0;
+  uint8_t data2 = 0;
+
+  uint8_t type() const { return (status < 0xF0u) ? static_cast<uint8_t>(status & 0xF0u) : status; }
+  uint8_t channel() const { return static_cast<uint8_t>(status & 0x0Fu); }
+  bool isNoteOn() const { return type() == 0x90u && data2 > 0; }
+  bool isNoteOff() const { return type() == 0x80u || (type() == 0x90u && data2 == 0); }
+  bool isControlChange() const { return type() == 0xB0u; }
+  bool isPitchBend() const { return type() == 0xE0u; }
+  bool isClock() const { return status == 0xF8u; }
+  bool isTransport() const { return status == 0xFAu || status == 0xFBu || status == 0xFCu; }
+};
+
+namespace midi_status {
+constexpr uint8_t kNoteOff = 0x80;
+constexpr uint8_t kNoteOn = 0x90;
+constexpr uint8_t kControlChange = 0xB0;
+constexpr uint8_t kPitchBend = 0xE0;
+constexpr uint8_t kClock = 0xF8;
+constexpr uint8_t kStart = 0xFA;
+constexpr uint8_t kContinue = 0xFB;
+constexpr uint8_t kStop = 0xFC;
+} // namespace midi_status
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "MidiMessage.hpp"
+
+// Minimal Standard MIDI File (SMF) reader: formats 0 and 1, PPQN time division,
+// tempo map applied so every channel/realtime message carries an absolute time in seconds.
+// SysEx and non-tempo meta events are skipped.
+struct SmfFile {
+  uint16_t format = 0;
+  uint16_t tracks = 0;
+  uint16_t ppqn = 480;
+  double initialBpm = 120.0;
+  std::vector<MidiMessage> events; // time-sorted, timeSec from file start
+};
+
+namespace smf_detail {
+
+struct RawEvent { uint64_t tick = 0; uint32_t order = 0; bool tempo = false; uint32_t usPerQuarter = 0; MidiMessage msg{}; };
+
+inline uint32_t readBe(const uint8_t* p, size_t n) {
+  uint32_t v = 0;
+  for (size_t i = 0; i < n; ++i) v = (v << 8) | p[i];
+  return v;
+}
+
+inline bool readVarLen(const std::vector<uint8_t>& d, size_t& pos, size_t end, uint32_t& out) {
+  out = 0;
+  for (int i = 0; i < 4; ++i) {
+    if (pos >= end) return false;
+    const uint8_t b = d[pos++];
+    out = (out << 7) | (b & 0x7Fu);
+    if ((b & 0x80u) == 0) return true;
+  }
+  return false;
+}
+
+inline uint8_t dataBytesForStatus(uint8_t status) {
+  switch (status & 0xF0u) {
+    case 0xC0: case 0xD0: return 1;
+    default: return 2;
+  }
+}
+
+} // namespace smf_detail
+
+inline SmfFile parseSmf(const std::vector<uint8_t>& d) {
+  using namespace smf_detail;
+  if (d.size() < 14 || std::string(d.begin(), d.begin() + 4) != "MThd") throw std::runtime_error("Not a Standard MIDI File (missing MThd)");
+  const uint32_t hdrLen = readBe(&d[4], 4);
+  if (hdrLen < 6 || 8u + hdrLen > d.size()) throw std::runtime_error("SMF header truncated");
+  SmfFile f;
+  f.format = static_cast<uint16_t>(readBe(&d[8], 2));
+  f.tracks = static_cast<uint16_t>(readBe(&d[10], 2));
+  const uint16_t division = static_cast<uint16_t>(readBe(&d[12], 2));
+  if (division & 0x8000u) throw std::runtime_error("SMPTE time division is not supported");
+  f.ppqn = division ? division : 480;
+  if (f.format > 1) std::fprintf(stderr, "Warning: SMF format %u treated as format 1\n", f.format);
+
+  std::vector<RawEvent> raw;
+  uint32_t order = 0;
+  size_t pos = 8u + hdrLen;
+  for (uint16_t t = 0; t < f.tracks && pos + 8 <= d.size(); ++t) {
+    if (std::string(d.begin() + static_cast<long>(pos), d.begin() + static_cast<long>(pos) + 4) != "MTrk") {
+      throw std::runtime_error("SMF track chunk missing MTrk");
+    }
+    const uint32_t len = readBe(&d[pos + 4], 4);
+    pos += 8;
+    const size_t end = std::min(d.size(), pos + len);
+    uint64_t tick = 0;
+    uint8_t running = 0;
+    while (pos < end) {
+      uint32_t delta = 0;
+      if (!readVarLen(d, pos, end, delta) || pos >= end) break;
+      tick += delta;
+      uint8_t status = d[pos];
+      if (status & 0x80u) { ++pos; } else if (running) { status = running; } else { break; }
+      if (status == 0xFF) {
+        if (pos >= end) break;
+        const uint8_t type = d[pos++];
+        uint32_t mlen = 0;
+        if (!readVarLen(d, pos, end, mlen) || pos + mlen > end) break;
+        if (type == 0x51 && mlen == 3) {
+          RawEvent e; e.tick = tick; e.order = order++; e.tempo = true; e.usPerQuarter = readBe(&d[pos], 3);
+          raw.push_back(e);
+        } else if (type == 0x2F) {
+          pos += mlen;
+          break;
+        }
+        pos += mlen;
+        continue;
+      }
+      if (status == 0xF0 || status == 0xF7) {
+        uint32_t slen = 0;
+        if (!readVarLen(d, pos, end, slen)) break;
+        pos += slen;
+        continue;
+      }
+      if (status >= 0xF8) {
+        RawEvent e; e.tick = tick; e.order = order++; e.msg.status = status;
+        raw.push_back(e);
+        continue;
+      }
+      running = status;
+      const uint8_t n = dataBytesForStatus(status);
+      if (pos + n > end) break;
+      RawEvent e; e.tick = tick; e.order = order++;
+      e.msg.status = status;
+      e.msg.data1 = d[pos];
+      e.msg.data2 = (n == 2) ? d[pos + 1] : 0;
+      pos += n;
+      raw.push_back(e);
+    }
+    pos = end;
+  }
+
+  // Merge tracks in tick order; tempo events ahead of same-tick channel events
+  std::stable_sort(raw.begin(), raw.end(), [](const RawEvent& a, const RawEvent& b) {
+    if (a.tick != b.tick) return a.tick < b.tick;
+    if (a.tempo != b.tempo) return a.tempo;
+    return a.order < b.order;
+  });
+  double usPerQuarter = 500000.0;
+  bool sawTempo = false;
+  uint64_t lastTick = 0;
+  double lastSec = 0.0;
+  f.events.reserve(raw.size());
+  for (const auto& e : raw) {
+    lastSec += static_cast<double>(e.tick - lastTick) * usPerQuarter / (1.0e6 * static_cast<double>(f.ppqn));
+    lastTick = e.tick;
+    if (e.tempo) {
+      if (e.usPerQuarter > 0) usPerQuarter = static_cast<double>(e.usPerQuarter);
+      if (!sawTempo && e.tick == 0) f.initialBpm = 60.0e6 / usPerQuarter;
+      sawTempo = true;
+      continue;
+    }
+    MidiMessage m = e.msg;
+    m.timeSec = lastSec;
+    f.events.push_back(m);
+  }
+  return f;
+}
+
+inline SmfFile loadSmfFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.good()) throw std::runtime_error("Cannot open MIDI file: " + path);
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  return parseSmf(bytes);
+}
@@ -0,0 +1,494 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+#include "../../third_party/nlohmann/json.hpp"
+#include "../core/Graph.hpp"
+#include "../core/GraphConfig.hpp"
+#include "../core/JobPool.hpp"
+#include "../instruments/sampler/SampleCache.hpp"
+#include "../io/AudioFileWriter.hpp"
+#include "../io/FlacEncoder.hpp"
+#include "../io/WavStreamWriter.hpp"
+#include "../session/SessionRuntime.hpp"
+#include "../session/SessionSpec.hpp"
+#include "GraphExport.hpp"
+#include "OfflineLoopRenderer.hpp"
+#include "OfflineProgress.hpp"
+#include "OfflineTimelineRenderer.hpp"
+#include "OfflineTopoScheduler.hpp"
+
+// Batch render service (--serve-batch jobs.jsonl): one long-lived process renders a queue of
+// rack/session exports instead of one mam spawn per render. Up to maxJobs jobs run side by
+// side; inside a job, session racks and FLAC frames fan out into one persistent JobPool, so
+// the tail of a batch still uses every core. Parsed specs, export plans
+// (transport commands and length), samples and rendered audio are shared across jobs; every
+// finished job writes one NDJSON result line with its timings and cache use.
+
+struct BatchJob {
+  size_t index = 0;         // line order in jobs.jsonl
+  std::string id;
+  std::string rackPath;     // rack/graph JSON, or
+  std::string sessionPath;  // session JSON
+  std::string outPath;
+  uint32_t sampleRate = 48000;
+  FileFormat format = FileFormat::Wav;
+  BitDepth bitDepth = BitDepth::Float32;
+  ExportOverrides overrides;
+  uint32_t randomSeed = 0;  // 0 = spec seed
+  bool normalize = false;
+  double peakTargetDb = -1.0;
+  bool topoScheduler = false;
+  uint32_t offlineBlock = 1024;
+  bool loopCopy = true;
+  bool laneBatching = false; // same output either way, so not part of the render cache key
+  std::string error;        // the line could not be parsed into a job
+};
+
+inline bool parseFileFormat(const std::string& s, FileFormat& out) {
+  if (s == "wav") out = FileFormat::Wav;
+  else if (s == "aiff" || s == "aif") out = FileFormat::Aiff;
+  else if (s == "caf") out = FileFormat::Caf;
+  else if (s == "flac") out = FileFormat::Flac;
+  else return false;
+  return true;
+}
+
+// Parse jobs.jsonl: one JSON object per line; blank lines and '#' comments are skipped. Keys
+// are the export flags without dashes ("rack" or "session", "out", "sr", "format", "bitdepth",
+// "duration", "bars", "loop-count", "loop-minutes", "loop-seconds", "start-bar", "end-bar",
+// "tail-ms", "random-seed", "normalize", "peak-target", "offline-scheduler", "offline-block",
+// "no-loop-copy", "simd-lanes") plus "id"; unset keys come from `defaults` (the command-line flags). Without
+// "format", the output extension picks it. Bad lines become jobs with `error` set.
+inline std::vector<BatchJob> loadBatchJobs(const std::string& path, const BatchJob& defaults) {
+  std::ifstream in(path);
+  if (!in.good()) throw std::runtime_error("Cannot open batch job file: " + path);
+  std::vector<BatchJob> jobs;
+  std::string line;
+  size_t lineNo = 0;
+  while (std::getline(in, line)) {
+    ++lineNo;
+    const size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#') continue;
+    BatchJob job = defaults;
+    job.index = jobs.size();
+    job.id = "line" + std::to_string(lineNo);
+    try {
+      const nlohmann::json j = nlohmann::json::parse(line);
+      if (!j.is_object()) throw std::runtime_error("expected a JSON object");
+      static const char* kKeys[] = { "id", "rack", "graph", "session", "out", "sr", "format", "bitdepth", "duration", "bars",
+                                     "loop-count", "loop-minutes", "loop-seconds", "start-bar", "end-bar", "tail-ms",
+                                     "random-seed", "normalize", "peak-target", "offline-scheduler", "offline-block", "no-loop-copy",
+                                     "simd-lanes" };
+      for (auto it = j.begin(); it != j.end(); ++it) {
+        if (std::find_if(std::begin(kKeys), std::end(kKeys), [&](const char* k) { return it.key() == k; }) == std::end(kKeys))
+          std::fprintf(stderr, "Warning: %s:%zu: unknown batch job key '%s'\n", path.c_str(), lineNo, it.key().c_str());
+      }
+      auto num = [&](const char* key, double fallback) { return j.contains(key) ? j.at(key).get<double>() : fallback; };
+      auto u32 = [&](const char* key, uint32_t fallback) { return j.contains(key) ? j.at(key).get<uint32_t>() : fallback; };
+      if (j.contains("id")) job.id = j.at("id").is_string() ? j.at("id").get<std::string>() : j.at("id").dump();
+      if (j.contains("rack")) job.rackPath = j.at("rack").get<std::string>();
+      else if (j.contains("graph")) job.rackPath = j.at("graph").get<std::string>();
+      if (j.contains("session")) job.sessionPath = j.at("session").get<std::string>();
+      if (j.contains("out")) job.outPath = j.at("out").get<std::string>();
+      job.sampleRate = static_cast<uint32_t>(std::max(8000.0, num("sr", job.sampleRate)) + 0.5);
+      if (j.contains("format")) {
+        if (!parseFileFormat(j.at("format").get<std::string>(), job.format)) throw std::runtime_error("unknown format " + j.at("format").dump());
+      } else {
+        const std::string ext = std::filesystem::path(job.outPath).extension().string();
+        if (ext.size() > 1) parseFileFormat(ext.substr(1), job.format);
+      }
+      if (j.contains("bitdepth")) {
+        const std::string b = j.at("bitdepth").is_string() ? j.at("bitdepth").get<std::string>() : j.at("bitdepth").dump();
+        job.bitDepth = b == "16" ? BitDepth::Pcm16 : (b == "24" ? BitDepth::Pcm24 : BitDepth::Float32);
+      }
+      ExportOverrides& ov = job.overrides;
+      ov.durationSec = num("duration", ov.durationSec);
+      ov.bars = u32("bars", ov.bars);
+      ov.loopCount = u32("loop-count", ov.loopCount);
+      ov.loopMinutes = num("loop-minutes", ov.loopMinutes);
+      ov.loopSeconds = num("loop-seconds", ov.loopSeconds);
+      ov.startBar = u32("start-bar", ov.startBar);
+      ov.endBar = u32("end-bar", ov.endBar);
+      if (j.contains("tail-ms")) { ov.tailMs = std::max(0.0, j.at("tail-ms").get<double>()); ov.tailOverridden = true; }
+      job.randomSeed = u32("random-seed", job.randomSeed);
+      if (j.contains("normalize")) job.normalize = j.at("normalize").get<bool>();
+      if (j.contains("peak-target")) { job.peakTargetDb = j.at("peak-target").get<double>(); job.normalize = true; }
+      if (j.contains("offline-scheduler")) job.topoScheduler = j.at("offline-scheduler").get<std::string>() == "topo";
+      job.offlineBlock = std::max(64u, u32("offline-block", job.offlineBlock));
+      if (j.contains("no-loop-copy")) job.loopCopy = !j.at("no-loop-copy").get<bool>();
+      if (j.contains("simd-lanes")) job.laneBatching = j.at("simd-lanes").get<bool>();
+      if (job.rackPath.empty() == job.sessionPath.empty()) throw std::runtime_error("exactly one of \"rack\" or \"session\" is required");
+      if (job.outPath.empty()) throw std::runtime_error("\"out\" is required");
+    } catch (const std::exception& e) {
+      job.error = path + ":" + std::to_string(lineNo) + ": " + e.what();
+    }
+    jobs.push_back(std::move(job));
+  }
+  return jobs;
+}
+
+// Parsed specs keyed by path; a file is re-parsed when its mtime or size changes
+template <typename Spec>
+class SpecCache {
+public:
+  explicit SpecCache(std::function<Spec(const std::string&)> load) : load_(std::move(load)) {}
+
+  // "path@mtime:size": identifies the file contents for render cache keys
+  static std::string version(const std::string& path) {
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0) return path + "@missing";
+    return path + "@" + std::to_string(static_cast<long long>(st.st_mtime)) + ":" + std::to_string(static_cast<long long>(st.st_size));
+  }
+
+  std::shared_ptr<const Spec> get(const std::string& path, bool* hit = nullptr) {
+    const std::string v = version(path);
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      auto it = entries_.find(path);
+      if (it != entries_.end() && it->second.first == v) {
+        ++hits_;
+        if (hit) *hit = true;
+        return it->second.second;
+      }
+    }
+    // Parse outside the lock; two workers missing the same file both parse it once
+    auto spec = std::make_shared<const Spec>(load_(path));
+    std::lock_guard<std::mutex> lk(m_);
+    ++misses_;
+    entries_[path] = std::make_pair(v, spec);
+    if (hit) *hit = false;
+    return spec;
+  }
+
+  uint64_t hits() const { std::lock_guard<std::mutex> lk(m_); return hits_; }
+  uint64_t misses() const { std::lock_guard<std::mutex> lk(m_); return misses_; }
+
+private:
+  std::function<Spec(const std::string&)> load_;
+  mutable std::mutex m_;
+  std::unordered_map<std::string, std::pair<std::string, std::shared_ptr<const Spec>>> entries_;
+  uint64_t hits_ = 0, misses_ = 0;
+};
+
+// Rendered audio keyed by everything that shapes the samples (spec versions, rate, length
+// overrides, seed, scheduler), so jobs that differ only in output format, bit depth, gain
+// normalization or path render once. A job whose key is already rendering elsewhere waits for
+// that render. Finished renders are kept FIFO up to budgetBytes.
+class RenderCache {
+public:
+  using Audio = std::shared_ptr<const std::vector<float>>;
+  enum class Use { Miss, Hit, Shared };
+
+  explicit RenderCache(size_t budgetBytes) : budget_(budgetBytes) {}
+
+  Audio getOrRender(const std::string& key, const std::function<std::vector<float>()>& render, Use& use) {
+    std::promise<Audio> promise;
+    std::shared_future<Audio> pending;
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        use = it->second.ready ? Use::Hit : Use::Shared;
+        if (it->second.ready) ++hits_; else ++shared_;
+        pending = it->second.audio;
+      } else {
+        use = Use::Miss;
+        ++misses_;
+        entries_[key] = Entry{ promise.get_future().share(), false, 0 };
+      }
+    }
+    if (use != Use::Miss) return pending.get();
+    Audio audio;
+    try {
+      audio = std::make_shared<const std::vector<float>>(render());
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+      std::lock_guard<std::mutex> lk(m_);
+      entries_.erase(key);
+      throw;
+    }
+    promise.set_value(audio);
+    std::lock_guard<std::mutex> lk(m_);
+    Entry& e = entries_[key];
+    e.ready = true;
+    e.bytes = audio->capacity() * sizeof(float);
+    bytes_ += e.bytes;
+    order_.push_back(key);
+    // Evict oldest finished renders; jobs still holding one keep it alive until they finish
+    while (bytes_ > budget_ && !order_.empty()) {
+      auto old = entries_.find(order_.front());
+      if (old != entries_.end()) { bytes_ -= old->second.bytes; entries_.erase(old); }
+      order_.pop_front();
+    }
+    return audio;
+  }
+
+  uint64_t hits() const { std::lock_guard<std::mutex> lk(m_); return hits_; }
+  uint64_t shared() const { std::lock_guard<std::mutex> lk(m_); return shared_; }
+  uint64_t misses() const { std::lock_guard<std::mutex> lk(m_); return misses_; }
+
+private:
+  struct Entry { std::shared_future<Audio> audio; bool ready = false; size_t bytes = 0; };
+  size_t budget_;
+  mutable std::mutex m_;
+  std::unordered_map<std::string, Entry> entries_;
+  std::deque<std::string> order_;
+  size_t bytes_ = 0;
+  uint64_t hits_ = 0, shared_ = 0, misses_ = 0;
+};
+
+class BatchRenderService {
+public:
+  struct Options {
+    uint32_t threads = 0;                 // pool size; 0 = hardware concurrency
+    uint32_t maxJobs = 0;                 // jobs in flight; 0 = pool size
+    size_t renderCacheBytes = size_t{1} << 30;
+  };
+
+  explicit BatchRenderService(const Options& opt)
+    : threads_(opt.threads > 0 ? opt.threads : std::max(1u, std::thread::hardware_concurrency())),
+      maxJobs_(opt.maxJobs > 0 ? opt.maxJobs : threads_),
+      pool_(threads_),
+      graphSpecs_([](const std::string& p) { return loadGraphSpecFromJsonFile(p); }),
+      sessionSpecs_([](const std::string& p) { return loadSessionSpecFromJsonFile(p); }),
+      renders_(opt.renderCacheBytes) {}
+
+  // Run every job and write one NDJSON line per job to `results` as jobs finish (the "index"
+  // field gives the jobs.jsonl order). Returns the number of failed jobs.
+  size_t run(const std::vector<BatchJob>& jobs, FILE* results) {
+    const bool progress = gOfflineProgressEnabled, summary = gOfflineSummaryEnabled;
+    gOfflineProgressEnabled = false; // per-render progress lines would interleave across jobs
+    gOfflineSummaryEnabled = false;
+    SampleCache::instance().setPinLoaded(true);
+    const uint64_t sampleHits0 = sampleCacheStats().loadHits.load(), sampleMisses0 = sampleCacheStats().loadMisses.load();
+    const auto t0 = std::chrono::steady_clock::now();
+    size_t failed = 0;
+    std::mutex m;
+    std::atomic<size_t> next{0};
+    // Jobs run on their own runner threads, never as pool jobs: a JobGroup waiting inside one
+    // job helps with queued pool work, and picking up a whole job that waits on its render
+    // would deadlock. The pool only carries fan-out from running jobs.
+    auto runner = [&] {
+      for (size_t i = next.fetch_add(1); i < jobs.size(); i = next.fetch_add(1)) {
+        const double waitMs = msSince(t0);
+        nlohmann::json r = runJob(jobs[i], waitMs);
+        const std::string line = r.dump();
+        std::lock_guard<std::mutex> lk(m);
+        if (r.value("status", std::string()) != "ok") ++failed;
+        std::fprintf(results, "%s\n", line.c_str());
+        std::fflush(results);
+      }
+    };
+    std::vector<std::thread> runners;
+    const size_t nRunners = std::min<size_t>(maxJobs_, jobs.size());
+    for (size_t k = 1; k < nRunners; ++k) runners.emplace_back(runner);
+    runner();
+    for (auto& t : runners) t.join();
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::fprintf(stderr, "[batch] %zu jobs (%zu failed) in %.3fs on %u threads, up to %u jobs at once\n",
+                 jobs.size(), failed, sec, threads_, maxJobs_);
+    std::fprintf(stderr, "[batch] caches: graph specs %llu/%llu hits, session specs %llu/%llu, plans %llu/%llu, renders %llu/%llu (+%llu shared in flight), samples %llu/%llu\n",
+                 ull(graphSpecs_.hits()), ull(graphSpecs_.hits() + graphSpecs_.misses()),
+                 ull(sessionSpecs_.hits()), ull(sessionSpecs_.hits() + sessionSpecs_.misses()),
+                 ull(planHits()), ull(planHits() + planMisses()),
+                 ull(renders_.hits()), ull(renders_.hits() + renders_.shared() + renders_.misses()), ull(renders_.shared()),
+                 ull(sampleCacheStats().loadHits.load() - sampleHits0),
+                 ull(sampleCacheStats().loadHits.load() - sampleHits0 + sampleCacheStats().loadMisses.load() - sampleMisses0));
+    SampleCache::instance().setPinLoaded(false);
+    gOfflineProgressEnabled = progress;
+    gOfflineSummaryEnabled = summary;
+    return failed;
+  }
+
+private:
+  static unsigned long long ull(uint64_t v) { return static_cast<unsigned long long>(v); }
+  static const char* useStr(RenderCache::Use u) { return u == RenderCache::Use::Hit ? "hit" : (u == RenderCache::Use::Shared ? "shared" : "miss"); }
+  static double msSince(std::chrono::steady_clock::time_point t) { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count(); }
+
+  static std::string overridesKey(const BatchJob& job) {
+    const ExportOverrides& ov = job.overrides;
+    char buf[256];
+    std::snprintf(buf, sizeof(buf), "sr=%u dur=%.9g bars=%u loops=%u lmin=%.9g lsec=%.9g bar=%u-%u tail=%.9g%s",
+                  job.sampleRate, ov.durationSec, ov.bars, ov.loopCount, ov.loopMinutes, ov.loopSeconds, ov.startBar, ov.endBar,
+                  ov.tailMs, ov.tailOverridden ? "!" : "");
+    return buf;
+  }
+
+  // Transport commands and export length for (spec version, rate, overrides)
+  std::shared_ptr<const GraphExportPlan> plan(const std::string& key, const GraphSpec& spec, const BatchJob& job, bool& hit) {
+    {
+      std::lock_guard<std::mutex> lk(planMutex_);
+      auto it = plans_.find(key);
+      if (it != plans_.end()) { ++planHits_; hit = true; return it->second; }
+    }
+    auto p = std::make_shared<const GraphExportPlan>(planGraphExport(spec, job.sampleRate, job.overrides));
+    std::lock_guard<std::mutex> lk(planMutex_);
+    ++planMisses_;
+    hit = false;
+    plans_[key] = p;
+    return p;
+  }
+  uint64_t planHits() const { std::lock_guard<std::mutex> lk(planMutex_); return planHits_; }
+  uint64_t planMisses() const { std::lock_guard<std::mutex> lk(planMutex_); return planMisses_; }
+
+  RenderCache::Audio renderRack(const BatchJob& job, nlohmann::json& r) {
+    bool specHit = false, planHit = false;
+    auto t = std::chrono::steady_clock::now();
+    const auto spec = graphSpecs_.get(job.rackPath, &specHit);
+    r["ms"]["load"] = msSince(t);
+    t = std::chrono::steady_clock::now();
+    const std::string version = SpecCache<GraphSpec>::version(job.rackPath);
+    const std::string planKey = version + "|" + overridesKey(job);
+    const auto p = plan(planKey, *spec, job, planHit);
+    r["ms"]["plan"] = msSince(t);
+    r["cache"] = { {"spec", specHit ? "hit" : "miss"}, {"plan", planHit ? "hit" : "miss"} };
+    const std::string key = "rack|" + planKey + "|seed=" + std::to_string(job.randomSeed) + (job.topoScheduler ? "|topo=" + std::to_string(job.offlineBlock) : "")
+                          + (job.loopCopy ? "" : "|nocopy");
+    t = std::chrono::steady_clock::now();
+    RenderCache::Use use = RenderCache::Use::Miss;
+    auto audio = renders_.getOrRender(key, [&] {
+      const uint32_t channels = 2;
+      Graph graph;
+      buildGraphFromSpec(graph, *spec, job.randomSeed);
+      graph.setLaneBatching(job.laneBatching);
+      std::vector<float> out;
+      if (job.topoScheduler) {
+        OfflineTopoScheduler sched(channels);
+        sched.setBlockSize(job.offlineBlock);
+        std::vector<GraphSpec::Connection> conns = spec->connections;
+        sched.render(graph, conns, p->cmds, job.sampleRate, channels, p->totalFrames, out);
+      } else if (p->loopFrames > 0 && job.loopCopy) {
+        out = renderGraphWithCommandsLooped(graph, p->cmds, job.sampleRate, channels, p->totalFrames, p->loopFrames, p->loopCount);
+      } else {
+        out = renderGraphWithCommands(graph, p->cmds, job.sampleRate, channels, p->totalFrames);
+      }
+      return out;
+    }, use);
+    r["ms"]["render"] = msSince(t);
+    r["cache"]["render"] = useStr(use);
+    r["prerollMs"] = 1000.0 * static_cast<double>(p->preroll) / job.sampleRate;
+    return audio;
+  }
+
+  RenderCache::Audio renderSession(const BatchJob& job, nlohmann::json& r) {
+    bool specHit = false;
+    auto t = std::chrono::steady_clock::now();
+    SessionSpec sess = *sessionSpecs_.get(job.sessionPath, &specHit);
+    sess.sampleRate = job.sampleRate;
+    r["ms"]["load"] = msSince(t);
+    r["cache"] = { {"spec", specHit ? "hit" : "miss"} };
+    // Rack files are part of the key: editing a rack between jobs re-renders the session
+    std::string key = "session|" + SpecCache<SessionSpec>::version(job.sessionPath);
+    for (const auto& rr : sess.racks) key += "|" + SpecCache<GraphSpec>::version(rr.path);
+    key += "|" + overridesKey(job) + "|seed=" + std::to_string(job.randomSeed) + (job.loopCopy ? "" : "|nocopy");
+    t = std::chrono::steady_clock::now();
+    RenderCache::Use use = RenderCache::Use::Miss;
+    double planMs = 0.0;
+    auto audio = renders_.getOrRender(key, [&] {
+      const auto tp = std::chrono::steady_clock::now();
+      SessionRuntime runtime;
+      runtime.randomSeedOverride = job.randomSeed;
+      runtime.rackSpecLoader = [this](const std::string& p) { return *graphSpecs_.get(p); };
+      runtime.rackPool = &pool_;
+      runtime.laneBatching = job.laneBatching;
+      runtime.loadFromSpec(sess);
+      uint32_t loops = 1;
+      uint64_t frames = runtime.planExportFrames(sess, job.overrides.tailMs, loops);
+      if (job.overrides.durationSec >= 0.0) frames = static_cast<uint64_t>(job.overrides.durationSec * job.sampleRate + 0.5);
+      planMs = msSince(tp);
+      return (sess.loop && sess.durationSec > 0.0 && loops > 1) ? runtime.renderOfflineWithLoop(frames, loops, nullptr, job.loopCopy) : runtime.renderOffline(frames);
+    }, use);
+    r["ms"]["plan"] = planMs;
+    r["ms"]["render"] = msSince(t) - planMs;
+    r["cache"]["render"] = useStr(use);
+    return audio;
+  }
+
+  nlohmann::json runJob(const BatchJob& job, double waitMs) {
+    nlohmann::json r;
+    r["index"] = job.index;
+    r["id"] = job.id;
+    r["kind"] = job.sessionPath.empty() ? "rack" : "session";
+    r["out"] = job.outPath;
+    const auto t0 = std::chrono::steady_clock::now();
+    try {
+      if (!job.error.empty()) throw std::runtime_error(job.error);
+      RenderCache::Audio audio = job.sessionPath.empty() ? renderRack(job, r) : renderSession(job, r);
+      const uint32_t channels = 2;
+      const auto t = std::chrono::steady_clock::now();
+      // Normalization scales a copy: the cached render stays shared with other jobs
+      double peakDb = 0.0, rmsDb = 0.0, gainDb = 0.0;
+      SessionRuntime::computePeakAndRmsSimple(*audio, channels, peakDb, rmsDb);
+      std::vector<float> scaled;
+      if (job.normalize && std::isfinite(peakDb)) {
+        gainDb = job.peakTargetDb - peakDb;
+        const double g = std::pow(10.0, gainDb / 20.0);
+        scaled.reserve(audio->size());
+        for (float s : *audio) scaled.push_back(static_cast<float>(static_cast<double>(s) * g));
+        SessionRuntime::computePeakAndRmsSimple(scaled, channels, peakDb, rmsDb);
+      }
+      const std::vector<float>& out = scaled.empty() ? *audio : scaled;
+      AudioFileSpec spec; spec.format = job.format; spec.bitDepth = job.bitDepth; spec.sampleRate = job.sampleRate; spec.channels = channels;
+      const std::filesystem::path parent = std::filesystem::path(job.outPath).parent_path();
+      if (!parent.empty()) std::filesystem::create_directories(parent);
+      uint64_t bytes = 0;
+      if (job.format == FileFormat::Wav) {
+        bytes = writeWavStreamed(job.outPath, spec, out).bytes;
+      } else if (job.format == FileFormat::Flac) {
+        FlacEncodeOptions fo; fo.pool = &pool_;
+        const FlacEncodeStats st = writeFlacStreamed(job.outPath, spec, out, fo);
+        bytes = st.bytes;
+        r["md5"] = st.md5;
+      } else {
+        writeWithExtAudioFile(job.outPath, spec, out);
+        std::error_code ec;
+        bytes = static_cast<uint64_t>(std::filesystem::file_size(job.outPath, ec));
+      }
+      r["ms"]["write"] = msSince(t);
+      const uint64_t frames = out.size() / channels;
+      r["status"] = "ok";
+      r["frames"] = frames;
+      r["seconds"] = static_cast<double>(frames) / job.sampleRate;
+      r["format"] = job.format == FileFormat::Wav ? "wav" : job.format == FileFormat::Flac ? "flac" : job.format == FileFormat::Aiff ? "aiff" : "caf";
+      r["bytes"] = bytes;
+      r["peakDb"] = std::isfinite(peakDb) ? peakDb : -999.0;
+      r["rmsDb"] = std::isfinite(rmsDb) ? rmsDb : -999.0;
+      if (job.normalize) r["gainDb"] = gainDb;
+    } catch (const std::exception& e) {
+      r["status"] = "error";
+      r["error"] = e.what();
+    }
+    r["ms"]["queue"] = waitMs;
+    r["ms"]["total"] = msSince(t0);
+    return r;
+  }
+
+  uint32_t threads_;
+  uint32_t maxJobs_;
+  JobPool pool_;
+  SpecCache<GraphSpec> graphSpecs_;
+  SpecCache<SessionSpec> sessionSpecs_;
+  mutable std::mutex planMutex_;
+  std::unordered_map<std::string, std::shared_ptr<const GraphExportPlan>> plans_;
+  uint64_t planHits_ = 0, planMisses_ = 0;
+  RenderCache renders_;
+};
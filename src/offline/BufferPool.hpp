@@ -26,6 +26,13 @@ public:
     return entries_.back().data;
   }
 
+  // Bytes held by all entries, in use or free (--mem-report)
+  size_t memoryBytes() const {
+    size_t n = 0;
+    for (const auto& e : entries_) n += e.data.capacity() * sizeof(float);
+    return n;
+  }
+
   void releaseAll() {
     for (auto& e : entries_) e.inUse = false;
   }
@@ -44,7 +51,8 @@ private:
 
   static void reuse(Entry& e, size_t need) {
     if (e.data.size() < need) e.data.resize(need);
-    std::fill(e.data.begin(), e.data.end(), 0.0f);
+    // Only the requested span is handed out, so only it needs clearing
+    std::fill(e.data.begin(), e.data.begin() + static_cast<std::ptrdiff_t>(need), 0.0f);
     e.inUse = true;
   }
 };
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../core/Graph.hpp"
+#include "../core/GraphConfig.hpp"
+#include "../core/GraphUtils.hpp"
+#include "../core/MixerNode.hpp"
+#include "../core/NodeFactory.hpp"
+#include "../core/ParamMap.hpp"
+#include "../instruments/sampler/SamplerWarmup.hpp"
+#include "../../third_party/nlohmann/json.hpp"
+#include "TransportGenerator.hpp"
+
+// Offline graph export planning shared by the CLI export and the batch service (--serve-batch):
+// graph construction, transport commands for the requested bars/loops/bar range, param-name
+// resolution and the export length (duration override or transport bars, plus preroll and tail).
+
+// Export length and transport overrides (the --duration / --bars / --loop-* / --*-bar / --tail-ms flags)
+struct ExportOverrides {
+  double durationSec = -1.0; // < 0 means auto
+  uint32_t bars = 0;         // 0 means transport length
+  uint32_t loopCount = 0;    // 0 means single pass
+  double loopMinutes = 0.0;  // derive loop count if > 0
+  double loopSeconds = 0.0;
+  uint32_t startBar = 0;     // 0-based
+  uint32_t endBar = 0;       // exclusive, 0 means transport length
+  double tailMs = 250.0;
+  bool tailOverridden = false;
+};
+
+struct GraphExportPlan {
+  std::vector<GraphSpec::CommandSpec> cmds;
+  uint64_t totalFrames = 0; // including preroll and tail
+  uint64_t preroll = 0;
+  double tailMs = 0.0;
+  uint64_t loopFrames = 0;  // repeating transport timeline for loop copy (0 = none)
+  uint32_t loopCount = 1;
+};
+
+// Nodes, mixer, connections, automation, port descriptors and random seed (seedOverride != 0
+// replaces the spec's); queues sampler heads on the prefetcher
+inline void buildGraphFromSpec(Graph& graph, const GraphSpec& spec, uint32_t seedOverride) {
+  for (const auto& ns : spec.nodes) {
+    auto node = createNodeFromSpec(ns);
+    if (node) graph.addNode(ns.id, std::move(node));
+  }
+  if (spec.hasMixer) {
+    std::vector<MixerChannel> chans;
+    for (const auto& inp : spec.mixer.inputs) {
+      MixerChannel mc; mc.id = inp.id; mc.gain = inp.gainPercent * (1.0f/100.0f);
+      chans.push_back(mc);
+    }
+    const float master = spec.mixer.masterPercent * (1.0f/100.0f);
+    graph.setMixer(std::make_unique<MixerNode>(std::move(chans), master, spec.mixer.softClip));
+  }
+  if (!spec.connections.empty()) {
+    graph.setConnections(spec.connections);
+  }
+  graph.setAutomation(spec.automation);
+  // Provide port descriptors to graph (for channel adapters)
+  graph.setPortDescriptors(spec.nodes);
+  graph.setRandomSeed(seedOverride != 0 ? seedOverride : spec.randomSeed);
+  warmSamplerHeads(graph, spec);
+}
+
+// Append transport commands covering the requested bars/loops (sliced to the bar range)
+inline void appendTransportCommands(const GraphSpec& spec, uint32_t sr, const ExportOverrides& ov, GraphExportPlan& plan) {
+  if (!spec.hasTransport) return;
+  GraphSpec::Transport tgen = spec.transport;
+  const uint32_t baseBars = spec.transport.lengthBars ? spec.transport.lengthBars : 1u;
+  uint32_t useBars = ov.bars > 0 ? ov.bars : baseBars;
+  uint32_t loops = ov.loopCount > 0 ? ov.loopCount : 1u;
+  if ((ov.loopMinutes > 0.0 || ov.loopSeconds > 0.0) && useBars > 0) {
+    const double targetSec = (ov.loopMinutes > 0.0 ? ov.loopMinutes * 60.0 : ov.loopSeconds);
+    if (targetSec > 0.0) {
+      // compute seconds per bar with ramps by averaging first bar
+      const double bpm = spec.transport.bpm > 0.0 ? spec.transport.bpm : 120.0;
+      const double secPerBar = 4.0 * (60.0 / bpm);
+      const uint32_t perLoopBars = useBars;
+      const double perLoopSec = secPerBar * static_cast<double>(perLoopBars);
+      loops = static_cast<uint32_t>(std::ceil(targetSec / std::max(0.001, perLoopSec)));
+      if (loops == 0) loops = 1;
+    }
+  }
+  tgen.lengthBars = useBars * loops;
+  if (loops > 1 && ov.startBar == 0 && ov.endBar == 0) { plan.loopFrames = transportLoopFrames(tgen, sr, useBars); plan.loopCount = loops; }
+  auto gen = generateCommandsFromTransport(tgen, sr);
+  // Optional slicing to a bar range [startBar, endBar)
+  if (ov.startBar > 0 || ov.endBar > 0) {
+    const uint32_t startBar = ov.startBar;
+    const uint32_t endBar = (ov.endBar > 0) ? ov.endBar : tgen.lengthBars;
+    const double secPerBar = 4.0 * (60.0 / (tgen.bpm > 0.0 ? tgen.bpm : 120.0));
+    const uint64_t framesPerBar0 = static_cast<uint64_t>(secPerBar * static_cast<double>(sr) + 0.5);
+    const uint64_t startFrames = framesPerBar0 * static_cast<uint64_t>(startBar);
+    const uint64_t endFrames = framesPerBar0 * static_cast<uint64_t>(std::max(endBar, startBar));
+    gen.erase(std::remove_if(gen.begin(), gen.end(), [&](const auto& c){ return c.sampleTime < startFrames || c.sampleTime >= endFrames; }), gen.end());
+    for (auto& c : gen) c.sampleTime -= startFrames;
+  }
+  plan.cmds.insert(plan.cmds.end(), gen.begin(), gen.end());
+}
+
+// Resolve named params to IDs based on node type
+inline void resolveCommandParamIds(const GraphSpec& spec, std::vector<GraphSpec::CommandSpec>& cmds) {
+  std::unordered_map<std::string, std::string> nodeIdToType;
+  for (const auto& ns : spec.nodes) nodeIdToType.emplace(ns.id, ns.type);
+  for (auto& c : cmds) {
+    if (c.paramId == 0 && !c.paramName.empty()) {
+      auto it = nodeIdToType.find(c.nodeId);
+      const std::string nodeType = (it != nodeIdToType.end()) ? it->second : std::string();
+      c.paramId = paramIdForNodeType(nodeType, c.paramName);
+    }
+  }
+}
+
+// Content length before preroll and tail: duration override, transport bars (with tempo
+// ramps), the last command, or 2 seconds
+inline uint64_t planContentFrames(const GraphSpec& spec, uint32_t sr, const ExportOverrides& ov, const std::vector<GraphSpec::CommandSpec>& cmds) {
+  if (ov.durationSec >= 0.0) return static_cast<uint64_t>(ov.durationSec * static_cast<double>(sr) + 0.5);
+  if (spec.hasTransport) {
+    auto bpmAtBar = [&](uint32_t barIndex) -> double {
+      double bpm = spec.transport.bpm;
+      for (const auto& p : spec.transport.tempoRamps) { if (p.bar <= barIndex) bpm = p.bpm; }
+      return bpm;
+    };
+    auto framesPerBarAt = [&](uint32_t barIndex) -> uint64_t {
+      const double secPerBeat = 60.0 / bpmAtBar(barIndex);
+      const double secPerBar = 4.0 * secPerBeat;
+      return static_cast<uint64_t>(secPerBar * static_cast<double>(sr) + 0.5);
+    };
+    const uint32_t baseBars = spec.transport.lengthBars ? spec.transport.lengthBars : 1u;
+    const uint32_t useBars = ov.bars > 0 ? ov.bars : baseBars;
+    const uint32_t startBar = ov.startBar;
+    const uint32_t endBar = (ov.endBar > 0) ? ov.endBar : useBars;
+    const uint32_t loops = ov.loopCount > 0 ? ov.loopCount : 1u;
+    const uint64_t spanBars = static_cast<uint64_t>((endBar > startBar ? (endBar - startBar) : 0u));
+    const uint64_t totalBars = spanBars * static_cast<uint64_t>(loops);
+    uint64_t frames = 0;
+    for (uint64_t b = 0; b < totalBars; ++b) frames += framesPerBarAt(static_cast<uint32_t>(startBar + b));
+    return frames;
+  }
+  if (!cmds.empty()) {
+    uint64_t last = 0; for (const auto& c : cmds) if (c.sampleTime > last) last = c.sampleTime;
+    return last;
+  }
+  return static_cast<uint64_t>(2.0 * static_cast<double>(sr) + 0.5);
+}
+
+// Tail after the content: the override, or longer for long delays and reverbs
+inline double planTailMs(const GraphSpec& spec, const ExportOverrides& ov) {
+  if (ov.tailOverridden) return ov.tailMs;
+  double maxDelayMs = 0.0; bool hasReverb = false;
+  for (const auto& ns : spec.nodes) {
+    if (ns.type == std::string("delay")) {
+      try { nlohmann::json pj = nlohmann::json::parse(ns.paramsJson); maxDelayMs = std::max(maxDelayMs, pj.value("delayMs", 0.0)); } catch (...) {}
+    } else if (ns.type == std::string("reverb")) {
+      hasReverb = true;
+    }
+  }
+  double suggested = 250.0;
+  if (maxDelayMs > 0.0) suggested = std::max(suggested, std::min(6000.0, maxDelayMs * 2.0));
+  if (hasReverb) suggested = std::max(suggested, 1000.0);
+  return suggested;
+}
+
+// Add graph preroll (node latency) and the tail to plan.totalFrames
+inline void addPrerollAndTail(const GraphSpec& spec, uint32_t sr, const ExportOverrides& ov, GraphExportPlan& plan) {
+  plan.tailMs = planTailMs(spec, ov);
+  plan.preroll = computeGraphPrerollSamples(spec, sr);
+  plan.totalFrames += plan.preroll + static_cast<uint64_t>((plan.tailMs / 1000.0) * static_cast<double>(sr) + 0.5);
+}
+
+// Full plan for a spec without external (MIDI) commands
+inline GraphExportPlan planGraphExport(const GraphSpec& spec, uint32_t sr, const ExportOverrides& ov) {
+  GraphExportPlan plan;
+  plan.cmds = spec.commands;
+  appendTransportCommands(spec, sr, ov, plan);
+  resolveCommandParamIds(spec, plan.cmds);
+  plan.totalFrames = planContentFrames(spec, sr, ov, plan.cmds);
+  addPrerollAndTail(spec, sr, ov, plan);
+  return plan;
+}
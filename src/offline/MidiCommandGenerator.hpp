@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "../core/GraphConfig.hpp"
+#include "../midi/MidiClock.hpp"
+#include "../midi/MidiEventSource.hpp"
+#include "../midi/MidiMapping.hpp"
+
+// Render a scheduled MIDI source (SMF or test generator) into graph commands.
+// Source seconds map directly to sample time, so offline exports of MIDI input are
+// deterministic and match the realtime bridge minus its scheduling latency.
+inline std::vector<GraphSpec::CommandSpec> generateCommandsFromMidi(MidiEventSource& source,
+                                                                   const MidiMapping& mapping,
+                                                                   uint32_t sampleRate,
+                                                                   bool followClock,
+                                                                   double maxSec = 600.0) {
+  std::vector<GraphSpec::CommandSpec> out;
+  if (source.isLive()) return out;
+  source.start();
+  std::vector<MidiMessage> msgs;
+  const double untilSec = (source.lengthSec() > 0.0) ? std::min(maxSec, source.lengthSec() + 1.0e-6) : maxSec;
+  source.poll(untilSec, msgs);
+  MidiClockFollower clock;
+  std::vector<Command> cmds;
+  for (const auto& m : msgs) {
+    const SampleTime st = static_cast<SampleTime>(std::llround(m.timeSec * static_cast<double>(sampleRate)));
+    cmds.clear();
+    if (followClock && clock.onMessage(m)) mapping.tempoCommands(clock.bpm(), st, cmds);
+    mapping.translate(m, st, cmds);
+    for (const auto& c : cmds) {
+      GraphSpec::CommandSpec cs;
+      cs.sampleTime = c.sampleTime;
+      cs.nodeId = c.nodeId ? c.nodeId : "";
+      cs.type = (c.type == CommandType::Trigger) ? "Trigger" : (c.type == CommandType::SetParam) ? "SetParam" : "SetParamRamp";
+      cs.paramId = c.paramId;
+      cs.value = c.value;
+      cs.rampMs = c.rampMs;
+      if (c.paramNameStr) cs.paramName = c.paramNameStr;
+      out.push_back(std::move(cs));
+    }
+  }
+  source.stop();
+  return out;
+}
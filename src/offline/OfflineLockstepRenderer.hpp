@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "../core/Graph.hpp"
+#include "../core/GraphConfig.hpp"
+#include "../core/JobPool.hpp"
+#include "../core/KernelBatch.hpp"
+#include "OfflineProgress.hpp"
+#include "OfflineTimelineRenderer.hpp"
+
+// One graph of a lockstep render: commands sorted by time, length, and where its audio goes
+struct LockstepGraph {
+  Graph* graph = nullptr;
+  std::vector<GraphSpec::CommandSpec> commands;
+  uint64_t frames = 0;
+  std::vector<float>* out = nullptr;
+};
+
+// Lane batching across graphs (--simd-lanes on a session): every rack graph advances block by
+// block together. Per block each graph routes its events (beginBlock), the batchable generators
+// of all graphs render grouped by kernel, one node per SIMD lane (renderBatchLanes), then each
+// graph finishes its block, in parallel on pool when given. Each graph's output is the same as
+// renderGraphWithSortedCommands would produce for it.
+inline void renderGraphsLockstep(std::vector<LockstepGraph>& graphs, uint32_t sampleRate, uint32_t channels, JobPool* pool = nullptr) {
+  const uint32_t block = 1024;
+  uint64_t frames = 0;
+  for (auto& g : graphs) {
+    g.graph->prepare(sampleRate, block);
+    g.graph->reset();
+    g.out->assign(static_cast<size_t>(g.frames * channels), 0.0f);
+    frames = std::max(frames, g.frames);
+  }
+  std::vector<size_t> cmdIndex(graphs.size(), 0);
+  std::vector<std::vector<Command>> events(graphs.size());
+  std::vector<ProcessContext> ctxs(graphs.size());
+  std::vector<BatchLane> lanes;
+  size_t maxLanes = 0;
+  const auto tStart = std::chrono::steady_clock::now();
+  for (uint64_t f = 0; f < frames; f += block) {
+    lanes.clear();
+    for (size_t i = 0; i < graphs.size(); ++i) {
+      LockstepGraph& g = graphs[i];
+      if (f >= g.frames) continue;
+      const uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(block, g.frames - f));
+      ctxs[i] = commandBlockContext(g.commands, cmdIndex[i], events[i], sampleRate, f, n);
+      g.graph->beginBlock(ctxs[i]);
+      g.graph->collectBatchLanes(lanes, channels);
+    }
+    maxLanes = std::max(maxLanes, lanes.size());
+    renderBatchLanes(lanes.data(), lanes.size(), channels);
+    {
+      JobGroup group(pool);
+      for (size_t i = 0; i < graphs.size(); ++i) {
+        if (f >= graphs[i].frames) continue;
+        group.run([&, i] { graphs[i].graph->process(ctxs[i], graphs[i].out->data() + static_cast<size_t>(f * channels), channels); });
+      }
+      group.wait();
+    }
+    if (gOfflineProgressEnabled && gOfflineProgressMs > 0) {
+      static auto last = tStart; const auto now = std::chrono::steady_clock::now();
+      if (std::chrono::duration_cast<std::chrono::milliseconds>(now - last).count() >= gOfflineProgressMs) {
+        const double frac = static_cast<double>(std::min<uint64_t>(f + block, frames)) / static_cast<double>(frames);
+        std::fprintf(stderr, "[offline-lanes] %3.0f%%\r", frac * 100.0);
+        last = now;
+      }
+    }
+  }
+  const auto tEnd = std::chrono::steady_clock::now();
+  const double sec = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(tEnd - tStart).count()) / 1e9;
+  const double rtSec = static_cast<double>(frames) / static_cast<double>(sampleRate);
+  if (gOfflineSummaryEnabled && rtSec > 0.0) {
+    std::fprintf(stderr, "[offline-lanes] %zu graphs, up to %zu batched nodes per block, done in %.3fs (speedup %.1fx)    \n",
+                 graphs.size(), maxLanes, sec, rtSec / sec);
+  }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "../core/Graph.hpp"
+#include "../core/GraphConfig.hpp"
+#include "OfflineProgress.hpp"
+#include "OfflineTimelineRenderer.hpp"
+
+struct LoopRenderStats {
+  uint32_t rendered = 0;  // loops rendered block by block
+  uint32_t copied = 0;    // loops copied from a converged loop
+  bool hashable = false;  // every node reported its state
+};
+
+// Loop-aware variant of renderGraphWithCommands for a timeline that repeats every loopFrames
+// for `loops` loops (preroll and tail follow). Loops are rendered from their own start. The
+// render converges with period p (usually 1) when the graph state digest (Graph::hashState)
+// after a loop equals the one p loops earlier and that loop's commands (shifted by loopFrames)
+// and output match bit for bit: every following loop whose commands match the loop p back is
+// then a copy. A loop whose commands differ is rendered and convergence has to be shown anew.
+// Graphs with a node that can't hash its state (noise indexed by absolute time, file writers)
+// render every frame.
+// Commands must be sorted by time (sortedCommands, mergeCommandStreams).
+inline std::vector<float> renderGraphWithSortedCommandsLooped(Graph& graph,
+                                                              const std::vector<GraphSpec::CommandSpec>& commands,
+                                                              uint32_t sampleRate,
+                                                              uint32_t channels,
+                                                              uint64_t frames,
+                                                              uint64_t loopFrames,
+                                                              uint32_t loops,
+                                                              LoopRenderStats* stats = nullptr) {
+  LoopRenderStats st;
+  graph.prepare(sampleRate, 1024);
+  graph.reset();
+  StateHash start;
+  st.hashable = loopFrames > 0 && loops > 1 && graph.hashState(start);
+  if (!st.hashable) {
+    if (gOfflineSummaryEnabled && loops > 1) std::fprintf(stderr, "[offline-loop] graph state not hashable; rendering every loop\n");
+    if (stats) *stats = st;
+    return renderGraphWithSortedCommands(graph, commands, sampleRate, channels, frames);
+  }
+
+  std::vector<float> out;
+  out.resize(static_cast<size_t>(frames * channels), 0.0f);
+  const auto tStart = std::chrono::steady_clock::now();
+
+  // Command index range of each loop window: [windowBegin[w], windowBegin[w + 1])
+  std::vector<size_t> windowBegin(static_cast<size_t>(loops) + 1);
+  for (uint32_t w = 0; w <= loops; ++w) {
+    const uint64_t t = static_cast<uint64_t>(w) * loopFrames;
+    windowBegin[w] = static_cast<size_t>(std::partition_point(commands.begin(), commands.end(), [&](const auto& c) { return c.sampleTime < t; }) - commands.begin());
+  }
+  auto sameWindow = [&](uint32_t a, uint32_t b) {
+    const size_t na = windowBegin[a + 1] - windowBegin[a];
+    if (na != windowBegin[b + 1] - windowBegin[b]) return false;
+    const uint64_t shift = static_cast<uint64_t>(b - a) * loopFrames;
+    for (size_t i = 0; i < na; ++i) {
+      const auto& x = commands[windowBegin[a] + i];
+      const auto& y = commands[windowBegin[b] + i];
+      if (x.sampleTime + shift != y.sampleTime || x.nodeId != y.nodeId || x.type != y.type ||
+          x.paramId != y.paramId || x.value != y.value || x.rampMs != y.rampMs) return false;
+    }
+    return true;
+  };
+
+  const uint32_t block = 1024;
+  size_t cmdIndex = 0;
+  std::vector<Command> events;
+  auto renderSpan = [&](uint64_t from, uint64_t to) {
+    for (uint64_t f = from; f < to; f += block) {
+      const uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(block, to - f));
+      renderCommandBlock(graph, commands, cmdIndex, events, sampleRate, channels, f, n, out.data() + static_cast<size_t>(f * channels));
+    }
+  };
+
+  // bounds[j] = state digest at the start of loop j. Feedback paths (delay lines, envelope
+  // followers) may settle into a short cycle of loops instead of a fixed point, so a loop is
+  // matched against the last kMaxCycle loops.
+  constexpr uint32_t kMaxCycle = 8;
+  const size_t loopSamples = static_cast<size_t>(loopFrames * channels);
+  std::vector<uint64_t> bounds(static_cast<size_t>(loops) + 1, 0);
+  bounds[0] = start.value();
+  uint32_t cycle = 0; // > 0: loop j repeats loop j - cycle while the commands do
+  uint64_t pos = 0;
+  for (uint32_t j = 0; j < loops && pos < frames; ++j, pos += loopFrames) {
+    const uint64_t end = std::min<uint64_t>(pos + loopFrames, frames);
+    const bool whole = end - pos == loopFrames;
+    float* dst = out.data() + static_cast<size_t>(pos * channels);
+    if (cycle > 0) {
+      // Copy whole cycles only: the graph itself stays at the state of loop j, which is also the
+      // state after every whole number of cycles, so the next rendered loop continues exactly
+      uint32_t run = 0;
+      while (j + run < loops && (j + run + 1) * loopFrames <= frames && sameWindow(j + run - cycle, j + run)) ++run;
+      run -= run % cycle;
+      for (uint32_t i = 0; i < run; ++i) {
+        float* d = dst + i * loopSamples;
+        std::memcpy(d, d - cycle * loopSamples, loopSamples * sizeof(float));
+        bounds[j + i + 1] = bounds[j + i + 1 - cycle];
+      }
+      cycle = 0;
+      if (run > 0) {
+        cmdIndex = windowBegin[j + run];
+        st.copied += run;
+        j += run - 1; pos += static_cast<uint64_t>(run - 1) * loopFrames;
+        continue;
+      }
+    }
+    renderSpan(pos, end);
+    ++st.rendered;
+    StateHash h;
+    graph.hashState(h);
+    bounds[j + 1] = h.value();
+    // Converged with period p: the state is back where it was p loops ago, and this loop's
+    // commands and output equal those of the loop p back
+    for (uint32_t p = 1; whole && p <= std::min(j, kMaxCycle); ++p) {
+      if (bounds[j + 1] != bounds[j + 1 - p] || !sameWindow(j - p, j)) continue;
+      if (std::memcmp(dst, dst - p * loopSamples, loopSamples * sizeof(float)) != 0) continue;
+      cycle = p;
+      break;
+    }
+  }
+  if (pos < frames) renderSpan(pos, frames);
+
+  if (gOfflineSummaryEnabled) {
+    const double sec = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - tStart).count()) / 1e9;
+    const double rtSec = static_cast<double>(frames) / static_cast<double>(sampleRate);
+    std::fprintf(stderr, "[offline-loop] %u loops rendered, %u copied; done in %.3fs (speedup %.1fx)\n",
+                 st.rendered, st.copied, sec, sec > 0.0 ? rtSec / sec : 0.0);
+  }
+  if (stats) *stats = st;
+  return out;
+}
+
+inline std::vector<float> renderGraphWithCommandsLooped(Graph& graph,
+                                                        const std::vector<GraphSpec::CommandSpec>& cmds,
+                                                        uint32_t sampleRate,
+                                                        uint32_t channels,
+                                                        uint64_t frames,
+                                                        uint64_t loopFrames,
+                                                        uint32_t loops,
+                                                        LoopRenderStats* stats = nullptr) {
+  return renderGraphWithSortedCommandsLooped(graph, sortedCommands(cmds), sampleRate, channels, frames, loopFrames, loops, stats);
+}
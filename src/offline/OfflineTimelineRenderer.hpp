@@ -3,86 +3,110 @@
 #include <vector>
 #include <algorithm>
 #include <cstdint>
+#include <initializer_list>
 #include <string>
 #include "../core/Graph.hpp"
 #include "OfflineProgress.hpp"
 #include "../core/GraphConfig.hpp"
 #include "../core/Command.hpp"
 
-inline std::vector<float> renderGraphWithCommands(Graph& graph,
-                                                  const std::vector<GraphSpec::CommandSpec>& cmds,
-                                                  uint32_t sampleRate,
-                                                  uint32_t channels,
-                                                  uint64_t frames) {
+// Engine command for a command spec delivered in a block starting at blockStart (late commands
+// are clamped to it); false for unknown types
+inline bool commandFromSpec(const GraphSpec::CommandSpec& cs, uint64_t blockStart, Command& c) {
+  c = Command{}; c.sampleTime = std::max<uint64_t>(cs.sampleTime, blockStart); c.nodeId = cs.nodeId.c_str();
+  if (cs.type == std::string("SetParam")) c.type = CommandType::SetParam;
+  else if (cs.type == std::string("SetParamRamp")) c.type = CommandType::SetParamRamp;
+  else if (cs.type == std::string("Trigger")) c.type = CommandType::Trigger;
+  else return false;
+  c.paramId = c.type == CommandType::Trigger ? 0 : cs.paramId; c.value = cs.value;
+  c.rampMs = c.type == CommandType::Trigger ? 0.0f : cs.rampMs;
+  return true;
+}
+
+// Context for the block [blockStart, blockStart + frames) with commands[cmdIndex..] that fall
+// before its end as events (stored in events); commands are sorted by time
+inline ProcessContext commandBlockContext(const std::vector<GraphSpec::CommandSpec>& commands, size_t& cmdIndex,
+                                          std::vector<Command>& events, uint32_t sampleRate,
+                                          uint64_t blockStart, uint32_t frames) {
+  const uint64_t cutoff = blockStart + frames;
+  events.clear();
+  for (; cmdIndex < commands.size() && commands[cmdIndex].sampleTime < cutoff; ++cmdIndex) {
+    Command c{};
+    if (commandFromSpec(commands[cmdIndex], blockStart, c)) events.push_back(c);
+  }
+  sortEvents(events.data(), events.data() + events.size());
+  ProcessContext ctx{}; ctx.sampleRate = sampleRate; ctx.frames = frames; ctx.blockStart = blockStart;
+  ctx.events = events.data(); ctx.eventCount = static_cast<uint32_t>(events.size());
+  return ctx;
+}
+
+// Render one block [blockStart, blockStart + frames) into out (the block's first frame),
+// delivering commands[cmdIndex..] that fall before its end; commands are sorted by time.
+// The graph hands each node its own event span, so the block is processed once.
+inline void renderCommandBlock(Graph& graph, const std::vector<GraphSpec::CommandSpec>& commands, size_t& cmdIndex,
+                               std::vector<Command>& events, uint32_t sampleRate, uint32_t channels,
+                               uint64_t blockStart, uint32_t frames, float* out) {
+  graph.process(commandBlockContext(commands, cmdIndex, events, sampleRate, blockStart, frames), out, channels);
+}
+
+// Copy of cmds sorted by time; equal times keep their given order
+inline std::vector<GraphSpec::CommandSpec> sortedCommands(const std::vector<GraphSpec::CommandSpec>& cmds) {
+  std::vector<GraphSpec::CommandSpec> commands = cmds;
+  std::stable_sort(commands.begin(), commands.end(), [](const auto& a, const auto& b){ return a.sampleTime < b.sampleTime; });
+  return commands;
+}
+
+// K-way merge of command streams that are each sorted by time. Equal times keep stream order
+// (then their order within the stream), the same result as stable-sorting the concatenation.
+inline std::vector<GraphSpec::CommandSpec> mergeCommandStreams(std::initializer_list<const std::vector<GraphSpec::CommandSpec>*> streams) {
+  std::vector<const std::vector<GraphSpec::CommandSpec>*> in(streams);
+  std::vector<size_t> pos(in.size(), 0);
+  size_t total = 0;
+  for (const auto* st : in) total += st->size();
+  std::vector<GraphSpec::CommandSpec> out;
+  out.reserve(total);
+  while (out.size() < total) {
+    size_t best = in.size();
+    for (size_t k = 0; k < in.size(); ++k) {
+      if (pos[k] == in[k]->size()) continue;
+      if (best == in.size() || (*in[k])[pos[k]].sampleTime < (*in[best])[pos[best]].sampleTime) best = k;
+    }
+    // Take the whole run of the winning stream up to the next stream's head
+    uint64_t limit = UINT64_MAX;
+    for (size_t k = 0; k < in.size(); ++k) {
+      if (k == best || pos[k] == in[k]->size()) continue;
+      const uint64_t t = (*in[k])[pos[k]].sampleTime;
+      limit = std::min(limit, k < best ? t : t + 1);
+    }
+    const auto& src = *in[best];
+    size_t end = pos[best];
+    while (end < src.size() && src[end].sampleTime < limit) ++end;
+    out.insert(out.end(), src.begin() + static_cast<std::ptrdiff_t>(pos[best]), src.begin() + static_cast<std::ptrdiff_t>(end));
+    pos[best] = end;
+  }
+  return out;
+}
+
+// As renderGraphWithCommands for commands already sorted by time (sortedCommands, mergeCommandStreams)
+inline std::vector<float> renderGraphWithSortedCommands(Graph& graph,
+                                                        const std::vector<GraphSpec::CommandSpec>& commands,
+                                                        uint32_t sampleRate,
+                                                        uint32_t channels,
+                                                        uint64_t frames) {
   graph.prepare(sampleRate, 1024);
   graph.reset();
 
   std::vector<float> out;
   out.resize(static_cast<size_t>(frames * channels), 0.0f);
 
-  // Copy and sort commands by time
-  std::vector<GraphSpec::CommandSpec> commands = cmds;
-  std::sort(commands.begin(), commands.end(), [](const auto& a, const auto& b){ return a.sampleTime < b.sampleTime; });
-
   const uint32_t block = 1024;
   const auto tStart = std::chrono::steady_clock::now();
   uint64_t processed = 0; (void)processed;
   size_t cmdIndex = 0;
+  std::vector<Command> events;
   for (uint64_t f = 0; f < frames; f += block) {
     const uint32_t thisBlock = static_cast<uint32_t>(std::min<uint64_t>(block, frames - f));
-    const uint64_t blockStart = f;
-    const uint64_t cutoff = f + thisBlock;
-
-    // Split offsets within block based on command times
-    std::vector<uint32_t> splits;
-    splits.reserve(8);
-    splits.push_back(0);
-    size_t idx = cmdIndex;
-    while (idx < commands.size() && commands[idx].sampleTime < cutoff) {
-      if (commands[idx].sampleTime >= blockStart) {
-        splits.push_back(static_cast<uint32_t>(commands[idx].sampleTime - blockStart));
-      }
-      ++idx;
-    }
-    splits.push_back(thisBlock);
-    std::sort(splits.begin(), splits.end());
-    splits.erase(std::unique(splits.begin(), splits.end()), splits.end());
-
-    // Process segments
-    for (size_t si = 0; si + 1 < splits.size(); ++si) {
-      const uint32_t segStart = splits[si];
-      const uint32_t segEnd = splits[si + 1];
-      const uint32_t segFrames = segEnd - segStart;
-      if (segFrames == 0) continue;
-
-      const uint64_t segAbs = blockStart + segStart;
-
-      // Deliver events exactly at segAbs
-      size_t di = cmdIndex;
-      while (di < commands.size() && commands[di].sampleTime < segAbs) ++di;
-      // 1) Apply SetParam/SetParamRamp first
-      for (size_t dj = di; dj < commands.size() && commands[dj].sampleTime == segAbs; ++dj) {
-        if (commands[dj].type != std::string("SetParam") && commands[dj].type != std::string("SetParamRamp")) continue;
-        Command c{}; c.sampleTime = segAbs; c.nodeId = commands[dj].nodeId.c_str();
-        c.type = (commands[dj].type == std::string("SetParam")) ? CommandType::SetParam : CommandType::SetParamRamp;
-        c.paramId = commands[dj].paramId; c.value = commands[dj].value; c.rampMs = commands[dj].rampMs;
-        graph.forEachNode([&](const std::string& id, Node& n){ if (c.nodeId && id == c.nodeId) n.handleEvent(c); });
-      }
-      // 2) Then apply Triggers
-      for (size_t dj = di; dj < commands.size() && commands[dj].sampleTime == segAbs; ++dj) {
-        if (commands[dj].type != std::string("Trigger")) continue;
-        Command c{}; c.sampleTime = segAbs; c.nodeId = commands[dj].nodeId.c_str();
-        c.type = CommandType::Trigger; c.paramId = 0; c.value = commands[dj].value; c.rampMs = 0.0f;
-        graph.forEachNode([&](const std::string& id, Node& n){ if (c.nodeId && id == c.nodeId) n.handleEvent(c); });
-      }
-
-      ProcessContext ctx{}; ctx.sampleRate = sampleRate; ctx.frames = segFrames; ctx.blockStart = segAbs;
-      float* outPtr = out.data() + static_cast<size_t>((blockStart + segStart) * channels);
-      graph.process(ctx, outPtr, channels);
-    }
-
-    // Advance cmdIndex beyond this block
-    while (cmdIndex < commands.size() && commands[cmdIndex].sampleTime < cutoff) ++cmdIndex;
+    renderCommandBlock(graph, commands, cmdIndex, events, sampleRate, channels, f, thisBlock, out.data() + static_cast<size_t>(f * channels));
     processed += block;
     if (gOfflineProgressEnabled && gOfflineProgressMs > 0) {
       static auto last = tStart; const auto now = std::chrono::steady_clock::now();
@@ -102,4 +126,11 @@ inline std::vector<float> renderGraphWithCommands(Graph& graph,
   return out;
 }
 
+inline std::vector<float> renderGraphWithCommands(Graph& graph,
+                                                  const std::vector<GraphSpec::CommandSpec>& cmds,
+                                                  uint32_t sampleRate,
+                                                  uint32_t channels,
+                                                  uint64_t frames) {
+  return renderGraphWithSortedCommands(graph, sortedCommands(cmds), sampleRate, channels, frames);
+}
 
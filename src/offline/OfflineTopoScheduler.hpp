@@ -15,6 +15,7 @@
 #include "../core/DelayNode.hpp"
 #include "../core/CompressorNode.hpp"
 #include "../core/MeterNode.hpp"
+#include "../core/WiretapNode.hpp"
 
 // Scaffold: A minimal topological scheduler for offline rendering.
 // Current Graph has no explicit edges; this placeholder processes nodes then applies mixer.
@@ -25,6 +26,10 @@ public:
   void setChannels(uint32_t channels) { channels_ = channels; pool_.setChannels(channels); }
   void setDebug(bool on) { debug_ = on; }
   void setBlockSize(uint32_t bs) { blockSize_ = (bs >= 64u) ? bs : 64u; }
+  // Pool buffers and scheduler scratch (--mem-report)
+  size_t memoryBytes() const {
+    return pool_.memoryBytes() + vectorBytes(nodeBuffers_) + vectorBytes(silent_) + vectorBytes(scSum_) + vectorBytes(ups_) + nestedVectorBytes(nodeEvents_);
+  }
 
   // Render 'frames' samples into interleaved output, using fixed blockSize.
   void render(Graph& graph,
@@ -39,7 +44,7 @@ public:
     graph.reset();
     out.assign(static_cast<size_t>(frames * channels), 0.0f);
 
-    // Timeline-like segmented processing with command delivery, using graph.process for mixing/topology.
+    // Block processing with per-node event spans, using the graph for topology and edge adaptation.
     std::vector<GraphSpec::CommandSpec> commands = cmds;
     std::sort(commands.begin(), commands.end(), [](const auto& a, const auto& b){ return a.sampleTime < b.sampleTime; });
 
@@ -80,126 +85,129 @@ public:
       const uint64_t blockStart = f;
       const uint64_t cutoff = f + thisBlock;
 
-      std::vector<uint32_t> splits; splits.reserve(8);
-      splits.push_back(0);
-      size_t idx = cmdIndex;
-      while (idx < commands.size() && commands[idx].sampleTime < cutoff) {
-        if (commands[idx].sampleTime >= blockStart) splits.push_back(static_cast<uint32_t>(commands[idx].sampleTime - blockStart));
-        ++idx;
+      // Per-node event spans for this block: the block is processed once and only nodes with
+      // events split their own processing (runWithEvents)
+      if (nodeEvents_.size() != graph.nodeCount()) nodeEvents_.assign(graph.nodeCount(), std::vector<Command>());
+      for (auto& v : nodeEvents_) v.clear();
+      for (size_t dj = cmdIndex; dj < commands.size() && commands[dj].sampleTime < cutoff; ++dj) {
+        const auto& cs = commands[dj];
+        auto itN = idToIdx_.find(cs.nodeId);
+        if (itN == idToIdx_.end()) continue;
+        Command c{}; c.sampleTime = std::max<uint64_t>(cs.sampleTime, blockStart); c.nodeId = cs.nodeId.c_str();
+        if (cs.type == std::string("SetParam")) c.type = CommandType::SetParam;
+        else if (cs.type == std::string("SetParamRamp")) c.type = CommandType::SetParamRamp;
+        else if (cs.type == std::string("Trigger")) c.type = CommandType::Trigger;
+        else continue;
+        c.paramId = c.type == CommandType::Trigger ? 0 : cs.paramId; c.value = cs.value;
+        c.rampMs = c.type == CommandType::Trigger ? 0.0f : cs.rampMs;
+        auto& v = nodeEvents_[itN->second];
+        v.push_back(c);
+        for (size_t k = v.size() - 1; k > 0 && eventBefore(v[k], v[k - 1]); --k) std::swap(v[k], v[k - 1]);
       }
-      splits.push_back(thisBlock);
-      std::sort(splits.begin(), splits.end());
-      splits.erase(std::unique(splits.begin(), splits.end()), splits.end());
-
-      for (size_t si = 0; si + 1 < splits.size(); ++si) {
-        const uint32_t segStart = splits[si];
-        const uint32_t segEnd   = splits[si + 1];
-        const uint32_t segFrames = segEnd - segStart;
-        if (segFrames == 0) continue;
-        const uint64_t segAbs = blockStart + segStart;
-
-        size_t di = cmdIndex;
-        while (di < commands.size() && commands[di].sampleTime < segAbs) ++di;
-        // SetParam / SetParamRamp first
-        for (size_t dj = di; dj < commands.size() && commands[dj].sampleTime == segAbs; ++dj) {
-          if (commands[dj].type != std::string("SetParam") && commands[dj].type != std::string("SetParamRamp")) continue;
-          Command c{}; c.sampleTime = segAbs; c.nodeId = commands[dj].nodeId.c_str();
-          c.type = (commands[dj].type == std::string("SetParam")) ? CommandType::SetParam : CommandType::SetParamRamp;
-          c.paramId = commands[dj].paramId; c.value = commands[dj].value; c.rampMs = commands[dj].rampMs;
-          graph.forEachNode([&](const std::string& id, Node& n){ if (c.nodeId && id == c.nodeId) n.handleEvent(c); });
-        }
-        // Triggers
-        for (size_t dj = di; dj < commands.size() && commands[dj].sampleTime == segAbs; ++dj) {
-          if (commands[dj].type != std::string("Trigger")) continue;
-          Command c{}; c.sampleTime = segAbs; c.nodeId = commands[dj].nodeId.c_str(); c.type = CommandType::Trigger; c.paramId = 0; c.value = commands[dj].value; c.rampMs = 0.0f;
-          graph.forEachNode([&](const std::string& id, Node& n){ if (c.nodeId && id == c.nodeId) n.handleEvent(c); });
-        }
 
-        // Execute by topo levels with explicit per-edge accumulation and BufferPool reuse
-        graph.ensureTopology();
-        const size_t totalSamples = static_cast<size_t>(segFrames) * channels;
-        if (nodeBuffers_.size() != graph.nodeCount()) nodeBuffers_.assign(graph.nodeCount(), static_cast<float*>(nullptr));
-        // Acquire/zero output buffers for all nodes for this segment (reuse-aware)
-        for (size_t i = 0; i < graph.nodeCount(); ++i) {
-          auto& buf = pool_.acquire(segFrames);
-          nodeBuffers_[i] = buf.data();
-          std::fill(nodeBuffers_[i], nodeBuffers_[i] + totalSamples, 0.0f);
-          if (debug_) std::fprintf(stderr, "[offline-topo] buf node=%s ptr=%p\n", graph.nodeIdAt(i).c_str(), (void*)nodeBuffers_[i]);
-        }
-        // Per-port sums for current node
-        std::unordered_map<uint32_t, std::vector<float>> portSums;
+      // Execute by topo levels with explicit per-edge accumulation and BufferPool reuse
+      graph.ensureTopology();
+      graph.applyAutomation(blockStart, thisBlock, sampleRate);
+      const size_t totalSamples = static_cast<size_t>(thisBlock) * channels;
+      if (nodeBuffers_.size() != graph.nodeCount()) nodeBuffers_.assign(graph.nodeCount(), static_cast<float*>(nullptr));
+      // Acquire output buffers for all nodes for this block (reuse-aware; the pool hands them out zeroed)
+      for (size_t i = 0; i < graph.nodeCount(); ++i) {
+        auto& buf = pool_.acquire(thisBlock);
+        nodeBuffers_[i] = buf.data();
+        if (debug_) std::fprintf(stderr, "[offline-topo] buf node=%s ptr=%p\n", graph.nodeIdAt(i).c_str(), (void*)nodeBuffers_[i]);
+      }
+      if (scSum_.size() < totalSamples) scSum_.resize(totalSamples);
+      // Nodes that slept this block (see Graph::process): buffer stays zero, edges skipped
+      silent_.assign(graph.nodeCount(), 0u);
 
-        // Iterate levels
-        for (const auto& level : levels_) {
-          for (size_t ni : level) {
-            // Build per-port sums from upstream edges
-            portSums.clear();
-            std::vector<Graph::EdgeInfo> ups; graph.getUpstreamEdgeInfos(ni, ups);
-            for (const auto& e : ups) {
-              const float* src = nodeBuffers_[e.fromIndex];
-              auto& dst = portSums[e.toPort]; if (dst.size() != totalSamples) dst.assign(totalSamples, 0.0f);
+      // Iterate levels
+      for (const auto& level : levels_) {
+        for (size_t ni : level) {
+          Node* node = graph.nodeAt(ni);
+          auto* delay = dynamic_cast<DelayNode*>(node);
+          auto* comp = delay ? nullptr : dynamic_cast<CompressorNode*>(node);
+          auto* meter = (delay || comp) ? nullptr : dynamic_cast<MeterNode*>(node);
+          auto* tap = (delay || comp || meter) ? nullptr : dynamic_cast<WiretapNode*>(node);
+          ProcessContext ctx{}; ctx.sampleRate = sampleRate; ctx.frames = thisBlock; ctx.blockStart = blockStart;
+          ctx.events = nodeEvents_[ni].data(); ctx.eventCount = static_cast<uint32_t>(nodeEvents_[ni].size());
+          // Inserts sum port 0 straight into their own buffer and a compressor's port 1 into
+          // scSum_ (the first edge overwrites); generators ignore inputs, so skip the sums
+          bool haveMain = false, haveSc = false;
+          if (delay || comp || meter || tap) {
+            ups_.clear(); graph.getUpstreamEdgeInfos(ni, ups_);
+            for (const auto& e : ups_) {
+              if (silent_[e.fromIndex]) continue;
+              float* dst = nullptr; bool first = false;
+              if (e.toPort == 0u) { dst = nodeBuffers_[ni]; first = !haveMain; haveMain = true; }
+              else if (e.toPort == 1u && comp) { dst = scSum_.data(); first = !haveSc; haveSc = true; }
+              else continue;
               const uint32_t srcDecl = graph.getDeclaredOutChannels(e.fromIndex, e.fromPort);
               const uint32_t dstDecl = graph.getDeclaredInChannels(ni, e.toPort);
-              graph.accumulateEdge(src, dst, segFrames, channels, srcDecl, dstDecl, e.gain);
+              graph.accumulateEdge(nodeBuffers_[e.fromIndex], dst, thisBlock, channels, srcDecl, dstDecl, e.gain, first);
             }
-            // Determine main input (port 0)
-            const float* mainIn = nullptr; if (portSums.count(0u)) mainIn = portSums[0u].data();
-            // Process node
-            Node* node = graph.nodeAt(ni);
-            if (auto* d = dynamic_cast<DelayNode*>(node)) {
+          }
+          if (graph.idleSkip() && !haveMain && !haveSc && ctx.eventCount == 0) {
+            if (meter) meter->updateFromBuffer(nodeBuffers_[ni], thisBlock, channels);
+            if (tap) tap->processInPlace(ctx, nodeBuffers_[ni], channels);
+            if (meter || tap || node->skipIfSilent(ctx)) { silent_[ni] = 1u; continue; }
+          }
+          if (comp && !haveSc) std::fill(scSum_.begin(), scSum_.begin() + static_cast<std::ptrdiff_t>(totalSamples), 0.0f);
+          const bool generator = !delay && !comp && !meter && !tap;
+          bool ran = false;
+          runWithEvents(*node, ctx, [&](ProcessContext sub, uint32_t off) {
+            // Generators may still sleep through the runs between their events
+            if (generator && ctx.eventCount > 0 && graph.idleSkip() && node->skipIfSilent(sub)) return;
+            float* buf = nodeBuffers_[ni] + static_cast<size_t>(off) * channels;
+            if (delay) {
               // in-place over input
-              if (mainIn) std::copy(portSums[0u].begin(), portSums[0u].end(), nodeBuffers_[ni]);
-              ProcessContext ctx{}; ctx.sampleRate = sampleRate; ctx.frames = segFrames; ctx.blockStart = segAbs;
-              d->processInPlace(ctx, nodeBuffers_[ni], channels);
-            } else if (auto* c = dynamic_cast<CompressorNode*>(node)) {
-              if (mainIn) std::copy(portSums[0u].begin(), portSums[0u].end(), nodeBuffers_[ni]);
-              std::vector<float> sc; sc.assign(totalSamples, 0.0f);
-              auto itSC = portSums.find(1u); if (itSC != portSums.end()) sc = itSC->second;
-              ProcessContext ctx{}; ctx.sampleRate = sampleRate; ctx.frames = segFrames; ctx.blockStart = segAbs;
-              c->applySidechain(ctx, nodeBuffers_[ni], sc.data(), channels);
-            } else if (auto* m = dynamic_cast<MeterNode*>(node)) {
-              if (mainIn) std::copy(portSums[0u].begin(), portSums[0u].end(), nodeBuffers_[ni]);
-              ProcessContext ctx{}; ctx.sampleRate = sampleRate; ctx.frames = segFrames; ctx.blockStart = segAbs;
-              m->updateFromBuffer(nodeBuffers_[ni], segFrames, channels);
+              delay->processInPlace(sub, buf, channels);
+            } else if (comp) {
+              comp->applySidechain(sub, buf, scSum_.data() + static_cast<size_t>(off) * channels, channels);
+            } else if (meter) {
+              meter->updateFromBuffer(buf, sub.frames, channels);
+            } else if (tap) {
+              tap->processInPlace(sub, buf, channels);
             } else {
               // Generators or nodes that ignore inputs
-              ProcessContext ctx{}; ctx.sampleRate = sampleRate; ctx.frames = segFrames; ctx.blockStart = segAbs;
-              node->process(ctx, nodeBuffers_[ni], channels);
+              node->process(sub, buf, channels);
             }
-          }
+            ran = true;
+          });
+          if (!ran) silent_[ni] = 1u;
         }
+      }
 
-        // Mix to output with dry taps and mixer gains; stable connection order
-        float* outPtr = out.data() + static_cast<size_t>((blockStart + segStart) * channels);
-        std::fill(outPtr, outPtr + totalSamples, 0.0f);
-        for (const auto& e : stableConns_) {
-          // dry tap suppression if present in mixer
-          const size_t fromIdx = idToIdx_.count(e.from) ? idToIdx_[e.from] : static_cast<size_t>(-1);
-          if (fromIdx == static_cast<size_t>(-1)) continue;
-          const float dry = e.dryPercent * (1.0f/100.0f);
-          if (dry <= 0.0f) continue;
-          if (graph.mixerGainForId(e.from) > 0.0f) continue;
-          const float* src = nodeBuffers_[fromIdx];
-          for (size_t i = 0; i < totalSamples; ++i) outPtr[i] += src[i] * dry;
-        }
-        for (size_t mi = 0; mi < graph.nodeCount(); ++mi) {
-          float gain = graph.mixerGainForId(graph.nodeIdAt(mi));
-          if (gain == 0.0f && (isSink_.size()==graph.nodeCount() ? isSink_[mi] : true)) gain = 1.0f;
-          if (gain == 0.0f) continue;
-          const float* src = nodeBuffers_[mi];
-          for (size_t i = 0; i < totalSamples; ++i) outPtr[i] += src[i] * gain;
-        }
-        if (graph.hasMixer()) {
-          const float master = graph.mixerMasterGain();
-          if (master != 1.0f) for (size_t i=0;i<totalSamples;++i) outPtr[i] *= master;
-          if (graph.mixerSoftClipEnabled()) {
-            for (size_t i=0;i<totalSamples;++i) outPtr[i] = std::tanh(outPtr[i]);
-          }
+      // Mix to output with dry taps and mixer gains; stable connection order
+      float* outPtr = out.data() + static_cast<size_t>(blockStart * channels);
+      std::fill(outPtr, outPtr + totalSamples, 0.0f);
+      for (const auto& e : stableConns_) {
+        // dry tap suppression if present in mixer
+        const size_t fromIdx = idToIdx_.count(e.from) ? idToIdx_[e.from] : static_cast<size_t>(-1);
+        if (fromIdx == static_cast<size_t>(-1)) continue;
+        const float dry = e.dryPercent * (1.0f/100.0f);
+        if (dry <= 0.0f || silent_[fromIdx]) continue;
+        if (graph.mixerGainForId(e.from) > 0.0f) continue;
+        const float* src = nodeBuffers_[fromIdx];
+        for (size_t i = 0; i < totalSamples; ++i) outPtr[i] += src[i] * dry;
+      }
+      for (size_t mi = 0; mi < graph.nodeCount(); ++mi) {
+        float gain = graph.mixerGainForId(graph.nodeIdAt(mi));
+        if (gain == 0.0f && (isSink_.size()==graph.nodeCount() ? isSink_[mi] : true)) gain = 1.0f;
+        if (gain == 0.0f || silent_[mi]) continue;
+        const float* src = nodeBuffers_[mi];
+        for (size_t i = 0; i < totalSamples; ++i) outPtr[i] += src[i] * gain;
+      }
+      if (graph.hasMixer()) {
+        const float master = graph.mixerMasterGain();
+        if (master != 1.0f) for (size_t i=0;i<totalSamples;++i) outPtr[i] *= master;
+        if (graph.mixerSoftClipEnabled()) {
+          for (size_t i=0;i<totalSamples;++i) outPtr[i] = std::tanh(outPtr[i]);
         }
-
-        // Release node buffers (eligible for reuse next segment)
-        for (size_t i = 0; i < graph.nodeCount(); ++i) pool_.release(nodeBuffers_[i]);
       }
+
+      // Release node buffers (eligible for reuse next block)
+      for (size_t i = 0; i < graph.nodeCount(); ++i) pool_.release(nodeBuffers_[i]);
+
       while (cmdIndex < commands.size() && commands[cmdIndex].sampleTime < cutoff) ++cmdIndex;
 
       if (gOfflineProgressEnabled && gOfflineProgressMs > 0) {
@@ -281,6 +289,10 @@ private:
   uint32_t channels_ = 2;
   uint32_t blockSize_ = 1024;
   std::vector<float*> nodeBuffers_{};
+  std::vector<uint8_t> silent_{};
+  std::vector<float> scSum_{};
+  std::vector<Graph::EdgeInfo> ups_{};
+  std::vector<std::vector<Command>> nodeEvents_{};
   std::vector<bool> isSink_{};
   std::vector<GraphSpec::Connection> stableConns_{};
 };
@@ -100,4 +100,11 @@ inline std::vector<GraphSpec::CommandSpec> generateCommandsFromTransport(const G
   return out;
 }
 
-
+// Frames spanned by `bars` bars of a transport without tempo ramps. The generator advances whole
+// steps, so a bar lasts stepsPerBar * (framesPerBar / stepsPerBar) frames. 0 when the tempo ramps.
+inline uint64_t transportLoopFrames(const GraphSpec::Transport& tr, uint32_t sampleRate, uint32_t bars) {
+  if (!tr.tempoRamps.empty() || tr.bpm <= 0.0) return 0;
+  const uint32_t stepsPerBar = tr.resolution ? tr.resolution : 16u;
+  const uint64_t framesPerBar = static_cast<uint64_t>(4.0 * (60.0 / tr.bpm) * sampleRate + 0.5);
+  return (framesPerBar / stepsPerBar) * stepsPerBar * static_cast<uint64_t>(bars);
+}
@@ -14,6 +14,7 @@
 #include <algorithm>
 #include <atomic>
 #include "../core/TransportNode.hpp"
+#include "Telemetry.hpp"
 
 class RealtimeGraphRenderer {
 public:
@@ -21,6 +22,10 @@ public:
   ~RealtimeGraphRenderer() { stop(); }
 
   void setCommandQueue(SpscCommandQueue<2048>* q) { cmdQueue_ = q; }
+  // Second producer path for live input (e.g. MIDI bridge); late events are applied at block start
+  template <size_t N>
+  void setLiveCommandQueue(SpscCommandQueue<N>* q) { liveQueue_ = reinterpret_cast<void*>(q); liveDrain_ = [](void* p, SampleTime cutoff, std::vector<Command>& out){ static_cast<SpscCommandQueue<N>*>(p)->drainUpTo(cutoff, out); }; }
+  uint64_t liveLateEvents() const noexcept { return liveLate_.load(std::memory_order_relaxed); }
   void setCmdQueueDebug(bool enabled) { queueDiag_ = enabled; }
   void setDiagnostics(bool printTriggers, double bpmForBeats, uint32_t resolutionStepsPerBar) {
     printTriggers_ = printTriggers; diagBpm_ = bpmForBeats; diagResolution_ = (resolutionStepsPerBar == 0 ? 16u : resolutionStepsPerBar);
@@ -31,6 +36,7 @@ public:
   void start(Graph& graph, double requestedSampleRate, uint32_t channels) {
     if (channels == 0) throw std::invalid_argument("channels must be > 0");
     graph_ = &graph;
+    graph_->setRealtime(true);
     channels_ = channels;
 
     AudioComponentDescription desc{};
@@ -79,6 +85,10 @@ public:
       sampleRate_ = requestedSampleRate;
     }
 
+    drained_.reserve(4096);
+    // Trigger and queue diagnostics are formatted and printed off the audio thread
+    if (printTriggers_ || queueDiag_) telemetry_.start([this](const TelemetryRecord& r) { writeTelemetry(r); });
+
     err = AudioOutputUnitStart(unit_.get());
     if (err != noErr) throw std::runtime_error(std::string("AudioOutputUnitStart failed: ") + osstatusToString(err));
     sampleCounter_ = 0;
@@ -86,7 +96,13 @@ public:
 
   void stop() {
     unit_.release();
+    telemetry_.stop();
+    if (telemetry_.dropped() > 0) {
+      std::fprintf(stderr, "Telemetry: records=%llu dropped=%llu\n", static_cast<unsigned long long>(telemetry_.records()), static_cast<unsigned long long>(telemetry_.dropped()));
+    }
   }
+  // Telemetry records lost because the writer thread fell behind
+  uint64_t telemetryDropped() const noexcept { return telemetry_.dropped(); }
 
   double sampleRate() const noexcept { return sampleRate_; }
   SampleTime sampleCounter() const noexcept { return sampleCounter_.load(std::memory_order_relaxed); }
@@ -97,7 +113,7 @@ private:
     // Interleaved: single buffer expected
     float* interleaved = static_cast<float*>(ioData->mBuffers[0].mData);
 
-    // Compute split points for sample-accurate event application
+    // Block range; events inside it reach each node at their exact sample offset
     const SampleTime blockStartAbs = self->sampleCounter_.load(std::memory_order_relaxed);
     const SampleTime cutoff = blockStartAbs + static_cast<SampleTime>(inNumberFrames);
     // Print loop boundary if it falls at block start or anywhere within this block,
@@ -107,109 +123,86 @@ private:
       if (L > 0) {
         const uint64_t start = static_cast<uint64_t>(blockStartAbs);
         const uint64_t end = static_cast<uint64_t>(cutoff);
+        TelemetryRecord r; r.kind = TelemetryRecord::Kind::Loop;
         if ((start % L) == 0ull) {
-          const uint64_t loopIdx = start / L;
-          std::fprintf(stderr, "Loop %llu\n", static_cast<unsigned long long>(loopIdx));
+          r.u = start / L;
+          self->telemetry_.push(r);
         } else if (end > start) {
           const uint64_t next = ((start + L - 1ull) / L) * L; // first multiple in [start, ∞)
           if (next >= start && next < end) {
-            const uint64_t loopIdx = next / L;
-            std::fprintf(stderr, "Loop %llu\n", static_cast<unsigned long long>(loopIdx));
+            r.u = next / L;
+            self->telemetry_.push(r);
           }
         }
       }
     }
-    std::vector<uint32_t> splitOffsets;
-    splitOffsets.reserve(8);
-    splitOffsets.push_back(0);
-    if (self->cmdQueue_) {
-      self->drained_.clear();
-      self->cmdQueue_->drainUpTo(cutoff, self->drained_);
+    self->drained_.clear();
+    if (self->cmdQueue_ || self->liveQueue_) {
+      if (self->cmdQueue_) self->cmdQueue_->drainUpTo(cutoff, self->drained_);
+      if (self->liveQueue_) {
+        const size_t first = self->drained_.size();
+        self->liveDrain_(self->liveQueue_, cutoff, self->drained_);
+        for (size_t i = first; i < self->drained_.size(); ++i) {
+          if (self->drained_[i].sampleTime < blockStartAbs) {
+            self->drained_[i].sampleTime = blockStartAbs;
+            self->liveLate_.fetch_add(1, std::memory_order_relaxed);
+          }
+        }
+      }
       if (self->queueDiag_) {
-        std::fprintf(stderr, "[rt] drained %zu events up to %llu (block %llu..%llu)\n",
-          self->drained_.size(),
-          static_cast<unsigned long long>(cutoff),
-          static_cast<unsigned long long>(blockStartAbs),
-          static_cast<unsigned long long>(cutoff));
+        TelemetryRecord r; r.kind = TelemetryRecord::Kind::Drained; r.u = self->drained_.size(); r.t = blockStartAbs; r.t2 = cutoff;
+        self->telemetry_.push(r);
       }
-        // Sort events to stabilize segment splits and de-duplicate identical ones on the same sample
-        std::sort(self->drained_.begin(), self->drained_.end(), [](const Command& a, const Command& b){
-          if (a.sampleTime != b.sampleTime) return a.sampleTime < b.sampleTime;
-          if (a.nodeId != b.nodeId) return std::strcmp(a.nodeId ? a.nodeId : "", b.nodeId ? b.nodeId : "") < 0;
-          if (a.type != b.type) return a.type < b.type;
-          if (a.paramId != b.paramId) return a.paramId < b.paramId;
-          return a.value < b.value;
-        });
-        self->drained_.erase(std::unique(self->drained_.begin(), self->drained_.end(), [](const Command& x, const Command& y){
-          return x.sampleTime == y.sampleTime && x.nodeId && y.nodeId && std::strcmp(x.nodeId, y.nodeId) == 0 && x.type == y.type && x.paramId == y.paramId && x.value == y.value && x.rampMs == y.rampMs;
-        }), self->drained_.end());
-      for (const Command& c : self->drained_) {
-        if (c.sampleTime >= blockStartAbs && c.sampleTime < cutoff) {
-          const uint32_t off = static_cast<uint32_t>(c.sampleTime - blockStartAbs);
-          splitOffsets.push_back(off);
-        }
+      // Sort events and de-duplicate identical ones on the same sample
+      std::sort(self->drained_.begin(), self->drained_.end(), [](const Command& a, const Command& b){
+        if (a.sampleTime != b.sampleTime) return a.sampleTime < b.sampleTime;
+        if (a.nodeId != b.nodeId) return std::strcmp(a.nodeId ? a.nodeId : "", b.nodeId ? b.nodeId : "") < 0;
+        if (a.type != b.type) return a.type < b.type;
+        if (a.paramId != b.paramId) return a.paramId < b.paramId;
+        return a.value < b.value;
+      });
+      self->drained_.erase(std::unique(self->drained_.begin(), self->drained_.end(), [](const Command& x, const Command& y){
+        return x.sampleTime == y.sampleTime && x.nodeId && y.nodeId && std::strcmp(x.nodeId, y.nodeId) == 0 && x.type == y.type && x.paramId == y.paramId && x.value == y.value && x.rampMs == y.rampMs;
+      }), self->drained_.end());
+      self->drained_.erase(std::remove_if(self->drained_.begin(), self->drained_.end(), [](const Command& c){ return c.nodeId == nullptr; }), self->drained_.end());
+      // Late queue events are applied at block start
+      for (Command& c : self->drained_) if (c.sampleTime < blockStartAbs) c.sampleTime = blockStartAbs;
+      sortEvents(self->drained_.data(), self->drained_.data() + self->drained_.size());
+      if (self->printTriggers_) {
+        for (const Command& c : self->drained_) self->pushEvent(c.type == CommandType::Trigger ? "TRIGGER" : (c.type == CommandType::SetParam ? "SET" : "RAMP"), c);
       }
-      self->sampleCounter_.store(cutoff, std::memory_order_relaxed);
-    } else {
-      self->sampleCounter_.store(cutoff, std::memory_order_relaxed);
     }
-    splitOffsets.push_back(inNumberFrames);
-    std::sort(splitOffsets.begin(), splitOffsets.end());
-    splitOffsets.erase(std::unique(splitOffsets.begin(), splitOffsets.end()), splitOffsets.end());
-
-    // Render each segment and apply events at boundaries
-    for (size_t si = 0; si + 1 < splitOffsets.size(); ++si) {
-      const uint32_t segStart = splitOffsets[si];
-      const uint32_t segEnd = splitOffsets[si + 1];
-      const uint32_t segFrames = segEnd - segStart;
-      if (segFrames == 0) continue;
-
-      // Deliver events that occur exactly at this segment start
-      if (self->cmdQueue_ && !self->drained_.empty()) {
-        const SampleTime segAbsStart = blockStartAbs + static_cast<SampleTime>(segStart);
-        // 1) Apply SetParam/SetParamRamp first (latch values before triggers), matching offline
-        for (const Command& c : self->drained_) {
-          if (c.sampleTime == segAbsStart && c.nodeId && (c.type == CommandType::SetParam || c.type == CommandType::SetParamRamp)) {
-            if (self->printTriggers_) self->printEvent(c.type == CommandType::SetParam ? "SET" : "RAMP", c);
-            self->graph_->forEachNode([&](const std::string& id, Node& n){ if (id == c.nodeId) n.handleEvent(c); });
-          }
-        }
-        // 2) Then apply Triggers
-        for (const Command& c : self->drained_) {
-          if (c.sampleTime == segAbsStart && c.nodeId && c.type == CommandType::Trigger) {
-            if (self->printTriggers_) self->printEvent("TRIGGER", c);
-            self->graph_->forEachNode([&](const std::string& id, Node& n){ if (id == c.nodeId) n.handleEvent(c); });
-          }
-        }
-      }
+    self->sampleCounter_.store(cutoff, std::memory_order_relaxed);
 
-      // Let transport-like nodes emit events at exact sample offsets across the whole segment
+    // Let transport-like nodes emit events at exact sample offsets across the whole block
+    if (self->transportEmitEnabled_) {
       self->graph_->forEachNode([&](const std::string& id, Node& n){
         (void)id;
-        if (self->transportEmitEnabled_) if (auto* t = dynamic_cast<TransportNode*>(&n)) {
-          SampleTime cursor = blockStartAbs + static_cast<SampleTime>(segStart);
-          const SampleTime segAbsEnd = blockStartAbs + static_cast<SampleTime>(segEnd);
-          // Emit all events at or after cursor; if next event is before cursor (wrap), allow it on the boundary to avoid missing step 0
+        if (auto* t = dynamic_cast<TransportNode*>(&n)) {
+          SampleTime cursor = blockStartAbs;
           while (true) {
             const SampleTime next = t->nextEventSample();
             if (next < cursor) break; // already emitted earlier in this block
-            if (next >= segAbsEnd) break;
+            if (next >= cutoff) break;
             t->emitIfMatch(next, [&](const Command& c){
-              if (self->printTriggers_) self->printEvent("TRANSPORT", c);
-              self->graph_->forEachNode([&](const std::string& nid, Node& nn){ if (nid == c.nodeId) nn.handleEvent(c); });
+              if (self->printTriggers_) self->pushEvent("TRANSPORT", c);
+              if (c.nodeId) self->drained_.push_back(c);
             });
             cursor = next + 1;
           }
         }
       });
-
-      ProcessContext ctx{};
-      ctx.sampleRate = self->sampleRate_;
-      ctx.frames = segFrames;
-      ctx.blockStart = blockStartAbs + static_cast<SampleTime>(segStart);
-      float* outPtr = interleaved + static_cast<size_t>(segStart) * self->channels_;
-      self->graph_->process(ctx, outPtr, self->channels_);
     }
+
+    // One graph pass per callback: each node gets its own event span and splits only itself
+    sortEvents(self->drained_.data(), self->drained_.data() + self->drained_.size());
+    ProcessContext ctx{};
+    ctx.sampleRate = self->sampleRate_;
+    ctx.frames = inNumberFrames;
+    ctx.blockStart = blockStartAbs;
+    ctx.events = self->drained_.data();
+    ctx.eventCount = static_cast<uint32_t>(self->drained_.size());
+    self->graph_->process(ctx, interleaved, self->channels_);
     return noErr;
   }
 
@@ -219,6 +212,8 @@ private:
   double sampleRate_ = 48000.0;
   std::atomic<SampleTime> sampleCounter_{0};
   SpscCommandQueue<2048>* cmdQueue_ = nullptr;
+  void* liveQueue_ = nullptr; using DrainFn = void(*)(void*, SampleTime, std::vector<Command>&); DrainFn liveDrain_ = nullptr;
+  std::atomic<uint64_t> liveLate_{0};
   std::vector<Command> drained_;
   bool printTriggers_ = false;
   double diagBpm_ = 120.0;
@@ -226,6 +221,32 @@ private:
   bool transportEmitEnabled_ = false;
   uint64_t diagLoopFrames_ = 0;
   bool queueDiag_ = false;
+  TelemetryWriter telemetry_{};
+
+  void pushEvent(const char* tag, const Command& c) {
+    TelemetryRecord r; r.kind = TelemetryRecord::Kind::Event; r.tag = tag; r.cmd = c;
+    telemetry_.push(r);
+  }
+
+  // Writer thread: print one diagnostics record
+  void writeTelemetry(const TelemetryRecord& r) const {
+    switch (r.kind) {
+      case TelemetryRecord::Kind::Loop:
+        std::fprintf(stderr, "Loop %llu\n", static_cast<unsigned long long>(r.u));
+        break;
+      case TelemetryRecord::Kind::Drained:
+        std::fprintf(stderr, "[rt] drained %llu events up to %llu (block %llu..%llu)\n",
+          static_cast<unsigned long long>(r.u),
+          static_cast<unsigned long long>(r.t2),
+          static_cast<unsigned long long>(r.t),
+          static_cast<unsigned long long>(r.t2));
+        break;
+      case TelemetryRecord::Kind::Event:
+        printEvent(r.tag, r.cmd);
+        break;
+      default: break;
+    }
+  }
 
   void printEvent(const char* tag, const Command& c) const {
     const uint64_t st = c.sampleTime;
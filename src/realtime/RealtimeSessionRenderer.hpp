@@ -11,13 +11,20 @@
 #include <string>
 #include <cstdio>
 #include <chrono>
+#include <thread>
 #include "../core/Graph.hpp"
 #include "../core/ScopedAudioUnit.hpp"
 #include "../core/OsStatusUtils.hpp"
 #include "../core/Command.hpp"
 #include "../core/ParamMap.hpp"
 #include "../session/SessionSpec.hpp"
-#include "../core/SpectralDuckerNode.hpp"
+#include "../session/SessionGraph.hpp"
+#include "../session/RackFreeze.hpp"
+#include "RtWorkerPool.hpp"
+#include "RenderAhead.hpp"
+#include "Telemetry.hpp"
+#include "../instruments/sampler/SampleCache.hpp"
+#include <memory>
 #include <cmath>
 
 class RealtimeSessionRenderer {
@@ -25,9 +32,18 @@ public:
   RealtimeSessionRenderer() = default;
   ~RealtimeSessionRenderer() { stop(); }
 
-  struct Rack { Graph* graph=nullptr; std::string id; float gain=1.0f; bool muted=false; bool solo=false; };
+  // frozen: pre-rendered audio played instead of the graph until "rack:<id>:frozen" is set to 0
+  struct Rack { Graph* graph=nullptr; std::string id; float gain=1.0f; bool muted=false; bool solo=false; const FrozenRack* frozen=nullptr; };
   template <size_t N>
-  void setCommandQueue(SpscCommandQueue<N>* q) { cmdQueue_ = reinterpret_cast<void*>(q); queueDrain_ = [](void* p, SampleTime cutoff, std::vector<Command>& out){ static_cast<SpscCommandQueue<N>*>(p)->drainUpTo(cutoff, out); }; }
+  void setCommandQueue(SpscCommandQueue<N>* q) { cmdQueue_ = reinterpret_cast<void*>(q); queueDrain_ = [](void* p, SampleTime cutoff, std::vector<Command>& out, size_t maxOut){ return static_cast<SpscCommandQueue<N>*>(p)->drainUpTo(cutoff, out, maxOut); }; }
+  // Second producer path for live input (e.g. MIDI bridge); late events are applied at block start
+  template <size_t N>
+  void setLiveCommandQueue(SpscCommandQueue<N>* q) { liveQueue_ = reinterpret_cast<void*>(q); liveDrain_ = [](void* p, SampleTime cutoff, std::vector<Command>& out, size_t maxOut){ return static_cast<SpscCommandQueue<N>*>(p)->drainUpTo(cutoff, out, maxOut); }; }
+  uint64_t liveLateEvents() const noexcept { return liveLate_.load(std::memory_order_relaxed); }
+  // Render independent racks on N realtime worker threads (0 = serial); workers spin spinUs before sleeping
+  void setWorkerPool(uint32_t workers, double spinUs) { poolWorkers_ = workers; poolSpinUs_ = spinUs; }
+  // Render active, non-frozen racks aheadMs ahead of the audio clock on `threads` threads (0 = off)
+  void setAnticipation(double aheadMs, uint32_t threads) { aheadMs_ = aheadMs; aheadThreads_ = threads; }
   void setDiagnostics(bool printTriggers) { printTriggers_ = printTriggers; }
   void setDebug(bool debug) { debug_ = debug; }
   void setMeters(bool enabled, double intervalSec) { metersEnabled_ = enabled; metersIntervalSec_ = (intervalSec > 0.05 ? intervalSec : 1.0); }
@@ -42,36 +58,21 @@ public:
       metricsEnabled_ = false;
     }
   }
-  // Session crossfaders: configure pairs and behavior
+  // Session crossfaders: configure pairs and behavior (resolved against the compiled session graph)
   void setXfaders(const std::vector<SessionSpec::XfaderRef>& xs, const std::vector<Rack>& racks) {
-    auto indexOf = [&](const std::string& id) -> size_t {
-      for (size_t i = 0; i < racks.size(); ++i) if (racks[i].id == id) return i; return SIZE_MAX;
-    };
-    xfaders_.clear();
-    for (const auto& xr : xs) {
-      if (xr.racks.size() < 2) continue;
-      XfaderState st{}; st.id = xr.id;
-      st.aIndex = indexOf(xr.racks[0]);
-      st.bIndex = indexOf(xr.racks[1]);
-      if (st.aIndex == SIZE_MAX || st.bIndex == SIZE_MAX) continue;
-      st.lawEqualPower = (xr.law != std::string("linear"));
-      st.smoothingMs = xr.smoothingMs;
-      st.lfoEnabled = xr.lfo.has;
-      st.freqHz = xr.lfo.freqHz;
-      st.phase01 = xr.lfo.phase01;
-      if (st.lfoEnabled) {
-        const double s = std::sin(2.0 * M_PI * st.phase01);
-        st.x = 0.5 * (s + 1.0);
-        st.xTarget = st.x;
-      } else { st.x = 0.5; st.xTarget = st.x; }
-      st.lastGA = st.lastGB = 1.0;
-      xfaders_.push_back(st);
-    }
+    (void)racks;
+    xfaderRefs_ = xs;
+    if (graphCompiled_) graph_.setXfaders(xfaderRefs_);
   }
 
   void start(const std::vector<Rack>& racks, const std::vector<SessionSpec::BusRef>& buses, const std::vector<SessionSpec::RouteRef>& routes, double requestedSampleRate, uint32_t channels) {
     if (channels == 0) throw std::invalid_argument("channels must be > 0");
     racks_ = racks; buses_ = buses; routes_ = routes; channels_ = channels;
+    std::vector<SessionGraph::RackDesc> descs; descs.reserve(racks_.size());
+    for (const auto& r : racks_) descs.push_back(SessionGraph::RackDesc{r.id, r.gain, r.muted || r.graph == nullptr, r.solo});
+    graph_.compile(descs, buses_, routes_, channels_);
+    graph_.setXfaders(xfaderRefs_);
+    graphCompiled_ = true;
 
     AudioComponentDescription desc{}; desc.componentType = kAudioUnitType_Output; desc.componentSubType = kAudioUnitSubType_DefaultOutput; desc.componentManufacturer = kAudioUnitManufacturer_Apple;
     AudioComponent comp = AudioComponentFindNext(nullptr, &desc);
@@ -95,30 +96,129 @@ public:
     UInt32 size = sizeof(asbd);
     err = AudioUnitGetProperty(unit_.get(), kAudioUnitProperty_StreamFormat, kAudioUnitScope_Input, 0, &asbd, &size);
     sampleRate_ = (err == noErr && asbd.mSampleRate > 0.0) ? asbd.mSampleRate : requestedSampleRate;
-    for (const auto& r : racks_) { if (r.graph) { r.graph->prepare(sampleRate_, 1024); r.graph->reset(); } }
+    for (const auto& r : racks_) { if (r.graph) { r.graph->setRealtime(true); prepareRackGraph(*r.graph); } }
+    graph_.prepare(sampleRate_, kMaxGraphFrames);
+    graph_.reset();
+    pool_.reset();
+    if (poolWorkers_ > 0) {
+      pool_ = std::make_unique<RtWorkerPool>(poolWorkers_, poolSpinUs_, sampleRate_, 512u);
+      std::fprintf(stderr, "[rt-session] worker pool: %u threads, spin %.0f us, %zu parallel racks\n", poolWorkers_, poolSpinUs_, graph_.parallelRackSteps());
+    }
     // Build nodeId -> nodeType map for param name resolution in diagnostics
     nodeTypeById_.clear();
     for (const auto& r : racks_) {
       if (!r.graph) continue;
       r.graph->forEachNode([&](const std::string& id, Node& n){ (void)n; nodeTypeById_[id] = n.name(); });
     }
+    drained_.reserve(kMaxDrained); splits_.reserve(64);
+    ahead_.clear(); ahead_.resize(racks_.size());
+    if (aheadMs_ > 0.0 && aheadThreads_ > 0) {
+      const uint64_t aheadFrames = static_cast<uint64_t>(aheadMs_ * 0.001 * sampleRate_);
+      for (size_t ri = 0; ri < racks_.size(); ++ri) {
+        if (racks_[ri].graph && graph_.rackActive(ri)) ahead_[ri] = std::make_unique<AnticipatedRack>(racks_[ri].graph, channels_, sampleRate_, aheadFrames);
+      }
+    }
+    freeze_ = std::vector<FreezeState>(racks_.size());
+    for (size_t ri = 0; ri < racks_.size(); ++ri) setFrozenRack(ri, racks_[ri].frozen);
     // Prepare meters accumulators
     rackMeters_.assign(racks_.size(), Meter{});
     busMeters_.assign(buses_.size(), Meter{});
     lastMetersPrintSec_ = 0.0;
+    // Meters, metrics and event logs are formatted and written off the audio thread
+    if (printTriggers_ || debug_ || metersEnabled_ || metricsEnabled_) telemetry_.start([this](const TelemetryRecord& r) { writeTelemetry(r); });
 
     // Do not start audio yet; allow caller to enqueue initial commands first.
     sampleCounter_.store(0, std::memory_order_relaxed);
   }
 
+  // Racks render the session graph's chunks whole: prepared, with node buffers sized, for
+  // kMaxGraphFrames so no chunk allocates on the audio thread
+  void prepareRackGraph(Graph& g) {
+    g.prepare(sampleRate_, kMaxGraphFrames);
+    g.reserveBuffers(channels_);
+    g.reset();
+  }
+
+  // Play pre-rendered audio for rack ri (nullptr = live graph only); call after start(), before begin()
+  void setFrozenRack(size_t ri, const FrozenRack* frozen) {
+    if (ri >= racks_.size() || ri >= freeze_.size()) return;
+    racks_[ri].frozen = frozen;
+    if (frozen && racks_[ri].graph) prepareRackGraph(*racks_[ri].graph); // freezing rendered it with its own block size
+    if (frozen && ri < ahead_.size()) ahead_[ri].reset(); // frozen audio is already pre-rendered
+    FreezeState& fz = freeze_[ri];
+    fz.mix = fz.target = frozen ? 1.0f : 0.0f;
+    fz.scratch.assign(frozen ? static_cast<size_t>(kMaxGraphFrames) * channels_ : 0u, 0.0f);
+    fz.held.clear(); fz.held.reserve(frozen ? kFreezeHeldEvents : 0u);
+    fz.graph.store(kGraphLive, std::memory_order_relaxed);
+  }
+
+  // Queue for commands addressed to an anticipated rack's nodes ("<rackId>:<node>"), or nullptr
+  // when the rack renders synchronously. Producers push the rack's timeline here instead of the
+  // session queue; valid from start() until stop().
+  AnticipatedRack::Queue* anticipatedQueue(const char* nodeId) {
+    const size_t ri = aheadRackFor(nodeId);
+    return ri < ahead_.size() ? &ahead_[ri]->queue() : nullptr;
+  }
+
   void begin() {
     if (!unit_.valid()) return;
+    if (std::any_of(racks_.begin(), racks_.end(), [](const Rack& r) { return r.frozen && r.graph; })) {
+      freezeResetRunning_.store(true, std::memory_order_relaxed);
+      freezeResetThread_ = std::thread([this] { freezeResetLoop(); });
+    }
+    std::vector<AnticipatedRack*> anticipated;
+    for (auto& a : ahead_) if (a) anticipated.push_back(a.get());
+    if (!anticipated.empty()) {
+      // Let the workers fill the rings before the first callback (bounded wait)
+      aheadWorkers_.start(anticipated, aheadThreads_);
+      const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+      for (auto* a : anticipated) {
+        while (a->written() < a->aheadFrames() && std::chrono::steady_clock::now() < deadline) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      std::fprintf(stderr, "[rt-session] render-ahead: %zu racks, %.1f ms ahead, %u threads\n", anticipated.size(), aheadMs_, aheadThreads_);
+    }
     OSStatus err = AudioOutputUnitStart(unit_.get());
     if (err != noErr) throw std::runtime_error(std::string("AudioOutputUnitStart failed: ") + osstatusToString(err));
     sampleCounter_.store(0, std::memory_order_relaxed);
   }
 
-  void stop() { if (metricsFile_) { std::fclose(metricsFile_); metricsFile_ = nullptr; } unit_.release(); }
+  void stop() {
+    unit_.release();
+    aheadWorkers_.stop();
+    freezeResetRunning_.store(false, std::memory_order_relaxed);
+    if (freezeResetThread_.joinable()) freezeResetThread_.join();
+    if (drainLimited_.load() > 0 || drainDropped_.load() > 0) {
+      std::fprintf(stderr, "Warning: command drain hit its %zu-event block limit %llu times, dropped %llu handover events\n", kMaxDrained,
+                   static_cast<unsigned long long>(drainLimited_.load()), static_cast<unsigned long long>(drainDropped_.load()));
+    }
+    if (freezeHeldDropped_.load() > 0) {
+      std::fprintf(stderr, "Warning: rack freeze dropped %llu parameter events while resetting a graph\n", static_cast<unsigned long long>(freezeHeldDropped_.load()));
+    }
+    if (aheadFallbacks_.load() > 0 || aheadUnderruns_.load() > 0) {
+      std::fprintf(stderr, "Render-ahead: fallbacks to sync=%llu underrun frames=%llu\n", static_cast<unsigned long long>(aheadFallbacks_.load()),
+                   static_cast<unsigned long long>(aheadUnderruns_.load()));
+    }
+    telemetry_.stop();
+    if (telemetry_.dropped() > 0) {
+      std::fprintf(stderr, "Telemetry: records=%llu dropped=%llu\n", static_cast<unsigned long long>(telemetry_.records()), static_cast<unsigned long long>(telemetry_.dropped()));
+    }
+    if (pool_) {
+      const RtWorkerPool::Stats& st = pool_->totalStats();
+      if (metricsFile_) writePoolMetrics(poolRecord(st).v, "rt_pool_summary", static_cast<double>(sampleCounter()) / sampleRate_);
+      std::fprintf(stderr, "RT pool: blocks=%llu parallel=%llu serial=%llu speedup avg=%.2fx min=%.2fx wake avg=%.1fus max=%.1fus\n",
+                   static_cast<unsigned long long>(st.jobs), static_cast<unsigned long long>(st.parallelJobs), static_cast<unsigned long long>(st.serialJobs),
+                   st.speedupAvg(), st.speedupMin, st.wakeUsAvg(), st.wakeUsMax);
+      pool_.reset();
+    }
+    if (sampleCacheStats().samples.load() > 0) SampleCache::instance().printSummary(stderr);
+    if (metricsFile_) {
+      std::fprintf(metricsFile_, "{\"event\":\"telemetry_summary\",\"records\":%llu,\"dropped\":%llu}\n",
+                   static_cast<unsigned long long>(telemetry_.records()), static_cast<unsigned long long>(telemetry_.dropped()));
+      std::fclose(metricsFile_); metricsFile_ = nullptr;
+    }
+  }
+  // Telemetry records lost because the writer thread fell behind
+  uint64_t telemetryDropped() const noexcept { return telemetry_.dropped(); }
   double sampleRate() const noexcept { return sampleRate_; }
   SampleTime sampleCounter() const noexcept { return sampleCounter_.load(std::memory_order_relaxed); }
   void resetSampleCounter() { sampleCounter_.store(0, std::memory_order_relaxed); }
@@ -131,236 +231,127 @@ private:
     const SampleTime cutoff = blockStartAbs + static_cast<SampleTime>(inNumberFrames);
 
     // Drain commands up to cutoff
-    std::vector<Command> drained; drained.clear();
-    if (self->cmdQueue_) self->queueDrain_(self->cmdQueue_, cutoff, drained);
+    std::vector<Command>& drained = self->drained_; drained.clear();
+    // At most kMaxDrained commands per block (drained_ never grows past its reserve); the rest stay
+    // queued for the next block
+    bool drainedAll = true;
+    if (self->cmdQueue_) drainedAll &= self->queueDrain_(self->cmdQueue_, cutoff, drained, kMaxDrained);
+    if (self->liveQueue_) {
+      const size_t first = drained.size();
+      drainedAll &= self->liveDrain_(self->liveQueue_, cutoff, drained, kMaxDrained);
+      for (size_t i = first; i < drained.size(); ++i) {
+        if (drained[i].sampleTime < blockStartAbs) { drained[i].sampleTime = blockStartAbs; self->liveLate_.fetch_add(1, std::memory_order_relaxed); }
+      }
+      // A live command for an anticipated rack hands its graph back to this thread; until the
+      // worker's checkpoint is reached the command is held
+      size_t keep = first;
+      for (size_t i = first; i < drained.size(); ++i) {
+        const size_t ri = self->aheadRackFor(drained[i].nodeId);
+        AnticipatedRack* a = ri < self->ahead_.size() ? self->ahead_[ri].get() : nullptr;
+        if (a && a->mode != AnticipatedRack::Mode::Sync) {
+          if (a->mode == AnticipatedRack::Mode::Ahead) { a->requestSync(); self->aheadFallbacks_.fetch_add(1, std::memory_order_relaxed); }
+          if (!a->holdLive(drained[i])) self->liveLate_.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        drained[keep++] = drained[i];
+      }
+      drained.resize(keep);
+    }
+    // Racks rendering synchronously again drain their own queue; the switch happens in the block
+    // that reaches the worker's last rendered frame
+    for (auto& ap : self->ahead_) {
+      if (!ap) continue;
+      AnticipatedRack& a = *ap;
+      if (a.mode == AnticipatedRack::Mode::Handing && a.handedOver() && a.written() < cutoff) {
+        a.mode = AnticipatedRack::Mode::Sync;
+        a.syncFrom = std::max<SampleTime>(a.written(), blockStartAbs);
+        for (auto c : a.pending()) {
+          if (drained.size() >= kMaxDrained) { self->drainDropped_.fetch_add(1, std::memory_order_relaxed); continue; }
+          c.sampleTime = std::max<SampleTime>(c.sampleTime, a.syncFrom); drained.push_back(c);
+        }
+        a.pending().clear();
+      }
+      if (a.mode == AnticipatedRack::Mode::Sync) drainedAll &= a.queue().drainUpTo(cutoff, drained, kMaxDrained);
+    }
+    if (!drainedAll) self->drainLimited_.fetch_add(1, std::memory_order_relaxed);
     if (self->debug_) {
-      std::fprintf(stderr, "[rt-session] drained=%zu at t=%.3f..%.3f sec\n",
-                   drained.size(), static_cast<double>(blockStartAbs)/self->sampleRate_, static_cast<double>(cutoff)/self->sampleRate_);
+      TelemetryRecord r; r.kind = TelemetryRecord::Kind::Drained; r.u = drained.size(); r.t = blockStartAbs; r.t2 = cutoff;
+      self->telemetry_.push(r);
     }
+    for (auto& c : drained) if (c.sampleTime < blockStartAbs) c.sampleTime = blockStartAbs;
+    sortEvents(drained.data(), drained.data() + drained.size());
+    if (self->printTriggers_) for (const auto& ev : drained) self->pushEvent(ev, ev.sampleTime);
 
-    // Determine split offsets
-    std::vector<uint32_t> splits; splits.reserve(8); splits.push_back(0); splits.push_back(inNumberFrames);
+    // Node events travel with the block (each rack graph routes every node its own span), so the
+    // block is only split where session-level targets (xfader/rack/bus gains) change
+    std::vector<uint32_t>& splits = self->splits_; splits.clear(); splits.push_back(0); splits.push_back(inNumberFrames);
     for (const auto& c : drained) {
-      if (c.sampleTime >= blockStartAbs && c.sampleTime < cutoff) splits.push_back(static_cast<uint32_t>(c.sampleTime - blockStartAbs));
+      if (c.type != CommandType::Trigger && SessionGraph::isSessionTarget(c.nodeId)) splits.push_back(static_cast<uint32_t>(c.sampleTime - blockStartAbs));
     }
     std::sort(splits.begin(), splits.end()); splits.erase(std::unique(splits.begin(), splits.end()), splits.end());
+    // Muted racks are not rendered but still latch their events
+    for (size_t ri = 0; ri < self->racks_.size(); ++ri) {
+      const auto& r = self->racks_[ri];
+      if (!r.graph || self->graph_.rackActive(ri)) continue;
+      for (const auto& ev : drained) if (ev.nodeId) self->latchRackEvent(ri, ev);
+    }
 
-    // Scratch buffers per rack and per bus
-    const size_t segMaxSamples = static_cast<size_t>(inNumberFrames) * self->channels_;
-    self->rackScratch_.assign(self->racks_.size(), std::vector<float>(segMaxSamples, 0.0f));
-    self->busScratch_.assign(self->buses_.size(), std::vector<float>(segMaxSamples, 0.0f));
-
+    size_t evBegin = 0;
     for (size_t si = 0; si + 1 < splits.size(); ++si) {
       const uint32_t segStart = splits[si]; const uint32_t segEnd = splits[si + 1]; const uint32_t segFrames = segEnd - segStart; if (segFrames == 0) continue;
       const SampleTime segAbsStart = blockStartAbs + static_cast<SampleTime>(segStart);
-      // Handle xfader param events (nodeId "xfader:<id>:x") at boundary before node events
-      for (const auto& ev : drained) if (ev.sampleTime == segAbsStart && (ev.type == CommandType::SetParam || ev.type == CommandType::SetParamRamp)) {
-        if (ev.nodeId) {
-          const char* nid = ev.nodeId;
-          if (std::strncmp(nid, "xfader:", 8) == 0) {
-            const char* rest = nid + 8; // <id>:x
-            const char* colon = std::strchr(rest, ':');
-            if (colon && std::strcmp(colon + 1, "x") == 0) {
-              const std::string xfId(rest, static_cast<size_t>(colon - rest));
-              for (auto& xf : self->xfaders_) {
-                if (xf.id == xfId) {
-                  xf.lfoEnabled = false; // manual takes over
-                  double v = static_cast<double>(ev.value);
-                  if (v < 0.0) v = 0.0; else if (v > 1.0) v = 1.0;
-                  xf.xTarget = v;
-                  if (ev.type == CommandType::SetParamRamp && ev.rampMs > 0.0f) xf.smoothingMs = static_cast<double>(ev.rampMs);
-                }
-              }
-            }
-          }
-        }
-      }
-      // Apply events at segment boundary: SetParam first, then Trigger across all racks
+      // Session-level targets (xfader:<id>:x, rack:<id>:gain, bus:<id>:gain) at their segment start
       for (const auto& ev : drained) if (ev.sampleTime == segAbsStart && (ev.type == CommandType::SetParam || ev.type == CommandType::SetParamRamp)) {
-        // Route events by matching full, prefixed nodeId against graph node ids
-        for (const auto& r : self->racks_) if (r.graph) {
-          if (!ev.nodeId) continue;
-          const char* fullId = ev.nodeId;
-          r.graph->forEachNode([&](const std::string& id, Node& n){ if (id == fullId) n.handleEvent(ev); });
-        }
-        if (self->printTriggers_) self->printEvent(ev, segAbsStart);
-      }
-      for (const auto& ev : drained) if (ev.sampleTime == segAbsStart && ev.type == CommandType::Trigger) {
-        // Route events by matching full, prefixed nodeId against graph node ids
-        for (const auto& r : self->racks_) if (r.graph) {
-          if (!ev.nodeId) continue;
-          const char* fullId = ev.nodeId;
-          r.graph->forEachNode([&](const std::string& id, Node& n){ if (id == fullId) n.handleEvent(ev); });
-        }
-        if (self->printTriggers_) self->printEvent(ev, segAbsStart);
+        if (self->applyFreezeTarget(ev.nodeId, ev.value, ev.type == CommandType::SetParamRamp ? ev.rampMs : 0.0f)) continue;
+        self->graph_.applySessionTarget(ev.nodeId, ev.value, ev.type == CommandType::SetParamRamp ? ev.rampMs : 0.0f);
       }
 
-      // Zero output segment
-      float* outPtr = interleaved + static_cast<size_t>(segStart) * self->channels_;
-      std::memset(outPtr, 0, static_cast<size_t>(segFrames) * self->channels_ * sizeof(float));
-
-      // Determine solo mode for this segment
-      bool anySolo = false; for (const auto& r : self->racks_) if (r.solo) { anySolo = true; break; }
-      // Render each rack graph to its scratch
-      for (size_t ri = 0; ri < self->racks_.size(); ++ri) {
-        const auto& rackCfg = self->racks_[ri];
-        if (rackCfg.muted) continue;
-        if (anySolo && !rackCfg.solo) continue;
-        auto* g = rackCfg.graph; if (!g) continue;
-        ProcessContext ctx{}; ctx.sampleRate = self->sampleRate_; ctx.frames = segFrames; ctx.blockStart = segAbsStart;
-        float* dst = self->rackScratch_[ri].data();
-        for (size_t i = 0; i < static_cast<size_t>(segFrames) * self->channels_; ++i) dst[i] = 0.0f;
-        g->process(ctx, dst, self->channels_);
-        // Update meters accumulators
-        if (self->metersEnabled_) {
-          Meter& m = self->rackMeters_[ri];
-          const size_t n = static_cast<size_t>(segFrames) * self->channels_;
-          for (size_t i = 0; i < n; ++i) {
-            const float s = dst[i];
-            const float a = std::fabs(s);
-            if (a > m.peak) m.peak = a;
-            m.sumSq += static_cast<double>(s) * static_cast<double>(s);
-          }
-          m.frames += segFrames * self->channels_;
+      // Mix through the compiled session graph in chunks of at most kMaxGraphFrames
+      for (uint32_t off = 0; off < segFrames; off += kMaxGraphFrames) {
+        const uint32_t n = std::min<uint32_t>(kMaxGraphFrames, segFrames - off);
+        ProcessContext ctx{}; ctx.sampleRate = self->sampleRate_; ctx.frames = n; ctx.blockStart = segAbsStart + off;
+        // This chunk's events (drained is time-sorted)
+        size_t evEnd = evBegin;
+        while (evEnd < drained.size() && drained[evEnd].sampleTime < ctx.blockStart + n) ++evEnd;
+        ctx.events = drained.data() + evBegin; ctx.eventCount = static_cast<uint32_t>(evEnd - evBegin);
+        evBegin = evEnd;
+        float* outPtr = interleaved + static_cast<size_t>(segStart + off) * self->channels_;
+        auto renderRack = [&](size_t ri, const ProcessContext& rctx, float* dst) { self->renderRack(ri, rctx, dst); };
+        if (self->pool_) {
+          self->graph_.process(ctx, outPtr, renderRack, [&](size_t count, auto& task) { self->pool_->parallelFor(count, n, task); });
+        } else {
+          self->graph_.process(ctx, outPtr, renderRack);
         }
-      }
-      // Zero bus scratch
-      for (auto& bbuf : self->busScratch_) {
-        const size_t count = static_cast<size_t>(segFrames) * self->channels_;
-        for (size_t i = 0; i < count; ++i) bbuf[i] = 0.0f;
-      }
-      // Compute per-rack gain multipliers from xfaders (apply once per segment)
-      std::vector<float> rackGainMul(self->racks_.size(), 1.0f);
-      for (auto& xf : self->xfaders_) {
-        if (xf.lfoEnabled) {
-          const double dt = static_cast<double>(segFrames) / self->sampleRate_;
-          xf.phase01 += xf.freqHz * dt; while (xf.phase01 >= 1.0) xf.phase01 -= 1.0;
-          const double s = std::sin(2.0 * M_PI * xf.phase01);
-          xf.xTarget = 0.5 * (s + 1.0);
-        }
-        const double alpha = std::min(1.0, (xf.smoothingMs > 0.0 ? (static_cast<double>(segFrames) / self->sampleRate_) / (xf.smoothingMs / 1000.0) : 1.0));
-        xf.x += (xf.xTarget - xf.x) * alpha;
-        double gA = 1.0, gB = 1.0;
-        const double x = std::clamp(xf.x, 0.0, 1.0);
-        if (xf.lawEqualPower) { gA = std::cos(0.5 * M_PI * x); gB = std::sin(0.5 * M_PI * x); }
-        else { gA = 1.0 - x; gB = x; }
-        xf.lastGA = gA; xf.lastGB = gB;
-        if (xf.aIndex < rackGainMul.size()) rackGainMul[xf.aIndex] *= static_cast<float>(gA);
-        if (xf.bIndex < rackGainMul.size()) rackGainMul[xf.bIndex] *= static_cast<float>(gB);
-      }
-      // Route racks to buses
-      std::vector<bool> rackHadRoute(self->racks_.size(), false);
-      for (const auto& rt : self->routes_) {
-        size_t ri = 0; bool foundRack = false; for (; ri < self->racks_.size(); ++ri) if (self->racks_[ri].id == rt.from) { foundRack = true; break; }
-        if (!foundRack) continue;
-        if (self->racks_[ri].muted) continue; // muted racks do not route
-        // honor solo globally: if anySolo and this rack not solo, skip
-        bool anySolo2 = false; for (const auto& r : self->racks_) if (r.solo) { anySolo2 = true; break; }
-        if (anySolo2 && !self->racks_[ri].solo) continue;
-        size_t bi = 0; bool foundBus = false; for (; bi < self->buses_.size(); ++bi) if (self->buses_[bi].id == rt.to) { foundBus = true; break; }
-        if (!foundBus) continue;
-        const float gain = self->racks_[ri].gain * rt.gain * ((ri < rackGainMul.size()) ? rackGainMul[ri] : 1.0f);
-        const float* src = self->rackScratch_[ri].data(); float* dst = self->busScratch_[bi].data();
-        const size_t n = static_cast<size_t>(segFrames) * self->channels_;
-        for (size_t i = 0; i < n; ++i) dst[i] += src[i] * gain;
-        rackHadRoute[ri] = true;
-      }
-      // Fallback: racks without routes → sum to output
-      for (size_t ri = 0; ri < self->racks_.size(); ++ri) {
-        if (ri >= rackHadRoute.size() || rackHadRoute[ri]) continue;
-        if (self->racks_[ri].muted) continue;
-        bool anySolo3 = false; for (const auto& r : self->racks_) if (r.solo) { anySolo3 = true; break; }
-        if (anySolo3 && !self->racks_[ri].solo) continue;
-        const float* src = self->rackScratch_[ri].data();
-        float* dst = outPtr;
-        const size_t n = static_cast<size_t>(segFrames) * self->channels_;
-        const float mul = ((ri < rackGainMul.size()) ? rackGainMul[ri] : 1.0f) * self->racks_[ri].gain;
-        for (size_t i = 0; i < n; ++i) dst[i] += src[i] * mul;
-      }
-      // Apply inserts (spectral_ducker) on each bus
-      for (size_t bi = 0; bi < self->buses_.size(); ++bi) {
-        auto& bus = self->buses_[bi];
-        for (const auto& ins : bus.inserts) {
-          if (ins.type == std::string("spectral_ducker")) {
-            SpectralDuckerNode duck; try {
-              if (ins.params.contains("mix")) duck.mix = ins.params["mix"].get<float>();
-              if (ins.params.contains("detectorHpfHz")) duck.scHpfHz = ins.params["detectorHpfHz"].get<float>();
-              if (ins.params.contains("applyMode")) { std::string m = ins.params["applyMode"].get<std::string>(); duck.applyMode = (m == std::string("dynamicEq")) ? SpectralDuckerNode::ApplyMode::DynamicEq : SpectralDuckerNode::ApplyMode::Multiply; }
-              if (ins.params.contains("stereoMode")) { std::string sm = ins.params["stereoMode"].get<std::string>(); duck.stereoMode = (sm == std::string("MidSide")) ? SpectralDuckerNode::StereoMode::MidSide : SpectralDuckerNode::StereoMode::LR; }
-              if (ins.params.contains("msSideScale")) duck.msSideScale = ins.params["msSideScale"].get<float>();
-            } catch (...) {}
-            duck.prepare(self->sampleRate_, std::min<uint32_t>(segFrames, 4096u));
-            std::vector<float> sc; sc.assign(static_cast<size_t>(segFrames) * self->channels_, 0.0f);
-            for (const auto& scp : ins.sidechains) {
-              const std::string& fromRack = scp.second; size_t ri = 0; bool found = false; for (; ri < self->racks_.size(); ++ri) if (self->racks_[ri].id == fromRack) { found = true; break; }
-              if (!found) continue; const float* s = self->rackScratch_[ri].data();
-              const size_t n = static_cast<size_t>(segFrames) * self->channels_;
-              for (size_t i = 0; i < n; ++i) sc[i] += s[i];
-            }
-            ProcessContext bctx{}; bctx.sampleRate = self->sampleRate_; bctx.frames = segFrames; bctx.blockStart = segAbsStart;
-            duck.applySidechain(bctx, self->busScratch_[bi].data(), sc.data(), self->channels_);
+        if (self->metersEnabled_) {
+          for (size_t ri = 0; ri < self->racks_.size(); ++ri) {
+            if (self->graph_.rackActive(ri)) accumulateMeter(self->rackMeters_[ri], self->graph_.rackBuffer(ri), static_cast<size_t>(n) * self->channels_);
           }
-        }
-      }
-      // Accumulate bus meters after inserts
-      if (self->metersEnabled_) {
-        for (size_t bi = 0; bi < self->busScratch_.size(); ++bi) {
-          Meter& m = self->busMeters_[bi];
-          const size_t n = static_cast<size_t>(segFrames) * self->channels_;
-          const float* src = self->busScratch_[bi].data();
-          for (size_t i = 0; i < n; ++i) {
-            const float s = src[i];
-            const float a = std::fabs(s);
-            if (a > m.peak) m.peak = a;
-            m.sumSq += static_cast<double>(s) * static_cast<double>(s);
+          for (size_t bi = 0; bi < self->graph_.busCount(); ++bi) {
+            accumulateMeter(self->busMeters_[bi], self->graph_.busBuffer(bi), static_cast<size_t>(n) * self->graph_.busChannels(bi));
           }
-          m.frames += segFrames * self->channels_;
         }
       }
-      // Sum buses to output
-      for (size_t bi = 0; bi < self->busScratch_.size(); ++bi) {
-        const size_t n = static_cast<size_t>(segFrames) * self->channels_;
-        const float* src = self->busScratch_[bi].data();
-        for (size_t i = 0; i < n; ++i) outPtr[i] += src[i];
-      }
-      // Periodic meters + metrics
+      // Periodic meters + metrics: raw accumulators go to the telemetry writer
       if (self->metersEnabled_) {
         const double nowSec = static_cast<double>(cutoff) / self->sampleRate_;
         if (nowSec - self->lastMetersPrintSec_ >= self->metersIntervalSec_) {
-          const double tRel = nowSec;
-          const double tsUnix = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
-          for (size_t ri = 0; ri < self->racks_.size(); ++ri) {
-            const Meter& m = self->rackMeters_[ri]; if (m.frames == 0) continue;
-            const double peakDb = (m.peak > 0.0) ? (20.0 * std::log10(static_cast<double>(m.peak))) : -std::numeric_limits<double>::infinity();
-            const double rmsLin = std::sqrt(m.sumSq / static_cast<double>(m.frames));
-            const double rmsDb = (rmsLin > 0.0) ? (20.0 * std::log10(rmsLin)) : -std::numeric_limits<double>::infinity();
-            std::fprintf(stderr, "Meters\track=%s\tpeak_dBFS=%.2f\trms_dBFS=%.2f\n", self->racks_[ri].id.c_str(), peakDb, rmsDb);
-            if (self->metricsEnabled_ && self->metricsFile_ && self->metricsIncludeRacks_) {
-              std::fprintf(self->metricsFile_,
-                           "{\"event\":\"meters\",\"ts_unix\":%.6f,\"t_rel\":%.6f,\"interval_s\":%.3f,\"sr\":%.0f,\"channels\":%u,\"kind\":\"rack\",\"id\":\"%s\",\"peak_dbfs\":%.3f,\"rms_dbfs\":%.3f}\n",
-                           tsUnix, tRel, self->metersIntervalSec_, self->sampleRate_, self->channels_, self->racks_[ri].id.c_str(), peakDb, rmsDb);
-            }
-          }
-          for (size_t bi = 0; bi < self->buses_.size(); ++bi) {
-            const Meter& m = self->busMeters_[bi]; if (m.frames == 0) continue;
-            const double peakDb = (m.peak > 0.0) ? (20.0 * std::log10(static_cast<double>(m.peak))) : -std::numeric_limits<double>::infinity();
-            const double rmsLin = std::sqrt(m.sumSq / static_cast<double>(m.frames));
-            const double rmsDb = (rmsLin > 0.0) ? (20.0 * std::log10(rmsLin)) : -std::numeric_limits<double>::infinity();
-            std::fprintf(stderr, "Meters\tbus=%s\tpeak_dBFS=%.2f\trms_dBFS=%.2f\n", self->buses_[bi].id.c_str(), peakDb, rmsDb);
-            if (self->metricsEnabled_ && self->metricsFile_ && self->metricsIncludeBuses_) {
-              std::fprintf(self->metricsFile_,
-                           "{\"event\":\"meters\",\"ts_unix\":%.6f,\"t_rel\":%.6f,\"interval_s\":%.3f,\"sr\":%.0f,\"channels\":%u,\"kind\":\"bus\",\"id\":\"%s\",\"peak_dbfs\":%.3f,\"rms_dbfs\":%.3f}\n",
-                           tsUnix, tRel, self->metersIntervalSec_, self->sampleRate_, self->channels_, self->buses_[bi].id.c_str(), peakDb, rmsDb);
-            }
-          }
-          if (self->metricsEnabled_ && self->metricsFile_) {
-            for (const auto& xf : self->xfaders_) {
-              std::fprintf(self->metricsFile_,
-                           "{\"event\":\"xfader\",\"ts_unix\":%.6f,\"t_rel\":%.6f,\"id\":\"%s\",\"x\":%.4f,\"gainA\":%.4f,\"gainB\":%.4f}\n",
-                           tsUnix, tRel, xf.id.c_str(), xf.x, xf.lastGA, xf.lastGB);
+          auto pushMeter = [&](const Meter& m, const char* id, uint8_t kind) {
+            if (m.frames == 0) return;
+            TelemetryRecord r; r.kind = TelemetryRecord::Kind::Meter; r.aux = kind; r.id = id; r.t = cutoff;
+            r.v[0] = m.peak; r.v[1] = m.sumSq; r.v[2] = static_cast<double>(m.frames);
+            self->telemetry_.push(r);
+          };
+          for (size_t ri = 0; ri < self->racks_.size(); ++ri) pushMeter(self->rackMeters_[ri], self->racks_[ri].id.c_str(), 0);
+          for (size_t bi = 0; bi < self->buses_.size(); ++bi) pushMeter(self->busMeters_[bi], self->buses_[bi].id.c_str(), 1);
+          if (self->metricsEnabled_) {
+            for (const auto& xf : self->graph_.xfaders()) {
+              TelemetryRecord r; r.kind = TelemetryRecord::Kind::Xfader; r.id = xf.id.c_str(); r.t = cutoff;
+              r.v[0] = xf.x; r.v[1] = xf.lastGA; r.v[2] = xf.lastGB;
+              self->telemetry_.push(r);
             }
-            std::fflush(self->metricsFile_);
           }
+          TelemetryRecord r; r.kind = TelemetryRecord::Kind::Interval; r.t = cutoff;
+          self->telemetry_.push(r);
           for (auto& m : self->rackMeters_) { m = Meter{}; }
           for (auto& m : self->busMeters_) { m = Meter{}; }
           self->lastMetersPrintSec_ = nowSec;
@@ -368,12 +359,237 @@ private:
       }
     }
 
+    if (self->pool_ && self->metricsEnabled_ && self->metricsFile_) {
+      const double nowSec = static_cast<double>(cutoff) / self->sampleRate_;
+      if (nowSec - self->lastPoolReportSec_ >= self->metersIntervalSec_) {
+        TelemetryRecord r = poolRecord(self->pool_->intervalStats()); r.t = cutoff;
+        self->telemetry_.push(r);
+        self->pool_->resetIntervalStats();
+        self->lastPoolReportSec_ = nowSec;
+      }
+    }
+
     self->sampleCounter_.store(cutoff, std::memory_order_relaxed);
     return noErr;
   }
 
-  void printEvent(const Command& c, SampleTime segAbsStart) const {
-    const double tSec = static_cast<double>(segAbsStart) / sampleRate_;
+  // Frozen racks: mix 1 = frozen audio, 0 = live graph; moves toward target by step per frame
+  // Who may touch a frozen rack's graph: the audio thread (live), or the reset thread, which
+  // clears its voices and tails once the rack is fully frozen and then hands it back
+  enum : uint8_t { kGraphLive = 0, kGraphResetRequested = 1, kGraphResetDone = 2 };
+  struct FreezeState {
+    float mix = 0.0f; float target = 0.0f; float step = 1.0f; std::vector<float> scratch;
+    std::atomic<uint8_t> graph{kGraphLive};
+    std::vector<Command> held; // parameter events latched while the reset thread owns the graph
+  };
+  static constexpr size_t kFreezeHeldEvents = 256;
+  static constexpr float kFreezeFadeMs = 20.0f;
+
+  // "rack:<id>:frozen" (value >= 0.5 freezes); crossfades over rampMs (at least kFreezeFadeMs).
+  // Returns true when nodeId addressed a freeze target. Does not allocate.
+  bool applyFreezeTarget(const char* nodeId, float value, float rampMs) noexcept {
+    if (!nodeId || std::strncmp(nodeId, "rack:", 5) != 0) return false;
+    const char* idBegin = nodeId + 5;
+    const char* colon = std::strrchr(idBegin, ':');
+    if (!colon || std::strcmp(colon + 1, "frozen") != 0) return false;
+    const size_t len = static_cast<size_t>(colon - idBegin);
+    for (size_t ri = 0; ri < racks_.size(); ++ri) {
+      const Rack& r = racks_[ri];
+      if (!r.frozen || r.id.size() != len || std::strncmp(r.id.c_str(), idBegin, len) != 0) continue;
+      FreezeState& fz = freeze_[ri];
+      fz.target = value >= 0.5f ? 1.0f : 0.0f;
+      const double fadeFrames = static_cast<double>(std::max(rampMs, kFreezeFadeMs)) * 0.001 * sampleRate_;
+      fz.step = static_cast<float>(1.0 / std::max(1.0, fadeFrames));
+    }
+    return true;
+  }
+
+  // Index of the anticipated rack owning nodeId ("<rackId>:<node>"), or ahead_.size(). Does not allocate.
+  size_t aheadRackFor(const char* nodeId) const noexcept {
+    if (!nodeId || SessionGraph::isSessionTarget(nodeId)) return ahead_.size();
+    for (size_t ri = 0; ri < ahead_.size(); ++ri) {
+      if (!ahead_[ri]) continue;
+      const std::string& id = racks_[ri].id;
+      if (std::strncmp(nodeId, id.c_str(), id.size()) == 0 && nodeId[id.size()] == ':') return ri;
+    }
+    return ahead_.size();
+  }
+
+  // Hand a parameter event to the rack graph's node without rendering (muted or frozen racks).
+  // Held back while the reset thread owns the graph. Does not allocate.
+  void latchRackEvent(size_t ri, const Command& ev) noexcept {
+    Node* n = racks_[ri].graph->findNode(ev.nodeId);
+    if (!n) return;
+    if (ri < freeze_.size() && freeze_[ri].graph.load(std::memory_order_acquire) != kGraphLive) {
+      FreezeState& fz = freeze_[ri];
+      if (fz.held.size() < fz.held.capacity()) fz.held.push_back(ev);
+      else freezeHeldDropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    n->handleEvent(ev);
+  }
+
+  // Non-RT: reset the graphs of racks that just became fully frozen, so an unfreeze starts clean
+  void freezeResetLoop() {
+    while (freezeResetRunning_.load(std::memory_order_relaxed)) {
+      for (size_t ri = 0; ri < freeze_.size(); ++ri) {
+        if (freeze_[ri].graph.load(std::memory_order_acquire) != kGraphResetRequested) continue;
+        racks_[ri].graph->reset();
+        freeze_[ri].graph.store(kGraphResetDone, std::memory_order_release);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  }
+
+  // Fill one rack's buffer: pre-rendered ring, live graph, frozen audio, or a crossfade
+  void renderRack(size_t ri, const ProcessContext& ctx, float* dst) noexcept {
+    const Rack& r = racks_[ri];
+    if (AnticipatedRack* a = ahead_[ri].get()) {
+      const SampleTime end = ctx.blockStart + ctx.frames;
+      if (a->mode != AnticipatedRack::Mode::Sync || end <= a->syncFrom) {
+        const uint32_t missing = a->read(ctx.blockStart, ctx.frames, dst);
+        if (missing > 0) aheadUnderruns_.fetch_add(missing, std::memory_order_relaxed);
+        return;
+      }
+      if (ctx.blockStart < a->syncFrom) {
+        // Switch inside this chunk: ring up to the checkpoint, the graph after it
+        const uint32_t pre = static_cast<uint32_t>(a->syncFrom - ctx.blockStart);
+        a->read(ctx.blockStart, pre, dst);
+        ProcessContext sub = ctx; sub.blockStart = a->syncFrom; sub.frames = ctx.frames - pre;
+        uint32_t skip = 0;
+        while (skip < ctx.eventCount && ctx.events[skip].sampleTime < a->syncFrom) ++skip;
+        sub.events = ctx.events + skip; sub.eventCount = ctx.eventCount - skip;
+        r.graph->process(sub, dst + static_cast<size_t>(pre) * channels_, channels_);
+        return;
+      }
+    }
+    if (!r.frozen) { r.graph->process(ctx, dst, channels_); return; }
+    FreezeState& fz = freeze_[ri];
+    if (fz.graph.load(std::memory_order_acquire) == kGraphResetDone) {
+      // Graph is back from the reset thread: apply what was latched meanwhile
+      for (const Command& ev : fz.held) if (Node* n = r.graph->findNode(ev.nodeId)) n->handleEvent(ev);
+      fz.held.clear();
+      fz.graph.store(kGraphLive, std::memory_order_relaxed);
+    }
+    const bool resetting = fz.graph.load(std::memory_order_relaxed) != kGraphLive;
+    if (fz.mix == 0.0f && fz.target == 0.0f) { r.graph->process(ctx, dst, channels_); return; }
+    if ((fz.mix == 1.0f && fz.target == 1.0f) || resetting) {
+      // The graph is not run while frozen (an unfreeze waits for a pending reset); parameter
+      // changes are latched so an unfreeze picks them up, triggers are dropped (they would sound
+      // stale voices later)
+      for (uint32_t i = 0; i < ctx.eventCount; ++i) {
+        const Command& ev = ctx.events[i];
+        if (ev.type == CommandType::Trigger || !ev.nodeId) continue;
+        latchRackEvent(ri, ev);
+      }
+      r.frozen->read(ctx.blockStart, ctx.frames, dst);
+      return;
+    }
+    r.graph->process(ctx, dst, channels_);
+    float* frozen = fz.scratch.data();
+    r.frozen->read(ctx.blockStart, ctx.frames, frozen);
+    for (uint32_t f = 0; f < ctx.frames; ++f) {
+      fz.mix = fz.target > fz.mix ? std::min(fz.target, fz.mix + fz.step) : std::max(fz.target, fz.mix - fz.step);
+      for (uint32_t c = 0; c < channels_; ++c) {
+        float& o = dst[static_cast<size_t>(f) * channels_ + c];
+        o += (frozen[static_cast<size_t>(f) * channels_ + c] - o) * fz.mix;
+      }
+    }
+    // Fully frozen again: the reset thread drops the graph's voices and tails so a later
+    // unfreeze starts clean; the callback leaves the graph alone until it is handed back
+    if (fz.mix == 1.0f) fz.graph.store(kGraphResetRequested, std::memory_order_release);
+  }
+
+  struct Meter { double sumSq = 0.0; double peak = 0.0; uint64_t frames = 0; };
+  static void accumulateMeter(Meter& m, const float* src, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      const float a = std::fabs(src[i]);
+      if (a > m.peak) m.peak = a;
+      m.sumSq += static_cast<double>(src[i]) * static_cast<double>(src[i]);
+    }
+    m.frames += n;
+  }
+
+  static TelemetryRecord poolRecord(const RtWorkerPool::Stats& st) {
+    TelemetryRecord r; r.kind = TelemetryRecord::Kind::Pool;
+    r.v[0] = static_cast<double>(st.jobs); r.v[1] = static_cast<double>(st.parallelJobs); r.v[2] = static_cast<double>(st.serialJobs);
+    r.v[3] = st.speedupAvg(); r.v[4] = st.speedupMin; r.v[5] = st.wakeUsAvg(); r.v[6] = st.wakeUsMax;
+    return r;
+  }
+
+  void writePoolMetrics(const double* v, const char* event, double tRel) const {
+    const double tsUnix = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    std::fprintf(metricsFile_,
+                 "{\"event\":\"%s\",\"ts_unix\":%.6f,\"t_rel\":%.6f,\"workers\":%u,\"blocks\":%llu,\"parallel_blocks\":%llu,\"serial_blocks\":%llu,\"speedup_avg\":%.3f,\"speedup_min\":%.3f,\"wake_us_avg\":%.2f,\"wake_us_max\":%.2f}\n",
+                 event, tsUnix, tRel, poolWorkers_, static_cast<unsigned long long>(v[0]), static_cast<unsigned long long>(v[1]),
+                 static_cast<unsigned long long>(v[2]), v[3], v[4], v[5], v[6]);
+  }
+
+  void pushEvent(const Command& c, SampleTime at) {
+    TelemetryRecord r; r.kind = TelemetryRecord::Kind::Event; r.cmd = c; r.cmd.sampleTime = at;
+    telemetry_.push(r);
+  }
+
+  // Writer thread: format one record to stderr and/or the metrics file
+  void writeTelemetry(const TelemetryRecord& r) {
+    const double tRel = static_cast<double>(r.t) / sampleRate_;
+    const bool metrics = metricsEnabled_ && metricsFile_;
+    switch (r.kind) {
+      case TelemetryRecord::Kind::Meter: {
+        const double peakDb = (r.v[0] > 0.0) ? (20.0 * std::log10(r.v[0])) : -std::numeric_limits<double>::infinity();
+        const double rmsLin = std::sqrt(r.v[1] / r.v[2]);
+        const double rmsDb = (rmsLin > 0.0) ? (20.0 * std::log10(rmsLin)) : -std::numeric_limits<double>::infinity();
+        const char* kind = r.aux == 0 ? "rack" : "bus";
+        std::fprintf(stderr, "Meters\t%s=%s\tpeak_dBFS=%.2f\trms_dBFS=%.2f\n", kind, r.id, peakDb, rmsDb);
+        if (metrics && (r.aux == 0 ? metricsIncludeRacks_ : metricsIncludeBuses_)) {
+          std::fprintf(metricsFile_,
+                       "{\"event\":\"meters\",\"ts_unix\":%.6f,\"t_rel\":%.6f,\"interval_s\":%.3f,\"sr\":%.0f,\"channels\":%u,\"kind\":\"%s\",\"id\":\"%s\",\"peak_dbfs\":%.3f,\"rms_dbfs\":%.3f}\n",
+                       wallNow(), tRel, metersIntervalSec_, sampleRate_, channels_, kind, r.id, peakDb, rmsDb);
+        }
+        break;
+      }
+      case TelemetryRecord::Kind::Xfader:
+        if (metrics) {
+          std::fprintf(metricsFile_,
+                       "{\"event\":\"xfader\",\"ts_unix\":%.6f,\"t_rel\":%.6f,\"id\":\"%s\",\"x\":%.4f,\"gainA\":%.4f,\"gainB\":%.4f}\n",
+                       wallNow(), tRel, r.id, r.v[0], r.v[1], r.v[2]);
+        }
+        break;
+      case TelemetryRecord::Kind::Interval:
+        if (metrics) {
+          // Sample memory (resident bytes are refreshed by the prefetcher thread)
+          const SampleCacheStats& sc = sampleCacheStats();
+          if (sc.samples.load(std::memory_order_relaxed) > 0) {
+            std::fprintf(metricsFile_,
+                         "{\"event\":\"sample_cache\",\"ts_unix\":%.6f,\"t_rel\":%.6f,\"samples\":%llu,\"decoded_bytes\":%llu,\"mapped_bytes\":%llu,\"resident_bytes\":%llu,\"prefetched_bytes\":%llu,\"prefetch_requests\":%llu}\n",
+                         wallNow(), tRel, static_cast<unsigned long long>(sc.samples.load(std::memory_order_relaxed)),
+                         static_cast<unsigned long long>(sc.decodedBytes.load(std::memory_order_relaxed)), static_cast<unsigned long long>(sc.mappedBytes.load(std::memory_order_relaxed)),
+                         static_cast<unsigned long long>(sc.residentBytes.load(std::memory_order_relaxed)), static_cast<unsigned long long>(sc.prefetchedBytes.load(std::memory_order_relaxed)),
+                         static_cast<unsigned long long>(sc.prefetchRequests.load(std::memory_order_relaxed)));
+          }
+          std::fprintf(metricsFile_, "{\"event\":\"telemetry\",\"ts_unix\":%.6f,\"t_rel\":%.6f,\"records\":%llu,\"dropped\":%llu}\n",
+                       wallNow(), tRel, static_cast<unsigned long long>(telemetry_.records()), static_cast<unsigned long long>(telemetry_.dropped()));
+          std::fflush(metricsFile_);
+        }
+        break;
+      case TelemetryRecord::Kind::Pool:
+        if (metrics) writePoolMetrics(r.v, "rt_pool", tRel);
+        break;
+      case TelemetryRecord::Kind::Drained:
+        std::fprintf(stderr, "[rt-session] drained=%llu at t=%.3f..%.3f sec\n",
+                     static_cast<unsigned long long>(r.u), tRel, static_cast<double>(r.t2) / sampleRate_);
+        break;
+      case TelemetryRecord::Kind::Event:
+        printEvent(r.cmd);
+        break;
+      default: break;
+    }
+  }
+
+  static double wallNow() { return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count(); }
+
+  void printEvent(const Command& c) const {
+    const double tSec = static_cast<double>(c.sampleTime) / sampleRate_;
     const char* src = (c.source == 1 ? "SESS" : "RACK");
     const char* tag = (c.type == CommandType::Trigger) ? "TRIGGER" : (c.type == CommandType::SetParam ? "SET" : "RAMP");
     const char* node = c.nodeId ? c.nodeId : "";
@@ -386,9 +602,13 @@ private:
     const char* pname = nullptr;
     if (node && *node) {
       // xfader special case: nodeId format "xfader:<id>:x"
-      if (std::strncmp(node, "xfader:", 8) == 0) {
-        const char* rest = node + 8; const char* colon = std::strchr(rest, ':');
+      if (std::strncmp(node, "xfader:", 7) == 0) {
+        const char* rest = node + 7; const char* colon = std::strchr(rest, ':');
         if (colon && std::strcmp(colon + 1, "x") == 0) pname = "x";
+      } else if (std::strncmp(node, "rack:", 5) == 0 || std::strncmp(node, "bus:", 4) == 0) {
+        const char* colon = std::strrchr(node, ':');
+        if (colon && std::strcmp(colon + 1, "gain") == 0) pname = "gain";
+        else if (colon && std::strcmp(colon + 1, "frozen") == 0) pname = "frozen";
       }
       if (!pname && c.paramNameStr && *c.paramNameStr) {
         pname = c.paramNameStr; // fallback to carried name
@@ -405,6 +625,7 @@ private:
           else if (t == std::string("clap")) pname = nameById(kClapParamMap, c.paramId);
           else if (t == std::string("tb303_ext")) pname = nameById(kTb303ParamMap, c.paramId);
           else if (t == std::string("mam_chip")) pname = nameById(kMamChipParamMap, c.paramId);
+          else if (t == std::string("sampler")) pname = nameById(kSamplerParamMap, c.paramId);
         }
       }
     }
@@ -420,19 +641,36 @@ private:
   uint32_t channels_ = 2;
   double sampleRate_ = 48000.0;
   std::atomic<SampleTime> sampleCounter_{0};
-  void* cmdQueue_ = nullptr; using DrainFn = void(*)(void*, SampleTime, std::vector<Command>&); DrainFn queueDrain_ = nullptr;
+  void* cmdQueue_ = nullptr; using DrainFn = bool(*)(void*, SampleTime, std::vector<Command>&, size_t); DrainFn queueDrain_ = nullptr;
+  void* liveQueue_ = nullptr; DrainFn liveDrain_ = nullptr; std::atomic<uint64_t> liveLate_{0};
   bool printTriggers_ = false;
   bool debug_ = false;
-  std::vector<std::vector<float>> rackScratch_{};
-  std::vector<std::vector<float>> busScratch_{};
-  struct Meter { double sumSq = 0.0; double peak = 0.0; uint64_t frames = 0; };
+  static constexpr uint32_t kMaxGraphFrames = 4096;
+  SessionGraph graph_{};
+  bool graphCompiled_ = false;
+  std::unique_ptr<RtWorkerPool> pool_{};
+  uint32_t poolWorkers_ = 0; double poolSpinUs_ = 50.0; double lastPoolReportSec_ = 0.0;
+  std::vector<SessionSpec::XfaderRef> xfaderRefs_{};
   std::vector<Meter> rackMeters_{};
   std::vector<Meter> busMeters_{};
   bool metersEnabled_ = false; double metersIntervalSec_ = 1.0; double lastMetersPrintSec_ = 0.0;
   bool metricsEnabled_ = false; FILE* metricsFile_ = nullptr; bool metricsIncludeRacks_ = true; bool metricsIncludeBuses_ = true; double startWallUnix_ = 0.0;
-  struct XfaderState { std::string id; size_t aIndex=SIZE_MAX; size_t bIndex=SIZE_MAX; bool lawEqualPower=true; double smoothingMs=10.0; bool lfoEnabled=false; double freqHz=0.25; double phase01=0.0; double x=0.0; double xTarget=0.0; double lastGA=1.0; double lastGB=1.0; };
-  std::vector<XfaderState> xfaders_{};
   std::unordered_map<std::string, std::string> nodeTypeById_{};
+  TelemetryWriter telemetry_{};
+  static constexpr size_t kMaxDrained = 8192; // commands taken from the queues per block
+  std::vector<Command> drained_{};
+  std::atomic<uint64_t> drainLimited_{0}; // blocks that left due commands queued at kMaxDrained
+  std::atomic<uint64_t> drainDropped_{0}; // held handover commands that did not fit
+  std::vector<uint32_t> splits_{};
+  std::vector<FreezeState> freeze_{};
+  double aheadMs_ = 0.0; uint32_t aheadThreads_ = 1;
+  std::vector<std::unique_ptr<AnticipatedRack>> ahead_{}; // per rack; nullptr = rendered in the callback
+  RenderAheadThreads aheadWorkers_{};
+  std::atomic<uint64_t> aheadFallbacks_{0};
+  std::atomic<uint64_t> aheadUnderruns_{0};
+  std::thread freezeResetThread_{};
+  std::atomic<bool> freezeResetRunning_{false};
+  std::atomic<uint64_t> freezeHeldDropped_{0};
 };
 
 
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../core/Command.hpp"
+#include "../core/Graph.hpp"
+#if defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+// A rack rendered ahead of the audio clock by a worker thread into a lookahead ring. The rack's
+// commands reach the worker through its own queue, fed from the known timeline (transport loops,
+// session commands); the audio thread only copies from the ring. Positions are absolute frames.
+//
+// A live command for the rack hands the graph back to the audio thread: the worker stops after
+// its current chunk, the audio thread plays the ring up to that checkpoint and renders the graph
+// synchronously from there, draining the rack queue itself.
+class AnticipatedRack {
+public:
+  static constexpr uint32_t kChunkFrames = 256;
+  using Queue = SpscCommandQueue<16384>;
+  enum class Mode : uint8_t { Ahead, Handing, Sync }; // audio thread only
+
+  AnticipatedRack(Graph* graph, uint32_t channels, double sampleRate, uint64_t aheadFrames)
+    : graph_(graph), channels_(channels), sampleRate_(sampleRate),
+      aheadFrames_(std::max<uint64_t>(aheadFrames, kChunkFrames)),
+      capacity_((aheadFrames_ / kChunkFrames + 2) * kChunkFrames),
+      ring_(static_cast<size_t>(capacity_) * channels, 0.0f), queue_(std::make_unique<Queue>()) {
+    events_.reserve(1024);
+    pending_.reserve(kMaxPending);
+  }
+
+  Queue& queue() { return *queue_; }
+  uint64_t aheadFrames() const { return aheadFrames_; }
+  uint64_t written() const { return written_.load(std::memory_order_acquire); }
+
+  // Worker: render the next chunk when the ring is less than aheadFrames ahead of the reader.
+  // Returns true when a chunk was rendered.
+  bool renderNext() {
+    if (stop_.load(std::memory_order_acquire)) { handedOver_.store(true, std::memory_order_release); return false; }
+    const uint64_t w = written_.load(std::memory_order_relaxed);
+    if (w + kChunkFrames > consumed_.load(std::memory_order_acquire) + aheadFrames_) return false;
+    events_.clear();
+    queue_->drainUpTo(w + kChunkFrames, events_);
+    for (auto& e : events_) if (e.sampleTime < w) e.sampleTime = w;
+    sortEvents(events_.data(), events_.data() + events_.size());
+    ProcessContext ctx{}; ctx.sampleRate = sampleRate_; ctx.frames = kChunkFrames; ctx.blockStart = w;
+    ctx.events = events_.data(); ctx.eventCount = static_cast<uint32_t>(events_.size());
+    graph_->process(ctx, ring_.data() + static_cast<size_t>(w % capacity_) * channels_, channels_);
+    written_.store(w + kChunkFrames, std::memory_order_release);
+    return true;
+  }
+
+  // Audio thread: copy frames [t, t + frames) from the ring. Frames the worker has not rendered
+  // yet are zeroed; returns their count.
+  uint32_t read(SampleTime t, uint32_t frames, float* dst) noexcept {
+    const uint64_t w = written_.load(std::memory_order_acquire);
+    const uint32_t avail = w > t ? static_cast<uint32_t>(std::min<uint64_t>(w - t, frames)) : 0u;
+    uint32_t done = 0;
+    while (done < avail) {
+      const uint64_t pos = (t + done) % capacity_;
+      const uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(avail - done, capacity_ - pos));
+      std::memcpy(dst + static_cast<size_t>(done) * channels_, ring_.data() + static_cast<size_t>(pos) * channels_, static_cast<size_t>(n) * channels_ * sizeof(float));
+      done += n;
+    }
+    if (avail < frames) std::fill(dst + static_cast<size_t>(avail) * channels_, dst + static_cast<size_t>(frames) * channels_, 0.0f);
+    if (t + frames > consumed_.load(std::memory_order_relaxed)) consumed_.store(t + frames, std::memory_order_release);
+    return frames - avail;
+  }
+
+  // Audio thread: hand the graph back (first live command); later live commands are held in
+  // pending() until the checkpoint
+  void requestSync() { stop_.store(true, std::memory_order_release); mode = Mode::Handing; }
+  bool handedOver() const { return handedOver_.load(std::memory_order_acquire); }
+  bool holdLive(const Command& c) { if (pending_.size() >= kMaxPending) return false; pending_.push_back(c); return true; }
+  std::vector<Command>& pending() { return pending_; }
+
+  Mode mode = Mode::Ahead;
+  SampleTime syncFrom = 0; // first frame rendered synchronously (valid in Mode::Sync)
+
+private:
+  static constexpr size_t kMaxPending = 256;
+  Graph* graph_ = nullptr;
+  uint32_t channels_ = 2;
+  double sampleRate_ = 48000.0;
+  uint64_t aheadFrames_ = 0;
+  uint64_t capacity_ = 0;
+  std::vector<float> ring_;
+  std::unique_ptr<Queue> queue_;
+  std::vector<Command> events_;  // worker
+  std::vector<Command> pending_; // audio thread
+  std::atomic<uint64_t> written_{0};
+  std::atomic<uint64_t> consumed_{0};
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> handedOver_{false};
+};
+
+// Worker threads for anticipated racks; rack i is rendered by thread i % threads. Each thread
+// keeps its racks' rings filled and sleeps briefly when all of them are far enough ahead.
+class RenderAheadThreads {
+public:
+  ~RenderAheadThreads() { stop(); }
+
+  void start(const std::vector<AnticipatedRack*>& racks, uint32_t threads) {
+    stop();
+    if (racks.empty()) return;
+    threads = std::max(1u, std::min<uint32_t>(threads, static_cast<uint32_t>(racks.size())));
+    running_.store(true);
+    for (uint32_t t = 0; t < threads; ++t) {
+      std::vector<AnticipatedRack*> mine;
+      for (size_t i = t; i < racks.size(); i += threads) mine.push_back(racks[i]);
+      threads_.emplace_back([this, mine] { run(mine); });
+    }
+  }
+
+  void stop() {
+    running_.store(false);
+    for (auto& t : threads_) if (t.joinable()) t.join();
+    threads_.clear();
+  }
+
+private:
+  void run(const std::vector<AnticipatedRack*>& racks) {
+#if defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+#endif
+    while (running_.load(std::memory_order_relaxed)) {
+      bool rendered = false;
+      for (auto* r : racks) rendered |= r->renderNext();
+      if (!rendered) std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+  }
+
+  std::atomic<bool> running_{false};
+  std::vector<std::thread> threads_;
+};
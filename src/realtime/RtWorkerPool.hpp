@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Worker pool for fork/join inside the audio callback.
+// - Workers spin for spinUs after each job, then sleep on a futex (Linux) or mach semaphore
+//   (macOS); the callback never takes a lock or allocates.
+// - The calling thread also claims tasks, so a late worker only costs parallelism, never a
+//   missed deadline waiting on a thread that has not woken up.
+// - Task claims are tagged with the job generation, so a worker waking late cannot run a
+//   task of a newer job with stale arguments.
+// - Small budgets (short blocks, or a budget close to the observed wakeup latency) and single
+//   task jobs run serially on the caller.
+class RtWorkerPool {
+public:
+  using TaskFn = void(*)(void* ctx, size_t index);
+
+  struct Stats {
+    uint64_t jobs = 0;
+    uint64_t parallelJobs = 0;
+    uint64_t serialJobs = 0;
+    double speedupSum = 0.0;   // busy time / wall time, parallel jobs only
+    double speedupMin = 0.0;
+    uint64_t wakeups = 0;
+    double wakeUsSum = 0.0;
+    double wakeUsMax = 0.0;
+    double speedupAvg() const { return parallelJobs ? speedupSum / static_cast<double>(parallelJobs) : 1.0; }
+    double wakeUsAvg() const { return wakeups ? wakeUsSum / static_cast<double>(wakeups) : 0.0; }
+  };
+
+  RtWorkerPool(uint32_t workers, double spinUs, double sampleRate, uint32_t maxBlockFrames)
+    : spinNs_(static_cast<int64_t>(std::max(0.0, spinUs) * 1000.0)), sampleRate_(sampleRate), maxBlockFrames_(maxBlockFrames) {
+    workers_.reserve(workers);
+    for (uint32_t i = 0; i < workers; ++i) workers_.emplace_back([this, i] { workerLoop(i); });
+  }
+  ~RtWorkerPool() { stop(); }
+  RtWorkerPool(const RtWorkerPool&) = delete;
+  RtWorkerPool& operator=(const RtWorkerPool&) = delete;
+
+  void stop() {
+    if (stop_.exchange(true)) return;
+    gen_.fetch_add(1, std::memory_order_release);
+    wakeAll();
+    for (auto& t : workers_) if (t.joinable()) t.join();
+#if defined(__APPLE__)
+    if (sem_ != 0) { semaphore_destroy(mach_task_self(), sem_); sem_ = 0; }
+#endif
+  }
+
+  size_t workerCount() const { return workers_.size(); }
+  // Budgets below this run serially (default: 1 ms)
+  void setMinParallelBudgetUs(double us) { minBudgetUs_ = std::max(0.0, us); }
+
+  // Run fn(ctx, i) for i in [0, count) and return when all tasks finished. Audio thread only.
+  void run(size_t count, TaskFn fn, void* ctx, uint32_t blockFrames) {
+    if (count == 0) return;
+    const double budgetUs = 1.0e6 * static_cast<double>(blockFrames) / sampleRate_;
+    if (workers_.empty() || count < 2 || budgetUs < minBudgetUs_ || budgetUs < 4.0 * wakeEwmaUs_) {
+      for (Stats* st : {&interval_, &total_}) { ++st->jobs; ++st->serialJobs; }
+      wakeEwmaUs_ *= 0.999; // let the estimate recover so parallel mode is probed again
+      for (size_t i = 0; i < count; ++i) fn(ctx, i);
+      return;
+    }
+    fn_ = fn; ctx_ = ctx; count_.store(static_cast<uint32_t>(count), std::memory_order_relaxed);
+    done_.store(0, std::memory_order_relaxed);
+    busyNs_.store(0, std::memory_order_relaxed);
+    wakeNsSum_.store(0, std::memory_order_relaxed); wakeNsMax_.store(0, std::memory_order_relaxed); wakeCount_.store(0, std::memory_order_relaxed);
+    const uint32_t g = gen_.load(std::memory_order_relaxed) + 1;
+    const int64_t t0 = nowNs();
+    publishNs_.store(t0, std::memory_order_relaxed);
+    claim_.store(static_cast<uint64_t>(g) << 32, std::memory_order_release);
+    gen_.store(g, std::memory_order_release);
+    wakeAll();
+    drain(g);
+    while (done_.load(std::memory_order_acquire) < count) { /* spin: remaining tasks are already running */ }
+    const int64_t wall = std::max<int64_t>(1, nowNs() - t0);
+    const double speedup = static_cast<double>(busyNs_.load(std::memory_order_relaxed)) / static_cast<double>(wall);
+    const uint64_t wc = wakeCount_.load(std::memory_order_relaxed);
+    const double wakeSumUs = static_cast<double>(wakeNsSum_.load(std::memory_order_relaxed)) / 1000.0;
+    const double wakeMaxUs = static_cast<double>(wakeNsMax_.load(std::memory_order_relaxed)) / 1000.0;
+    for (Stats* st : {&interval_, &total_}) {
+      ++st->jobs;
+      st->speedupMin = (st->parallelJobs == 0) ? speedup : std::min(st->speedupMin, speedup);
+      ++st->parallelJobs; st->speedupSum += speedup;
+      st->wakeups += wc; st->wakeUsSum += wakeSumUs; st->wakeUsMax = std::max(st->wakeUsMax, wakeMaxUs);
+    }
+    if (wc > 0) wakeEwmaUs_ += 0.05 * (wakeSumUs / static_cast<double>(wc) - wakeEwmaUs_);
+  }
+
+  // Convenience wrapper for callables; fn must outlive the call (it does: run() joins)
+  template <typename Fn>
+  void parallelFor(size_t count, uint32_t blockFrames, Fn& fn) {
+    run(count, [](void* c, size_t i) { (*static_cast<Fn*>(c))(i); }, &fn, blockFrames);
+  }
+
+  // Audio-thread view: interval stats are cleared by resetIntervalStats(), totals never
+  const Stats& intervalStats() const { return interval_; }
+  const Stats& totalStats() const { return total_; }
+  void resetIntervalStats() { interval_ = Stats{}; }
+
+private:
+  static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Claim and run tasks of generation g until none are left
+  void drain(uint32_t g) {
+    for (;;) {
+      uint64_t v = claim_.load(std::memory_order_acquire);
+      uint32_t idx = 0;
+      do {
+        if (static_cast<uint32_t>(v >> 32) != g) return;
+        idx = static_cast<uint32_t>(v & 0xffffffffu);
+        if (idx >= count_.load(std::memory_order_relaxed)) return;
+      } while (!claim_.compare_exchange_weak(v, v + 1, std::memory_order_acq_rel, std::memory_order_acquire));
+      const int64_t t0 = nowNs();
+      fn_(ctx_, idx);
+      busyNs_.fetch_add(static_cast<uint64_t>(nowNs() - t0), std::memory_order_relaxed);
+      done_.fetch_add(1, std::memory_order_acq_rel);
+    }
+  }
+
+  void workerLoop(uint32_t index) {
+    configureWorkerThread(index);
+    uint32_t seen = gen_.load(std::memory_order_acquire);
+    while (!stop_.load(std::memory_order_acquire)) {
+      uint32_t g = gen_.load(std::memory_order_acquire);
+      if (g == seen) {
+        const int64_t spinUntil = nowNs() + spinNs_;
+        while ((g = gen_.load(std::memory_order_acquire)) == seen && nowNs() < spinUntil) {}
+        if (g == seen) { waitForJob(seen); continue; }
+      }
+      seen = g;
+      if (stop_.load(std::memory_order_acquire)) break;
+      const int64_t lat = nowNs() - publishNs_.load(std::memory_order_relaxed);
+      if (lat > 0) {
+        wakeNsSum_.fetch_add(static_cast<uint64_t>(lat), std::memory_order_relaxed);
+        wakeCount_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t prev = wakeNsMax_.load(std::memory_order_relaxed);
+        while (static_cast<uint64_t>(lat) > prev && !wakeNsMax_.compare_exchange_weak(prev, static_cast<uint64_t>(lat), std::memory_order_relaxed)) {}
+      }
+      drain(g);
+    }
+  }
+
+  // Sleep/wake handshake (Dekker style): the worker publishes sleepers_ then reads gen_, the
+  // publisher stores gen_ then reads sleepers_. The seq_cst fences on both sides keep each store
+  // ahead of the following load, so at least one side sees the other and no wake is lost.
+  void waitForJob(uint32_t seen) {
+#if defined(__linux__)
+    sleepers_.fetch_add(1, std::memory_order_acq_rel);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&gen_), FUTEX_WAIT_PRIVATE, seen, nullptr, nullptr, 0);
+    sleepers_.fetch_sub(1, std::memory_order_acq_rel);
+#elif defined(__APPLE__)
+    sleepers_.fetch_add(1, std::memory_order_acq_rel);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (gen_.load(std::memory_order_acquire) == seen) semaphore_wait(sem_);
+    sleepers_.fetch_sub(1, std::memory_order_acq_rel);
+#else
+    (void)seen; std::this_thread::yield();
+#endif
+  }
+
+  void wakeAll() {
+    std::atomic_thread_fence(std::memory_order_seq_cst); // gen_ store before the sleepers_ load
+#if defined(__linux__)
+    // Skip the syscall while every worker is still spinning
+    if (sleepers_.load(std::memory_order_acquire) > 0) syscall(SYS_futex, reinterpret_cast<uint32_t*>(&gen_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#elif defined(__APPLE__)
+    // Signal once per sleeper; extra signals only cause a spurious re-check
+    const int n = sleepers_.load(std::memory_order_acquire);
+    for (int i = 0; i < n; ++i) semaphore_signal(sem_);
+#endif
+  }
+
+  // Best effort: pin to a core and request realtime scheduling sized to the audio block
+  void configureWorkerThread(uint32_t index) {
+#if defined(__APPLE__)
+    thread_affinity_policy_data_t aff{ static_cast<integer_t>(index + 1) };
+    thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_AFFINITY_POLICY, reinterpret_cast<thread_policy_t>(&aff), THREAD_AFFINITY_POLICY_COUNT);
+    mach_timebase_info_data_t tb{}; mach_timebase_info(&tb);
+    const double nsToAbs = (tb.numer > 0) ? static_cast<double>(tb.denom) / static_cast<double>(tb.numer) : 1.0;
+    const double periodNs = 1.0e9 * static_cast<double>(maxBlockFrames_) / sampleRate_;
+    thread_time_constraint_policy_data_t tc{};
+    tc.period = static_cast<uint32_t>(periodNs * nsToAbs);
+    tc.computation = static_cast<uint32_t>(0.5 * periodNs * nsToAbs);
+    tc.constraint = static_cast<uint32_t>(periodNs * nsToAbs);
+    tc.preemptible = 1;
+    thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_TIME_CONSTRAINT_POLICY, reinterpret_cast<thread_policy_t>(&tc), THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+#elif defined(__linux__)
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set; CPU_ZERO(&set); CPU_SET((index + 1) % hw, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    sched_param sp{}; sp.sched_priority = std::max(1, sched_get_priority_max(SCHED_FIFO) - 1);
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp); // needs CAP_SYS_NICE; ignored otherwise
+#else
+    (void)index;
+#endif
+  }
+
+#if defined(__APPLE__)
+  static semaphore_t makeSemaphore() { semaphore_t s = 0; semaphore_create(mach_task_self(), &s, SYNC_POLICY_FIFO, 0); return s; }
+  semaphore_t sem_ = makeSemaphore();
+#endif
+  std::atomic<int> sleepers_{0};
+  std::atomic<uint32_t> gen_{0};
+  std::atomic<uint64_t> claim_{0};    // generation << 32 | next task index
+  std::atomic<uint32_t> done_{0};
+  std::atomic<bool> stop_{false};
+  std::atomic<int64_t> publishNs_{0};
+  std::atomic<uint64_t> busyNs_{0};
+  std::atomic<uint64_t> wakeNsSum_{0};
+  std::atomic<uint64_t> wakeNsMax_{0};
+  std::atomic<uint64_t> wakeCount_{0};
+  TaskFn fn_ = nullptr;
+  void* ctx_ = nullptr;
+  std::atomic<uint32_t> count_{0};
+  int64_t spinNs_ = 50000;
+  double sampleRate_ = 48000.0;
+  uint32_t maxBlockFrames_ = 512;
+  double minBudgetUs_ = 1000.0;
+  double wakeEwmaUs_ = 0.0;
+  Stats interval_{};
+  Stats total_{};
+  std::vector<std::thread> workers_;
+};
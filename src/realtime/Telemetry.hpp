@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include "../core/Command.hpp"
+#if defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+// Fixed-size POD record pushed by the audio thread. Strings are pointers to ids that stay
+// alive while the renderer runs (rack/bus/xfader/node ids, string literals); the writer
+// thread does all formatting, dB conversion and file I/O.
+struct TelemetryRecord {
+  enum class Kind : uint8_t {
+    Meter,    // id, aux: 0 = rack / 1 = bus; v = {peak, sumSq, samples}; t = block end
+    Event,    // cmd = the delivered command (sampleTime = delivery time); tag may name it
+    Xfader,   // id; v = {x, gainA, gainB}
+    Drained,  // u = commands drained; t..t2 = block range
+    Loop,     // u = loop index
+    Pool,     // v = {jobs, parallel, serial, speedupAvg, speedupMin, wakeUsAvg, wakeUsMax}
+    Interval  // end of a meters interval: flush files, write sample cache / telemetry lines
+  };
+  Kind kind = Kind::Meter;
+  uint8_t aux = 0;
+  uint64_t u = 0;
+  SampleTime t = 0, t2 = 0;
+  const char* id = nullptr;
+  const char* tag = nullptr;
+  Command cmd{};
+  double v[7] = {};
+};
+
+// Single-producer/single-consumer ring of telemetry records. push never blocks or allocates;
+// when the ring is full the record is dropped and counted.
+template <size_t Capacity>
+class TelemetryRing {
+public:
+  bool push(const TelemetryRecord& r) noexcept {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t next = (head + 1) % Capacity;
+    if (next == tail_.load(std::memory_order_acquire)) { dropped_.fetch_add(1, std::memory_order_relaxed); return false; }
+    buffer_[head] = r;
+    head_.store(next, std::memory_order_release);
+    pushed_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool pop(TelemetryRecord& out) noexcept {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    out = buffer_[tail];
+    tail_.store((tail + 1) % Capacity, std::memory_order_release);
+    return true;
+  }
+
+  uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+  uint64_t pushed() const noexcept { return pushed_.load(std::memory_order_relaxed); }
+
+private:
+  TelemetryRecord buffer_[Capacity];
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> pushed_{0};
+};
+
+// Low-priority thread that drains a TelemetryRing every few ms and hands each record to a
+// sink (formatting + stderr/NDJSON writes). stop() drains what is left before joining.
+class TelemetryWriter {
+public:
+  static constexpr size_t kCapacity = 4096;
+  using Sink = std::function<void(const TelemetryRecord&)>;
+
+  ~TelemetryWriter() { stop(); }
+
+  void start(Sink sink) {
+    stop();
+    sink_ = std::move(sink);
+    running_.store(true);
+    thread_ = std::thread([this] { run(); });
+  }
+
+  void stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    drain();
+  }
+
+  bool running() const noexcept { return running_.load(std::memory_order_relaxed); }
+  // Audio thread: returns false when the ring is full (counted as dropped) or no writer runs
+  bool push(const TelemetryRecord& r) noexcept { return running() ? ring_.push(r) : false; }
+  uint64_t dropped() const noexcept { return ring_.dropped(); }
+  uint64_t records() const noexcept { return ring_.pushed(); }
+
+private:
+  void run() {
+#if defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#endif
+    while (running_.load()) {
+      drain();
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  }
+
+  void drain() {
+    TelemetryRecord r;
+    while (ring_.pop(r)) if (sink_) sink_(r);
+  }
+
+  TelemetryRing<kCapacity> ring_;
+  Sink sink_;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+};
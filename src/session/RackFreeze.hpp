@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../core/Command.hpp"
+#include "../core/Graph.hpp"
+#include "../core/GraphConfig.hpp"
+#include "../core/Sha1.hpp"
+#include "../io/AsyncFileWriter.hpp"
+#include "../io/MappedFile.hpp"
+#include "../offline/OfflineTimelineRenderer.hpp"
+
+// Pre-rendered audio of a frozen rack: two loops of interleaved float32 in a memory-mapped
+// file. Loop 0 is the intro (no tails from an earlier loop), loop 1 the steady state with the
+// earlier loops' tails rung in; playback continues with loop 1 for every later loop.
+class FrozenRack {
+public:
+  FrozenRack(const std::string& path, uint64_t loopLen, uint32_t channels) : loopLen_(loopLen), channels_(channels) {
+    file_.open(path);
+    if (file_.size() != static_cast<size_t>(2 * loopLen * channels) * sizeof(float)) throw std::runtime_error("Frozen rack file has the wrong size: " + path);
+    data_ = reinterpret_cast<const float*>(file_.data());
+    file_.touch(0, file_.size());
+  }
+
+  // Copy frames [t, t + frames) of the rack timeline into dst; no allocation, safe on the audio thread
+  void read(SampleTime t, uint32_t frames, float* dst) const noexcept {
+    while (frames > 0) {
+      const uint64_t pos = t < loopLen_ ? t : loopLen_ + (t - loopLen_) % loopLen_;
+      const uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(frames, 2 * loopLen_ - pos));
+      std::memcpy(dst, data_ + pos * channels_, static_cast<size_t>(n) * channels_ * sizeof(float));
+      dst += static_cast<size_t>(n) * channels_; t += n; frames -= n;
+    }
+  }
+
+  uint64_t loopLen() const { return loopLen_; }
+  size_t bytes() const { return file_.size(); }
+
+private:
+  MappedFile file_;
+  const float* data_ = nullptr;
+  uint64_t loopLen_ = 0;
+  uint32_t channels_ = 2;
+};
+
+// Cache file name for a frozen rack: rack id plus a digest of everything the render depends on
+// (rack JSON, the rack's commands after overrides and rescaling, sample rate, channels, loop
+// length, random seed). Sample files referenced by the rack are not part of the digest.
+inline std::string frozenRackCachePath(const std::string& cacheDir, const std::string& rackId, const std::string& rackPath,
+                                       const std::vector<GraphSpec::CommandSpec>& cmds, uint32_t sampleRate,
+                                       uint32_t channels, uint64_t loopLen, uint32_t randomSeed) {
+  std::ostringstream key;
+  { std::ifstream f(rackPath, std::ios::binary); key << f.rdbuf(); }
+  key << '\n' << sampleRate << ' ' << channels << ' ' << loopLen << ' ' << randomSeed << '\n';
+  for (const auto& c : cmds) key << c.sampleTime << ' ' << c.nodeId << ' ' << c.type << ' ' << c.paramId << ' ' << c.paramName << ' ' << c.value << ' ' << c.rampMs << '\n';
+  const std::string k = key.str();
+  std::string name = rackId;
+  for (auto& ch : name) if (ch == '/' || ch == ':' || ch == '\\') ch = '_';
+  return (std::filesystem::path(cacheDir) / (name + "-" + computeSha1Hex(k.data(), k.size()).substr(0, 16) + ".f32")).string();
+}
+
+// Render the rack's intro and steady-state loops offline (or reuse a cached render) and map the result.
+// The graph is left prepared and reset for live playback. Throws on I/O errors.
+inline std::unique_ptr<FrozenRack> freezeRack(Graph& graph, const std::string& rackId, const std::string& rackPath,
+                                              const std::vector<GraphSpec::CommandSpec>& cmds, uint32_t sampleRate,
+                                              uint32_t channels, uint64_t loopLen, uint32_t randomSeed, const std::string& cacheDir) {
+  if (loopLen == 0) throw std::runtime_error("rack '" + rackId + "' has no transport loop");
+  const std::string path = frozenRackCachePath(cacheDir, rackId, rackPath, cmds, sampleRate, channels, loopLen, randomSeed);
+  const uintmax_t expected = static_cast<uintmax_t>(2 * loopLen * channels) * sizeof(float);
+  std::error_code ec;
+  if (std::filesystem::file_size(path, ec) == expected && !ec) {
+    std::fprintf(stderr, "[freeze] rack=%s reusing %s\n", rackId.c_str(), path.c_str());
+  } else {
+    // Feedback tails (delays, reverbs) can span several loops: keep rendering until the graph
+    // state repeats after a loop (graphs that can't hash their state: kMaxWarmLoops) and store
+    // the last loop as the steady one
+    constexpr uint32_t kMaxWarmLoops = 8;
+    std::vector<GraphSpec::CommandSpec> loopCmds; loopCmds.reserve(cmds.size() * kMaxWarmLoops);
+    for (uint64_t rep = 0; rep < kMaxWarmLoops; ++rep) {
+      for (auto c : cmds) { c.sampleTime += rep * loopLen; loopCmds.push_back(std::move(c)); }
+    }
+    const std::vector<GraphSpec::CommandSpec> sorted = sortedCommands(loopCmds);
+    const auto t0 = std::chrono::steady_clock::now();
+    graph.prepare(sampleRate, 1024);
+    graph.reset();
+    const size_t loopSamples = static_cast<size_t>(loopLen * channels);
+    std::vector<float> audio(2 * loopSamples, 0.0f);
+    size_t cmdIndex = 0;
+    std::vector<Command> events;
+    uint64_t prevHash = 0;
+    uint32_t loops = 0;
+    while (loops < kMaxWarmLoops) {
+      float* dst = audio.data() + (loops == 0 ? 0 : loopSamples);
+      if (loops > 0) std::fill(dst, dst + loopSamples, 0.0f);
+      const uint64_t base = static_cast<uint64_t>(loops) * loopLen;
+      for (uint64_t f = 0; f < loopLen; f += 1024) {
+        const uint32_t n = static_cast<uint32_t>(std::min<uint64_t>(1024, loopLen - f));
+        renderCommandBlock(graph, sorted, cmdIndex, events, sampleRate, channels, base + f, n, dst + static_cast<size_t>(f * channels));
+      }
+      ++loops;
+      StateHash h;
+      if (!graph.hashState(h)) continue;
+      if (loops >= 2 && h.value() == prevHash) break;
+      prevHash = h.value();
+    }
+    std::filesystem::create_directories(cacheDir);
+    const std::string tmp = path + ".tmp";
+    AsyncFileWriter io;
+    try {
+      io.open(tmp);
+      io.write(audio.data(), audio.size() * sizeof(float));
+      io.close();
+    } catch (const std::exception& e) {
+      throw std::runtime_error(std::string("Failed to write frozen rack file: ") + e.what());
+    }
+    std::filesystem::rename(tmp, path);
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::fprintf(stderr, "[freeze] rack=%s rendered %u loops (%.2fs of audio) in %.3fs -> %s (write %.0f MB/s)\n", rackId.c_str(), loops,
+                 static_cast<double>(loops * loopLen) / sampleRate, sec, path.c_str(), io.stats().mbPerSec());
+  }
+  graph.prepare(sampleRate, 1024);
+  graph.reset();
+  return std::make_unique<FrozenRack>(path, loopLen, channels);
+}
@@ -0,0 +1,456 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "SessionSpec.hpp"
+#include "../core/ChannelLayout.hpp"
+#include "../core/GainRamp.hpp"
+#include "../core/Graph.hpp"
+#include "../core/SpectralDuckerNode.hpp"
+
+inline void configureSpectralDuckerFromParams(SpectralDuckerNode& duck, const nlohmann::json& params) {
+  try {
+    if (params.contains("mix")) duck.mix = params["mix"].get<float>();
+    if (params.contains("detectorHpfHz")) duck.scHpfHz = params["detectorHpfHz"].get<float>();
+    if (params.contains("applyMode")) {
+      const std::string m = params["applyMode"].get<std::string>();
+      duck.applyMode = (m == std::string("dynamicEq")) ? SpectralDuckerNode::ApplyMode::DynamicEq : SpectralDuckerNode::ApplyMode::Multiply;
+    }
+    if (params.contains("stereoMode")) {
+      const std::string sm = params["stereoMode"].get<std::string>();
+      duck.stereoMode = (sm == std::string("MidSide")) ? SpectralDuckerNode::StereoMode::MidSide : SpectralDuckerNode::StereoMode::LR;
+    }
+    if (params.contains("msSideScale")) duck.msSideScale = params["msSideScale"].get<float>();
+  } catch (...) {}
+}
+
+// Session routing compiled once into an index-addressed DAG:
+//   racks → sidechain taps → buses → inserts → master
+// String ids are resolved at compile time, mute/solo is folded into an active mask and all
+// scratch is preallocated, so process() does no lookups or allocations. The realtime and
+// offline session renderers both mix through this graph, which keeps them in parity.
+class SessionGraph {
+public:
+  struct RackDesc { std::string id; float gain = 1.0f; bool muted = false; bool solo = false; };
+  enum class StepKind : uint8_t { Rack, SidechainTap, Bus, Insert, Master };
+  struct Step { StepKind kind = StepKind::Master; uint32_t index = 0; };
+  struct Xfader {
+    std::string id; uint32_t a = 0; uint32_t b = 0;
+    bool lawEqualPower = true; double smoothingMs = 10.0;
+    bool lfoEnabled = false; double freqHz = 0.25; double phase01 = 0.0;
+    double x = 0.5; double xTarget = 0.5; double lastGA = 1.0; double lastGB = 1.0;
+    std::vector<float> gainA, gainB; // per-sample gains of the last block (when not steady)
+    bool steady = false;
+  };
+
+  void compile(const std::vector<RackDesc>& racks,
+               const std::vector<SessionSpec::BusRef>& buses,
+               const std::vector<SessionSpec::RouteRef>& routes,
+               uint32_t channels) {
+    if (channels == 0) throw std::invalid_argument("SessionGraph: channels must be > 0");
+    channels_ = channels;
+    masterLayout_ = defaultLayoutForChannels(channels_);
+    racks_.clear(); buses_.clear(); routes_.clear(); taps_.clear(); inserts_.clear(); detectors_.clear(); xfaders_.clear();
+    std::unordered_map<std::string, uint32_t> rackIndex, busIndex;
+    bool anySolo = false; for (const auto& r : racks) if (r.solo) { anySolo = true; break; }
+    for (const auto& r : racks) {
+      RackNode n; n.id = r.id; n.gain.setImmediate(r.gain); n.active = !r.muted && (!anySolo || r.solo);
+      rackIndex.emplace(r.id, static_cast<uint32_t>(racks_.size()));
+      racks_.push_back(std::move(n));
+    }
+    for (const auto& b : buses) {
+      BusNode n; n.id = b.id; n.channels = (b.channels > 0) ? b.channels : channels_;
+      n.layout = defaultLayoutForChannels(n.channels);
+      if (!b.layout.empty() && !parseChannelLayout(b.layout, n.layout)) {
+        std::fprintf(stderr, "Warning: bus %s has unknown layout '%s'; using %s\n", b.id.c_str(), b.layout.c_str(), channelLayoutName(n.layout));
+      }
+      n.channels = channelCountForLayout(n.layout, n.channels);
+      n.toMaster = makeChannelMixMatrix(n.layout, n.channels, masterLayout_, channels_);
+      n.fromRack = makeChannelMixMatrix(masterLayout_, channels_, n.layout, n.channels);
+      busIndex.emplace(b.id, static_cast<uint32_t>(buses_.size()));
+      buses_.push_back(std::move(n));
+    }
+    for (const auto& rt : routes) {
+      auto ir = rackIndex.find(rt.from); auto ib = busIndex.find(rt.to);
+      if (ir == rackIndex.end() || ib == busIndex.end()) {
+        std::fprintf(stderr, "Warning: session route %s -> %s ignored (unknown rack or bus)\n", rt.from.c_str(), rt.to.c_str());
+        continue;
+      }
+      racks_[ir->second].routed = true;
+      if (!racks_[ir->second].active) continue;
+      buses_[ib->second].routesIn.push_back(static_cast<uint32_t>(routes_.size()));
+      routes_.push_back(Route{ir->second, ib->second, rt.gain});
+    }
+    for (size_t bi = 0; bi < buses.size(); ++bi) {
+      for (const auto& ins : buses[bi].inserts) {
+        if (ins.type != std::string("spectral_ducker")) {
+          std::fprintf(stderr, "Warning: unknown bus insert type '%s' on bus %s (skipped)\n", ins.type.c_str(), buses[bi].id.c_str());
+          continue;
+        }
+        InsertNode n; n.bus = static_cast<uint32_t>(bi);
+        n.duck = std::make_unique<SpectralDuckerNode>();
+        configureSpectralDuckerFromParams(*n.duck, ins.params);
+        Tap tap; tap.bus = n.bus;
+        for (const auto& sc : ins.sidechains) {
+          auto ir = rackIndex.find(sc.second);
+          if (ir == rackIndex.end()) {
+            std::fprintf(stderr, "Warning: sidechain source rack '%s' not found for insert on bus %s\n", sc.second.c_str(), buses[bi].id.c_str());
+            continue;
+          }
+          if (racks_[ir->second].active) tap.racks.push_back(ir->second);
+        }
+        // Inserts keyed by the same racks into equally shaped buses read one tap, and those with
+        // equal detector settings one detector: the key is summed and analysed once per block
+        auto same = std::find_if(taps_.begin(), taps_.end(), [&](const Tap& t) {
+          return t.racks == tap.racks && buses_[t.bus].channels == buses_[n.bus].channels && buses_[t.bus].layout == buses_[n.bus].layout;
+        });
+        n.tap = static_cast<uint32_t>(same - taps_.begin());
+        if (same == taps_.end()) taps_.push_back(std::move(tap));
+        const SidechainDetector::Config config = n.duck->detectorConfig();
+        auto det = std::find_if(detectors_.begin(), detectors_.end(), [&](const KeyDetector& d) {
+          return d.tap == n.tap && d.detector->config() == config;
+        });
+        n.detector = static_cast<uint32_t>(det - detectors_.begin());
+        if (det == detectors_.end()) {
+          KeyDetector d; d.tap = n.tap; d.detector = std::make_unique<SidechainDetector>(); d.detector->configure(config);
+          detectors_.push_back(std::move(d));
+        }
+        buses_[bi].inserts.push_back(static_cast<uint32_t>(inserts_.size()));
+        inserts_.push_back(std::move(n));
+      }
+    }
+    buildOrder();
+  }
+
+  // Crossfaders reference racks by id; pairs with unknown racks are dropped
+  void setXfaders(const std::vector<SessionSpec::XfaderRef>& xs) {
+    xfaders_.clear();
+    for (const auto& xr : xs) {
+      if (xr.racks.size() < 2) continue;
+      const uint32_t a = rackIndexOf(xr.racks[0]); const uint32_t b = rackIndexOf(xr.racks[1]);
+      if (a == kNone || b == kNone) {
+        std::fprintf(stderr, "Warning: xfader %s references unknown racks (ignored)\n", xr.id.c_str());
+        continue;
+      }
+      Xfader xf; xf.id = xr.id; xf.a = a; xf.b = b;
+      xf.lawEqualPower = (xr.law != std::string("linear"));
+      xf.smoothingMs = xr.smoothingMs;
+      xf.lfoEnabled = xr.lfo.has; xf.freqHz = xr.lfo.freqHz; xf.phase01 = xr.lfo.phase01;
+      xf.x = xf.lfoEnabled ? 0.5 * (std::sin(2.0 * M_PI * xf.phase01) + 1.0) : 0.5;
+      xf.xTarget = xf.x;
+      xf.gainA.assign(maxFrames_, 1.0f); xf.gainB.assign(maxFrames_, 1.0f);
+      xfaders_.push_back(std::move(xf));
+    }
+  }
+
+  void prepare(double sampleRate, uint32_t maxFrames) {
+    sampleRate_ = (sampleRate > 0.0) ? sampleRate : 48000.0;
+    maxFrames_ = std::max<uint32_t>(maxFrames, 1u);
+    const size_t rackSamples = static_cast<size_t>(maxFrames_) * channels_;
+    for (auto& r : racks_) r.buffer.assign(r.active ? rackSamples : 0u, 0.0f);
+    for (auto& b : buses_) b.buffer.assign(static_cast<size_t>(maxFrames_) * b.channels, 0.0f);
+    for (auto& t : taps_) t.buffer.assign(static_cast<size_t>(maxFrames_) * buses_[t.bus].channels, 0.0f);
+    for (auto& ins : inserts_) ins.duck->prepare(sampleRate_, maxFrames_);
+    for (auto& d : detectors_) d.detector->prepare(sampleRate_, maxFrames_);
+    for (auto& r : racks_) r.gainBuf.assign(maxFrames_, 1.0f);
+    for (auto& b : buses_) b.gainBuf.assign(maxFrames_, 1.0f);
+    for (auto& xf : xfaders_) { xf.gainA.assign(maxFrames_, 1.0f); xf.gainB.assign(maxFrames_, 1.0f); }
+  }
+
+  void reset() {
+    for (auto& ins : inserts_) ins.duck->reset();
+    for (auto& d : detectors_) d.detector->reset();
+    for (auto& r : racks_) std::fill(r.buffer.begin(), r.buffer.end(), 0.0f);
+  }
+
+  // Render one block (ctx.frames <= maxFrames) into out (channels interleaved, overwritten).
+  // renderRack(rackIndex, ctx, dst) fills a zeroed channels-wide buffer for an active rack.
+  template <typename RenderRackFn>
+  void process(const ProcessContext& ctx, float* out, RenderRackFn&& renderRack) {
+    process(ctx, out, renderRack, [](size_t count, auto& task) { for (size_t i = 0; i < count; ++i) task(i); });
+  }
+
+  // As above, with the independent rack steps handed to parallelFor(count, task), which must
+  // call task(i) for every i in [0, count) and return once all of them have finished
+  template <typename RenderRackFn, typename ParallelForFn>
+  void process(const ProcessContext& ctx, float* out, RenderRackFn&& renderRack, ParallelForFn&& parallelFor) {
+    const uint32_t frames = std::min(ctx.frames, maxFrames_);
+    if (frames == 0) return;
+    // Racks and inserts see the clamped block: their buffers hold maxFrames_ frames
+    ProcessContext block = ctx; block.frames = frames;
+    std::fill(out, out + static_cast<size_t>(frames) * channels_, 0.0f);
+    ++serial_;
+    updateGains(ctx.blockStart, frames);
+    auto rackTask = [&](size_t k) {
+      RackNode& r = racks_[order_[k].index];
+      std::fill(r.buffer.begin(), r.buffer.begin() + static_cast<std::ptrdiff_t>(frames * channels_), 0.0f);
+      renderRack(static_cast<size_t>(order_[k].index), block, r.buffer.data());
+    };
+    parallelFor(rackSteps_, rackTask);
+    for (size_t k = rackSteps_; k < order_.size(); ++k) {
+      const Step& s = order_[k];
+      switch (s.kind) {
+        case StepKind::Rack: break; // only in the parallel prefix
+        case StepKind::SidechainTap: {
+          Tap& t = taps_[s.index]; const uint32_t bch = buses_[t.bus].channels;
+          std::fill(t.buffer.begin(), t.buffer.begin() + static_cast<std::ptrdiff_t>(frames * bch), 0.0f);
+          for (uint32_t ri : t.racks) buses_[t.bus].fromRack.applyAdd(t.buffer.data(), racks_[ri].buffer.data(), frames, 1.0f);
+          break;
+        }
+        case StepKind::Bus: {
+          BusNode& b = buses_[s.index];
+          std::fill(b.buffer.begin(), b.buffer.begin() + static_cast<std::ptrdiff_t>(frames * b.channels), 0.0f);
+          for (uint32_t rti : b.routesIn) {
+            const Route& rt = routes_[rti]; const RackNode& r = racks_[rt.rack];
+            if (r.gainConst) b.fromRack.applyAdd(b.buffer.data(), r.buffer.data(), frames, r.gainScalar * rt.gain);
+            else b.fromRack.applyAddGains(b.buffer.data(), r.buffer.data(), frames, r.gainBuf.data(), rt.gain);
+          }
+          break;
+        }
+        case StepKind::Insert: {
+          InsertNode& ins = inserts_[s.index]; BusNode& b = buses_[ins.bus];
+          SidechainDetector& det = *detectors_[ins.detector].detector;
+          if (det.serial != serial_) { det.analyse(taps_[ins.tap].buffer.data(), frames, b.channels); det.serial = serial_; }
+          ins.duck->applyDetected(block, b.buffer.data(), det, 0, b.channels);
+          break;
+        }
+        case StepKind::Master: {
+          for (size_t ri = 0; ri < racks_.size(); ++ri) {
+            const RackNode& r = racks_[ri];
+            if (!r.active || r.routed) continue;
+            if (r.gainConst) {
+              const size_t n = static_cast<size_t>(frames) * channels_;
+              for (size_t i = 0; i < n; ++i) out[i] += r.buffer[i] * r.gainScalar;
+            } else {
+              for (uint32_t f = 0; f < frames; ++f)
+                for (uint32_t c = 0; c < channels_; ++c) out[static_cast<size_t>(f) * channels_ + c] += r.buffer[static_cast<size_t>(f) * channels_ + c] * r.gainBuf[f];
+            }
+          }
+          for (auto& b : buses_) {
+            if (b.gain.steady()) b.toMaster.applyAdd(out, b.buffer.data(), frames, b.gain.value);
+            else { b.gain.render(b.gainBuf.data(), frames); b.toMaster.applyAddGains(out, b.buffer.data(), frames, b.gainBuf.data(), 1.0f); }
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  size_t rackCount() const { return racks_.size(); }
+  size_t busCount() const { return buses_.size(); }
+  bool rackActive(size_t ri) const { return ri < racks_.size() && racks_[ri].active; }
+  const std::string& rackId(size_t ri) const { return racks_[ri].id; }
+  const std::string& busId(size_t bi) const { return buses_[bi].id; }
+  uint32_t busChannels(size_t bi) const { return buses_[bi].channels; }
+  ChannelLayout busLayout(size_t bi) const { return buses_[bi].layout; }
+  // --mem-report: a bus's buffers and inserts, and everything the session graph holds
+  size_t busMemoryBytes(size_t bi) const {
+    const BusNode& b = buses_[bi];
+    size_t n = vectorBytes(b.buffer) + vectorBytes(b.gainBuf);
+    for (uint32_t ii : b.inserts) n += inserts_[ii].duck->memoryBytes();
+    return n;
+  }
+  size_t memoryBytes() const {
+    size_t n = 0;
+    for (const auto& r : racks_) n += vectorBytes(r.buffer) + vectorBytes(r.gainBuf);
+    for (size_t bi = 0; bi < buses_.size(); ++bi) n += busMemoryBytes(bi);
+    for (const auto& t : taps_) n += vectorBytes(t.buffer);
+    for (const auto& d : detectors_) n += d.detector->memoryBytes();
+    for (const auto& xf : xfaders_) n += vectorBytes(xf.gainA) + vectorBytes(xf.gainB);
+    return n;
+  }
+  // Valid after process() for the frames of the last block
+  const float* rackBuffer(size_t ri) const { return racks_[ri].buffer.data(); }
+  const float* busBuffer(size_t bi) const { return buses_[bi].buffer.data(); }
+  uint32_t maxFrames() const { return maxFrames_; }
+  const std::vector<Step>& order() const { return order_; }
+  // Leading rack steps in order(); they have no inputs and may run concurrently
+  size_t parallelRackSteps() const { return rackSteps_; }
+  std::vector<Xfader>& xfaders() { return xfaders_; }
+  const std::vector<Xfader>& xfaders() const { return xfaders_; }
+  // Manual xfader position; takes over from the LFO. Returns false for unknown ids.
+  bool setXfaderTarget(const std::string& id, double x, double rampMs) {
+    return setXfaderTarget(id.data(), id.size(), x, rampMs);
+  }
+  // Rack/bus output gain, ramped linearly over rampMs (0 = from the next sample)
+  bool setRackGain(const std::string& id, float gain, double rampMs) { return setRackGain(id.data(), id.size(), gain, rampMs); }
+  bool setBusGain(const std::string& id, float gain, double rampMs) { return setBusGain(id.data(), id.size(), gain, rampMs); }
+
+  // True for ids addressed to applySessionTarget rather than to a rack node
+  static bool isSessionTarget(const char* nodeId) {
+    return nodeId && (std::strncmp(nodeId, "xfader:", 7) == 0 || std::strncmp(nodeId, "rack:", 5) == 0 || std::strncmp(nodeId, "bus:", 4) == 0);
+  }
+  // Session-level command targets: "xfader:<id>:x", "rack:<id>:gain", "bus:<id>:gain".
+  // Returns true when nodeId addressed the session graph (whether or not the id exists).
+  // Does not allocate, so it is safe on the audio thread.
+  bool applySessionTarget(const char* nodeId, float value, float rampMs) {
+    if (!nodeId) return false;
+    auto match = [&](const char* prefix, const char* suffix, const char*& idBegin, size_t& idLen) {
+      const size_t pl = std::strlen(prefix);
+      if (std::strncmp(nodeId, prefix, pl) != 0) return false;
+      idBegin = nodeId + pl;
+      const char* colon = std::strrchr(idBegin, ':');
+      if (!colon || std::strcmp(colon + 1, suffix) != 0) return false;
+      idLen = static_cast<size_t>(colon - idBegin);
+      return true;
+    };
+    const char* id = nullptr; size_t len = 0;
+    if (match("xfader:", "x", id, len)) { setXfaderTarget(id, len, static_cast<double>(value), static_cast<double>(rampMs)); return true; }
+    if (match("rack:", "gain", id, len)) { setRackGain(id, len, value, static_cast<double>(rampMs)); return true; }
+    if (match("bus:", "gain", id, len)) { setBusGain(id, len, value, static_cast<double>(rampMs)); return true; }
+    return false;
+  }
+
+private:
+  static constexpr uint32_t kNone = UINT32_MAX;
+  struct RackNode {
+    std::string id; GainRamp gain; bool active = true; bool routed = false; std::vector<float> buffer;
+    // Effective per-block gain (ramp × xfaders): a scalar when constant, else per sample
+    bool gainConst = true; float gainScalar = 1.0f; std::vector<float> gainBuf;
+  };
+  struct Route { uint32_t rack = 0; uint32_t bus = 0; float gain = 1.0f; };
+  struct Tap { uint32_t bus = 0; std::vector<uint32_t> racks; std::vector<float> buffer; };
+  struct InsertNode { uint32_t bus = 0; uint32_t tap = 0; uint32_t detector = 0; std::unique_ptr<SpectralDuckerNode> duck; };
+  struct KeyDetector { uint32_t tap = 0; std::unique_ptr<SidechainDetector> detector; };
+  struct BusNode {
+    std::string id; uint32_t channels = 2; ChannelLayout layout = ChannelLayout::Stereo;
+    ChannelMixMatrix fromRack; ChannelMixMatrix toMaster; // precomputed at route boundaries
+    std::vector<uint32_t> routesIn; std::vector<uint32_t> inserts; std::vector<float> buffer;
+    GainRamp gain; std::vector<float> gainBuf;
+  };
+
+  uint32_t rackIndexOf(const std::string& id) const {
+    for (size_t i = 0; i < racks_.size(); ++i) if (racks_[i].id == id) return static_cast<uint32_t>(i);
+    return kNone;
+  }
+
+  static bool idEquals(const std::string& a, const char* id, size_t len) { return a.size() == len && std::memcmp(a.data(), id, len) == 0; }
+
+  bool setXfaderTarget(const char* id, size_t len, double x, double rampMs) {
+    bool found = false;
+    for (auto& xf : xfaders_) {
+      if (!idEquals(xf.id, id, len)) continue;
+      xf.lfoEnabled = false;
+      xf.xTarget = std::clamp(x, 0.0, 1.0);
+      if (rampMs > 0.0) xf.smoothingMs = rampMs;
+      found = true;
+    }
+    return found;
+  }
+  bool setRackGain(const char* id, size_t len, float gain, double rampMs) {
+    for (auto& r : racks_) if (idEquals(r.id, id, len)) { r.gain.rampTo(gain, rampMs, sampleRate_); return true; }
+    return false;
+  }
+  bool setBusGain(const char* id, size_t len, float gain, double rampMs) {
+    for (auto& b : buses_) if (idEquals(b.id, id, len)) { b.gain.rampTo(gain, rampMs, sampleRate_); return true; }
+    return false;
+  }
+
+  // Per-sample xfader evaluation. The LFO is closed form in absolute sample time and the
+  // smoother is a per-sample one-pole, so gains are identical for any block partition.
+  void renderXfader(Xfader& xf, SampleTime blockStart, uint32_t frames) {
+    if (!xf.lfoEnabled && xf.x == xf.xTarget) {
+      if (!xf.steady) { xf.steady = true; lawGains(xf, xf.x, xf.lastGA, xf.lastGB); }
+      return;
+    }
+    xf.steady = false;
+    const double a = (xf.smoothingMs > 0.0) ? 1.0 - std::exp(-1.0 / (xf.smoothingMs * 0.001 * sampleRate_)) : 1.0;
+    const double w = xf.freqHz / sampleRate_;
+    for (uint32_t i = 0; i < frames; ++i) {
+      if (xf.lfoEnabled) {
+        const double ph = xf.phase01 + w * static_cast<double>(blockStart + i);
+        xf.xTarget = 0.5 * (std::sin(2.0 * M_PI * (ph - std::floor(ph))) + 1.0);
+      }
+      xf.x += (xf.xTarget - xf.x) * a;
+      if (!xf.lfoEnabled && std::fabs(xf.xTarget - xf.x) < 1.0e-7) xf.x = xf.xTarget;
+      double gA = 1.0, gB = 1.0; lawGains(xf, xf.x, gA, gB);
+      xf.gainA[i] = static_cast<float>(gA); xf.gainB[i] = static_cast<float>(gB);
+      xf.lastGA = gA; xf.lastGB = gB;
+    }
+  }
+  static void lawGains(const Xfader& xf, double xIn, double& gA, double& gB) {
+    const double x = std::clamp(xIn, 0.0, 1.0);
+    if (xf.lawEqualPower) { gA = std::cos(0.5 * M_PI * x); gB = std::sin(0.5 * M_PI * x); }
+    else { gA = 1.0 - x; gB = x; }
+  }
+
+  // Multiply a rack's effective gain by a scalar or a per-sample buffer
+  void scaleRackGain(RackNode& r, bool constant, float scalar, const float* buf, uint32_t frames) {
+    if (r.gainConst && constant) { r.gainScalar *= scalar; return; }
+    if (r.gainConst) { std::fill(r.gainBuf.begin(), r.gainBuf.begin() + frames, r.gainScalar); r.gainConst = false; }
+    if (constant) { for (uint32_t i = 0; i < frames; ++i) r.gainBuf[i] *= scalar; }
+    else multiplyGains(r.gainBuf.data(), buf, frames);
+  }
+
+  void updateGains(SampleTime blockStart, uint32_t frames) {
+    for (auto& r : racks_) {
+      if (r.gain.steady()) { r.gainConst = true; r.gainScalar = r.gain.value; }
+      else { r.gain.render(r.gainBuf.data(), frames); r.gainConst = false; }
+    }
+    for (auto& xf : xfaders_) {
+      renderXfader(xf, blockStart, frames);
+      scaleRackGain(racks_[xf.a], xf.steady, static_cast<float>(xf.lastGA), xf.gainA.data(), frames);
+      scaleRackGain(racks_[xf.b], xf.steady, static_cast<float>(xf.lastGB), xf.gainB.data(), frames);
+    }
+  }
+
+  // Kahn topological sort over racks, taps, buses, inserts and master. Inactive racks are
+  // dropped entirely; racks come first and have no inputs, so they may run in parallel.
+  void buildOrder() {
+    const uint32_t nR = static_cast<uint32_t>(racks_.size()), nT = static_cast<uint32_t>(taps_.size());
+    const uint32_t nB = static_cast<uint32_t>(buses_.size()), nI = static_cast<uint32_t>(inserts_.size());
+    const uint32_t baseT = nR, baseB = baseT + nT, baseI = baseB + nB, master = baseI + nI;
+    const uint32_t total = master + 1;
+    std::vector<std::vector<uint32_t>> succ(total);
+    std::vector<uint32_t> indeg(total, 0);
+    auto edge = [&](uint32_t from, uint32_t to) { succ[from].push_back(to); ++indeg[to]; };
+    for (const auto& rt : routes_) edge(rt.rack, baseB + rt.bus);
+    for (uint32_t ri = 0; ri < nR; ++ri) if (racks_[ri].active && !racks_[ri].routed) edge(ri, master);
+    for (uint32_t ti = 0; ti < nT; ++ti) for (uint32_t ri : taps_[ti].racks) edge(ri, baseT + ti);
+    for (uint32_t bi = 0; bi < nB; ++bi) {
+      uint32_t prev = baseB + bi;
+      for (uint32_t ii : buses_[bi].inserts) { edge(prev, baseI + ii); edge(baseT + inserts_[ii].tap, baseI + ii); prev = baseI + ii; }
+      edge(prev, master);
+    }
+    std::vector<uint32_t> ready; ready.reserve(total);
+    for (uint32_t n = 0; n < total; ++n) if (indeg[n] == 0 && (n >= nR || racks_[n].active)) ready.push_back(n);
+    order_.clear(); order_.reserve(total);
+    for (size_t head = 0; head < ready.size(); ++head) {
+      const uint32_t n = ready[head];
+      Step s;
+      if (n < baseT) { s.kind = StepKind::Rack; s.index = n; }
+      else if (n < baseB) { s.kind = StepKind::SidechainTap; s.index = n - baseT; }
+      else if (n < baseI) { s.kind = StepKind::Bus; s.index = n - baseB; }
+      else if (n < master) { s.kind = StepKind::Insert; s.index = n - baseI; }
+      else { s.kind = StepKind::Master; s.index = 0; }
+      order_.push_back(s);
+      for (uint32_t m : succ[n]) if (--indeg[m] == 0) ready.push_back(m);
+    }
+    if (order_.empty() || order_.back().kind != StepKind::Master) throw std::runtime_error("SessionGraph: routing contains a cycle");
+    rackSteps_ = 0;
+    while (rackSteps_ < order_.size() && order_[rackSteps_].kind == StepKind::Rack) ++rackSteps_;
+  }
+
+  uint32_t channels_ = 2;
+  ChannelLayout masterLayout_ = ChannelLayout::Stereo;
+  double sampleRate_ = 48000.0;
+  uint32_t maxFrames_ = 0;
+  std::vector<RackNode> racks_;
+  std::vector<BusNode> buses_;
+  std::vector<Route> routes_;
+  std::vector<Tap> taps_;
+  std::vector<InsertNode> inserts_;
+  std::vector<KeyDetector> detectors_;
+  uint64_t serial_ = 0; // process() calls; detectors analyse once per serial
+  std::vector<Xfader> xfaders_;
+  std::vector<Step> order_;
+  size_t rackSteps_ = 0;
+};
@@ -2,24 +2,32 @@
 
 #include <vector>
 #include <string>
+#include <utility>
 #include <cstdint>
 #include <algorithm>
+#include <functional>
 #include "SessionSpec.hpp"
+#include "../core/JobPool.hpp"
 #include "../core/Graph.hpp"
 #include "../core/GraphConfig.hpp"
+#include "../core/ParamMap.hpp"
 #include "../core/NodeFactory.hpp"
+#include "../instruments/sampler/SamplerWarmup.hpp"
 #include "../offline/OfflineGraphRenderer.hpp"
 #include "../offline/OfflineTimelineRenderer.hpp" // for renderGraphWithCommands
+#include "../offline/OfflineLoopRenderer.hpp"
+#include "../offline/OfflineLockstepRenderer.hpp"
 #include "../offline/TransportGenerator.hpp"
 #include "../core/GraphUtils.hpp" // computeGraphPrerollSamples
-#include "../core/SpectralDuckerNode.hpp"
+#include "SessionGraph.hpp"
 
 struct SessionRuntime {
   struct Rack {
     std::string id;
     Graph graph;
     GraphSpec spec;
-    std::vector<GraphSpec::CommandSpec> cmds;
+    std::vector<GraphSpec::CommandSpec> cmds;        // rack commands and transport, sorted, rack time
+    std::vector<GraphSpec::CommandSpec> sessionCmds; // session commands for this rack's nodes, sorted, rack time
     int64_t startOffsetFrames = 0;
     float gain = 1.0f;
     bool muted = false;
@@ -35,20 +43,50 @@ struct SessionRuntime {
     uint64_t blocks = 0;
   };
 
+  // --mem-report: bytes per rack (graph peak and its rendered audio) and for the session mix
+  struct RackMemory {
+    std::string id;
+    size_t graphBytes = 0;
+    size_t graphPeakBytes = 0;
+    size_t audioBytes = 0; // the rack's full-length render, held until the mix
+  };
+  struct MemoryReport {
+    std::vector<RackMemory> racks;
+    std::vector<std::pair<std::string, size_t>> buses;
+    size_t routingBytes = 0; // session graph: rack/bus/tap buffers, inserts, detectors, xfaders
+    size_t mixBytes = 0;
+    size_t totalBytes = 0;
+    size_t peakBytes = 0;    // all rack graphs at their peak plus every render held for the mix
+  };
+
   uint32_t sampleRate = 48000;
   uint32_t channels = 2;
   std::vector<Rack> racks;
   bool enablePerRackMeters = false;
   bool enablePerRackCpu = false;
-  struct Bus { std::string id; uint32_t channels = 2; std::vector<float> buffer; std::vector<SessionSpec::InsertRef> inserts; };
-  std::vector<Bus> buses;
-  struct Route { std::string from; std::string to; float gain = 1.0f; };
-  std::vector<Route> routes;
-  // Session-level commands (resolved to sample time)
+  bool enableMemReport = false;
+  MemoryReport memory; // filled by the last render when enableMemReport is set
+  uint32_t randomSeedOverride = 0; // replaces each rack's randomSeed when non-zero
+  // --simd-lanes: offline racks render in lockstep so same-type generators of all racks share
+  // lane kernels (renderGraphsLockstep); looped renders that copy loops batch within each rack
+  bool laneBatching = false;
+  // Batch service hooks: rack specs from a shared parse cache, and racks rendered in parallel
+  // on a pool (the mix stays serial). Unset: read each rack file, render racks in order.
+  std::function<GraphSpec(const std::string&)> rackSpecLoader;
+  JobPool* rackPool = nullptr;
+  std::vector<SessionSpec::BusRef> buses;
+  std::vector<SessionSpec::RouteRef> routes;
+  std::vector<SessionSpec::XfaderRef> xfaders;
+  // Bus/insert/xfader routing, compiled once in loadFromSpec (shared with the realtime renderer)
+  SessionGraph routing;
+  // Session-level commands (resolved to sample time, sorted)
   std::vector<GraphSpec::CommandSpec> sessionCommands;
+  // The xfader/rack/bus targets among them, applied by the session mix
+  std::vector<GraphSpec::CommandSpec> sessionTargets;
 
   void setPerRackMeters(bool v) { enablePerRackMeters = v; }
   void setPerRackCpu(bool v) { enablePerRackCpu = v; }
+  void setMemReport(bool v) { enableMemReport = v; }
 
   static inline void computePeakAndRmsSimple(const std::vector<float>& interleaved, uint32_t /*channels*/, double& outPeakDb, double& outRmsDb) {
     double peak = 0.0; long double sumSq = 0.0L; const size_t n = interleaved.size();
@@ -66,9 +104,9 @@ struct SessionRuntime {
   void loadFromSpec(const SessionSpec& s) {
     sampleRate = s.sampleRate; channels = s.channels;
     racks.clear(); racks.reserve(s.racks.size());
-    buses.clear(); routes.clear();
+    buses.clear(); routes.clear(); xfaders.clear();
     for (const auto& rr : s.racks) {
-      GraphSpec gs = loadGraphSpecFromJsonFile(rr.path);
+      GraphSpec gs = rackSpecLoader ? rackSpecLoader(rr.path) : loadGraphSpecFromJsonFile(rr.path);
       Graph g;
       for (const auto& ns : gs.nodes) {
         auto node = createNodeFromSpec(ns);
@@ -86,8 +124,12 @@ struct SessionRuntime {
       if (!gs.connections.empty()) {
         g.setConnections(gs.connections);
       }
+      // Scope streams by rack id so two racks loading the same file do not share noise
+      g.setRandomSeed(randomSeedOverride != 0 ? randomSeedOverride : gs.randomSeed, rr.id + ":");
+      warmSamplerHeads(g, gs);
       // Build command list for this rack (transport + explicit commands), resolve param names
-      std::vector<GraphSpec::CommandSpec> rackCmds = gs.commands;
+      std::vector<GraphSpec::CommandSpec> rackCmds = sortedCommands(gs.commands);
+      std::vector<GraphSpec::CommandSpec> transportCmds;
       if (gs.hasTransport) {
         GraphSpec::Transport tgen = gs.transport;
         // Apply per-rack overrides (bars/loopCount or minutes/seconds)
@@ -102,35 +144,32 @@ struct SessionRuntime {
           if (loops == 0) loops = 1;
           tgen.lengthBars = tgen.lengthBars * loops;
         }
-        auto gen = generateCommandsFromTransport(tgen, sampleRate);
-        rackCmds.insert(rackCmds.end(), gen.begin(), gen.end());
+        transportCmds = generateCommandsFromTransport(tgen, sampleRate);
       }
+      // Both streams are sorted: merge instead of concatenating and re-sorting
+      rackCmds = mergeCommandStreams({&rackCmds, &transportCmds});
       {
         std::unordered_map<std::string, std::string> nodeIdToType;
         for (const auto& ns : gs.nodes) nodeIdToType.emplace(ns.id, ns.type);
-        auto mapParam = [](const std::string& type, const std::string& name) -> uint16_t {
-          if (type == std::string("kick")) return resolveParamIdByName(kKickParamMap, name);
-          if (type == std::string("clap")) return resolveParamIdByName(kClapParamMap, name);
-          if (type == std::string("tb303_ext")) return resolveParamIdByName(kTb303ParamMap, name);
-          if (type == std::string("mam_chip")) return resolveParamIdByName(kMamChipParamMap, name);
-          return 0;
-        };
         for (auto& c : rackCmds) {
           if (c.paramId == 0 && !c.paramName.empty()) {
             auto it = nodeIdToType.find(c.nodeId);
             const std::string nodeType = (it != nodeIdToType.end()) ? it->second : std::string();
-            c.paramId = mapParam(nodeType, c.paramName);
+            c.paramId = paramIdForNodeType(nodeType, c.paramName);
           }
         }
+        // Rack graphs run on rack time; session lanes are moved by the rack's start offset
+        g.setAutomation(rackAutomationLanes(s, rr, gs, std::string(), 0, sampleRate, paramIdForNodeType));
       }
       Rack r; r.id = rr.id; r.graph = std::move(g); r.spec = std::move(gs); r.cmds = std::move(rackCmds); r.startOffsetFrames = rr.startOffsetFrames; r.gain = rr.gain; r.muted = rr.muted; r.solo = rr.solo;
       racks.push_back(std::move(r));
     }
-    // Initialize buses and routes
-    for (const auto& b : s.buses) {
-      Bus bb; bb.id = b.id; bb.channels = b.channels; bb.inserts = b.inserts; buses.push_back(std::move(bb));
-    }
-    for (const auto& r : s.routes) { Route rr; rr.from = r.from; rr.to = r.to; rr.gain = r.gain; routes.push_back(rr); }
+    // Compile buses, routes, inserts and xfaders into the session graph
+    buses = s.buses; routes = s.routes; xfaders = s.xfaders;
+    std::vector<SessionGraph::RackDesc> descs; descs.reserve(racks.size());
+    for (const auto& r : racks) descs.push_back(SessionGraph::RackDesc{r.id, r.gain, r.muted, r.solo});
+    routing.compile(descs, buses, routes, channels);
+    routing.setXfaders(xfaders);
 
     // Resolve session commands from musical time to sample time
     sessionCommands.clear();
@@ -176,129 +215,49 @@ struct SessionRuntime {
       cmd.sampleTime = static_cast<uint64_t>(std::llround(resolvedTimeSec * sampleRate));
       cmd.nodeId = sc.nodeId;
       cmd.type = sc.type;
-      cmd.paramId = 0; // Session commands use nodeId targeting, not paramId
+      cmd.paramId = 0; // resolved per rack below
+      cmd.paramName = sc.paramName;
       cmd.value = sc.value;
       cmd.rampMs = sc.rampMs;
       sessionCommands.push_back(cmd);
     }
-  }
-
-  // Render offline: mix simple sum with per-rack gain and start offset (silence before start)
-  std::vector<float> renderOffline(uint64_t frames, std::vector<RackStats>* outStats = nullptr) {
-    std::vector<float> mix;
-    mix.assign(static_cast<size_t>(frames * channels), 0.0f);
-    if (outStats) outStats->clear();
-    // Prepare bus buffers
-    for (auto& b : buses) b.buffer.assign(static_cast<size_t>(frames * b.channels), 0.0f);
+    sessionCommands = sortedCommands(sessionCommands);
 
-    // Session commands are resolved but not yet applied in offline rendering
-    // This provides the foundation for musical time addressing in offline sessions
-
-    struct RackOutput { std::string id; std::vector<float> audio; int64_t startOffsetFrames = 0; float gain = 1.0f; };
-    std::vector<RackOutput> outputs;
-    outputs.reserve(racks.size());
-
-    // Determine solo mode: if any rack is solo, only those racks render
-    bool anySolo = false; for (const auto& r : racks) if (r.solo) { anySolo = true; break; }
-    // Render each rack with its commands
-    for (auto& r : racks) {
-      if (r.muted) continue;
-      if (anySolo && !r.solo) continue;
-      const uint64_t rackFrames = frames > static_cast<uint64_t>(std::max<int64_t>(0, -r.startOffsetFrames))
-        ? (frames - static_cast<uint64_t>(std::max<int64_t>(0, -r.startOffsetFrames))) : 0ull;
-      if (rackFrames == 0) continue;
-      if (enablePerRackCpu) r.graph.enableCpuStats(true);
-      auto audio = renderGraphWithCommands(r.graph, r.cmds, sampleRate, channels, rackFrames);
-      outputs.push_back(RackOutput{r.id, audio, r.startOffsetFrames, r.gain});
-    }
-    // Route rack outputs to buses or final mix
-    for (const auto& ro : outputs) {
-      const auto& audio = ro.audio;
-      if (outStats && enablePerRackMeters) {
-        RackStats st; st.id = ro.id; computePeakAndRmsSimple(audio, channels, st.peakDb, st.rmsDb);
-        outStats->push_back(st);
-      }
-      // Route to buses per routes; if no bus routes match, sum to mix directly
-      bool routed = false;
-      for (const auto& rt : routes) {
-        if (rt.from != ro.id) continue; routed = true;
-        auto it = std::find_if(buses.begin(), buses.end(), [&](const Bus& b){ return b.id == rt.to; });
-        if (it == buses.end()) continue;
-        const uint32_t bch = it->channels;
-        uint64_t writeStart = static_cast<uint64_t>(std::max<int64_t>(0, ro.startOffsetFrames));
-        const size_t n = audio.size();
-        for (size_t i = 0; i < n; ++i) {
-          const uint64_t frameIndex = writeStart + (i / channels);
-          if (frameIndex >= frames) break;
-          const uint32_t ch = static_cast<uint32_t>(i % channels);
-          const uint32_t dstCh = (bch == channels) ? ch : std::min(ch, bch - 1);
-          it->buffer[static_cast<size_t>(frameIndex * bch) + dstCh] += audio[i] * (ro.gain * rt.gain);
-        }
+    // Split them into session-graph targets and per-rack streams on rack time (session time
+    // minus the rack's start offset); both stay sorted. Params set before a rack starts apply
+    // at its first frame, triggers before it are dropped.
+    sessionTargets.clear();
+    for (auto& r : racks) r.sessionCmds.clear();
+    for (const auto& c : sessionCommands) {
+      if (SessionGraph::isSessionTarget(c.nodeId.c_str())) { sessionTargets.push_back(c); continue; }
+      const size_t colon = c.nodeId.find(':');
+      auto rackIt = colon == std::string::npos ? racks.end()
+        : std::find_if(racks.begin(), racks.end(), [&](const Rack& r) { return c.nodeId.compare(0, colon, r.id) == 0; });
+      if (rackIt == racks.end()) {
+        std::fprintf(stderr, "Warning: session command for %s matches no rack (ignored)\n", c.nodeId.c_str());
+        continue;
       }
-      if (!routed) {
-        uint64_t writeStart = static_cast<uint64_t>(std::max<int64_t>(0, ro.startOffsetFrames));
-        const size_t n = audio.size();
-        for (size_t i = 0; i < n; ++i) {
-          const uint64_t frameIndex = writeStart + (i / channels);
-          if (frameIndex >= frames) break;
-          mix[static_cast<size_t>(frameIndex * channels) + (i % channels)] += audio[i] * ro.gain;
-        }
+      GraphSpec::CommandSpec rc = c;
+      rc.nodeId = c.nodeId.substr(colon + 1);
+      if (!rc.paramName.empty()) {
+        for (const auto& ns : rackIt->spec.nodes) if (ns.id == rc.nodeId) { rc.paramId = paramIdForNodeType(ns.type, rc.paramName); break; }
       }
+      const int64_t t = static_cast<int64_t>(c.sampleTime) - rackIt->startOffsetFrames;
+      if (t < 0 && rc.type == std::string("Trigger")) continue;
+      rc.sampleTime = static_cast<uint64_t>(std::max<int64_t>(0, t));
+      rackIt->sessionCmds.push_back(std::move(rc));
     }
-    // Apply inserts and mix buses to final
-    for (auto& b : buses) {
-      // Apply known inserts
-      for (const auto& ins : b.inserts) {
-        if (ins.type == std::string("spectral_ducker")) {
-          SpectralDuckerNode duck;
-          // Params
-          try {
-            if (ins.params.contains("mix")) duck.mix = ins.params["mix"].get<float>();
-            if (ins.params.contains("detectorHpfHz")) duck.scHpfHz = ins.params["detectorHpfHz"].get<float>();
-            if (ins.params.contains("applyMode")) {
-              std::string m = ins.params["applyMode"].get<std::string>();
-              duck.applyMode = (m == std::string("dynamicEq")) ? SpectralDuckerNode::ApplyMode::DynamicEq : SpectralDuckerNode::ApplyMode::Multiply;
-            }
-            if (ins.params.contains("stereoMode")) {
-              std::string sm = ins.params["stereoMode"].get<std::string>();
-              duck.stereoMode = (sm == std::string("MidSide")) ? SpectralDuckerNode::StereoMode::MidSide : SpectralDuckerNode::StereoMode::LR;
-            }
-            if (ins.params.contains("msSideScale")) duck.msSideScale = ins.params["msSideScale"].get<float>();
-          } catch (...) {}
-          duck.prepare(static_cast<double>(sampleRate), static_cast<uint32_t>(std::min<uint64_t>(frames, 4096)));
-          // Build sidechain from referenced rack(s)
-          std::vector<float> sc; sc.assign(static_cast<size_t>(frames * b.channels), 0.0f);
-          for (const auto& scRef : ins.sidechains) {
-            const std::string& fromRack = scRef.second;
-            auto itOut = std::find_if(outputs.begin(), outputs.end(), [&](const RackOutput& ro){ return ro.id == fromRack; });
-            if (itOut == outputs.end()) continue;
-            const auto& audio = itOut->audio; const uint32_t bch = b.channels;
-            const uint64_t writeStart = static_cast<uint64_t>(std::max<int64_t>(0, itOut->startOffsetFrames));
-            const size_t n = audio.size();
-            for (size_t i = 0; i < n; ++i) {
-              const uint64_t frameIndex = writeStart + (i / channels);
-              if (frameIndex >= frames) break;
-              const uint32_t ch = static_cast<uint32_t>(i % channels);
-              const uint32_t dstCh = (bch == channels) ? ch : std::min(ch, bch - 1);
-              sc[static_cast<size_t>(frameIndex * bch) + dstCh] += audio[i];
-            }
-          }
-          // Apply ducking on bus buffer in-place
-          ProcessContext ctx{}; ctx.sampleRate = sampleRate; ctx.frames = static_cast<uint32_t>(frames); ctx.blockStart = 0;
-          duck.applySidechain(ctx, b.buffer.data(), sc.data(), b.channels);
-        }
-      }
-      // Sum bus to mix
-      const size_t n = b.buffer.size();
-      const uint32_t bch = b.channels;
-      for (size_t i = 0; i < n; ++i) {
-        const uint64_t frameIndex = static_cast<uint64_t>(i / bch);
-        const uint32_t ch = static_cast<uint32_t>(i % bch);
-        const uint32_t dstCh = (channels == bch) ? ch : std::min(ch, channels - 1);
-        mix[static_cast<size_t>(frameIndex * channels) + dstCh] += b.buffer[i];
-      }
-    }
-    return mix;
+  }
+
+  // Render offline: each active rack renders its commands merged with its session commands in
+  // full, then the compiled session graph mixes them block by block (start offsets, routes,
+  // inserts, xfaders, session targets) like the realtime path
+  std::vector<float> renderOffline(uint64_t frames, std::vector<RackStats>* outStats = nullptr) {
+    return renderAndMix(frames, outStats, laneBatching, [&](Rack& r) {
+      return mergeCommandStreams({&r.cmds, &r.sessionCmds});
+    }, [&](Rack& r, const std::vector<GraphSpec::CommandSpec>& cmds, uint64_t rackFrames) {
+      return renderGraphWithSortedCommands(r.graph, cmds, sampleRate, channels, rackFrames);
+    });
   }
 
   // Plan total frames considering content length, preroll, start offsets, and looping
@@ -307,18 +266,7 @@ struct SessionRuntime {
 
     if (enableLoop && maxLoops > 0) {
       // For looping, calculate based on the loop duration (max of rack loop lengths)
-      for (const auto& r : racks) {
-        uint64_t loopLen = 0;
-        if (r.spec.hasTransport) {
-          const double bpm = (r.spec.transport.bpm > 0.0) ? r.spec.transport.bpm : 120.0;
-          const double secPerBar = 4.0 * (60.0 / bpm);
-          const uint64_t framesPerBar = static_cast<uint64_t>(secPerBar * sampleRate + 0.5);
-          const uint32_t bars = (r.spec.transport.lengthBars > 0) ? r.spec.transport.lengthBars : 1u;
-          loopLen = framesPerBar * static_cast<uint64_t>(bars);
-        }
-        if (loopLen > maxEnd) maxEnd = loopLen;
-      }
-      maxEnd = maxEnd * maxLoops;
+      maxEnd = loopFrames() * maxLoops;
     } else {
       // Standard calculation: max of rack content
       for (const auto& r : racks) {
@@ -336,28 +284,141 @@ struct SessionRuntime {
     return maxEnd + tail;
   }
 
-  // Render with optional looping support
-  std::vector<float> renderOfflineWithLoop(uint64_t frames, uint32_t maxLoops = 1, std::vector<RackStats>* outStats = nullptr) {
+  // Export length: one pass, or for a looping session with a duration enough loops to cover it
+  // (loopsOut; 1 otherwise)
+  uint64_t planExportFrames(const SessionSpec& s, double sessionTailMs, uint32_t& loopsOut) const {
+    loopsOut = 1;
+    if (!s.loop || s.durationSec <= 0.0) return planTotalFrames(sessionTailMs);
+    const uint64_t singleLoopFrames = planTotalFrames(sessionTailMs, false, 1);
+    if (singleLoopFrames == 0) return planTotalFrames(sessionTailMs);
+    const double singleLoopSec = static_cast<double>(singleLoopFrames) / sampleRate;
+    loopsOut = static_cast<uint32_t>(std::ceil(s.durationSec / singleLoopSec));
+    return planTotalFrames(sessionTailMs, true, loopsOut);
+  }
+
+  // Session loop length: the longest rack transport loop (0 when no rack has a transport)
+  uint64_t loopFrames() const {
+    uint64_t maxLen = 0;
+    for (const auto& r : racks) {
+      if (!r.spec.hasTransport) continue;
+      const double bpm = (r.spec.transport.bpm > 0.0) ? r.spec.transport.bpm : 120.0;
+      const double secPerBar = 4.0 * (60.0 / bpm);
+      const uint64_t framesPerBar = static_cast<uint64_t>(secPerBar * sampleRate + 0.5);
+      const uint32_t bars = (r.spec.transport.lengthBars > 0) ? r.spec.transport.lengthBars : 1u;
+      maxLen = std::max<uint64_t>(maxLen, framesPerBar * static_cast<uint64_t>(bars));
+    }
+    return maxLen;
+  }
+
+  // Render a looping session: each rack plays its first loop's commands again every loopFrames()
+  // for maxLoops loops as one continuous render, so tails ring into the next loop, and loops that
+  // converge are copied (renderGraphWithCommandsLooped) unless copyLoops is false. Session
+  // commands play once at their own time; loops they touch are rendered.
+  std::vector<float> renderOfflineWithLoop(uint64_t frames, uint32_t maxLoops = 1, std::vector<RackStats>* outStats = nullptr, bool copyLoops = true) {
+    const uint64_t period = loopFrames();
+    if (period == 0 || maxLoops <= 1) return renderOffline(frames, outStats);
+    return renderAndMix(frames, outStats, laneBatching && !copyLoops, [&](Rack& r) {
+      std::vector<GraphSpec::CommandSpec> cmds;
+      for (uint32_t k = 0; k < maxLoops; ++k) {
+        for (const auto& c : r.cmds) {
+          if (c.sampleTime >= period) continue;
+          cmds.push_back(c);
+          cmds.back().sampleTime += static_cast<uint64_t>(k) * period;
+        }
+      }
+      return mergeCommandStreams({&cmds, &r.sessionCmds});
+    }, [&](Rack& r, const std::vector<GraphSpec::CommandSpec>& cmds, uint64_t rackFrames) {
+      return copyLoops ? renderGraphWithSortedCommandsLooped(r.graph, cmds, sampleRate, channels, rackFrames, period, maxLoops)
+                       : renderGraphWithSortedCommands(r.graph, cmds, sampleRate, channels, rackFrames);
+    });
+  }
+
+private:
+  // Render every active rack with renderRack(rack, rackCommands(rack), frames), or all of them in
+  // lockstep (lane batching across racks), then mix through the session graph
+  template <typename RackCommands, typename RenderRack>
+  std::vector<float> renderAndMix(uint64_t frames, std::vector<RackStats>* outStats, bool lockstep,
+                                  RackCommands&& rackCommands, RenderRack&& renderRack) {
     std::vector<float> mix;
     mix.assign(static_cast<size_t>(frames * channels), 0.0f);
     if (outStats) outStats->clear();
 
-    // Render multiple loops if requested
-    uint64_t framesRendered = 0;
-    for (uint32_t loop = 0; loop < maxLoops && framesRendered < frames; ++loop) {
-      uint64_t loopFrames = std::min(frames - framesRendered, frames / maxLoops); // Distribute frames across loops
-      if (loopFrames == 0) break;
-
-      std::vector<float> loopMix = renderOffline(loopFrames, outStats);
-      // Copy loop audio to the appropriate position in the final mix
-      for (size_t i = 0; i < loopMix.size() && framesRendered + i < mix.size(); ++i) {
-        mix[framesRendered + i] += loopMix[i];
+    struct RackOutput { std::vector<float> audio; uint64_t writeStart = 0; };
+    std::vector<RackOutput> outputs(racks.size());
+    std::vector<LockstepGraph> lockstepGraphs;
+    {
+      JobGroup group(rackPool);
+      for (size_t ri = 0; ri < racks.size(); ++ri) {
+        auto& r = racks[ri];
+        if (!routing.rackActive(ri)) continue;
+        const uint64_t rackFrames = frames > static_cast<uint64_t>(std::max<int64_t>(0, -r.startOffsetFrames))
+          ? (frames - static_cast<uint64_t>(std::max<int64_t>(0, -r.startOffsetFrames))) : 0ull;
+        if (rackFrames == 0) continue;
+        if (enablePerRackCpu) r.graph.enableCpuStats(true);
+        if (enableMemReport) r.graph.enableMemoryTracking(true);
+        r.graph.setLaneBatching(laneBatching);
+        outputs[ri].writeStart = static_cast<uint64_t>(std::max<int64_t>(0, r.startOffsetFrames));
+        if (lockstep) { lockstepGraphs.push_back(LockstepGraph{&r.graph, rackCommands(r), rackFrames, &outputs[ri].audio}); continue; }
+        group.run([&, ri, rackFrames] { outputs[ri].audio = renderRack(racks[ri], rackCommands(racks[ri]), rackFrames); });
+      }
+      group.wait();
+    }
+    if (!lockstepGraphs.empty()) renderGraphsLockstep(lockstepGraphs, sampleRate, channels, rackPool);
+    if (outStats && enablePerRackMeters) {
+      for (size_t ri = 0; ri < racks.size(); ++ri) {
+        if (outputs[ri].audio.empty()) continue;
+        RackStats st; st.id = racks[ri].id; computePeakAndRmsSimple(outputs[ri].audio, channels, st.peakDb, st.rmsDb);
+        outStats->push_back(st);
       }
-      framesRendered += loopFrames;
     }
 
+    const uint32_t block = 1024;
+    routing.prepare(static_cast<double>(sampleRate), block);
+    routing.reset();
+    // Session targets (xfader:<id>:x, rack:<id>:gain, bus:<id>:gain) end a mix block at their
+    // time and apply before the next, so gains change on the same sample as in realtime
+    size_t target = 0;
+    for (uint64_t f = 0; f < frames;) {
+      for (; target < sessionTargets.size() && sessionTargets[target].sampleTime <= f; ++target) {
+        const auto& t = sessionTargets[target];
+        if (t.type == std::string("Trigger")) continue;
+        routing.applySessionTarget(t.nodeId.c_str(), t.value, t.type == std::string("SetParamRamp") ? t.rampMs : 0.0f);
+      }
+      uint64_t end = std::min<uint64_t>(f + block, frames);
+      if (target < sessionTargets.size()) end = std::min<uint64_t>(end, sessionTargets[target].sampleTime);
+      ProcessContext ctx{}; ctx.sampleRate = sampleRate; ctx.frames = static_cast<uint32_t>(end - f); ctx.blockStart = f;
+      f = end;
+      routing.process(ctx, mix.data() + static_cast<size_t>(ctx.blockStart * channels), [&](size_t ri, const ProcessContext& c, float* dst) {
+        const RackOutput& ro = outputs[ri];
+        const uint64_t avail = ro.audio.size() / channels;
+        for (uint32_t i = 0; i < c.frames; ++i) {
+          const uint64_t abs = c.blockStart + i;
+          if (abs < ro.writeStart || abs - ro.writeStart >= avail) continue;
+          const float* src = ro.audio.data() + static_cast<size_t>((abs - ro.writeStart) * channels);
+          std::copy(src, src + channels, dst + static_cast<size_t>(i) * channels);
+        }
+      });
+    }
+    if (enableMemReport) collectMemory(outputs, mix);
     return mix;
   }
+
+  template <typename RackOutputs>
+  void collectMemory(const RackOutputs& outputs, const std::vector<float>& mix) {
+    memory = MemoryReport{};
+    size_t graphsTotal = 0, graphsPeak = 0;
+    for (size_t ri = 0; ri < racks.size(); ++ri) {
+      const Graph::MemoryReport g = racks[ri].graph.memoryReport();
+      RackMemory rm; rm.id = racks[ri].id; rm.graphBytes = g.totalBytes; rm.graphPeakBytes = g.peakBytes; rm.audioBytes = vectorBytes(outputs[ri].audio);
+      graphsTotal += rm.graphBytes + rm.audioBytes; graphsPeak += rm.graphPeakBytes + rm.audioBytes;
+      memory.racks.push_back(rm);
+    }
+    for (size_t bi = 0; bi < routing.busCount(); ++bi) memory.buses.emplace_back(routing.busId(bi), routing.busMemoryBytes(bi));
+    memory.routingBytes = routing.memoryBytes();
+    memory.mixBytes = vectorBytes(mix);
+    memory.totalBytes = graphsTotal + memory.routingBytes + memory.mixBytes;
+    memory.peakBytes = graphsPeak + memory.routingBytes + memory.mixBytes;
+  }
 };
 
 
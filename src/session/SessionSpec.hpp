@@ -2,12 +2,14 @@
 
 #include <string>
 #include <vector>
+#include <cmath>
 #include <cstdint>
 #include <stdexcept>
 #include <cstdio>
 #include <fstream>
 #include <sstream>
 #include "../core/GraphConfig.hpp"
+#include "../core/ChannelLayout.hpp"
 #include "../../third_party/nlohmann/json.hpp"
 #include <filesystem>
 
@@ -20,6 +22,7 @@ struct SessionSpec {
     float gain = 1.0f;
     bool muted = false;
     bool solo = false;
+    bool frozen = false;         // realtime: stream a pre-rendered loop instead of running the graph
     // Optional transport overrides per rack
     uint32_t bars = 0;           // force bars (0 = use graph)
     uint32_t loopCount = 0;      // repeat bars N times
@@ -28,7 +31,7 @@ struct SessionSpec {
     double tailMs = 0.0;         // extra tail for this rack
   };
   struct InsertRef { std::string type; std::string id; nlohmann::json params; std::vector<std::pair<std::string,std::string>> sidechains; };
-  struct BusRef { std::string id; uint32_t channels = 2; std::vector<InsertRef> inserts; };
+  struct BusRef { std::string id; uint32_t channels = 2; std::string layout; std::vector<InsertRef> inserts; }; // layout: mono|stereo|ms|quad|5.1|7.1 (empty = from channels)
   struct RouteRef { std::string from; std::string to; float gain = 1.0f; };
   struct XfaderRef {
     std::string id;
@@ -62,6 +65,15 @@ struct SessionSpec {
   std::vector<RouteRef> routes;
   std::vector<XfaderRef> xfaders;
   std::vector<SessCommand> commands;
+  // Parameter curves on rack nodes ("<rack>:<node>"), points in session seconds
+  struct AutomationRef {
+    std::string nodeId;
+    std::string paramName;
+    uint16_t paramId = 0;
+    struct Point { double timeSec = 0.0; float value = 0.0f; AutomationLane::Shape shape = AutomationLane::Shape::Linear; float c1 = 0.0f, c2 = 0.0f; };
+    std::vector<Point> points;
+  };
+  std::vector<AutomationRef> automation;
 };
 
 inline SessionSpec loadSessionSpecFromJsonFile(const std::string& path) {
@@ -94,6 +106,7 @@ inline SessionSpec loadSessionSpecFromJsonFile(const std::string& path) {
       rr.gain = r.value("gain", 1.0f);
       rr.muted = r.value("muted", false);
       rr.solo = r.value("solo", false);
+      rr.frozen = r.value("frozen", false);
       rr.bars = r.value("bars", 0u);
       rr.loopCount = r.value("loopCount", 0u);
       rr.loopMinutes = r.value("loopMinutes", 0.0);
@@ -114,6 +127,13 @@ inline SessionSpec loadSessionSpecFromJsonFile(const std::string& path) {
   if (j.contains("buses")) {
     for (const auto& b : j["buses"]) {
       SessionSpec::BusRef br; br.id = b.value("id", std::string()); br.channels = b.value("channels", 2u);
+      br.layout = b.value("layout", std::string());
+      if (!br.layout.empty()) {
+        ChannelLayout l = ChannelLayout::Stereo;
+        if (!parseChannelLayout(br.layout, l)) throw std::runtime_error("Session bus '" + br.id + "' has unknown layout: " + br.layout);
+        if (!b.contains("channels")) br.channels = channelCountForLayout(l, br.channels);
+        else if (l != ChannelLayout::Discrete && channelCountForLayout(l) != br.channels) throw std::runtime_error("Session bus '" + br.id + "' layout " + br.layout + " does not match channels");
+      }
       if (b.contains("inserts")) {
         for (const auto& ins : b["inserts"]) {
           SessionSpec::InsertRef ir; ir.type = ins.value("type", std::string()); ir.id = ins.value("id", std::string());
@@ -179,7 +199,62 @@ inline SessionSpec loadSessionSpecFromJsonFile(const std::string& path) {
       s.commands.push_back(std::move(sc));
     }
   }
+  if (j.contains("automation")) {
+    for (const auto& aj : j["automation"]) {
+      SessionSpec::AutomationRef ar;
+      ar.nodeId = aj.value("nodeId", std::string());
+      ar.paramName = aj.value("param", std::string());
+      ar.paramId = static_cast<uint16_t>(aj.value("paramId", 0));
+      if (ar.nodeId.find(':') == std::string::npos) throw std::runtime_error("Session automation requires nodeId as <rack>:<node>");
+      if (aj.contains("points")) {
+        for (const auto& pj : aj["points"]) {
+          SessionSpec::AutomationRef::Point pt;
+          pt.timeSec = pj.value("timeSec", 0.0);
+          pt.value = pj.value("value", 0.0f);
+          const std::string curve = pj.value("curve", std::string("linear"));
+          if (!AutomationLane::parseShape(curve, pt.shape)) throw std::runtime_error("Unknown automation curve '" + curve + "' for " + ar.nodeId);
+          pt.c1 = pj.value("c1", 0.0f); pt.c2 = pj.value("c2", 0.0f);
+          ar.points.push_back(pt);
+        }
+      }
+      s.automation.push_back(std::move(ar));
+    }
+  }
   return s;
 }
 
+// Automation for one rack's graph: the rack's own lanes plus the session lanes addressed to
+// "<rack>:<node>" (seconds at sampleRate). rackOffset is where rack time 0 lies on the graph's timeline (startOffsetFrames
+// when the graph runs on session time, 0 when it runs on rack time); node ids become prefix + node.
+// Named params of session lanes are resolved with paramIdFor(nodeType, name); unresolved lanes are dropped.
+template <typename ParamIdFn>
+inline std::vector<AutomationLane> rackAutomationLanes(const SessionSpec& s, const SessionSpec::RackRef& rr, const GraphSpec& gs,
+                                                       const std::string& prefix, int64_t rackOffset, double sampleRate, ParamIdFn&& paramIdFor) {
+  std::vector<AutomationLane> lanes;
+  for (AutomationLane lane : gs.automation) {
+    lane.nodeId = prefix + lane.nodeId;
+    lane.shift(rackOffset);
+    if (!lane.empty()) lanes.push_back(std::move(lane));
+  }
+  const std::string scope = rr.id + ":";
+  for (const auto& ar : s.automation) {
+    if (ar.nodeId.compare(0, scope.size(), scope) != 0) continue;
+    const std::string node = ar.nodeId.substr(scope.size());
+    AutomationLane lane;
+    lane.nodeId = prefix + node; lane.paramName = ar.paramName; lane.paramId = ar.paramId;
+    if (lane.paramId == 0 && !lane.paramName.empty()) {
+      for (const auto& ns : gs.nodes) if (ns.id == node) { lane.paramId = paramIdFor(ns.type, lane.paramName); break; }
+    }
+    if (lane.paramId == 0) {
+      std::fprintf(stderr, "Warning: session automation %s/%s has no resolvable param (ignored)\n", ar.nodeId.c_str(), ar.paramName.c_str());
+      continue;
+    }
+    for (const auto& pt : ar.points) lane.addPoint(static_cast<uint64_t>(std::llround(std::max(0.0, pt.timeSec) * sampleRate)), pt.value, pt.shape, pt.c1, pt.c2);
+    lane.sort();
+    lane.shift(rackOffset - rr.startOffsetFrames);
+    if (!lane.empty()) lanes.push_back(std::move(lane));
+  }
+  return lanes;
+}
+
 
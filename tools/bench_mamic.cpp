@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../src/instruments/mam_chip/MamChipFactory.hpp"
+
+// MAMIC CPU benchmark: cost of one node by voice count, and the realtime load of 8 racks x 8 voices.
+// Usage: bench_mamic [seconds=10] [blockFrames=256] [sampleRate=48000] [maxOverrunPct=0.1]
+// Exits non-zero when more than maxOverrunPct % of the 8x8 blocks take longer than their budget
+// (blockFrames / sampleRate).
+
+static const char* kBenchParams =
+    R"({"mode":"custom","wave":"saw","pulseWidth":0.3,"noiseMix":0.1,"filterType":"lp","filterCutoff":2500,"filterReso":0.4,"filterDrive":0.3,"sync":1})";
+
+static std::unique_ptr<MamChipNode> makeBenchChip(uint32_t voices, double sr, uint32_t block, uint64_t key) {
+  static const uint16_t kNumVoices = resolveParamIdByName(kMamChipParamMap, "NUM_VOICES");
+  static const uint16_t kNote = resolveParamIdByName(kMamChipParamMap, "NOTE_SEMITONES");
+  auto node = makeMamChipFromParamsJson(kBenchParams);
+  node->prepare(sr, block);
+  node->setRandomKey(key);
+  Command c{}; c.type = CommandType::SetParam; c.paramId = kNumVoices; c.value = static_cast<float>(voices); node->handleEvent(c);
+  for (uint32_t v = 0; v < voices; ++v) {
+    c.type = CommandType::SetParam; c.paramId = kNote; c.value = static_cast<float>(48 + 5 * v); node->handleEvent(c);
+    c.type = CommandType::Trigger; c.value = 1.0f; node->handleEvent(c);
+  }
+  return node;
+}
+
+// Block times in microseconds for `nodes` rendered back to back: average, 99th percentile and worst
+struct BlockTimes { double avgUs = 0.0, p99Us = 0.0, maxUs = 0.0; uint64_t blocks = 0, overruns = 0; };
+
+static BlockTimes runBlocks(std::vector<std::unique_ptr<MamChipNode>>& nodes, double sr, uint32_t block, double seconds, double budgetUs) {
+  std::vector<float> out(static_cast<size_t>(block) * 2);
+  const uint64_t blocks = static_cast<uint64_t>(seconds * sr / block);
+  std::vector<double> times; times.reserve(static_cast<size_t>(blocks));
+  BlockTimes bt; bt.blocks = blocks;
+  double sum = 0.0;
+  for (uint64_t b = 0; b < blocks; ++b) {
+    const auto t0 = std::chrono::steady_clock::now();
+    for (auto& n : nodes) n->process(ProcessContext{sr, block, b * block}, out.data(), 2);
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    times.push_back(us); sum += us;
+    if (us > budgetUs) ++bt.overruns;
+  }
+  if (times.empty()) return bt;
+  bt.avgUs = sum / static_cast<double>(blocks);
+  std::sort(times.begin(), times.end());
+  bt.p99Us = times[std::min(times.size() - 1, times.size() * 99 / 100)];
+  bt.maxUs = times.back();
+  return bt;
+}
+
+int main(int argc, char** argv) {
+  const double seconds = argc > 1 ? std::atof(argv[1]) : 10.0;
+  const uint32_t block = argc > 2 ? static_cast<uint32_t>(std::atoi(argv[2])) : 256u;
+  const double sr = argc > 3 ? std::atof(argv[3]) : 48000.0;
+  const double maxOverrunPct = argc > 4 ? std::atof(argv[4]) : 0.1;
+  const double budgetUs = 1.0e6 * block / sr;
+  std::printf("MAMIC benchmark: sr=%.0f block=%u budget=%.1fus seconds=%.1f\n", sr, block, budgetUs, seconds);
+
+  // One node per row: the shared drive/filter/grit chain costs the same at any voice count, so
+  // the node (what a rack pays) is the unit, not the voice
+  std::printf("| voices | node avg us/block | node p99 us/block | node %% of budget |\n|---:|---:|---:|---:|\n");
+  for (uint32_t voices : {1u, 3u, 4u, 8u}) {
+    std::vector<std::unique_ptr<MamChipNode>> nodes;
+    nodes.push_back(makeBenchChip(voices, sr, block, voices));
+    const BlockTimes nt = runBlocks(nodes, sr, block, seconds, budgetUs);
+    std::printf("| %u | %.2f | %.2f | %.3f |\n", voices, nt.avgUs, nt.p99Us, 100.0 * nt.avgUs / budgetUs);
+  }
+
+  std::vector<std::unique_ptr<MamChipNode>> racks;
+  for (uint32_t r = 0; r < 8; ++r) racks.push_back(makeBenchChip(8, sr, block, 100 + r));
+  const BlockTimes bt = runBlocks(racks, sr, block, seconds, budgetUs);
+  // Judged by how often blocks miss their deadline, not by the average; a rare preempted block
+  // on a shared machine is tolerated up to maxOverrunPct
+  const double overrunPct = bt.blocks ? 100.0 * static_cast<double>(bt.overruns) / static_cast<double>(bt.blocks) : 0.0;
+  const bool ok = overrunPct <= maxOverrunPct;
+  std::printf("8 racks x 8 voices: avg=%.1fus (%.2fus per node) p99=%.1fus worst=%.1fus load=%.1f%% (p99 %.1f%%, worst %.1f%%) overruns=%llu/%llu (%.3f%%, limit %.3f%%) -> %s\n",
+              bt.avgUs, bt.avgUs / static_cast<double>(racks.size()), bt.p99Us, bt.maxUs, 100.0 * bt.avgUs / budgetUs, 100.0 * bt.p99Us / budgetUs,
+              100.0 * bt.maxUs / budgetUs, static_cast<unsigned long long>(bt.overruns), static_cast<unsigned long long>(bt.blocks), overrunPct, maxOverrunPct,
+              ok ? "realtime OK" : "NOT realtime");
+  return ok ? 0 : 1;
+}